@@ -0,0 +1,78 @@
+#ifndef ADDRESS_CACHE_H
+#define ADDRESS_CACHE_H
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <sys/socket.h>
+
+/**
+ * One resolved socket address of a host
+ */
+struct ResolvedAddress {
+    int family = AF_UNSPEC;
+    int socktype = SOCK_STREAM;
+    int protocol = 0;
+    struct sockaddr_storage address {};
+    socklen_t address_length = 0;
+};
+
+/**
+ * Process-wide DNS cache for the raw-socket transport.
+ *
+ * Resolved addresses are kept per host and port for a fixed TTL (the
+ * resolver does not report record TTLs). resolve() returns them in the
+ * order a Happy Eyeballs (RFC 8305) connection race should try them:
+ * families interleaved, starting with the family that last won a race
+ * for the host, or IPv6 when none has.
+ */
+class AddressCache {
+public:
+    static AddressCache& instance();
+
+    explicit AddressCache(std::chrono::seconds ttl = std::chrono::seconds(300),
+                          size_t max_entries = 10000);
+
+    /**
+     * Resolve a host, from the cache when fresh
+     * @param error Set to the resolver's message when resolution fails
+     * @return Addresses ordered for racing; empty on failure
+     */
+    std::vector<ResolvedAddress> resolve(const std::string& host, int port, std::string& error);
+
+    /**
+     * Remember which address family won a connection race for the host
+     */
+    void remember_family(const std::string& host, int family);
+
+    /**
+     * Family that last won for the host, AF_UNSPEC if none
+     */
+    int preferred_family(const std::string& host) const;
+
+    /**
+     * Interleave address families (RFC 8305 section 4), starting with first_family
+     */
+    static std::vector<ResolvedAddress> interleave(const std::vector<ResolvedAddress>& addresses,
+                                                   int first_family);
+
+    void clear();
+
+private:
+    struct Entry {
+        std::vector<ResolvedAddress> addresses;  // In resolver order
+        std::chrono::steady_clock::time_point expires;
+    };
+
+    std::chrono::seconds ttl_;
+    size_t max_entries_;
+    std::unordered_map<std::string, Entry> entries_;  // "host:port" -> addresses
+    std::unordered_map<std::string, int> families_;   // host -> winning family
+    mutable std::mutex mutex_;
+
+    void evict(std::chrono::steady_clock::time_point now);
+};
+
+#endif // ADDRESS_CACHE_H
@@ -0,0 +1,75 @@
+#ifndef BYTE_BUFFER_H
+#define BYTE_BUFFER_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+
+/**
+ * Immutable, reference-counted byte range.
+ *
+ * A page body is received into one buffer and travels from the socket to
+ * the dataset writer as slices of it: copying a ByteBuffer or slicing it
+ * only bumps a reference count. adopt() takes ownership of a string
+ * without copying it. The storage of the last released buffer goes back
+ * to a small process-wide pool, and acquire() hands out pooled storage
+ * with its capacity kept, so receive buffers are not allocated and
+ * faulted in anew for every page.
+ */
+class ByteBuffer {
+public:
+    ByteBuffer() = default;
+
+    /**
+     * Take ownership of bytes without copying them
+     */
+    static ByteBuffer adopt(std::string&& bytes);
+
+    /**
+     * Empty string with at least `capacity` bytes reserved, from the pool when possible
+     */
+    static std::string acquire(size_t capacity);
+
+    /**
+     * Sub-range sharing this buffer's storage; clamped to its bounds
+     */
+    ByteBuffer slice(size_t offset, size_t length = std::string_view::npos) const;
+
+    std::string_view view() const {
+        return std::string_view(data_, size_);
+    }
+
+    const char* data() const {
+        return data_;
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+    bool empty() const {
+        return size_ == 0;
+    }
+
+    /**
+     * Copy of the bytes, for consumers that need to own a std::string
+     */
+    std::string str() const {
+        return std::string(data_, size_);
+    }
+
+    /**
+     * Buffers sharing this storage, 0 for an empty buffer
+     */
+    long use_count() const {
+        return storage_.use_count();
+    }
+
+private:
+    std::shared_ptr<const std::string> storage_;
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+#endif // BYTE_BUFFER_H
@@ -0,0 +1,95 @@
+#ifndef CIRCUIT_BREAKER_H
+#define CIRCUIT_BREAKER_H
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+enum class CircuitState {
+    Closed,    // Requests flow
+    Open,      // Host is failing; its URLs are deferred
+    HalfOpen   // Cool-down over; the next outcome decides
+};
+
+/**
+ * Thresholds for the per-host circuit breaker
+ */
+struct CircuitLimits {
+    size_t window = 20;                              // Recent outcomes kept per host (max 64)
+    size_t min_requests = 5;                         // Outcomes needed before the rate is judged
+    double failure_rate = 0.5;                       // Failing share that opens the circuit
+    std::chrono::seconds open_for = std::chrono::seconds(30);       // First cool-down
+    std::chrono::seconds max_open_for = std::chrono::seconds(600);  // Cool-down cap
+};
+
+/**
+ * Per-host circuit breaker driven by the recent failure rate.
+ *
+ * Each host keeps its last `window` outcomes. When at least min_requests
+ * are known and the failing share reaches failure_rate the circuit opens
+ * for a cool-down, during which the crawler defers the host's URLs. After
+ * the cool-down the circuit is half-open: the next outcome closes it, or
+ * reopens it with twice the cool-down. The crawl loop fetches one URL at a
+ * time, so half-open lets exactly one probe through.
+ *
+ * Hosts whose recent outcomes are all successes are not tracked, which
+ * keeps the table to the hosts that are actually failing.
+ */
+class CircuitBreaker {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit CircuitBreaker(const CircuitLimits& limits = CircuitLimits());
+
+    void set_limits(const CircuitLimits& limits);
+
+    /**
+     * May a request to the host go out now? Moves an open circuit whose
+     * cool-down ended to half-open.
+     */
+    bool allow(const std::string& host, Clock::time_point now);
+
+    /**
+     * True while the host's cool-down runs
+     */
+    bool is_open(const std::string& host, Clock::time_point now) const;
+
+    /**
+     * Record the outcome of a request to the host
+     * @return true if this outcome opened the circuit
+     */
+    bool record(const std::string& host, bool success, Clock::time_point now);
+
+    CircuitState state(const std::string& host) const;
+
+    /**
+     * Move open circuits whose cool-down ended to half-open
+     * @return Their hosts, whose deferred URLs can be released
+     */
+    std::vector<std::string> cooled_down(Clock::time_point now);
+
+    size_t open_hosts() const;
+
+    void clear();
+
+private:
+    struct HostState {
+        uint64_t outcomes = 0;  // Bit i set = i-th most recent request failed
+        uint32_t count = 0;
+        CircuitState state = CircuitState::Closed;
+        Clock::time_point open_until;
+        std::chrono::seconds open_for{0};
+    };
+
+    CircuitLimits limits_;
+    std::unordered_map<std::string, HostState> hosts_;
+    size_t open_count_ = 0;
+    mutable std::mutex mutex_;
+
+    void trip(HostState& state, std::chrono::seconds open_for, Clock::time_point now);
+};
+
+#endif // CIRCUIT_BREAKER_H
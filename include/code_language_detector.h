@@ -0,0 +1,74 @@
+#ifndef CODE_LANGUAGE_DETECTOR_H
+#define CODE_LANGUAGE_DETECTOR_H
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Keyword-scoring classifier for code snippets.
+ *
+ * All keywords of all languages are compiled into one case-insensitive
+ * Aho-Corasick automaton, so a snippet is classified in a single pass over
+ * its bytes no matter how many languages or keywords are registered.
+ */
+class CodeLanguageDetector {
+public:
+    CodeLanguageDetector();
+
+    /**
+     * Register a keyword for a language (the language is created on first use).
+     * @param language Language tag written after the code fence, e.g. "python"
+     * @param keyword Literal to look for, matched case-insensitively
+     * @param weight Score added each time the keyword occurs
+     */
+    void add_keyword(const std::string& language, const std::string& keyword, int weight);
+
+    /**
+     * Build the automaton. Must be called after the last add_keyword().
+     */
+    void compile();
+
+    /**
+     * Classify a snippet
+     * @return Language with the highest score, or "" if nothing scored
+     *         at least min_score
+     */
+    std::string detect(const std::string& code_snippet) const;
+
+    void set_min_score(int min_score);
+
+    /**
+     * Shared detector with the built-in language table, compiled once.
+     */
+    static const CodeLanguageDetector& default_detector();
+
+private:
+    static constexpr size_t kAlphabetSize = 64;
+
+    struct Output {
+        uint16_t language;
+        uint16_t length;
+        int weight;
+        bool needs_boundary;  // Keyword starts with a word character
+    };
+
+    struct Keyword {
+        std::string text;
+        uint16_t language;
+        int weight;
+    };
+
+    std::vector<std::string> languages_;
+    std::vector<Keyword> keywords_;
+    std::array<uint8_t, 256> char_class_;
+    std::vector<std::array<uint32_t, kAlphabetSize>> transitions_;
+    std::vector<std::vector<Output>> outputs_;
+    int min_score_;
+    bool compiled_;
+
+    uint16_t language_id(const std::string& language);
+};
+
+#endif // CODE_LANGUAGE_DETECTOR_H
@@ -17,11 +17,26 @@ struct CrawlerConfig {
     bool follow_redirects;
     bool respect_robots_txt;
     bool respect_meta_tags;
+    std::string extraction_mode;  // "full", "main_content"
+    bool learn_templates;         // Skip per-host repeated boilerplate
+    int robots_prefetch_workers;  // Background robots.txt fetchers, 0 = inline
+    std::vector<std::string> strip_query_params;  // Empty = built-in tracking/session list
+    bool sort_query_params;       // Sort query parameters when canonicalizing URLs
+    bool learn_dust_rules;        // Learn and drop per-host parameters that do not change content
+    bool detect_crawler_traps;    // Throttle/block calendars, endless paths, facet explosions
+    bool importance_ordering;     // OPIC-based frontier priorities instead of FIFO
+    bool recrawl;                 // Revisit pages by estimated change rate
+    long recrawl_min_interval;    // Seconds
+    long recrawl_max_interval;    // Seconds
 
     // Output settings
-    std::string output_format;  // "json", "csv", "both"
+    std::string output_format;  // "json", "csv", "parquet", a comma list of these, or "both"
     std::string output_dir;
-    int batch_size;
+    int batch_size;             // Records per write to the current shard
+    long shard_max_mb;          // Start a new shard at this size...
+    long shard_max_seconds;     // ... or after this long
+    std::string compression;    // Parquet codec: "none", "snappy", "gzip", "zstd"
+    int row_group_size;         // Rows per Parquet row group
 
     // URLs to crawl
     std::vector<std::string> urls;
@@ -53,8 +68,20 @@ struct CrawlerConfig {
     CrawlerConfig() 
         : timeout(30), max_retries(3), user_agent("DatasetCrawler/1.0"),
           follow_redirects(true), respect_robots_txt(true),
-          respect_meta_tags(true), output_format("json"),
+          respect_meta_tags(true), extraction_mode("full"),
+          learn_templates(false),
+          robots_prefetch_workers(4),
+          sort_query_params(false),
+          learn_dust_rules(false),
+          detect_crawler_traps(true),
+          importance_ordering(true),
+          recrawl(false),
+          recrawl_min_interval(3600),
+          recrawl_max_interval(30 * 86400),
+          output_format("json"),
           output_dir("./output"), batch_size(1000),
+          shard_max_mb(256), shard_max_seconds(3600),
+          compression("snappy"), row_group_size(5000),
           enable_headless_rendering(false),
           chrome_path("chromium"),
           chrome_timeout_seconds(15),
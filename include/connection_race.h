@@ -0,0 +1,74 @@
+#ifndef CONNECTION_RACE_H
+#define CONNECTION_RACE_H
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "address_cache.h"
+#include "event_loop.h"
+
+/**
+ * Happy Eyeballs connection race over a host's resolved addresses.
+ *
+ * Candidates are started one by one, each kAttemptDelay after the
+ * previous one or as soon as an attempt fails, and all run in parallel;
+ * the first to connect wins and the others are closed. Sockets stay
+ * non-blocking. step() only checks progress; the caller waits on the
+ * event loop for pending() to become writable or next_attempt_at().
+ */
+class ConnectionRace {
+public:
+    // Delay before the next candidate joins the race (RFC 8305 section 5)
+    static constexpr auto kAttemptDelay = std::chrono::milliseconds(250);
+
+    ConnectionRace(EventLoop& loop, std::vector<ResolvedAddress> candidates);
+    ~ConnectionRace();
+
+    ConnectionRace(const ConnectionRace&) = delete;
+    ConnectionRace& operator=(const ConnectionRace&) = delete;
+
+    /**
+     * Advance the race without blocking
+     * @return Connected socket, now owned by the caller, or -1 while
+     *         pending or once every candidate failed (see failed())
+     */
+    int step();
+
+    bool failed() const {
+        return attempts_.empty() && next_ >= candidates_.size();
+    }
+
+    std::vector<int> pending() const;
+
+    /**
+     * When the next candidate joins, time_point::max() if none is left
+     */
+    EventLoop::Clock::time_point next_attempt_at() const;
+
+    const std::string& error() const {
+        return error_;
+    }
+
+    int winner_family() const {
+        return winner_family_;
+    }
+
+private:
+    struct Attempt {
+        int fd;
+        int family;
+    };
+
+    EventLoop& loop_;
+    std::vector<ResolvedAddress> candidates_;
+    size_t next_ = 0;
+    std::vector<Attempt> attempts_;
+    EventLoop::Clock::time_point last_start_;
+    std::string error_ = "no address to connect to";
+    int winner_family_ = AF_UNSPEC;
+
+    bool start_next();
+};
+
+#endif // CONNECTION_RACE_H
@@ -2,6 +2,7 @@
 #define CRAWLER_H
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <memory>
 #include <map>
@@ -12,31 +13,37 @@
 #include <mutex>
 #include <condition_variable>
 #include <atomic>
+#include "byte_buffer.h"
 #include "http_config.h"
+#include "circuit_breaker.h"
 #include "clickhouse_client.h"
+#include "dust_learner.h"
+#include "host_latency.h"
+#include "host_throttle.h"
+#include "importance_estimator.h"
+#include "recrawl_scheduler.h"
+#include "retry_budget.h"
 #include "rocksdb_manager.h"
+#include "robots_cache.h"
+#include "robots_matcher.h"
+#include "robots_prefetcher.h"
 #include "text_extractor.h"
+#include "trap_detector.h"
+#include "url.h"
+#include "url_canonicalizer.h"
 
-/**
- * robots.txt rules for a specific user-agent group
- */
-struct RobotRule {
-    std::vector<std::string> user_agents;
-    std::vector<std::string> disallows;
-    std::vector<std::string> allows;
-    int specificity = 0;  // Higher = more specific (exact match > pattern > wildcard)
-    double crawl_delay_seconds = -1.0;
-};
+class RecordSink;
 
 struct DataRecord {
     std::string url;
     std::string title;
-    std::string content;
+    ByteBuffer content;     // Shares the buffer the page was received into
     std::string timestamp;
     int status_code;
     bool was_allowed;
     size_t content_length;  // Size of downloaded content
     bool was_skipped;       // Whether skipped due to size limit
+    std::string text;       // Extracted text, when text extraction is enabled
 };
 
 /**
@@ -51,6 +58,18 @@ struct CrawlerStats {
     int skipped_by_size = 0;
     int sitemaps_found = 0;
     int duplicates_detected = 0;  // Number of duplicates found by SimHash
+    int dust_rewrites = 0;        // URLs rewritten by learned DUST rules before enqueue
+    int blocked_by_trap = 0;      // URLs kept out of the queue as crawler traps
+    int throttled_by_trap = 0;    // URLs deferred over a throttled prefix's allowance
+    int trap_prefixes = 0;        // Host/path prefixes flagged as traps
+    int recrawls_enqueued = 0;    // Due revisits put back into the queue
+    int pages_changed = 0;        // Refetched pages whose content changed
+    int not_modified = 0;         // Revalidations answered 304, body reused from cache
+    int rate_limited = 0;         // 429/503 responses that paused their host
+    int paused_hosts = 0;         // Hosts currently inside a pause window
+    int open_circuits = 0;        // Hosts whose circuit breaker is open
+    int retries_scheduled = 0;    // Failed fetches put back into the frontier
+    int retries_denied = 0;       // Retries refused by the global retry budget
     int http2_requests = 0;        // Number of requests using HTTP/2
     int http11_requests = 0;       // Number of requests using HTTP/1.1
     int http10_requests = 0;       // Number of requests using HTTP/1.0
@@ -71,11 +90,19 @@ public:
     DataRecord fetch(const std::string& url);
 
     /**
-     * Crawl multiple URLs
+     * Crawl multiple URLs, keeping every record in memory
      */
     std::vector<DataRecord> crawl_urls(const std::vector<std::string>& urls,
                                        bool wait_for_new_urls = false);
 
+    /**
+     * Crawl multiple URLs, pushing records to the sink as they are produced;
+     * the sink is flushed before this returns
+     * @return Number of records pushed
+     */
+    size_t crawl_urls(const std::vector<std::string>& urls, RecordSink& sink,
+                      bool wait_for_new_urls = false);
+
     /**
      * Enqueue a URL for crawling.
      */
@@ -150,9 +177,13 @@ public:
      */
     void enable_deduplication(bool enable);
     bool is_deduplication_enabled() const;
-    uint64_t calculate_simhash(const std::string& content);
+    uint64_t calculate_simhash(std::string_view content);
     int hamming_distance(uint64_t hash1, uint64_t hash2);
-    bool is_duplicate(uint64_t content_hash, int threshold = 3);
+    /**
+     * Whether a page's content matches a page fetched earlier from another
+     * URL; a refetch of the same URL only updates its stored SimHash
+     */
+    bool is_duplicate(const std::string& url, uint64_t content_hash, int threshold = 3);
     int get_duplicates_detected_count() const;
 
     /**
@@ -166,6 +197,83 @@ public:
      */
     void set_headless_rendering(bool enable, const std::string& chrome_path, int timeout_seconds);
 
+    /**
+     * Full-page or main-content text extraction.
+     */
+    void set_extraction_mode(ExtractionMode mode);
+
+    /**
+     * Fill DataRecord::text with the extracted text of each fetched page.
+     */
+    void enable_text_extraction(bool enable);
+
+    /**
+     * Learn per-host page templates and skip them during extraction.
+     * Templates are persisted in RocksDB.
+     */
+    void enable_template_learning(bool enable);
+
+    /**
+     * Learn per-host URL parameters that do not change page content and drop
+     * them before URLs are enqueued. Rules are persisted in RocksDB.
+     */
+    void enable_dust_learning(bool enable);
+
+    /**
+     * Learned DUST rules (dropped parameter names) per host, from RocksDB
+     */
+    std::map<std::string, std::vector<std::string>> get_dust_rules();
+
+    /**
+     * Order discovered URLs by online importance (OPIC cash), link depth and
+     * host diversity instead of discovery time. Seeds still go first.
+     * PageRank stored by the link_graph_rank tool is used when present.
+     */
+    void enable_importance_ordering(bool enable);
+
+    /**
+     * Incremental recrawl: keep per-URL fetch history, estimate each page's
+     * change rate and revisit pages when they are due. Revisits are conditional
+     * GETs with the page's stored ETag/Last-Modified; a 304 reuses the cached body.
+     * @param min_interval_seconds Shortest revisit interval
+     * @param max_interval_seconds Longest revisit interval
+     */
+    void enable_recrawl(bool enable);
+    void set_recrawl_intervals(long min_interval_seconds, long max_interval_seconds);
+
+    /**
+     * Detect crawler traps (deep or repeating paths, exploding parameters,
+     * mostly-duplicate sections) and throttle or block their enqueue.
+     */
+    void enable_trap_detection(bool enable);
+    void set_trap_limits(const TrapLimits& limits);
+
+    /**
+     * Per-host circuit breaker: hosts failing at a high recent rate are
+     * deferred in bulk for a cool-down, then probed with a single request.
+     */
+    void set_circuit_limits(const CircuitLimits& limits);
+
+    /**
+     * Prefixes flagged as traps, with the reason
+     */
+    std::vector<std::string> get_trap_prefixes() const;
+
+    /**
+     * Fetch robots.txt for newly discovered hosts in the background.
+     * URLs of a host wait outside the queue until its robots.txt is loaded.
+     * @param workers Prefetch threads, 0 = fetch robots.txt inline on first use
+     */
+    void set_robots_prefetch_workers(int workers);
+
+    /**
+     * URL canonicalization for the frontier.
+     * @param stripped_params Query/path parameters to drop ("utm_*" style prefixes allowed);
+     *                        empty keeps the built-in tracking and session-id list
+     * @param sort_query Sort remaining query parameters by name
+     */
+    void set_url_canonicalization(const std::vector<std::string>& stripped_params, bool sort_query);
+
     /**
      * ClickHouse metrics/link graph export.
      */
@@ -190,14 +298,24 @@ private:
     // RocksDB and Text Extraction
     std::unique_ptr<RocksDBManager> db_manager_;
     std::unique_ptr<TextExtractor> text_extractor_;
+    bool enable_text_extraction_;
     std::string db_path_;
     
     // Statistics
     int blocked_by_robots_;
     int blocked_by_noindex_;
     int skipped_by_size_;
-    int sitemaps_found_;
+    std::atomic<int> sitemaps_found_;  // Also updated by robots prefetch workers
     int duplicates_detected_;
+    std::atomic<int> dust_rewrites_;
+    std::atomic<int> blocked_by_trap_;
+    std::atomic<int> throttled_by_trap_;
+    std::atomic<int> recrawls_enqueued_;
+    std::atomic<int> pages_changed_;
+    std::atomic<int> not_modified_;
+    std::atomic<int> rate_limited_;
+    std::atomic<int> retries_scheduled_;
+    std::atomic<int> retries_denied_;
     int http2_requests_;
     int http11_requests_;
     int http10_requests_;
@@ -205,6 +323,7 @@ private:
     long total_duration_ms_;
     std::vector<long> request_durations_;  // For calculating avg
     long last_request_duration_ms_;
+    long last_retry_after_seconds_;  // Retry-After of the last response, -1 if absent
     double latency_ema_ms_;
     int consecutive_failures_;
     int consecutive_successes_;
@@ -212,12 +331,34 @@ private:
     std::chrono::steady_clock::time_point last_request_time_;
     std::string current_domain_;
     
-    std::map<std::string, bool> robots_cache_;
-    std::map<std::string, std::vector<std::string>> robots_sitemaps_cache_;
-    std::map<std::string, std::vector<RobotRule>> robots_rules_cache_;  // Cache parsed robots.txt rules
-    std::map<std::string, double> robots_crawl_delay_cache_;
-    std::map<std::string, std::chrono::steady_clock::time_point> robots_cache_time_;
-    std::map<std::string, std::chrono::steady_clock::time_point> robots_sitemaps_cache_time_;
+    RobotsCache robots_cache_;  // Compiled robots.txt rules and sitemaps per domain
+    UrlCanonicalizer url_canonicalizer_;
+    bool enable_dust_learning_;
+    DustLearner dust_learner_;
+    bool enable_trap_detection_;
+    TrapDetector trap_detector_;
+    bool enable_importance_ordering_;
+    ImportanceEstimator importance_;  // OPIC cash of queued URLs
+    bool enable_recrawl_;
+    RecrawlScheduler recrawl_scheduler_;
+    std::chrono::steady_clock::time_point last_recrawl_poll_;
+    
+    // Hosts answering 429/503 are paused; their URLs are deferred in RocksDB meanwhile
+    HostThrottle host_throttle_;
+    
+    // Failing hosts are deferred by the circuit breaker; failed fetches are
+    // retried through the frontier within a global budget
+    CircuitBreaker circuit_breaker_;
+    RetryBudget retry_budget_;
+    std::unordered_map<std::string, int> retry_attempts_;  // Normalized URL -> retries so far
+    HostLatencyTracker host_latency_;  // Per-host latency histograms behind adaptive timeouts
+    
+    // Robots prefetch: URLs parked per host until its robots.txt is cached
+    int robots_prefetch_workers_;
+    RobotsPrefetcher robots_prefetcher_;
+    std::unordered_map<std::string, std::vector<std::pair<std::string, int>>> parked_urls_;
+    std::unordered_set<std::string> deferred_hosts_;  // Hosts on hold with URLs deferred in RocksDB
+    mutable std::mutex parked_mutex_;
     std::chrono::steady_clock::time_point crawl_start_time_;
     
     // Memory-efficient caches using STL hash containers
@@ -231,7 +372,7 @@ private:
     
     // Deduplication
     bool enable_deduplication_;
-    std::vector<uint64_t> content_hashes_;  // Store SimHashes for deduplication
+    std::vector<std::pair<size_t, uint64_t>> content_hashes_;  // (URL hash, SimHash) of fetched pages
     std::mutex dedup_mutex_;
 
     // Headless rendering
@@ -255,7 +396,9 @@ private:
     void stats_reporter_loop();
     std::string format_stats_message(const CrawlerStats& stats);
 
-    std::string fetch_html(const std::string& url, int& status_code);
+    ByteBuffer fetch_html(const std::string& url, int& status_code,
+                          const HttpValidators* conditional = nullptr,
+                          HttpValidators* validators = nullptr);
     std::string fetch_headless_html(const std::string& url, int& status_code, std::string& error_message);
     bool should_stop() const;
     bool ensure_db_initialized();
@@ -266,25 +409,49 @@ private:
                                const std::string& content_type,
                                const std::string& error_message);
     void report_link_edge(const std::string& from_url, const std::string& to_url);
-    std::string extract_title(const std::string& html);
+    std::string extract_title(std::string_view html);
     bool check_robots_txt(const std::string& url);
-    bool check_meta_tags(const std::string& html);
+    bool check_meta_tags(std::string_view html);
     std::string get_domain(const std::string& url);
+    std::string get_domain(const Url& url);
     std::vector<std::string> extract_sitemap_urls_from_robots(const std::string& robots_content);
     std::vector<std::string> parse_sitemap_xml(const std::string& xml_content);
     
     // Link extraction and normalization
-    std::vector<std::string> extract_links_from_html(const std::string& html, const std::string& base_url);
+    std::vector<std::string> extract_links_from_html(std::string_view html, const std::string& base_url);
     std::string normalize_url(const std::string& url);
     std::string resolve_relative_url(const std::string& base_url, const std::string& relative_url);
-    std::string extract_canonical_url(const std::string& html, const std::string& base_url);
+    std::string extract_canonical_url(std::string_view html, const std::string& base_url);
     bool is_valid_url(const std::string& url);
+    bool is_valid_url(const Url& url);
     
     // Encoding detection and conversion
-    std::string detect_encoding(const std::string& content, const std::string& content_type);
-    std::string convert_to_utf8(const std::string& content, const std::string& from_encoding);
+    std::string detect_encoding(std::string_view content, const std::string& content_type);
+    std::string convert_to_utf8(std::string_view content, const std::string& from_encoding);
     void apply_adaptive_delay(int status_code);
     double get_crawl_delay_for_domain(const std::string& domain) const;
+    RobotsMatcher compile_robots_rules(const std::vector<RobotRule>& rules) const;
+    std::shared_ptr<const RobotsEntry> robots_entry(const std::string& domain);
+    std::string fetch_robots_txt(const std::string& domain, int& status_code);
+    bool admit_url(const std::string& url, int priority);
+    void record_fetch_history(const std::string& url, uint64_t fingerprint, bool not_modified = false);
+    void remember_page(const std::string& page_key, const DataRecord& record, const HttpValidators& validators);
+    void enqueue_due_recrawls();
+    void release_parked_urls(const std::string& domain);
+    void park_url(const std::string& domain, const std::string& url, int priority);
+    bool pause_rate_limited_host(const std::string& url, const std::string& normalized, int status_code,
+                                 int priority, const ImportanceEstimator::Credit& credit);
+    void resume_paused_hosts();
+    bool host_on_hold(const std::string& domain) const;
+    HostTimeouts request_timeouts(const std::string& domain);
+    bool retry_failed_url(const std::string& url, const std::string& normalized, int status_code,
+                          int priority, const ImportanceEstimator::Credit& credit);
+    bool has_parked_urls() const;
+    std::shared_ptr<const RobotsEntry> load_robots_entry(const std::string& domain);
+    std::shared_ptr<const RobotsEntry> build_robots_entry(const std::string& domain,
+                                                          int status_code,
+                                                          const std::string& robots_content,
+                                                          std::chrono::system_clock::time_point fetched_at);
     std::vector<std::string> parse_sitemap_index_xml(const std::string& xml_content);
 };
 
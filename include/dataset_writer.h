@@ -2,6 +2,8 @@
 #define DATASET_WRITER_H
 
 #include "crawler.h"
+#include "parquet_file_writer.h"
+#include <ostream>
 #include <vector>
 #include <string>
 #include <memory>
@@ -12,7 +14,7 @@ public:
     ~ParquetDatasetWriter();
 
     /**
-     * Write records to JSON file (with .json extension)
+     * Write records to a JSON file, or to Parquet for a .parquet path
      */
     void write_records(const std::string& filepath, const std::vector<DataRecord>& records);
 
@@ -26,11 +28,35 @@ public:
      */
     void write_csv(const std::string& filepath, const std::vector<DataRecord>& records);
 
+    /**
+     * Write records to a Parquet file
+     */
+    void write_parquet(const std::string& filepath, const std::vector<DataRecord>& records);
+
+    /**
+     * Compression and row-group size used by write_parquet()
+     */
+    void set_parquet_options(const ParquetWriterOptions& options);
+
+    /**
+     * Append records to a JSON array being streamed out; all but the first
+     * record of the array are preceded by a comma
+     */
+    void write_json_rows(std::ostream& out, const std::vector<DataRecord>& records, bool first);
+
+    /**
+     * Streaming CSV output: the header line, then any number of row batches
+     */
+    void write_csv_header(std::ostream& out);
+    void write_csv_rows(std::ostream& out, const std::vector<DataRecord>& records);
+
 private:
     void write_json_internal(const std::string& filepath, 
                             const std::vector<DataRecord>& records);
     
     std::string escape_json(const std::string& value);
+
+    ParquetWriterOptions parquet_options_;
 };
 
 #endif // DATASET_WRITER_H
@@ -0,0 +1,138 @@
+#ifndef DUST_LEARNER_H
+#define DUST_LEARNER_H
+
+#include "url.h"
+#include "url_canonicalizer.h"
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Learns per-host query parameters that do not change page content
+ * (DUST: different URLs with similar text).
+ *
+ * Every fetched page is recorded with its content fingerprint under the
+ * hashes of "the URL without parameter p", for each of its parameters, and
+ * of the URL itself. Two pages that meet under the same key differ only in
+ * p (its value, or whether it is present), so comparing their fingerprints
+ * is one piece of evidence about p. A parameter with at least min_support
+ * agreeing pairs and min_confidence agreement becomes a drop rule, which
+ * rewrite() applies to URLs of that host before they are enqueued.
+ *
+ * Hosts are kept in a bounded LRU cache, which only observe() adds to.
+ * Parameter statistics are handed to the persistence callbacks whenever a
+ * rule is learned, so rules survive eviction and restarts; the stored form
+ * is one "name agree disagree" line per parameter, with a leading '-' on
+ * dropped names. rewrite() of a host that is not being learned reads its
+ * stored rules, outside the lock, into a second bounded cache that holds
+ * only the rewriter, so merely linked-to hosts never evict learning ones.
+ */
+class DustLearner {
+public:
+    using Loader = std::function<std::string(const std::string& host)>;
+    using Saver = std::function<void(const std::string& host, const std::string& data)>;
+
+    explicit DustLearner(size_t max_hosts = 4096);
+
+    /**
+     * Agreeing page pairs needed before a parameter is dropped (default 5)
+     */
+    void set_min_support(size_t pairs);
+
+    /**
+     * Share of agreeing pairs needed before a parameter is dropped (default 0.95)
+     */
+    void set_min_confidence(double confidence);
+
+    /**
+     * Persist learned rules, e.g. in RocksDB
+     */
+    void set_persistence(Loader loader, Saver saver);
+
+    /**
+     * Record a fetched page
+     * @param url Canonical URL of the page
+     * @param fingerprint SimHash of the page content
+     * @return true if a new rule was learned for the page's host
+     */
+    bool observe(const Url& url, uint64_t fingerprint);
+
+    /**
+     * Drop the host's learned parameters from a URL
+     * @return true if the URL changed
+     */
+    bool rewrite(Url& url);
+
+    /**
+     * Parameter names dropped for a host, sorted. A host that is not cached
+     * is read through the loader without entering the cache, so listing
+     * many hosts does not evict the ones being crawled.
+     */
+    std::vector<std::string> rules(const std::string& host);
+
+    /**
+     * Parameter names dropped in a host's stored rules, sorted
+     */
+    static std::vector<std::string> dropped_parameters(const std::string& data);
+
+private:
+    static constexpr size_t kMaxSamplesPerHost = 50000;
+    static constexpr size_t kMaxSamplesPerKey = 4;
+    static constexpr int kSameContentBits = 3;  // SimHash distance for "same page"
+
+    struct ParamStat {
+        uint32_t agree = 0;
+        uint32_t disagree = 0;
+        bool dropped = false;
+    };
+
+    struct Sample {
+        uint64_t param = 0;   // Hash of the parameter name, 0 for the URL itself
+        uint64_t value = 0;   // Hash of the parameter value
+        uint64_t fingerprint = 0;
+    };
+
+    struct HostRules {
+        std::unordered_map<std::string, ParamStat> params;
+        std::unordered_map<uint64_t, std::string> names;  // Sample::param -> name
+        std::unordered_map<uint64_t, std::vector<Sample>> samples;
+        size_t sample_count = 0;
+        UrlCanonicalizer rewriter;  // Strips the dropped parameters
+        bool has_rules = false;
+        std::list<std::string>::iterator lru_position;
+    };
+
+    // Stored rules of a host that is not being learned; no rewriter if it has none
+    struct StoredRules {
+        std::shared_ptr<const UrlCanonicalizer> rewriter;
+        std::list<std::string>::iterator lru_position;
+    };
+
+    size_t max_hosts_;
+    size_t min_support_;
+    double min_confidence_;
+    Loader loader_;
+    Saver saver_;
+    std::unordered_map<std::string, HostRules> hosts_;
+    std::list<std::string> lru_;  // Most recently used first
+    std::unordered_map<std::string, StoredRules> stored_;
+    std::list<std::string> stored_lru_;
+    std::mutex mutex_;
+
+    HostRules& lookup(const std::string& host);
+    std::shared_ptr<const UrlCanonicalizer> load_rewriter(const std::string& host, const Loader& loader);
+    void forget_stored(const std::string& host);
+    bool record(HostRules& entry, const std::string& name, bool same_content);
+    void rebuild_rewriter(HostRules& entry);
+
+    static std::vector<std::string> dropped_names(const HostRules& entry);
+    static std::string serialize(const HostRules& entry);
+    static void deserialize(const std::string& data, HostRules& entry);
+};
+
+#endif // DUST_LEARNER_H
@@ -0,0 +1,194 @@
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#include <chrono>
+#include <coroutine>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "http_config.h"
+#include "io_uring_queue.h"
+#include "task.h"
+
+/**
+ * Single-threaded event loop that resumes coroutines on socket readiness,
+ * completed receives or deadlines.
+ *
+ * A coroutine co_awaits readable(), writable() or sleep_until(); the
+ * awaiter parks its handle here and evaluates to true when the socket
+ * became ready and false when the deadline passed first. receive() reads
+ * from a plain socket.
+ *
+ * Two backends, chosen at construction:
+ * - io_uring: readiness polls and receives (with linked timeouts for
+ *   their deadlines) are queued without syscalls and submitted in one
+ *   batch by the io_uring_enter that also waits, so a receive usually
+ *   costs a fraction of a syscall under load.
+ * - epoll: one-shot registrations, so an idle socket costs nothing and
+ *   each wait is one epoll_ctl; receive() is readiness plus recv().
+ * Thousands of concurrent fetches cost one coroutine frame each; the loop
+ * itself keeps only the parked waiters. A task must not be destroyed
+ * while it is parked here.
+ */
+class EventLoop {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit EventLoop(IoBackend backend = IoBackend::Auto);
+    ~EventLoop();
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    class Wait {
+    public:
+        Wait(EventLoop& loop, std::vector<int> fds, uint32_t events, Clock::time_point deadline)
+            : loop_(loop), fds_(std::move(fds)), events_(events), deadline_(deadline) {}
+
+        bool await_ready() const noexcept {
+            return false;
+        }
+
+        void await_suspend(std::coroutine_handle<> handle) {
+            handle_ = handle;
+            loop_.park(this);
+        }
+
+        bool await_resume() const noexcept {
+            return ready_;
+        }
+
+    private:
+        friend class EventLoop;
+
+        EventLoop& loop_;
+        std::vector<int> fds_;
+        uint32_t events_;
+        Clock::time_point deadline_;
+        std::coroutine_handle<> handle_;
+        std::multimap<Clock::time_point, Wait*>::iterator timer_;
+        bool ready_ = false;
+    };
+
+    /**
+     * Backend actually in use: Epoll or IoUring
+     */
+    IoBackend backend() const {
+        return ring_ ? IoBackend::IoUring : IoBackend::Epoll;
+    }
+
+    /**
+     * Suspend until the socket is readable (or closed) or the deadline passes
+     */
+    Wait readable(int fd, Clock::time_point deadline);
+
+    /**
+     * Suspend until the socket is writable (or failed) or the deadline passes
+     */
+    Wait writable(int fd, Clock::time_point deadline);
+
+    /**
+     * Suspend until any of the sockets is writable or the deadline passes
+     */
+    Wait any_writable(std::vector<int> fds, Clock::time_point deadline);
+
+    Wait sleep_until(Clock::time_point deadline);
+
+    /**
+     * Receive from a non-blocking plain socket
+     * @return Bytes received, 0 once the peer closed, -ETIME when the
+     *         deadline passed first, other -errno on failure
+     */
+    Task<long> receive(int fd, char* buffer, size_t size, Clock::time_point deadline);
+
+    /**
+     * Drop the loop's state for a socket; call before closing it
+     */
+    void forget(int fd);
+
+    /**
+     * Wait for events once and resume the coroutines they wake
+     * @return False when nothing is parked, so nothing could ever resume
+     */
+    bool run_once();
+
+    /**
+     * Drive the loop until finished() holds or nothing is left to wait for
+     */
+    void run(const std::function<bool()>& finished);
+
+    /**
+     * Start a task and drive the loop until it completes
+     * @return Its result, or T() if it stalled with nothing left to wait for
+     */
+    template <typename T>
+    T run(Task<T> task) {
+        task.start();
+        run([&task]() { return task.done(); });
+        return task.done() ? task.result() : T();
+    }
+
+    size_t parked() const {
+        return parked_;
+    }
+
+private:
+    // One io_uring receive in flight; its address is the completion's user_data
+    class RingReceive {
+    public:
+        RingReceive(EventLoop& loop, int fd, char* buffer, size_t size, Clock::time_point deadline)
+            : loop_(loop), fd_(fd), buffer_(buffer), size_(size), deadline_(deadline) {}
+
+        bool await_ready() const noexcept {
+            return false;
+        }
+
+        void await_suspend(std::coroutine_handle<> handle);
+
+        long await_resume() const noexcept {
+            return result_;
+        }
+
+    private:
+        friend class EventLoop;
+
+        EventLoop& loop_;
+        int fd_;
+        char* buffer_;
+        size_t size_;
+        Clock::time_point deadline_;
+        std::coroutine_handle<> handle_;
+        long result_ = 0;
+    };
+
+    struct Watch {
+        bool registered = false;  // epoll: known to epoll, armed or not
+        uint64_t read_poll = 0;   // io_uring: tokens of the polls in flight, 0 if none
+        uint64_t write_poll = 0;
+        Wait* reader = nullptr;
+        Wait* writer = nullptr;
+    };
+
+    int epoll_fd_ = -1;
+    std::unique_ptr<IoUringQueue> ring_;
+    uint64_t next_poll_ = 0;
+    std::unordered_map<int, Watch> watches_;
+    std::multimap<Clock::time_point, Wait*> timers_;
+    std::vector<Wait*> failed_;  // Could not be armed; resumed on the next run_once()
+    std::vector<RingReceive*> failed_receives_;
+    size_t parked_ = 0;
+
+    void park(Wait* wait);
+    bool arm(int fd, Watch& watch);
+    bool arm_epoll(int fd, Watch& watch);
+    bool arm_ring(int fd, Watch& watch);
+    void unpark(Wait* wait, bool ready, std::vector<std::coroutine_handle<>>& wake);
+    void wait_events(int timeout_ms, std::vector<std::coroutine_handle<>>& wake);
+    void on_ready(int fd, bool readable, bool writable, std::vector<std::coroutine_handle<>>& wake);
+};
+
+#endif // EVENT_LOOP_H
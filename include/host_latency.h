@@ -0,0 +1,105 @@
+#ifndef HOST_LATENCY_H
+#define HOST_LATENCY_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+/**
+ * Request phases whose latency is tracked per host
+ */
+enum class LatencyMetric {
+    Connect,    // TCP connect (and TLS handshake for https)
+    FirstByte,  // Request sent to first response byte
+    Total       // Whole request
+};
+
+/**
+ * Deadlines for one request
+ */
+struct HostTimeouts {
+    std::chrono::milliseconds connect;
+    std::chrono::milliseconds idle;   // Longest wait for the next bytes once connected
+    std::chrono::milliseconds total;
+};
+
+/**
+ * How timeouts are derived from a host's latency percentiles
+ */
+struct TimeoutPolicy {
+    double percentile = 0.99;
+    double multiplier = 3.0;
+    size_t min_samples = 5;  // Below this a host gets the defaults
+    std::chrono::milliseconds min_connect = std::chrono::milliseconds(1000);
+    std::chrono::milliseconds min_idle = std::chrono::milliseconds(2000);
+    std::chrono::milliseconds min_total = std::chrono::milliseconds(5000);
+};
+
+/**
+ * Per-host latency histograms and the timeouts derived from them.
+ *
+ * Each host keeps log-scale histograms (four buckets per doubling) of
+ * connect time, time to first byte and total time. Once a host has
+ * min_samples requests its deadlines become percentile x multiplier of the
+ * matching histogram, clamped between the policy minimum and the
+ * defaults: connect from connect time, idle from time to first byte (the
+ * longest silence in a normal response), total from total time. Counts are
+ * halved every kDecayAt samples so the histograms follow a host that
+ * slows down or recovers. Hosts live in a bounded LRU cache.
+ */
+class HostLatencyTracker {
+public:
+    explicit HostLatencyTracker(const TimeoutPolicy& policy = TimeoutPolicy(), size_t max_hosts = 4096);
+
+    void set_policy(const TimeoutPolicy& policy);
+
+    /**
+     * Record the phases of a request; negative values were not measured.
+     * A phase cut off by its deadline is recorded as the time it was
+     * given: a lower bound, without which deadlines could only shrink.
+     */
+    void record(const std::string& host, long connect_ms, long first_byte_ms, long total_ms);
+
+    /**
+     * Deadlines for the next request to a host
+     * @param defaults Used as-is for unknown hosts and as the upper bound otherwise
+     */
+    HostTimeouts timeouts(const std::string& host, const HostTimeouts& defaults);
+
+    /**
+     * Latency percentile in milliseconds (bucket upper bound), -1 without samples
+     */
+    long percentile(const std::string& host, LatencyMetric metric, double p);
+
+private:
+    static constexpr size_t kBuckets = 80;  // Up to about 15 minutes
+    static constexpr uint32_t kDecayAt = 512;
+
+    struct Histogram {
+        std::array<uint32_t, kBuckets> counts{};
+        uint32_t total = 0;
+
+        void add(long ms);
+        long percentile(double p) const;
+    };
+
+    struct HostStats {
+        Histogram metrics[3];
+        std::list<std::string>::iterator lru_position;
+    };
+
+    TimeoutPolicy policy_;
+    size_t max_hosts_;
+    std::unordered_map<std::string, HostStats> hosts_;
+    std::list<std::string> lru_;  // Most recently used first
+    std::mutex mutex_;
+
+    static size_t bucket_of(long ms);
+    static long bucket_upper_ms(size_t bucket);
+};
+
+#endif // HOST_LATENCY_H
@@ -0,0 +1,77 @@
+#ifndef HOST_THROTTLE_H
+#define HOST_THROTTLE_H
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Per-host pause windows for rate-limited hosts (429 / 503).
+ *
+ * A host's window lasts for its Retry-After delay when the server sent
+ * one; otherwise it starts at the default pause and doubles with each
+ * rate-limited response in a row, up to the cap. A successful response
+ * resets the streak. Only the paused host is held back: the crawler parks
+ * its URLs and releases them when expire() reports the window over.
+ */
+class HostThrottle {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit HostThrottle(std::chrono::seconds default_pause = std::chrono::seconds(10),
+                          std::chrono::seconds max_pause = std::chrono::seconds(3600));
+
+    void set_limits(std::chrono::seconds default_pause, std::chrono::seconds max_pause);
+
+    /**
+     * Record a rate-limited response and pause the host
+     * @param retry_after_seconds Parsed Retry-After, or -1 if absent
+     * @return Length of the pause window
+     */
+    std::chrono::seconds rate_limited(const std::string& host, long retry_after_seconds,
+                                      Clock::time_point now);
+
+    /**
+     * Record a successful response, ending the host's streak
+     */
+    void succeeded(const std::string& host);
+
+    bool is_paused(const std::string& host, Clock::time_point now) const;
+
+    /**
+     * Rate-limited responses in a row for a host
+     */
+    int strikes(const std::string& host) const;
+
+    /**
+     * Remove windows that have ended
+     * @return Hosts whose window ended, to be resumed
+     */
+    std::vector<std::string> expire(Clock::time_point now);
+
+    size_t paused_hosts() const;
+
+    /**
+     * Drop every window, e.g. when the crawl ends
+     */
+    void clear();
+
+private:
+    static constexpr int kMaxDoublings = 8;
+
+    struct HostState {
+        Clock::time_point resume_at;
+        int strikes = 0;
+        bool paused = false;
+    };
+
+    std::chrono::seconds default_pause_;
+    std::chrono::seconds max_pause_;
+    std::unordered_map<std::string, HostState> hosts_;
+    size_t paused_count_ = 0;
+    mutable std::mutex mutex_;
+};
+
+#endif // HOST_THROTTLE_H
@@ -2,6 +2,8 @@
 #define HTTP_CONFIG_H
 
 #include <string>
+#include <ctime>
+#include <cstring>
 #include <curl/curl.h>
 
 /**
@@ -10,6 +12,15 @@
  * Uses BoringSSL for TLS operations
  */
 
+/**
+ * Readiness and receive backend of the raw-socket event loop
+ */
+enum class IoBackend {
+    Auto,     // io_uring when the kernel supports it, else epoll
+    Epoll,
+    IoUring   // Falls back to epoll (with a warning) when unavailable
+};
+
 struct HTTPConfig {
     bool enable_http2 = true;      // Enable HTTP/2 (falls back to HTTP/1.1)
     bool enable_http_keep_alive = true;
@@ -18,8 +29,13 @@ struct HTTPConfig {
     int tcp_keepalive_idle = 120;  // Seconds
     int tcp_keepalive_interval = 60; // Seconds
     bool use_raw_sockets = true;   // Use raw-socket HTTP/1.1 fetch for http://
-    int max_retries = 2;           // Auto-retries for fetch failures
-    int retry_backoff_ms = 200;    // Base backoff between retries
+    IoBackend io_backend = IoBackend::Epoll; // Event loop backend of the raw-socket fetch
+    int max_retries = 2;           // Retries per URL, rescheduled through the frontier
+    int retry_backoff_ms = 200;    // Base backoff between inline retries (robots.txt fetches)
+    double retry_budget_ratio = 0.1; // Retries allowed per request, across all hosts
+    bool enable_adaptive_timeouts = true;   // Per-host deadlines from latency percentiles
+    int connect_timeout_ms = 10000;         // Connect deadline for hosts without history
+    double adaptive_timeout_multiplier = 3.0; // Deadline = p99 latency x multiplier
     bool enable_adaptive_delay = true; // Enable adaptive delay between requests
     int min_delay_ms = 50;         // Minimum adaptive delay
     int max_delay_ms = 2000;       // Maximum adaptive delay
@@ -28,11 +44,64 @@ struct HTTPConfig {
     int failure_backoff_ms = 250;  // Extra backoff per failure streak
     int jitter_pct = 10;           // Random jitter percentage applied to delay
     double max_qps = 0.0;          // Global QPS cap (0 = disabled)
-    int robots_cache_ttl_seconds = 3600;  // TTL for robots cache
-    int sitemaps_cache_ttl_seconds = 3600; // TTL for sitemap cache
+    int robots_cache_ttl_seconds = 3600;  // TTL for robots cache (memory and RocksDB)
+    int robots_cache_max_hosts = 100000;  // Hosts kept in the in-memory robots cache
     int max_redirects = 5;         // Max redirects to follow in raw socket fetch
+    int rate_limit_pause_seconds = 10;   // Host pause after 429/503 without Retry-After (doubles per repeat)
+    int max_retry_after_seconds = 3600;  // Cap on any per-host pause window
+};
+
+/**
+ * Cache validators of a response, sent back as If-None-Match and
+ * If-Modified-Since when the URL is refetched
+ */
+struct HttpValidators {
+    std::string etag;
+    std::string last_modified;
+
+    bool empty() const {
+        return etag.empty() && last_modified.empty();
+    }
 };
 
+/**
+ * Parse a Retry-After header value, given either as delay-seconds or as an
+ * HTTP-date (IMF-fixdate, RFC 850 or asctime form)
+ * @param now Current time, to turn a date into a delay
+ * @return Delay in seconds (0 for dates in the past), or -1 if unparseable
+ */
+inline long parse_retry_after(const std::string& value, std::time_t now) {
+    size_t start = value.find_first_not_of(" \t");
+    if (start == std::string::npos) {
+        return -1;
+    }
+    size_t end = value.find_last_not_of(" \t\r\n");
+    std::string trimmed = value.substr(start, end - start + 1);
+
+    if (trimmed.find_first_not_of("0123456789") == std::string::npos) {
+        if (trimmed.size() > 9) {
+            return 999999999L;  // Absurdly long; callers cap it anyway
+        }
+        return std::stol(trimmed);
+    }
+
+    static const char* const kDateFormats[] = {
+        "%a, %d %b %Y %H:%M:%S GMT",  // IMF-fixdate
+        "%A, %d-%b-%y %H:%M:%S GMT",  // RFC 850
+        "%a %b %d %H:%M:%S %Y"        // asctime
+    };
+    for (const char* format : kDateFormats) {
+        struct tm parsed;
+        std::memset(&parsed, 0, sizeof(parsed));
+        const char* rest = strptime(trimmed.c_str(), format, &parsed);
+        if (rest && *rest == '\0') {
+            std::time_t when = timegm(&parsed);
+            return when > now ? static_cast<long>(when - now) : 0;
+        }
+    }
+    return -1;
+}
+
 enum class HTTPVersion {
     HTTP_1_0,
     HTTP_1_1,
@@ -0,0 +1,103 @@
+#ifndef IMPORTANCE_ESTIMATOR_H
+#define IMPORTANCE_ESTIMATOR_H
+
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Online page-importance estimate for the crawl frontier (OPIC: On-line
+ * Page Importance Computation).
+ *
+ * Every page holds "cash". When a page is fetched its cash is split evenly
+ * among its not-yet-crawled outlinks, so URLs linked from many important
+ * pages accumulate cash while they wait in the queue. A URL's priority
+ * combines log2 of its cash with a depth penalty (links from the nearest
+ * seed) and a host penalty (URLs of the same host already queued), and is
+ * quantized into kLevels queue priorities, best first. When an offline
+ * PageRank is available (see tools/link_graph_rank.cpp), log2 of the stored
+ * rank, scaled so the average page has rank 1, is added to the score.
+ *
+ * Only queued URLs are tracked; a URL the estimator does not know (a seed,
+ * or one enqueued through the API) is credited like a seed when fetched.
+ */
+class ImportanceEstimator {
+public:
+    static constexpr int kFirstPriority = 1;  // Priority 0 stays reserved for seeds
+    static constexpr int kLevels = 64;
+
+    /**
+     * Cash and depth a fetched page hands on to its outlinks
+     */
+    struct Credit {
+        double cash = 1.0;
+        int depth = 0;
+    };
+
+    explicit ImportanceEstimator(size_t max_tracked = 1000000);
+
+    /**
+     * Score penalty per link of depth and per doubling of a host's queued URLs
+     * (defaults 0.5 and 1.0; one unit of score is one doubling of cash)
+     */
+    void set_weights(double depth_weight, double host_weight);
+
+    /**
+     * Stored link-graph rank of a URL (average page = 1, 0 = unknown)
+     */
+    using RankLookup = std::function<double(const std::string& url)>;
+    void set_rank_lookup(RankLookup lookup);
+
+    /**
+     * Remove a page from the frontier when it is dequeued
+     */
+    Credit take(const std::string& url);
+
+    /**
+     * Give back the credit of a page taken from the frontier that goes back
+     * to the queue unfetched (retried, or its host paused)
+     */
+    void restore(const std::string& url, const Credit& credit, int priority);
+
+    /**
+     * Split a fetched page's cash among its uncrawled outlinks
+     */
+    void distribute(const Credit& credit, const std::vector<std::string>& links);
+
+    /**
+     * Queue priority for a URL about to be enqueued
+     * @return Priority in [kFirstPriority, kFirstPriority + kLevels), or -1 when
+     *         the URL is already queued at that priority or better
+     */
+    int claim_priority(const std::string& url);
+
+    /**
+     * Current cash of a queued URL (0 if untracked)
+     */
+    double cash(const std::string& url) const;
+
+private:
+    struct PageState {
+        double cash = 0.0;
+        int depth = 0;
+        double rank = 1.0;         // Offline PageRank, average page = 1
+        int queued_priority = -1;  // -1 = not queued yet
+        std::string host;
+    };
+
+    size_t max_tracked_;
+    double depth_weight_;
+    double host_weight_;
+    RankLookup rank_lookup_;
+    std::unordered_map<std::string, PageState> pages_;
+    std::unordered_map<std::string, size_t> queued_per_host_;
+    mutable std::mutex mutex_;
+
+    int priority_for(const PageState& page) const;
+    PageState* track(const std::string& url, int depth, double rank);
+    std::vector<double> lookup_ranks(const std::vector<std::string>& urls);
+};
+
+#endif // IMPORTANCE_ESTIMATOR_H
@@ -0,0 +1,90 @@
+#ifndef IO_URING_QUEUE_H
+#define IO_URING_QUEUE_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include <linux/io_uring.h>
+
+/**
+ * Minimal io_uring submission/completion queue pair, on raw syscalls.
+ *
+ * Operations are queued into the shared submission ring without a syscall
+ * and submitted together by the next wait(), which also reaps completions
+ * in the same io_uring_enter. create() returns nullptr when the kernel
+ * lacks io_uring (or the features used here, Linux 5.11+) or forbids it,
+ * so callers can fall back to epoll.
+ */
+class IoUringQueue {
+public:
+    struct Completion {
+        uint64_t user_data;
+        int32_t result;  // Bytes or poll mask on success, -errno on failure
+    };
+
+    static std::unique_ptr<IoUringQueue> create(unsigned entries);
+
+    ~IoUringQueue();
+
+    IoUringQueue(const IoUringQueue&) = delete;
+    IoUringQueue& operator=(const IoUringQueue&) = delete;
+
+    /**
+     * One-shot readiness poll (POLLIN/POLLOUT mask)
+     */
+    bool poll(int fd, uint32_t events, uint64_t user_data);
+
+    /**
+     * Cancel the poll queued with target_user_data; completes it with -ECANCELED
+     */
+    bool poll_remove(uint64_t target_user_data);
+
+    /**
+     * recv() into buffer, cancelled with -ECANCELED if the (steady clock)
+     * deadline passes first; the linked timeout's own completion carries
+     * user_data 0
+     */
+    bool recv(int fd, void* buffer, size_t size, uint64_t user_data,
+              std::chrono::steady_clock::time_point deadline);
+
+    /**
+     * Submit everything queued and wait up to timeout_ms (-1 = no limit)
+     * for completions, appending them to completions
+     * @return False if io_uring_enter failed for a reason other than a timeout or signal
+     */
+    bool wait(int timeout_ms, std::vector<Completion>& completions);
+
+private:
+    IoUringQueue() = default;
+
+    bool reserve(unsigned count);
+    struct io_uring_sqe* next_sqe();
+    bool submit_pending(unsigned wait_for, int timeout_ms);
+    void reap(std::vector<Completion>& completions);
+
+    int ring_fd_ = -1;
+    void* ring_ = nullptr;
+    size_t ring_size_ = 0;
+    struct io_uring_sqe* sqes_ = nullptr;
+    size_t sqes_size_ = 0;
+
+    unsigned* sq_head_ = nullptr;
+    unsigned* sq_tail_ = nullptr;
+    unsigned* sq_array_ = nullptr;
+    unsigned sq_mask_ = 0;
+    unsigned sq_entries_ = 0;
+    unsigned local_tail_ = 0;  // Queued but not yet published to the kernel
+
+    unsigned* cq_head_ = nullptr;
+    unsigned* cq_tail_ = nullptr;
+    unsigned cq_mask_ = 0;
+    struct io_uring_cqe* cqes_ = nullptr;
+
+    std::deque<struct __kernel_timespec> timeouts_;  // Read by the kernel at submission
+};
+
+#endif // IO_URING_QUEUE_H
@@ -0,0 +1,85 @@
+#ifndef LINK_GRAPH_H
+#define LINK_GRAPH_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * In-memory link graph for offline analytics (PageRank, in-degree, host graph).
+ *
+ * URLs are interned into dense 32-bit IDs backed by a chunked arena, and
+ * edges are collected as (from, to) pairs. finalize() turns them into a
+ * CSR of incoming edges plus out-degrees, which is what a pull-based
+ * PageRank reads; the edge list is released afterwards.
+ */
+class LinkGraph {
+public:
+    LinkGraph();
+
+    /**
+     * ID of a URL, interning it on first sight
+     */
+    uint32_t add_node(std::string_view url);
+
+    /**
+     * Add a link; self-links are ignored. Call before finalize().
+     */
+    void add_edge(uint32_t from, uint32_t to);
+
+    /**
+     * Build the incoming-edge CSR (parallel counting sort).
+     * URLs can no longer be added afterwards.
+     */
+    void finalize(size_t threads);
+
+    size_t node_count() const;
+    size_t edge_count() const;
+    std::string_view url(uint32_t id) const;
+    uint32_t in_degree(uint32_t id) const;
+    uint32_t out_degree(uint32_t id) const;
+
+    /**
+     * Multi-threaded PageRank by power iteration. Rank of dangling pages is
+     * spread over all pages. Returned ranks sum to 1.
+     * @param iterations_run Set to the number of iterations performed
+     */
+    std::vector<double> pagerank(double damping,
+                                 int max_iterations,
+                                 double tolerance,
+                                 size_t threads,
+                                 int* iterations_run = nullptr) const;
+
+    struct HostStats {
+        std::string host;
+        double rank = 0.0;           // Sum of page ranks
+        uint32_t pages = 0;
+        uint32_t linking_hosts = 0;  // Distinct other hosts linking in
+    };
+
+    /**
+     * Aggregate page ranks and links into the host graph
+     */
+    std::vector<HostStats> aggregate_hosts(const std::vector<double>& ranks) const;
+
+private:
+    static constexpr size_t kArenaChunk = 1 << 20;
+
+    std::vector<std::unique_ptr<char[]>> arena_;      // Current chunk last
+    std::vector<std::unique_ptr<char[]>> oversized_;  // URLs too long to share a chunk
+    size_t arena_used_;
+    std::unordered_map<std::string_view, uint32_t> ids_;
+    std::vector<std::string_view> urls_;
+
+    std::vector<std::pair<uint32_t, uint32_t>> edges_;  // Until finalize()
+    std::vector<uint64_t> in_offsets_;                  // node_count() + 1 entries
+    std::vector<uint32_t> in_sources_;
+    std::vector<uint32_t> out_degrees_;
+
+    std::string_view store(std::string_view text);
+};
+
+#endif // LINK_GRAPH_H
@@ -0,0 +1,135 @@
+#ifndef PARQUET_FILE_WRITER_H
+#define PARQUET_FILE_WRITER_H
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "crawler.h"
+
+enum class ParquetCompression {
+    None,
+    Snappy,
+    Gzip,
+    Zstd  // Needs libzstd at build time; Snappy otherwise
+};
+
+struct ParquetWriterOptions {
+    ParquetCompression compression = ParquetCompression::Snappy;
+    size_t row_group_rows = 5000;                 // Rows per row group...
+    size_t row_group_bytes = 64 * 1024 * 1024;    // ... or fewer once they hold this much data
+    int zstd_level = 3;
+};
+
+/**
+ * Streaming writer for the dataset as a Parquet file.
+ *
+ * Columns: url, host, title, text, content_length, status_code, timestamp.
+ * host is dictionary-encoded per row group; the rest are PLAIN. Rows are
+ * buffered column by column until a row group is full, then its pages are
+ * compressed and written, so memory is bounded by one row group however
+ * many rows the file gets. The footer is written by close(); until then
+ * the file is not readable.
+ */
+class ParquetFileWriter {
+public:
+    explicit ParquetFileWriter(ParquetWriterOptions options = ParquetWriterOptions());
+    ~ParquetFileWriter();
+
+    ParquetFileWriter(const ParquetFileWriter&) = delete;
+    ParquetFileWriter& operator=(const ParquetFileWriter&) = delete;
+
+    /**
+     * Start a new file, truncating any existing one
+     */
+    bool open(const std::string& path);
+
+    /**
+     * Append rows, writing out each row group as it fills
+     */
+    bool write(const std::vector<DataRecord>& records);
+
+    /**
+     * Write the last row group and the footer
+     */
+    bool close();
+
+    bool is_open() const {
+        return file_.is_open();
+    }
+
+    /**
+     * Bytes in the file so far, excluding rows not yet flushed as a row group
+     */
+    uint64_t bytes_written() const {
+        return offset_;
+    }
+
+    uint64_t rows_written() const {
+        return total_rows_;
+    }
+
+    size_t row_groups() const {
+        return row_groups_.size();
+    }
+
+    /**
+     * "none", "snappy", "gzip" or "zstd"; unknown names give Snappy
+     */
+    static ParquetCompression parse_compression(const std::string& name);
+
+private:
+    // Where flush_row_group() put a column's pages, for the footer
+    struct ColumnChunkInfo {
+        int64_t num_values = 0;
+        int64_t uncompressed_size = 0;  // Pages including their headers
+        int64_t compressed_size = 0;
+        int64_t data_page_offset = 0;
+        int64_t dictionary_page_offset = -1;
+    };
+
+    struct RowGroupInfo {
+        std::vector<ColumnChunkInfo> columns;
+        int64_t num_rows = 0;
+        int64_t file_offset = 0;
+    };
+
+    // Values of one row group, already PLAIN-encoded where that applies
+    struct ColumnBuffers {
+        std::string url;
+        std::vector<uint32_t> host_ids;
+        std::unordered_map<std::string, uint32_t> host_dictionary;
+        std::vector<std::string> hosts;
+        std::string title;
+        std::string text;
+        std::string content_length;
+        std::string status_code;
+        std::string timestamp;
+        size_t rows = 0;
+        size_t dictionary_bytes = 0;
+
+        size_t bytes() const {
+            return url.size() + host_ids.size() * sizeof(uint32_t) + dictionary_bytes + title.size() +
+                   text.size() + content_length.size() + status_code.size() + timestamp.size();
+        }
+    };
+
+    ParquetWriterOptions options_;
+    std::ofstream file_;
+    std::string path_;
+    uint64_t offset_ = 0;
+    uint64_t total_rows_ = 0;
+    ColumnBuffers buffers_;
+    std::vector<RowGroupInfo> row_groups_;
+
+    void add_row(const DataRecord& record);
+    bool flush_row_group();
+    bool write_page(int page_type, const std::string& body, int32_t num_values, int encoding,
+                    ColumnChunkInfo& chunk);
+    bool write_footer();
+    bool write_bytes(const std::string& bytes);
+};
+
+#endif // PARQUET_FILE_WRITER_H
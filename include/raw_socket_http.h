@@ -7,15 +7,24 @@
 #include <string>
 #include <vector>
 
+#include "byte_buffer.h"
+#include "event_loop.h"
 #include "http_config.h"
+#include "task.h"
 
 struct RawHttpResponse {
     int status_code = 0;
-    std::string body;
+    ByteBuffer body;  // Slice of the receive buffer
     std::string content_type;
     HTTPVersion http_version = HTTPVersion::UNKNOWN;
     std::string final_url;
     std::string location;
+    HttpValidators validators;
+    long retry_after_seconds = -1;  // From Retry-After, -1 if absent
+    long connect_ms = -1;           // Phase timings of the last attempt, -1 if not reached;
+    long first_byte_ms = -1;        // a phase cut off by its deadline reports the time it
+    long total_ms = -1;             // was given, a lower bound
+    bool timed_out = false;         // The total deadline fired: total_ms is such a lower bound
     bool success = false;
     std::string error_message;
 };
@@ -26,33 +35,43 @@ struct RawSocketRetryConfig {
 };
 
 struct RawSocketHttpConfig {
-    std::chrono::seconds timeout = std::chrono::seconds(30);
+    std::chrono::milliseconds timeout = std::chrono::seconds(30);   // Whole request
+    std::chrono::milliseconds connect_timeout{0};  // 0 = timeout
+    std::chrono::milliseconds idle_timeout{0};     // Longest silence once connected, 0 = timeout
     RawSocketRetryConfig retry;
     int max_redirects = 5;
+    IoBackend io_backend = IoBackend::Epoll;  // For the thread's loop fetch() runs on
 };
 
-class CoroutineTask {
-public:
-    virtual ~CoroutineTask() = default;
-    virtual bool step() = 0;
-    virtual bool is_complete() const = 0;
-};
-
-class RoundRobinScheduler {
-public:
-    void add_task(const std::shared_ptr<CoroutineTask>& task);
-    void run();
-
-private:
-    std::vector<std::shared_ptr<CoroutineTask>> tasks_;
-};
-
+/**
+ * HTTP/1.1 client over raw sockets, with TLS for https://.
+ *
+ * fetch_async() is a coroutine driven by an EventLoop: it resolves the
+ * host, races its addresses (Happy Eyeballs), runs the TLS handshake,
+ * sends the request and reads the response, suspending on socket
+ * readiness between steps, then follows redirects and retries. Any number
+ * of fetches can share one loop and thread. fetch() runs a single fetch
+ * on the calling thread's loop for the backend, kept for the thread's
+ * lifetime, and blocks until it finishes.
+ *
+ * The crawler still fetches through fetch(), one page at a time per
+ * worker thread; fetch_async() is groundwork for multiplexing a worker's
+ * fetches on its loop, which nothing in the crawler does yet.
+ */
 class RawSocketHttpClient {
 public:
     explicit RawSocketHttpClient(const RawSocketHttpConfig& config);
+
     RawHttpResponse fetch(const std::string& url,
                           const std::map<std::string, std::string>& headers);
 
+    /**
+     * Awaitable fetch; the url, headers and config are copied into the
+     * coroutine, so neither they nor the client need to outlive it
+     */
+    Task<RawHttpResponse> fetch_async(EventLoop& loop, const std::string& url,
+                                      const std::map<std::string, std::string>& headers) const;
+
 private:
     RawSocketHttpConfig config_;
 };
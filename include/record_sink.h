@@ -0,0 +1,24 @@
+#ifndef RECORD_SINK_H
+#define RECORD_SINK_H
+
+#include "crawler.h"
+
+/**
+ * Destination for crawled records, fed by the crawl loop as pages are fetched.
+ *
+ * push() may block to hold the producer back, but an implementation meant for
+ * long crawls must not keep every record it has been given.
+ */
+class RecordSink {
+public:
+    virtual ~RecordSink() = default;
+
+    virtual void push(DataRecord record) = 0;
+
+    /**
+     * Deliver everything pushed so far; called when the crawl ends
+     */
+    virtual void flush() {}
+};
+
+#endif // RECORD_SINK_H
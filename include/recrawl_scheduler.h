@@ -0,0 +1,70 @@
+#ifndef RECRAWL_SCHEDULER_H
+#define RECRAWL_SCHEDULER_H
+
+#include <cstdint>
+#include <string>
+
+/**
+ * Fetch history of one URL, as stored in RocksDB
+ */
+struct FetchHistory {
+    int64_t first_fetch = 0;   // Unix seconds
+    int64_t last_fetch = 0;
+    uint32_t fetches = 0;
+    uint32_t changes = 0;      // Fetches whose content differed from the previous one
+    uint64_t fingerprint = 0;  // SimHash of the last content
+    int64_t next_due = 0;      // Scheduled revisit, 0 = none
+};
+
+/**
+ * Revisit policy for incremental recrawls.
+ *
+ * Page changes are modelled as a Poisson process. With n revisits, X of
+ * which found the content changed, and mean revisit interval I, the rate is
+ * estimated as lambda = -ln((n - X + 0.5) / (n + 0.5)) / I (Cho and
+ * Garcia-Molina), which stays finite when every revisit saw a change. The
+ * next revisit is placed where the page has changed with probability
+ * target_probability, i.e. after -ln(1 - p) / lambda seconds. Pages never
+ * seen to change back off by doubling their interval. Intervals are clamped
+ * to [min_interval, max_interval].
+ */
+class RecrawlScheduler {
+public:
+    explicit RecrawlScheduler(int64_t min_interval = 3600,
+                              int64_t max_interval = 30 * 86400);
+
+    void set_intervals(int64_t min_interval, int64_t max_interval);
+    void set_target_probability(double probability);
+    int64_t min_interval() const;
+
+    /**
+     * Add a fetch to the history and schedule the next revisit
+     * @return true if the content changed since the previous fetch
+     */
+    bool record_fetch(FetchHistory& history, uint64_t fingerprint, int64_t now) const;
+
+    /**
+     * Estimated changes per second (0 while no change has been seen)
+     */
+    static double change_rate(const FetchHistory& history);
+
+    /**
+     * Seconds until the next revisit
+     */
+    int64_t revisit_interval(const FetchHistory& history) const;
+
+    static std::string serialize(const FetchHistory& history);
+    static bool deserialize(const std::string& data, FetchHistory& history);
+
+private:
+    static constexpr int64_t kInitialInterval = 86400;
+    static constexpr int kSameContentBits = 3;  // SimHash distance treated as unchanged
+
+    int64_t min_interval_;
+    int64_t max_interval_;
+    double target_probability_;
+
+    int64_t clamp(double seconds) const;
+};
+
+#endif // RECRAWL_SCHEDULER_H
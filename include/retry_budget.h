@@ -0,0 +1,41 @@
+#ifndef RETRY_BUDGET_H
+#define RETRY_BUDGET_H
+
+#include <mutex>
+
+/**
+ * Global cap on retries as a share of requests.
+ *
+ * Every request deposits `ratio` of a retry into the budget and every
+ * retry withdraws one, so over a run retries stay within ratio * requests.
+ * The balance starts at, and never exceeds, `reserve`, which allows a
+ * short burst of retries without letting an outage bank an unbounded
+ * number of them.
+ */
+class RetryBudget {
+public:
+    explicit RetryBudget(double ratio = 0.1, double reserve = 10.0);
+
+    void configure(double ratio, double reserve);
+
+    /**
+     * Record a request (first attempt or retry)
+     */
+    void on_request();
+
+    /**
+     * Take one retry from the budget
+     * @return false if the budget is spent
+     */
+    bool try_spend();
+
+    double balance() const;
+
+private:
+    double ratio_;
+    double reserve_;
+    double balance_;
+    mutable std::mutex mutex_;
+};
+
+#endif // RETRY_BUDGET_H
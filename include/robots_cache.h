@@ -0,0 +1,80 @@
+#ifndef ROBOTS_CACHE_H
+#define ROBOTS_CACHE_H
+
+#include "robots_matcher.h"
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Everything the crawler keeps from one host's robots.txt
+ */
+struct RobotsEntry {
+    RobotsMatcher matcher;
+    std::vector<std::string> sitemaps;
+    std::chrono::system_clock::time_point fetched_at;
+};
+
+/**
+ * Size-bounded LRU cache of compiled robots.txt entries with a TTL.
+ *
+ * Lookups are single-flight: while one caller loads a host's entry, other
+ * callers asking for the same host wait for that result instead of starting
+ * their own fetch. The loader decides where an entry comes from (persistent
+ * store or network); the cache only bounds memory and deduplicates work.
+ */
+class RobotsCache {
+public:
+    using Loader = std::function<std::shared_ptr<const RobotsEntry>(const std::string& host)>;
+
+    RobotsCache(size_t max_hosts = 100000, long ttl_seconds = 3600);
+
+    /**
+     * Change the bounds; entries beyond the new size are evicted
+     */
+    void configure(size_t max_hosts, long ttl_seconds);
+
+    /**
+     * Get a fresh entry for a host, loading it at most once at a time
+     * @return Entry, or nullptr if the loader failed
+     */
+    std::shared_ptr<const RobotsEntry> get(const std::string& host, const Loader& loader);
+
+    /**
+     * Get a fresh cached entry without loading
+     */
+    std::shared_ptr<const RobotsEntry> find(const std::string& host) const;
+
+    size_t size() const;
+    long ttl_seconds() const;
+
+private:
+    struct Slot {
+        std::shared_ptr<const RobotsEntry> entry;
+        std::list<std::string>::iterator lru_position;
+    };
+
+    struct InFlight {
+        bool done = false;
+        std::shared_ptr<const RobotsEntry> result;
+    };
+
+    size_t max_hosts_;
+    long ttl_seconds_;
+    std::unordered_map<std::string, Slot> entries_;
+    std::list<std::string> lru_;  // Most recently used first
+    std::unordered_map<std::string, std::shared_ptr<InFlight>> in_flight_;
+    mutable std::mutex mutex_;
+    std::condition_variable loaded_cv_;
+
+    bool is_fresh(const RobotsEntry& entry) const;
+    void insert_locked(const std::string& host, std::shared_ptr<const RobotsEntry> entry);
+};
+
+#endif // ROBOTS_CACHE_H
@@ -0,0 +1,83 @@
+#ifndef ROBOTS_MATCHER_H
+#define ROBOTS_MATCHER_H
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * robots.txt rules for a specific user-agent group
+ */
+struct RobotRule {
+    std::vector<std::string> user_agents;
+    std::vector<std::string> disallows;
+    std::vector<std::string> allows;
+    int specificity = 0;  // Higher = more specific (exact match > pattern > wildcard)
+    double crawl_delay_seconds = -1.0;
+};
+
+/**
+ * Allow/Disallow rules of one robots.txt group, compiled for fast path checks.
+ *
+ * Literal patterns (optionally ending in '$') live in a byte trie, so they
+ * are all checked by one walk along the path. Patterns containing '*' are
+ * split into literal segments and matched left to right without
+ * backtracking, longest pattern first, stopping as soon as no remaining
+ * pattern can beat the current match.
+ *
+ * Precedence follows RFC 9309: the longest matching pattern wins, and Allow
+ * wins over Disallow on equal length. An empty matcher allows everything.
+ */
+class RobotsMatcher {
+public:
+    RobotsMatcher();
+
+    /**
+     * Add an Allow or Disallow pattern (empty patterns are ignored)
+     */
+    void add_pattern(const std::string& pattern, bool allow);
+
+    /**
+     * Check a URL path (with query) against the compiled patterns
+     */
+    bool is_allowed(const std::string& path) const;
+
+    void set_crawl_delay(double seconds);
+    double crawl_delay() const;  // Negative when the group has none
+
+    size_t pattern_count() const;
+
+    /**
+     * Match a single robots.txt pattern ('*' and trailing '$') against a path
+     */
+    static bool match_pattern(const std::string& pattern, const std::string& path);
+
+private:
+    static constexpr uint8_t kNone = 0;
+    static constexpr uint8_t kDisallow = 1;
+    static constexpr uint8_t kAllow = 2;
+
+    struct TrieNode {
+        std::vector<std::pair<char, uint32_t>> children;
+        uint8_t prefix_verdict = kNone;  // Pattern ending here matches any continuation
+        uint8_t exact_verdict = kNone;   // Pattern ending here with '$'
+    };
+
+    struct GlobPattern {
+        std::vector<std::string> segments;  // Literal text between '*'
+        bool anchored = false;              // Trailing '$'
+        size_t length = 0;                  // Precedence length, '$' excluded
+        bool allow = false;
+    };
+
+    std::vector<TrieNode> trie_;
+    std::vector<GlobPattern> globs_;  // Longest first
+    size_t pattern_count_;
+    double crawl_delay_seconds_;
+
+    static bool match_glob(const GlobPattern& glob, const std::string& path);
+    static GlobPattern compile_glob(const std::string& pattern, bool anchored);
+};
+
+#endif // ROBOTS_MATCHER_H
@@ -0,0 +1,65 @@
+#ifndef ROBOTS_PREFETCHER_H
+#define ROBOTS_PREFETCHER_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+/**
+ * Background stage that loads robots.txt for hosts ahead of their first fetch.
+ *
+ * Hosts are scheduled as soon as they are discovered. A small pool of worker
+ * threads runs the loader for each host (which fills the robots cache) and
+ * then reports the host as ready, so the caller can release URLs it was
+ * holding back. A host is queued at most once while its load is pending.
+ */
+class RobotsPrefetcher {
+public:
+    using Loader = std::function<void(const std::string& host)>;
+    using ReadyCallback = std::function<void(const std::string& host)>;
+
+    RobotsPrefetcher();
+    ~RobotsPrefetcher();
+
+    RobotsPrefetcher(const RobotsPrefetcher&) = delete;
+    RobotsPrefetcher& operator=(const RobotsPrefetcher&) = delete;
+
+    /**
+     * Start the worker pool
+     * @param workers Number of worker threads (at least one is started)
+     */
+    void start(size_t workers, Loader loader, ReadyCallback on_ready);
+
+    /**
+     * Stop the workers; hosts still queued are dropped
+     */
+    void stop();
+
+    /**
+     * Queue a host for loading
+     * @return true if the host was queued, false if already pending or stopped
+     */
+    bool schedule(const std::string& host);
+
+    bool is_running() const;
+    size_t pending() const;  // Hosts queued or being loaded
+
+private:
+    Loader loader_;
+    ReadyCallback on_ready_;
+    std::deque<std::string> queue_;
+    std::unordered_set<std::string> pending_;
+    std::vector<std::thread> workers_;
+    bool running_;
+    mutable std::mutex mutex_;
+    std::condition_variable queue_cv_;
+
+    void worker_loop();
+};
+
+#endif // ROBOTS_PREFETCHER_H
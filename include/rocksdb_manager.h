@@ -1,7 +1,11 @@
 #ifndef ROCKSDB_MANAGER_H
 #define ROCKSDB_MANAGER_H
 
+#include <cstdint>
+#include <functional>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 #include <memory>
 
@@ -20,25 +24,71 @@ public:
     
     // Queue operations
     bool enqueue_url(const std::string& url, int priority = 0);
-    std::string dequeue_url();
+    std::string dequeue_url(int* priority = nullptr);  // Also reports the URL's queue priority
     bool has_queued_urls();
     int get_queue_size();
 
+    // Deferred URLs of hosts on hold (paused or behind an open circuit),
+    // kept per host until released back into the queue
+    bool defer_url(const std::string& host, const std::string& url, int priority);
+    size_t release_deferred_urls(const std::string& host);
+    std::vector<std::string> get_deferred_hosts();
+
     // Link graph operations
     bool add_link_edge(const std::string& from_url, const std::string& to_url);
     std::vector<std::string> get_outgoing_links(const std::string& from_url);
     
+    // Scan all link edges from a consistent snapshot; returns the edge count
+    size_t for_each_link_edge(const std::function<void(std::string_view from_url,
+                                                       std::string_view to_url)>& visit);
+    
+    // Link-graph scores computed offline: "<rank> <in_degree>" per URL and
+    // "<rank> <pages> <linking_hosts>" per host, written in batches
+    bool store_page_scores(const std::vector<std::pair<std::string, std::string>>& scores);
+    bool store_host_scores(const std::vector<std::pair<std::string, std::string>>& scores);
+    double get_page_rank(const std::string& url);
+    
     // Visited links operations
     bool mark_visited(const std::string& url);
     bool is_visited(const std::string& url);
+    bool unmark_visited(const std::string& url);
     std::vector<std::string> get_all_visited();
     int get_visited_count();
     
+    // Recrawl: per-URL fetch history plus a revisit index ordered by due time.
+    // Storing history moves the URL's index entry from previous_due to next_due.
+    bool store_fetch_history(const std::string& url, const std::string& data,
+                             int64_t next_due, int64_t previous_due);
+    std::string get_fetch_history(const std::string& url);
+    std::vector<std::string> get_due_recrawls(int64_t now, size_t limit);
+    
     // Cache operations
     bool cache_html(const std::string& url, const std::string& html);
     std::string get_cached_html(const std::string& url);
     bool has_cached_html(const std::string& url);
     
+    // Conditional GET: the cached body, its extracted title and text and its
+    // ETag/Last-Modified validators are written together, so validators are
+    // never sent without a page to rebuild the record from on a 304
+    bool store_validators(const std::string& url, std::string_view html,
+                          const std::string& title, const std::string& text,
+                          const std::string& etag, const std::string& last_modified);
+    bool get_validators(const std::string& url, std::string& etag, std::string& last_modified);
+    bool get_cached_extract(const std::string& url, std::string& title, std::string& text);
+    
+    // Raw robots.txt responses, with fetch time and status
+    bool store_robots_txt(const std::string& host, const std::string& data);
+    std::string get_robots_txt(const std::string& host);
+    
+    // Learned page templates (serialized by TemplateLearner)
+    bool store_host_template(const std::string& host, const std::string& data);
+    std::string get_host_template(const std::string& host);
+    
+    // Learned DUST parameter rules (serialized by DustLearner)
+    bool store_dust_rules(const std::string& host, const std::string& data);
+    std::string get_dust_rules(const std::string& host);
+    std::vector<std::string> get_dust_hosts();
+    
     // Statistics
     std::string get_stats();
     
@@ -52,10 +102,22 @@ private:
     
     std::string make_priority_queue_key(int priority, int index) const;
     std::string make_priority_tail_key(int priority) const;
+    std::string make_deferred_key(const std::string& host, int index) const;
+    std::string make_deferred_tail_key(const std::string& host) const;
     std::string make_visited_key(const std::string& url) const;
+    std::string make_history_key(const std::string& url) const;
+    std::string make_recrawl_key(int64_t due, const std::string& url) const;
     std::string make_cache_key(const std::string& url) const;
+    std::string make_validators_key(const std::string& url) const;
+    std::string make_extract_key(const std::string& url) const;
+    std::string make_template_key(const std::string& host) const;
+    std::string make_robots_key(const std::string& host) const;
+    std::string make_dust_key(const std::string& host) const;
     std::string make_link_edge_key(const std::string& from_url, const std::string& to_url) const;
     std::string make_link_prefix(const std::string& from_url) const;
+    std::string make_page_rank_key(const std::string& url) const;
+    std::string make_host_rank_key(const std::string& host) const;
+    bool write_scores(const std::vector<std::pair<std::string, std::string>>& scores, bool hosts);
 };
 
 #endif // ROCKSDB_MANAGER_H
@@ -0,0 +1,72 @@
+#ifndef SELECTOR_MATCHER_H
+#define SELECTOR_MATCHER_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Compiled list of simple CSS selectors, matched against Gumbo elements.
+ *
+ * Supported per selector (compound only, no combinators):
+ *   tag, *, .class, #id, [attr], [attr=v], [attr^=v], [attr$=v],
+ *   [attr*=v], [attr~=v], and the case-insensitive flag: [attr=v i]
+ *
+ * Selectors are indexed by tag and by attribute name, so an element is
+ * decided by one array lookup plus one hash lookup per attribute it has;
+ * only selectors that can possibly match are evaluated.
+ */
+class SelectorMatcher {
+public:
+    SelectorMatcher();
+
+    /**
+     * Compile a comma-separated selector list, replacing the current one.
+     * Unsupported selectors are logged and skipped.
+     * @return Number of selectors compiled
+     */
+    size_t compile(const std::string& selector_list);
+
+    /**
+     * Check whether a Gumbo element node matches any compiled selector
+     * @param node GumboNode* (non-element nodes never match)
+     */
+    bool matches(const void* node) const;
+
+    size_t size() const;
+
+private:
+    enum class AttrOp {
+        Exists,    // [attr]
+        Equals,    // [attr=v]
+        Prefix,    // [attr^=v]
+        Suffix,    // [attr$=v]
+        Contains,  // [attr*=v]
+        Word       // [attr~=v], .class
+    };
+
+    struct AttrCondition {
+        std::string name;
+        AttrOp op = AttrOp::Exists;
+        std::string value;        // Lowercased when ignore_case
+        bool ignore_case = false;
+    };
+
+    struct CompoundSelector {
+        int tag = -1;                // GumboTag, -1 = any
+        std::string unknown_tag;     // Custom element name when tag is GUMBO_TAG_UNKNOWN
+        std::vector<AttrCondition> conditions;
+    };
+
+    std::vector<CompoundSelector> selectors_;
+    std::vector<bool> tag_always_;                 // Bare tag selectors
+    std::vector<std::vector<size_t>> by_tag_;      // Tag + attribute selectors
+    std::unordered_map<std::string, std::vector<size_t>> by_attribute_;  // Tagless, keyed by first attribute
+    std::vector<size_t> universal_;                // "*" and custom element tags
+
+    bool parse_compound(const std::string& text, CompoundSelector& selector) const;
+    bool evaluate(const CompoundSelector& selector, const void* node) const;
+    static bool evaluate_condition(const AttrCondition& condition, const char* value);
+};
+
+#endif // SELECTOR_MATCHER_H
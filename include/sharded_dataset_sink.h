@@ -0,0 +1,97 @@
+#ifndef SHARDED_DATASET_SINK_H
+#define SHARDED_DATASET_SINK_H
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "dataset_writer.h"
+#include "record_sink.h"
+
+struct ShardedDatasetSinkConfig {
+    std::string output_dir = "./output";
+    std::string format = "json";                   // "json", "csv", "parquet" or a comma list; "both" is json,csv
+    size_t batch_size = 1000;                      // Records per write
+    size_t max_shard_bytes = 256 * 1024 * 1024;    // Rotate once a shard reaches this size
+    std::chrono::seconds max_shard_age{3600};      // ... or has been open this long
+    std::chrono::milliseconds flush_interval{5000};  // A partial batch waits at most this long
+    ParquetWriterOptions parquet;                  // Compression and row-group size of Parquet shards
+};
+
+/**
+ * Record sink that writes the dataset in shards from a background thread.
+ *
+ * push() queues a record and returns; the writer thread takes records off
+ * the queue in batch_size chunks (or whatever has arrived after
+ * flush_interval) and appends them to the current shard,
+ * dataset-NNNNN.json, .csv and/or .parquet in output_dir. A shard is closed and the
+ * next one started once it reaches max_shard_bytes or max_shard_age. The
+ * queue holds at most two batches: past that, push() blocks until the
+ * writer catches up, so memory stays flat however long the crawl runs.
+ *
+ * Each JSON shard is a complete array after every batch, so a crash loses
+ * at most the records still queued. A Parquet shard only gets its footer
+ * when it is closed, so after a crash the open one is unreadable;
+ * max_shard_age bounds how much that can be. Shard numbers continue after
+ * the shards already in output_dir.
+ */
+class ShardedDatasetSink : public RecordSink {
+public:
+    explicit ShardedDatasetSink(ShardedDatasetSinkConfig config);
+    ~ShardedDatasetSink() override;
+
+    ShardedDatasetSink(const ShardedDatasetSink&) = delete;
+    ShardedDatasetSink& operator=(const ShardedDatasetSink&) = delete;
+
+    void push(DataRecord record) override;
+
+    /**
+     * Block until every record pushed so far has been written
+     */
+    void flush() override;
+
+    size_t records_written() const;
+    size_t shards_opened() const;
+
+private:
+    ShardedDatasetSinkConfig config_;
+    bool write_json_;
+    bool write_csv_;
+    bool write_parquet_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable queue_cv_;    // Wakes the writer
+    std::condition_variable written_cv_;  // Wakes blocked pushes and flushes
+    std::deque<DataRecord> queue_;
+    size_t in_flight_ = 0;  // Taken by the writer, not yet written
+    size_t records_written_ = 0;
+    size_t shards_opened_ = 0;
+    bool flush_requested_ = false;
+    bool stopping_ = false;
+    std::thread writer_;
+
+    // Owned by the writer thread
+    ParquetDatasetWriter formatter_;
+    std::ofstream json_;
+    std::ofstream csv_;
+    ParquetFileWriter parquet_;
+    bool shard_open_ = false;
+    size_t shard_records_ = 0;
+    size_t next_shard_ = 0;
+    std::chrono::steady_clock::time_point shard_opened_at_;
+
+    void writer_loop();
+    bool write_batch(const std::vector<DataRecord>& batch);
+    bool shard_full();
+    bool open_shard();
+    void close_shard();
+    std::string shard_path(size_t index, const std::string& extension) const;
+    std::string shard_extension() const;
+};
+
+#endif // SHARDED_DATASET_SINK_H
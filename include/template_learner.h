@@ -0,0 +1,127 @@
+#ifndef TEMPLATE_LEARNER_H
+#define TEMPLATE_LEARNER_H
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/**
+ * Learns per-host page templates: DOM subtrees (header, footer, sidebar...)
+ * that are identical on most pages of a host.
+ *
+ * A subtree is identified by its position, a hash of the tag/id/class path
+ * from <body>, and compared by a hash of its full content. During the first
+ * learning_pages pages of a host every shallow subtree is hashed; subtrees
+ * whose content repeats on at least min_share of the pages seen become the
+ * host's template. Once learning is over only the path hashes of shallow
+ * nodes are computed, and template subtrees are skipped without being
+ * traversed.
+ *
+ * A template never takes most of a page's text: when the subtrees it
+ * would skip hold more text than the rest of the page, the page is
+ * extracted in full instead. A frozen template is learned again once it
+ * is older than the relearn age, has been applied to relearn_pages pages,
+ * or has been refused on kMaxRefusals pages in a row, so one learned from
+ * an unrepresentative sample (a consent wall, soft 404s) does not empty
+ * the host's pages for good.
+ *
+ * Hosts are kept in a bounded LRU cache. A finished template is handed to the
+ * persistence callbacks with the time it was learned, so it survives
+ * eviction and restarts.
+ */
+class TemplateLearner {
+public:
+    using Loader = std::function<std::string(const std::string& host)>;
+    using Saver = std::function<void(const std::string& host, const std::string& data)>;
+
+    explicit TemplateLearner(size_t max_hosts = 1024);
+
+    /**
+     * Fraction of a host's pages a subtree must appear on, unchanged (default 0.8)
+     */
+    void set_min_share(double share);
+
+    /**
+     * Pages sampled before the template is frozen and saved (default 20).
+     * Templates are applied from the fifth page on, while still learning.
+     */
+    void set_learning_pages(size_t pages);
+
+    /**
+     * Learn a frozen template again after it has been applied to this many
+     * pages (default 5000) or once it is this old (default 7 days)
+     */
+    void set_relearn_after(size_t pages, std::chrono::seconds age);
+
+    /**
+     * Persist finished templates, e.g. in RocksDB
+     */
+    void set_persistence(Loader loader, Saver saver);
+
+    /**
+     * Learn from one page of a host and collect its template subtrees
+     * @param host Host the page belongs to
+     * @param body GumboNode* of the page's <body>
+     * @param skipped Receives the roots of template subtrees
+     * @return Number of template subtrees found on the page
+     */
+    size_t process_page(const std::string& host, const void* body,
+                        std::unordered_set<const void*>& skipped);
+
+    /**
+     * Number of template subtrees known for a host (0 if not cached)
+     */
+    size_t template_size(const std::string& host) const;
+
+private:
+    static constexpr int kMaxDepth = 12;              // Template roots are shallow
+    static constexpr size_t kMaxSubtreesPerHost = 4096;
+    static constexpr size_t kMinPages = 5;
+    static constexpr size_t kMaxRefusals = 5;  // Refused pages in a row before relearning
+
+    struct SubtreeStat {
+        uint64_t content_hash = 0;
+        uint32_t hits = 0;
+        uint32_t misses = 0;
+    };
+
+    struct HostTemplate {
+        size_t pages_seen = 0;
+        bool frozen = false;
+        int64_t learned_at = 0;        // Unix seconds when frozen
+        size_t pages_applied = 0;      // Since frozen, this run
+        size_t refusals = 0;           // Consecutive pages the template would have emptied
+        std::unordered_map<uint64_t, SubtreeStat> stats;  // Only while learning
+        std::unordered_set<uint64_t> template_paths;
+        std::list<std::string>::iterator lru_position;
+    };
+
+    size_t max_hosts_;
+    double min_share_;
+    size_t learning_pages_;
+    size_t relearn_pages_;
+    std::chrono::seconds relearn_age_;
+    Loader loader_;
+    Saver saver_;
+    std::unordered_map<std::string, HostTemplate> hosts_;
+    std::list<std::string> lru_;  // Most recently used first
+
+    HostTemplate& lookup(const std::string& host);
+    void save(const std::string& host, const HostTemplate& entry);
+    void rebuild_template(HostTemplate& entry);
+    void relearn(const std::string& host, HostTemplate& entry, const char* reason);
+    bool expired(const HostTemplate& entry) const;
+    uint64_t observe(const void* node, uint64_t path, int depth, HostTemplate& entry, bool& has_text);
+    void mark(const void* node, uint64_t path, int depth, const HostTemplate& entry,
+              std::vector<const void*>& found) const;
+
+    static std::string serialize(const HostTemplate& entry);
+    static bool deserialize(const std::string& data, HostTemplate& entry);
+};
+
+#endif // TEMPLATE_LEARNER_H
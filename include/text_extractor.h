@@ -1,7 +1,12 @@
 #ifndef TEXT_EXTRACTOR_H
 #define TEXT_EXTRACTOR_H
 
+#include "selector_matcher.h"
+#include "template_learner.h"
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 struct TextExtraction {
@@ -12,6 +17,16 @@ struct TextExtraction {
     std::vector<std::string> links;
 };
 
+/**
+ * Which part of <body> extract_from_html() emits
+ */
+enum class ExtractionMode {
+    FullPage,      // Everything not matched by the remove selectors
+    MainContent    // Only the main article, boilerplate blocks dropped
+};
+
+class MarkdownBuilder;
+
 class TextExtractor {
 public:
     TextExtractor();
@@ -23,24 +38,50 @@ public:
      * @param url Original URL (for relative link resolution)
      * @return TextExtraction structure with extracted content
      */
-    TextExtraction extract_from_html(const std::string& html, const std::string& url);
+    TextExtraction extract_from_html(std::string_view html, const std::string& url);
     
     /**
-     * Set CSS selectors for elements to remove
-     * @param selectors Comma-separated CSS selectors
+     * Set CSS selectors for elements to remove, replacing the defaults
+     * @param selectors Comma-separated CSS selectors (see SelectorMatcher
+     *                  for the supported subset)
      */
     void set_remove_selectors(const std::string& selectors);
     
+    /**
+     * Select full-page or main-content extraction (default: FullPage).
+     * MainContent scores blocks by text density, link density and tag and
+     * class hints, and emits only the best-scoring article block; pages
+     * where nothing scores fall back to the full page.
+     */
+    void set_extraction_mode(ExtractionMode mode);
+    ExtractionMode get_extraction_mode() const;
+    
+    /**
+     * Learn per-host templates and skip the subtrees they cover
+     * @param min_share Fraction of a host's pages a subtree must repeat on
+     */
+    void enable_template_learning(bool enable, double min_share = 0.8);
+    
+    /**
+     * Load/save learned templates across runs (see TemplateLearner)
+     */
+    void set_template_persistence(TemplateLearner::Loader loader, TemplateLearner::Saver saver);
+    
 private:
-    std::vector<std::string> remove_selectors_;
+    SelectorMatcher remove_selectors_;
+    ExtractionMode extraction_mode_;
+    TemplateLearner template_learner_;
+    bool template_learning_;
+    std::unordered_set<const void*> pruned_nodes_;  // Per-document boilerplate and template subtrees
+    std::unordered_map<const void*, std::string> language_cache_;  // Per-document, keyed by node
     
     // Helper methods
-    std::string extract_text_recursive(void* node, bool& in_code);
+    void extract_text_recursive(void* node, MarkdownBuilder& out);
     std::string detect_language(const std::string& code_snippet);
-    std::string normalize_text(const std::string& text);
+    const std::string& detect_language_cached(void* node, const std::string& code_snippet);
     bool should_remove_element(void* node);
     std::string get_element_tag(void* node);
-    std::string get_element_text(void* node);
+    void append_element_text(void* node, std::string& out);
     bool is_code_element(void* node);
     void extract_code_blocks(void* node, std::vector<std::string>& code_blocks);
 };
@@ -0,0 +1,105 @@
+#ifndef TRAP_DETECTOR_H
+#define TRAP_DETECTOR_H
+
+#include "url.h"
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+enum class TrapVerdict {
+    Allow,
+    Throttle,  // Over the prefix's per-minute allowance: defer behind other URLs
+    Block
+};
+
+/**
+ * Thresholds for crawler-trap detection
+ */
+struct TrapLimits {
+    size_t max_path_depth = 16;          // Path segments per URL
+    size_t max_segment_repeats = 3;      // Occurrences of one segment in a path
+    size_t max_param_values = 500;       // Distinct values of one parameter per prefix
+    size_t min_fetches_for_ratio = 40;   // Fetched pages before the content ratio is judged
+    double min_unique_ratio = 0.2;       // Unique-content pages / fetched pages
+    double max_discovered_per_unique = 50.0;  // Newly discovered URLs per unique-content page
+    int throttled_urls_per_minute = 10;  // Enqueues a throttled prefix still gets at normal priority
+};
+
+/**
+ * Detects crawler traps (calendars, infinitely nested paths, faceted
+ * search) before their URLs reach the queue.
+ *
+ * URLs are judged on their own shape (path depth, repeated segments) and
+ * on the history of their prefix, i.e. host plus first path segment. A
+ * prefix whose parameter takes more than max_param_values distinct values,
+ * or that keeps yielding new URLs (more than max_discovered_per_unique per
+ * page of unique content), is throttled; a prefix whose fetched pages are
+ * mostly duplicates of each other is blocked. Duplicates are judged here from the pages'
+ * SimHash, independently of the crawler's deduplication, and a refetch of
+ * the same URL never counts as a duplicate of itself. Prefix state lives
+ * in a bounded LRU cache for the run.
+ */
+class TrapDetector {
+public:
+    explicit TrapDetector(const TrapLimits& limits = TrapLimits(), size_t max_prefixes = 16384);
+
+    void set_limits(const TrapLimits& limits);
+
+    /**
+     * Judge a URL about to be enqueued and count it for its prefix
+     */
+    TrapVerdict check(const Url& url);
+
+    /**
+     * Record a fetched page
+     * @param fingerprint SimHash of the page content
+     * @return false if the page duplicates another recent page of its prefix
+     */
+    bool record_fetch(const Url& url, uint64_t fingerprint);
+
+    /**
+     * Prefixes flagged so far, with the reason, e.g. "example.com/calendar (throttled: ...)"
+     */
+    std::vector<std::string> flagged_prefixes() const;
+
+private:
+    enum class PrefixState {
+        Normal,
+        Throttled,
+        Blocked
+    };
+
+    struct PrefixStats {
+        PrefixState state = PrefixState::Normal;
+        std::string reason;
+        bool shape_reported = false;  // A depth/repeat block was logged
+        size_t discovered = 0;
+        size_t fetched = 0;
+        size_t unique = 0;
+        std::vector<std::pair<uint64_t, uint64_t>> recent;  // (URL hash, fingerprint), oldest first
+        std::unordered_map<std::string, std::unordered_set<uint64_t>> param_values;
+        std::chrono::steady_clock::time_point window_start;
+        int window_count = 0;
+        std::list<std::string>::iterator lru_position;
+    };
+
+    TrapLimits limits_;
+    size_t max_prefixes_;
+    std::unordered_map<std::string, PrefixStats> prefixes_;
+    std::list<std::string> lru_;  // Most recently used first
+    std::vector<std::string> flagged_;
+    mutable std::mutex mutex_;
+
+    PrefixStats& lookup(const std::string& prefix);
+    void flag(const std::string& prefix, PrefixStats& stats, PrefixState state, const std::string& reason);
+    bool take_throttle_slot(PrefixStats& stats);
+
+    static std::string prefix_of(const Url& url);
+};
+
+#endif // TRAP_DETECTOR_H
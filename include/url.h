@@ -0,0 +1,88 @@
+#ifndef URL_H
+#define URL_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+/**
+ * A URL parsed once into component offsets over a single owned buffer.
+ *
+ * Accessors return views into that buffer, so looking at the scheme, host,
+ * path or query never allocates. Resolving a reference against a base URL
+ * builds the result in one new buffer, with dot segments already removed.
+ */
+class Url {
+public:
+    Url();
+
+    /**
+     * Parse an absolute URL (check valid() before use)
+     */
+    static Url parse(std::string spec);
+
+    /**
+     * Resolve a (possibly relative) reference against a base URL (RFC 3986, 5.2).
+     * The fragment of the reference is dropped.
+     */
+    static Url resolve(const Url& base, std::string_view reference);
+
+    bool valid() const;    // Has a scheme and a non-empty host
+    bool is_http() const;  // Scheme is http or https
+
+    std::string_view scheme() const;
+    std::string_view authority() const;  // host[:port], without userinfo
+    std::string_view host() const;       // Without IPv6 brackets
+    std::string_view port_text() const;  // Empty when no port is given
+    int port() const;                    // Explicit port, else the scheme default, else 0
+    std::string_view path() const;
+    std::string_view query() const;      // Without the leading '?'
+    bool has_query() const;
+    std::string_view fragment() const;   // Without the leading '#'
+
+    /**
+     * Path and query as sent in an HTTP request line ("/" for an empty path)
+     */
+    std::string request_target() const;
+
+    /**
+     * RFC 3986 normalization in place: lowercase scheme and host, drop the
+     * fragment and a default or empty port, uppercase percent-encoding hex
+     * and decode unreserved characters, remove dot segments, use "/" for an
+     * empty path, and drop a trailing slash on non-root paths without a query.
+     */
+    void normalize();
+
+    const std::string& str() const;
+
+    /**
+     * Move the buffer out; the Url is left empty and invalid
+     */
+    std::string release();
+
+private:
+    struct Parts {
+        bool has_scheme = false;
+        bool has_authority = false;
+        bool has_query = false;
+        bool has_fragment = false;
+        size_t scheme_end = 0;       // ':' after the scheme
+        size_t authority_begin = 0;  // After "//" and any userinfo
+        size_t host_begin = 0;       // After '[' for IPv6 literals
+        size_t host_end = 0;
+        size_t port_begin = 0;       // == authority_end when there is no port
+        size_t authority_end = 0;
+        size_t path_begin = 0;
+        size_t path_end = 0;         // '?' or '#' or end
+        size_t query_end = 0;        // '#' or end
+    };
+
+    std::string spec_;
+    Parts parts_;
+
+    static Parts split(std::string_view spec);
+    static void remove_dot_segments(std::string& buffer, size_t path_begin, size_t path_end);
+    static void normalize_percent_encoding(std::string& buffer, size_t begin, size_t end);
+};
+
+#endif // URL_H
@@ -0,0 +1,50 @@
+#ifndef URL_CANONICALIZER_H
+#define URL_CANONICALIZER_H
+
+#include "url.h"
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * Canonical form of a URL for the frontier and the visited set.
+ *
+ * On top of Url::normalize() it removes tracking and session parameters
+ * (from the query and from ";name=value" path parameters) and can sort the
+ * remaining query parameters by name. Rewriting happens inside the URL's
+ * own buffer; only a per-thread scratch buffer is used for sorting.
+ */
+class UrlCanonicalizer {
+public:
+    UrlCanonicalizer();
+
+    /**
+     * utm_*, click identifiers and common session-id parameters
+     */
+    static std::vector<std::string> default_stripped_params();
+
+    /**
+     * Replace the stripped parameter names (case-insensitive; a trailing '*'
+     * matches by prefix, e.g. "utm_*")
+     */
+    void set_stripped_params(const std::vector<std::string>& names);
+
+    void set_sort_query(bool sort);
+
+    /**
+     * Canonicalize in place
+     */
+    void canonicalize(Url& url) const;
+
+    bool is_stripped(std::string_view name) const;
+
+private:
+    std::vector<std::string> exact_;     // Lowercase, sorted
+    std::vector<std::string> prefixes_;  // Lowercase, without '*'
+    bool sort_query_;
+
+    void rewrite_query(std::string& spec, size_t question_mark, size_t query_end) const;
+    void strip_path_params(std::string& spec, size_t path_begin, size_t path_end) const;
+};
+
+#endif // URL_CANONICALIZER_H
@@ -20,6 +20,10 @@ sudo apt-get install -y build-essential git
 echo "Installing libcurl..."
 sudo apt-get install -y libcurl4-openssl-dev
 
+# Install compression libraries (Parquet output)
+echo "Installing zlib and zstd..."
+sudo apt-get install -y zlib1g-dev libzstd-dev
+
 # Install Apache Arrow and Parquet
 echo "Installing Apache Arrow and Parquet..."
 sudo apt-get install -y libparquet-dev libparquet0
@@ -0,0 +1,119 @@
+#include "address_cache.h"
+#include <cstring>
+#include <netdb.h>
+
+AddressCache& AddressCache::instance() {
+    static AddressCache cache;
+    return cache;
+}
+
+AddressCache::AddressCache(std::chrono::seconds ttl, size_t max_entries)
+    : ttl_(ttl),
+      max_entries_(max_entries > 0 ? max_entries : 1) {}
+
+std::vector<ResolvedAddress> AddressCache::resolve(const std::string& host, int port, std::string& error) {
+    const std::string key = host + ":" + std::to_string(port);
+    auto now = std::chrono::steady_clock::now();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = entries_.find(key);
+        if (it != entries_.end() && now < it->second.expires) {
+            auto family = families_.find(host);
+            return interleave(it->second.addresses,
+                              family == families_.end() ? AF_INET6 : family->second);
+        }
+    }
+
+    // Resolve outside the lock; concurrent misses for one host just resolve twice
+    struct addrinfo hints {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo* result = nullptr;
+    const std::string port_str = std::to_string(port);
+    int status = getaddrinfo(host.c_str(), port_str.c_str(), &hints, &result);
+    if (status != 0) {
+        error = gai_strerror(status);
+        return {};
+    }
+
+    std::vector<ResolvedAddress> addresses;
+    for (struct addrinfo* info = result; info != nullptr; info = info->ai_next) {
+        if (info->ai_addrlen > sizeof(sockaddr_storage)) {
+            continue;
+        }
+        ResolvedAddress address;
+        address.family = info->ai_family;
+        address.socktype = info->ai_socktype;
+        address.protocol = info->ai_protocol;
+        std::memcpy(&address.address, info->ai_addr, info->ai_addrlen);
+        address.address_length = info->ai_addrlen;
+        addresses.push_back(address);
+    }
+    freeaddrinfo(result);
+    if (addresses.empty()) {
+        error = "no usable address";
+        return {};
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (entries_.size() >= max_entries_) {
+        evict(now);
+    }
+    entries_[key] = Entry{addresses, now + ttl_};
+    auto family = families_.find(host);
+    return interleave(addresses, family == families_.end() ? AF_INET6 : family->second);
+}
+
+void AddressCache::remember_family(const std::string& host, int family) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (families_.size() >= max_entries_ && families_.find(host) == families_.end()) {
+        families_.clear();
+    }
+    families_[host] = family;
+}
+
+int AddressCache::preferred_family(const std::string& host) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = families_.find(host);
+    return it == families_.end() ? AF_UNSPEC : it->second;
+}
+
+std::vector<ResolvedAddress> AddressCache::interleave(const std::vector<ResolvedAddress>& addresses,
+                                                      int first_family) {
+    std::vector<const ResolvedAddress*> first;
+    std::vector<const ResolvedAddress*> second;
+    for (const auto& address : addresses) {
+        (address.family == first_family ? first : second).push_back(&address);
+    }
+
+    std::vector<ResolvedAddress> ordered;
+    ordered.reserve(addresses.size());
+    for (size_t i = 0; i < first.size() || i < second.size(); ++i) {
+        if (i < first.size()) {
+            ordered.push_back(*first[i]);
+        }
+        if (i < second.size()) {
+            ordered.push_back(*second[i]);
+        }
+    }
+    return ordered;
+}
+
+void AddressCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+    families_.clear();
+}
+
+void AddressCache::evict(std::chrono::steady_clock::time_point now) {
+    for (auto it = entries_.begin(); it != entries_.end();) {
+        if (now >= it->second.expires) {
+            it = entries_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    if (entries_.size() >= max_entries_) {
+        entries_.erase(entries_.begin());
+    }
+}
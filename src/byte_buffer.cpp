@@ -0,0 +1,80 @@
+#include "byte_buffer.h"
+
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+constexpr size_t kMaxPooled = 64;
+constexpr size_t kMaxPooledCapacity = 8 * 1024 * 1024;  // Outsized pages go back to the allocator
+
+class StoragePool {
+public:
+    static StoragePool& instance() {
+        static StoragePool pool;
+        return pool;
+    }
+
+    std::string acquire(size_t capacity) {
+        std::string storage;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!free_.empty()) {
+                storage = std::move(free_.back());
+                free_.pop_back();
+            }
+        }
+        storage.reserve(capacity);
+        return storage;
+    }
+
+    void release(std::string* storage) {
+        if (storage->capacity() <= kMaxPooledCapacity) {
+            storage->clear();
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (free_.size() < kMaxPooled) {
+                free_.push_back(std::move(*storage));
+            }
+        }
+        delete storage;
+    }
+
+private:
+    std::mutex mutex_;
+    std::vector<std::string> free_;
+};
+
+} // namespace
+
+ByteBuffer ByteBuffer::adopt(std::string&& bytes) {
+    ByteBuffer buffer;
+    if (bytes.empty()) {
+        return buffer;
+    }
+    auto* storage = new std::string(std::move(bytes));
+    buffer.storage_ = std::shared_ptr<const std::string>(
+        storage, [](const std::string* released) {
+            StoragePool::instance().release(const_cast<std::string*>(released));
+        });
+    buffer.data_ = storage->data();
+    buffer.size_ = storage->size();
+    return buffer;
+}
+
+std::string ByteBuffer::acquire(size_t capacity) {
+    return StoragePool::instance().acquire(capacity);
+}
+
+ByteBuffer ByteBuffer::slice(size_t offset, size_t length) const {
+    ByteBuffer part;
+    offset = std::min(offset, size_);
+    length = std::min(length, size_ - offset);
+    if (length == 0) {
+        return part;
+    }
+    part.storage_ = storage_;
+    part.data_ = data_ + offset;
+    part.size_ = length;
+    return part;
+}
@@ -0,0 +1,127 @@
+#include "circuit_breaker.h"
+#include <algorithm>
+#include <bitset>
+
+CircuitBreaker::CircuitBreaker(const CircuitLimits& limits) {
+    set_limits(limits);
+}
+
+void CircuitBreaker::set_limits(const CircuitLimits& limits) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    limits_ = limits;
+    limits_.window = std::max<size_t>(1, std::min<size_t>(limits_.window, 64));
+    limits_.min_requests = std::max<size_t>(1, std::min(limits_.min_requests, limits_.window));
+    limits_.open_for = std::max(std::chrono::seconds(1), limits_.open_for);
+    limits_.max_open_for = std::max(limits_.open_for, limits_.max_open_for);
+}
+
+bool CircuitBreaker::allow(const std::string& host, Clock::time_point now) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (open_count_ == 0) {
+        return true;
+    }
+    auto it = hosts_.find(host);
+    if (it == hosts_.end() || it->second.state != CircuitState::Open) {
+        return true;
+    }
+    if (now < it->second.open_until) {
+        return false;
+    }
+    it->second.state = CircuitState::HalfOpen;
+    open_count_--;
+    return true;
+}
+
+bool CircuitBreaker::is_open(const std::string& host, Clock::time_point now) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (open_count_ == 0) {
+        return false;
+    }
+    auto it = hosts_.find(host);
+    return it != hosts_.end() && it->second.state == CircuitState::Open &&
+           now < it->second.open_until;
+}
+
+bool CircuitBreaker::record(const std::string& host, bool success, Clock::time_point now) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = hosts_.find(host);
+    if (it == hosts_.end()) {
+        if (success) {
+            return false;  // Healthy hosts are not tracked
+        }
+        it = hosts_.emplace(host, HostState()).first;
+    }
+    HostState& state = it->second;
+
+    switch (state.state) {
+        case CircuitState::Open:
+            return false;  // Late outcome of a request sent before the circuit opened
+        case CircuitState::HalfOpen:
+            if (success) {
+                hosts_.erase(it);
+                return false;
+            }
+            trip(state, std::min(limits_.max_open_for, state.open_for * 2), now);
+            return true;
+        case CircuitState::Closed:
+            break;
+    }
+
+    uint64_t mask = limits_.window == 64 ? ~0ULL : ((1ULL << limits_.window) - 1);
+    state.outcomes = ((state.outcomes << 1) | (success ? 0 : 1)) & mask;
+    state.count = std::min<uint32_t>(state.count + 1, static_cast<uint32_t>(limits_.window));
+
+    size_t failures = std::bitset<64>(state.outcomes).count();
+    if (failures == 0) {
+        hosts_.erase(it);
+        return false;
+    }
+    if (state.count >= limits_.min_requests &&
+        static_cast<double>(failures) / state.count >= limits_.failure_rate) {
+        trip(state, limits_.open_for, now);
+        return true;
+    }
+    return false;
+}
+
+CircuitState CircuitBreaker::state(const std::string& host) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = hosts_.find(host);
+    return it == hosts_.end() ? CircuitState::Closed : it->second.state;
+}
+
+std::vector<std::string> CircuitBreaker::cooled_down(Clock::time_point now) {
+    std::vector<std::string> hosts;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (open_count_ == 0) {
+        return hosts;
+    }
+    for (auto& [host, state] : hosts_) {
+        if (state.state == CircuitState::Open && now >= state.open_until) {
+            state.state = CircuitState::HalfOpen;
+            open_count_--;
+            hosts.push_back(host);
+        }
+    }
+    return hosts;
+}
+
+size_t CircuitBreaker::open_hosts() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return open_count_;
+}
+
+void CircuitBreaker::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    hosts_.clear();
+    open_count_ = 0;
+}
+
+void CircuitBreaker::trip(HostState& state, std::chrono::seconds open_for, Clock::time_point now) {
+    state.state = CircuitState::Open;
+    state.open_for = open_for;
+    state.open_until = now + open_for;
+    state.outcomes = 0;
+    state.count = 0;
+    open_count_++;
+}
@@ -0,0 +1,238 @@
+#include "code_language_detector.h"
+#include "logger.h"
+#include <cctype>
+#include <deque>
+#include <limits>
+
+namespace {
+
+struct KeywordSpec {
+    const char* language;
+    const char* keyword;
+    int weight;
+};
+
+// Built-in language table. Strong, unambiguous markers weigh more than
+// tokens shared by several languages; a snippet needs a score of at least
+// two, so a lone "import " or "let " is not enough to label it.
+const KeywordSpec kDefaultKeywords[] = {
+    {"js", "function ", 2},
+    {"js", "const ", 1},
+    {"js", "let ", 1},
+    {"js", "var ", 1},
+    {"js", "import {", 2},
+    {"js", "console.log", 3},
+    {"js", "=> ", 1},
+    {"js", "===", 2},
+    {"js", "document.", 2},
+    {"php", "<?php", 5},
+    {"php", "echo $", 3},
+    {"php", "$this->", 3},
+    {"python", "def ", 2},
+    {"python", "import ", 1},
+    {"python", "from ", 1},
+    {"python", "self.", 2},
+    {"python", "elif ", 3},
+    {"python", "print(", 1},
+    {"python", "__init__", 3},
+    {"cpp", "#include", 5},
+    {"cpp", "std::", 3},
+    {"cpp", "template<", 3},
+    {"cpp", "nullptr", 3},
+    {"rust", "pub fn ", 4},
+    {"rust", "fn ", 1},
+    {"rust", "let mut ", 3},
+    {"rust", "println!", 3},
+    {"rust", "impl ", 2},
+    {"go", "func ", 2},
+    {"go", "package ", 2},
+    {"go", ":= ", 1},
+    {"go", "fmt.", 3},
+    {"java", "public static void", 4},
+    {"java", "system.out.print", 4},
+    {"java", "import java.", 4},
+    {"sql", "create table", 4},
+    {"sql", "select ", 1},
+    {"sql", " from ", 1},
+    {"sql", "insert into", 4},
+    {"sql", "where ", 1},
+    {"html", "<html", 4},
+    {"html", "<!doctype", 4},
+    {"html", "<div", 2},
+    {"css", "@media", 3},
+    {"css", ".css", 2},
+    {"css", "px;", 2},
+    {"bash", "#!/bin/bash", 5},
+    {"bash", "#!/bin/sh", 5},
+    {"bash", "$(", 2},
+    {"bash", "sudo ", 2},
+    {"bash", "apt-get ", 2},
+    {"bash", "echo ", 1},
+};
+
+bool is_word_char(unsigned char c) {
+    return std::isalnum(c) || c == '_';
+}
+
+} // namespace
+
+CodeLanguageDetector::CodeLanguageDetector()
+    : char_class_(),
+      min_score_(2),
+      compiled_(false) {
+}
+
+void CodeLanguageDetector::add_keyword(const std::string& language, const std::string& keyword, int weight) {
+    if (keyword.empty() || keyword.size() > std::numeric_limits<uint16_t>::max()) {
+        return;
+    }
+    std::string lowered;
+    lowered.reserve(keyword.size());
+    for (unsigned char c : keyword) {
+        lowered += static_cast<char>(std::tolower(c));
+    }
+    keywords_.push_back({lowered, language_id(language), weight});
+    compiled_ = false;
+}
+
+void CodeLanguageDetector::set_min_score(int min_score) {
+    min_score_ = min_score;
+}
+
+uint16_t CodeLanguageDetector::language_id(const std::string& language) {
+    for (size_t i = 0; i < languages_.size(); ++i) {
+        if (languages_[i] == language) {
+            return static_cast<uint16_t>(i);
+        }
+    }
+    languages_.push_back(language);
+    return static_cast<uint16_t>(languages_.size() - 1);
+}
+
+void CodeLanguageDetector::compile() {
+    // Map every byte that occurs in a keyword to a compact class; class 0 is
+    // "anything else" and never advances the automaton past the root.
+    char_class_.fill(0);
+    size_t next_class = 1;
+    std::vector<Keyword> accepted;
+    for (const auto& keyword : keywords_) {
+        bool fits = true;
+        for (unsigned char c : keyword.text) {
+            if (char_class_[c] == 0) {
+                if (next_class >= kAlphabetSize) {
+                    fits = false;
+                    break;
+                }
+                char_class_[c] = static_cast<uint8_t>(next_class++);
+            }
+        }
+        if (!fits) {
+            Logger::instance().warn("CodeLanguageDetector: alphabet full, skipping keyword: " + keyword.text);
+            continue;
+        }
+        accepted.push_back(keyword);
+    }
+    for (int c = 'A'; c <= 'Z'; ++c) {
+        char_class_[c] = char_class_[std::tolower(c)];
+    }
+    // Any whitespace matches a space in a keyword
+    char_class_[static_cast<unsigned char>('\t')] = char_class_[static_cast<unsigned char>(' ')];
+    char_class_[static_cast<unsigned char>('\n')] = char_class_[static_cast<unsigned char>(' ')];
+    char_class_[static_cast<unsigned char>('\r')] = char_class_[static_cast<unsigned char>(' ')];
+
+    // Trie of all keywords
+    constexpr uint32_t kNone = std::numeric_limits<uint32_t>::max();
+    std::array<uint32_t, kAlphabetSize> empty_row;
+    empty_row.fill(kNone);
+    transitions_.assign(1, empty_row);
+    outputs_.assign(1, {});
+
+    for (const auto& keyword : accepted) {
+        uint32_t state = 0;
+        for (unsigned char c : keyword.text) {
+            uint8_t cls = char_class_[c];
+            if (transitions_[state][cls] == kNone) {
+                transitions_[state][cls] = static_cast<uint32_t>(transitions_.size());
+                transitions_.push_back(empty_row);
+                outputs_.emplace_back();
+            }
+            state = transitions_[state][cls];
+        }
+        outputs_[state].push_back({keyword.language,
+                                   static_cast<uint16_t>(keyword.text.size()),
+                                   keyword.weight,
+                                   is_word_char(static_cast<unsigned char>(keyword.text[0]))});
+    }
+
+    // Breadth-first failure links, folded into a full transition table so
+    // matching is one table lookup per input byte.
+    std::vector<uint32_t> fail(transitions_.size(), 0);
+    std::deque<uint32_t> queue;
+    for (size_t cls = 0; cls < kAlphabetSize; ++cls) {
+        uint32_t child = transitions_[0][cls];
+        if (child == kNone) {
+            transitions_[0][cls] = 0;
+        } else {
+            fail[child] = 0;
+            queue.push_back(child);
+        }
+    }
+    while (!queue.empty()) {
+        uint32_t state = queue.front();
+        queue.pop_front();
+        const auto& inherited = outputs_[fail[state]];
+        outputs_[state].insert(outputs_[state].end(), inherited.begin(), inherited.end());
+        for (size_t cls = 0; cls < kAlphabetSize; ++cls) {
+            uint32_t child = transitions_[state][cls];
+            if (child == kNone) {
+                transitions_[state][cls] = transitions_[fail[state]][cls];
+            } else {
+                fail[child] = transitions_[fail[state]][cls];
+                queue.push_back(child);
+            }
+        }
+    }
+
+    compiled_ = true;
+}
+
+std::string CodeLanguageDetector::detect(const std::string& code_snippet) const {
+    if (!compiled_ || languages_.empty()) {
+        return "";
+    }
+
+    std::vector<int> scores(languages_.size(), 0);
+    uint32_t state = 0;
+    for (size_t i = 0; i < code_snippet.size(); ++i) {
+        state = transitions_[state][char_class_[static_cast<unsigned char>(code_snippet[i])]];
+        for (const auto& output : outputs_[state]) {
+            size_t start = i + 1 - output.length;
+            if (output.needs_boundary && start > 0 &&
+                is_word_char(static_cast<unsigned char>(code_snippet[start - 1]))) {
+                continue;
+            }
+            scores[output.language] += output.weight;
+        }
+    }
+
+    // Highest score wins; ties go to the language registered first
+    size_t best = 0;
+    for (size_t i = 1; i < scores.size(); ++i) {
+        if (scores[i] > scores[best]) {
+            best = i;
+        }
+    }
+    return scores[best] >= min_score_ ? languages_[best] : "";
+}
+
+const CodeLanguageDetector& CodeLanguageDetector::default_detector() {
+    static const CodeLanguageDetector detector = [] {
+        CodeLanguageDetector built;
+        for (const auto& spec : kDefaultKeywords) {
+            built.add_keyword(spec.language, spec.keyword, spec.weight);
+        }
+        built.compile();
+        return built;
+    }();
+    return detector;
+}
@@ -60,6 +60,49 @@ CrawlerConfig ConfigLoader::from_command_line(int argc, char* argv[]) {
         if (arg == "--output-dir" && i + 1 < argc) {
             config.output_dir = argv[i + 1];
         }
+        if (arg == "--extraction-mode" && i + 1 < argc) {
+            config.extraction_mode = argv[i + 1];
+        }
+        if (arg == "--learn-templates") {
+            config.learn_templates = true;
+        }
+        if (arg == "--robots-prefetch-workers" && i + 1 < argc) {
+            config.robots_prefetch_workers = std::stoi(argv[i + 1]);
+        }
+        if (arg == "--strip-params" && i + 1 < argc) {
+            // Comma-separated: --strip-params "utm_*,ref,sessionid"
+            config.strip_query_params.clear();
+            std::istringstream iss(argv[i + 1]);
+            std::string name;
+            while (std::getline(iss, name, ',')) {
+                name.erase(0, name.find_first_not_of(" \t"));
+                name.erase(name.find_last_not_of(" \t") + 1);
+                if (!name.empty()) {
+                    config.strip_query_params.push_back(name);
+                }
+            }
+        }
+        if (arg == "--sort-query") {
+            config.sort_query_params = true;
+        }
+        if (arg == "--learn-dust-rules") {
+            config.learn_dust_rules = true;
+        }
+        if (arg == "--no-trap-detection") {
+            config.detect_crawler_traps = false;
+        }
+        if (arg == "--fifo-order") {
+            config.importance_ordering = false;
+        }
+        if (arg == "--recrawl") {
+            config.recrawl = true;
+        }
+        if (arg == "--recrawl-min-interval" && i + 1 < argc) {
+            config.recrawl_min_interval = std::stol(argv[i + 1]);
+        }
+        if (arg == "--recrawl-max-interval" && i + 1 < argc) {
+            config.recrawl_max_interval = std::stol(argv[i + 1]);
+        }
         if (arg == "--headless") {
             config.enable_headless_rendering = true;
         }
@@ -132,13 +175,32 @@ void ConfigLoader::save(const std::string& filepath, const CrawlerConfig& config
         file << "    \"user_agent\": \"" << config.user_agent << "\",\n";
         file << "    \"follow_redirects\": " << (config.follow_redirects ? "true" : "false") << ",\n";
         file << "    \"respect_robots_txt\": " << (config.respect_robots_txt ? "true" : "false") << ",\n";
-        file << "    \"respect_meta_tags\": " << (config.respect_meta_tags ? "true" : "false") << "\n";
+        file << "    \"respect_meta_tags\": " << (config.respect_meta_tags ? "true" : "false") << ",\n";
+        file << "    \"extraction_mode\": \"" << config.extraction_mode << "\",\n";
+        file << "    \"learn_templates\": " << (config.learn_templates ? "true" : "false") << ",\n";
+        file << "    \"robots_prefetch_workers\": " << config.robots_prefetch_workers << ",\n";
+        file << "    \"strip_query_params\": [";
+        for (size_t i = 0; i < config.strip_query_params.size(); i++) {
+            file << (i > 0 ? ", " : "") << "\"" << config.strip_query_params[i] << "\"";
+        }
+        file << "],\n";
+        file << "    \"sort_query_params\": " << (config.sort_query_params ? "true" : "false") << ",\n";
+        file << "    \"learn_dust_rules\": " << (config.learn_dust_rules ? "true" : "false") << ",\n";
+        file << "    \"detect_crawler_traps\": " << (config.detect_crawler_traps ? "true" : "false") << ",\n";
+        file << "    \"importance_ordering\": " << (config.importance_ordering ? "true" : "false") << ",\n";
+        file << "    \"recrawl\": " << (config.recrawl ? "true" : "false") << ",\n";
+        file << "    \"recrawl_min_interval\": " << config.recrawl_min_interval << ",\n";
+        file << "    \"recrawl_max_interval\": " << config.recrawl_max_interval << "\n";
         file << "  },\n";
 
         file << "  \"output\": {\n";
         file << "    \"format\": \"" << config.output_format << "\",\n";
         file << "    \"output_dir\": \"" << config.output_dir << "\",\n";
-        file << "    \"batch_size\": " << config.batch_size << "\n";
+        file << "    \"batch_size\": " << config.batch_size << ",\n";
+        file << "    \"shard_max_mb\": " << config.shard_max_mb << ",\n";
+        file << "    \"shard_max_seconds\": " << config.shard_max_seconds << ",\n";
+        file << "    \"compression\": \"" << config.compression << "\",\n";
+        file << "    \"row_group_size\": " << config.row_group_size << "\n";
         file << "  },\n";
 
         file << "  \"urls\": [\n";
@@ -246,6 +308,114 @@ CrawlerConfig ConfigLoader::parse_json(const std::string& json_str) {
             config.user_agent = json_str.substr(quote1_pos + 1, quote2_pos - quote1_pos - 1);
         }
 
+        // Extract extraction_mode
+        size_t mode_pos = json_str.find("\"extraction_mode\"");
+        if (mode_pos != std::string::npos) {
+            size_t colon_pos = json_str.find(":", mode_pos);
+            size_t quote1_pos = json_str.find("\"", colon_pos);
+            size_t quote2_pos = json_str.find("\"", quote1_pos + 1);
+            config.extraction_mode = json_str.substr(quote1_pos + 1, quote2_pos - quote1_pos - 1);
+        }
+
+        // Extract learn_templates
+        size_t templates_pos = json_str.find("\"learn_templates\"");
+        if (templates_pos != std::string::npos) {
+            size_t colon_pos = json_str.find(":", templates_pos);
+            size_t comma_pos = json_str.find_first_of(",}", colon_pos);
+            std::string enabled_str = json_str.substr(colon_pos + 1, comma_pos - colon_pos - 1);
+            config.learn_templates = enabled_str.find("true") != std::string::npos;
+        }
+
+        // Extract robots_prefetch_workers
+        size_t prefetch_pos = json_str.find("\"robots_prefetch_workers\"");
+        if (prefetch_pos != std::string::npos) {
+            size_t colon_pos = json_str.find(":", prefetch_pos);
+            size_t comma_pos = json_str.find_first_of(",}", colon_pos);
+            std::string workers_str = json_str.substr(colon_pos + 1, comma_pos - colon_pos - 1);
+            workers_str.erase(0, workers_str.find_first_not_of(" \t\n\r"));
+            config.robots_prefetch_workers = std::stoi(workers_str);
+        }
+
+        // Extract strip_query_params
+        size_t strip_pos = json_str.find("\"strip_query_params\"");
+        if (strip_pos != std::string::npos) {
+            size_t bracket_pos = json_str.find("[", strip_pos);
+            size_t end_bracket_pos = json_str.find("]", bracket_pos);
+            std::string params_section = json_str.substr(bracket_pos + 1, end_bracket_pos - bracket_pos - 1);
+
+            config.strip_query_params.clear();
+            size_t start = 0;
+            while ((start = params_section.find("\"", start)) != std::string::npos) {
+                size_t end = params_section.find("\"", start + 1);
+                if (end == std::string::npos) {
+                    break;
+                }
+                config.strip_query_params.push_back(params_section.substr(start + 1, end - start - 1));
+                start = end + 1;
+            }
+        }
+
+        // Extract sort_query_params
+        size_t sort_pos = json_str.find("\"sort_query_params\"");
+        if (sort_pos != std::string::npos) {
+            size_t colon_pos = json_str.find(":", sort_pos);
+            size_t comma_pos = json_str.find_first_of(",}", colon_pos);
+            std::string enabled_str = json_str.substr(colon_pos + 1, comma_pos - colon_pos - 1);
+            config.sort_query_params = enabled_str.find("true") != std::string::npos;
+        }
+
+        // Extract learn_dust_rules
+        size_t dust_pos = json_str.find("\"learn_dust_rules\"");
+        if (dust_pos != std::string::npos) {
+            size_t colon_pos = json_str.find(":", dust_pos);
+            size_t comma_pos = json_str.find_first_of(",}", colon_pos);
+            std::string enabled_str = json_str.substr(colon_pos + 1, comma_pos - colon_pos - 1);
+            config.learn_dust_rules = enabled_str.find("true") != std::string::npos;
+        }
+
+        // Extract detect_crawler_traps
+        size_t traps_pos = json_str.find("\"detect_crawler_traps\"");
+        if (traps_pos != std::string::npos) {
+            size_t colon_pos = json_str.find(":", traps_pos);
+            size_t comma_pos = json_str.find_first_of(",}", colon_pos);
+            std::string enabled_str = json_str.substr(colon_pos + 1, comma_pos - colon_pos - 1);
+            config.detect_crawler_traps = enabled_str.find("true") != std::string::npos;
+        }
+
+        // Extract importance_ordering
+        size_t order_pos = json_str.find("\"importance_ordering\"");
+        if (order_pos != std::string::npos) {
+            size_t colon_pos = json_str.find(":", order_pos);
+            size_t comma_pos = json_str.find_first_of(",}", colon_pos);
+            std::string enabled_str = json_str.substr(colon_pos + 1, comma_pos - colon_pos - 1);
+            config.importance_ordering = enabled_str.find("true") != std::string::npos;
+        }
+
+        // Extract recrawl settings
+        size_t recrawl_pos = json_str.find("\"recrawl\"");
+        if (recrawl_pos != std::string::npos) {
+            size_t colon_pos = json_str.find(":", recrawl_pos);
+            size_t comma_pos = json_str.find_first_of(",}", colon_pos);
+            std::string enabled_str = json_str.substr(colon_pos + 1, comma_pos - colon_pos - 1);
+            config.recrawl = enabled_str.find("true") != std::string::npos;
+        }
+        size_t min_interval_pos = json_str.find("\"recrawl_min_interval\"");
+        if (min_interval_pos != std::string::npos) {
+            size_t colon_pos = json_str.find(":", min_interval_pos);
+            size_t comma_pos = json_str.find_first_of(",}", colon_pos);
+            std::string interval_str = json_str.substr(colon_pos + 1, comma_pos - colon_pos - 1);
+            interval_str.erase(0, interval_str.find_first_not_of(" \t\n\r"));
+            config.recrawl_min_interval = std::stol(interval_str);
+        }
+        size_t max_interval_pos = json_str.find("\"recrawl_max_interval\"");
+        if (max_interval_pos != std::string::npos) {
+            size_t colon_pos = json_str.find(":", max_interval_pos);
+            size_t comma_pos = json_str.find_first_of(",}", colon_pos);
+            std::string interval_str = json_str.substr(colon_pos + 1, comma_pos - colon_pos - 1);
+            interval_str.erase(0, interval_str.find_first_not_of(" \t\n\r"));
+            config.recrawl_max_interval = std::stol(interval_str);
+        }
+
         // Extract output_format
         size_t fmt_pos = json_str.find("\"format\"");
         if (fmt_pos != std::string::npos) {
@@ -264,6 +434,49 @@ CrawlerConfig ConfigLoader::parse_json(const std::string& json_str) {
             config.output_dir = json_str.substr(quote1_pos + 1, quote2_pos - quote1_pos - 1);
         }
 
+        // Extract batch_size and shard rotation limits
+        size_t batch_pos = json_str.find("\"batch_size\"");
+        if (batch_pos != std::string::npos) {
+            size_t colon_pos = json_str.find(":", batch_pos);
+            size_t comma_pos = json_str.find_first_of(",}", colon_pos);
+            std::string batch_str = json_str.substr(colon_pos + 1, comma_pos - colon_pos - 1);
+            batch_str.erase(0, batch_str.find_first_not_of(" \t\n\r"));
+            config.batch_size = std::stoi(batch_str);
+        }
+        size_t shard_mb_pos = json_str.find("\"shard_max_mb\"");
+        if (shard_mb_pos != std::string::npos) {
+            size_t colon_pos = json_str.find(":", shard_mb_pos);
+            size_t comma_pos = json_str.find_first_of(",}", colon_pos);
+            std::string shard_str = json_str.substr(colon_pos + 1, comma_pos - colon_pos - 1);
+            shard_str.erase(0, shard_str.find_first_not_of(" \t\n\r"));
+            config.shard_max_mb = std::stol(shard_str);
+        }
+        size_t shard_seconds_pos = json_str.find("\"shard_max_seconds\"");
+        if (shard_seconds_pos != std::string::npos) {
+            size_t colon_pos = json_str.find(":", shard_seconds_pos);
+            size_t comma_pos = json_str.find_first_of(",}", colon_pos);
+            std::string shard_str = json_str.substr(colon_pos + 1, comma_pos - colon_pos - 1);
+            shard_str.erase(0, shard_str.find_first_not_of(" \t\n\r"));
+            config.shard_max_seconds = std::stol(shard_str);
+        }
+
+        // Extract Parquet settings
+        size_t compression_pos = json_str.find("\"compression\"");
+        if (compression_pos != std::string::npos) {
+            size_t colon_pos = json_str.find(":", compression_pos);
+            size_t quote1_pos = json_str.find("\"", colon_pos);
+            size_t quote2_pos = json_str.find("\"", quote1_pos + 1);
+            config.compression = json_str.substr(quote1_pos + 1, quote2_pos - quote1_pos - 1);
+        }
+        size_t row_group_pos = json_str.find("\"row_group_size\"");
+        if (row_group_pos != std::string::npos) {
+            size_t colon_pos = json_str.find(":", row_group_pos);
+            size_t comma_pos = json_str.find_first_of(",}", colon_pos);
+            std::string row_group_str = json_str.substr(colon_pos + 1, comma_pos - colon_pos - 1);
+            row_group_str.erase(0, row_group_str.find_first_not_of(" \t\n\r"));
+            config.row_group_size = std::stoi(row_group_str);
+        }
+
         // Extract headless settings
         size_t headless_pos = json_str.find("\"headless\"");
         if (headless_pos != std::string::npos) {
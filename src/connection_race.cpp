@@ -0,0 +1,102 @@
+#include "connection_race.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+ConnectionRace::ConnectionRace(EventLoop& loop, std::vector<ResolvedAddress> candidates)
+    : loop_(loop), candidates_(std::move(candidates)) {}
+
+ConnectionRace::~ConnectionRace() {
+    for (const auto& attempt : attempts_) {
+        loop_.forget(attempt.fd);
+        close(attempt.fd);
+    }
+}
+
+int ConnectionRace::step() {
+    if (attempts_.empty() && !start_next()) {
+        return -1;
+    }
+
+    std::vector<struct pollfd> fds(attempts_.size());
+    for (size_t i = 0; i < attempts_.size(); ++i) {
+        fds[i].fd = attempts_[i].fd;
+        fds[i].events = POLLOUT;
+    }
+    int ready = poll(fds.data(), fds.size(), 0);
+    if (ready < 0 && errno != EINTR) {
+        error_ = std::strerror(errno);
+    }
+
+    bool attempt_failed = false;
+    for (size_t i = fds.size(); i-- > 0;) {
+        if (ready <= 0 || fds[i].revents == 0) {
+            continue;
+        }
+        int socket_error = 0;
+        socklen_t len = sizeof(socket_error);
+        if (getsockopt(fds[i].fd, SOL_SOCKET, SO_ERROR, &socket_error, &len) == 0 && socket_error == 0) {
+            int fd = attempts_[i].fd;
+            winner_family_ = attempts_[i].family;
+            attempts_.erase(attempts_.begin() + static_cast<long>(i));
+            return fd;
+        }
+        error_ = socket_error == 0 ? "connect failed" : std::strerror(socket_error);
+        loop_.forget(fds[i].fd);
+        close(fds[i].fd);
+        attempts_.erase(attempts_.begin() + static_cast<long>(i));
+        attempt_failed = true;
+    }
+
+    // A failure hands its slot to the next candidate at once (RFC 8305 section 5)
+    if (next_ < candidates_.size() &&
+        (attempt_failed || attempts_.empty() || EventLoop::Clock::now() - last_start_ >= kAttemptDelay)) {
+        start_next();
+    }
+    return -1;
+}
+
+std::vector<int> ConnectionRace::pending() const {
+    std::vector<int> fds;
+    for (const auto& attempt : attempts_) {
+        fds.push_back(attempt.fd);
+    }
+    return fds;
+}
+
+EventLoop::Clock::time_point ConnectionRace::next_attempt_at() const {
+    return next_ < candidates_.size() ? last_start_ + kAttemptDelay : EventLoop::Clock::time_point::max();
+}
+
+// Start the next candidate that gets as far as an in-progress connect
+bool ConnectionRace::start_next() {
+    while (next_ < candidates_.size()) {
+        const ResolvedAddress& candidate = candidates_[next_++];
+        int fd = socket(candidate.family, candidate.socktype, candidate.protocol);
+        if (fd < 0) {
+            error_ = std::strerror(errno);
+            continue;
+        }
+        int flags = fcntl(fd, F_GETFL, 0);
+        if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+            error_ = "failed to set non-blocking socket";
+            close(fd);
+            continue;
+        }
+        int result = connect(fd, reinterpret_cast<const struct sockaddr*>(&candidate.address),
+                             candidate.address_length);
+        if (result != 0 && errno != EINPROGRESS) {
+            error_ = std::strerror(errno);
+            close(fd);
+            continue;
+        }
+        attempts_.push_back(Attempt{fd, candidate.family});
+        last_start_ = EventLoop::Clock::now();
+        return true;
+    }
+    return false;
+}
@@ -1,6 +1,7 @@
 #include "crawler.h"
 #include "logger.h"
 #include "raw_socket_http.h"
+#include "record_sink.h"
 #include <curl/curl.h>
 #include <iconv.h>
 #include <regex>
@@ -24,6 +25,43 @@ static size_t write_callback(void* contents, size_t size, size_t nmemb, std::str
     return size * nmemb;
 }
 
+// Response headers the crawler acts on, collected by header_callback
+struct CurlResponseHeaders {
+    HttpValidators validators;
+    std::string retry_after;
+};
+
+// Callback for CURL to capture response headers; a new status line (after a
+// redirect) starts a new response, so earlier values are dropped
+static size_t header_callback(char* buffer, size_t size, size_t nitems, CurlResponseHeaders* headers) {
+    size_t length = size * nitems;
+    std::string line(buffer, length);
+    if (line.compare(0, 5, "HTTP/") == 0) {
+        *headers = CurlResponseHeaders();
+        return length;
+    }
+    auto colon = line.find(':');
+    if (colon == std::string::npos) {
+        return length;
+    }
+    std::string name = line.substr(0, colon);
+    std::transform(name.begin(), name.end(), name.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    size_t value_start = line.find_first_not_of(" \t", colon + 1);
+    size_t value_end = line.find_last_not_of(" \t\r\n");
+    std::string value = value_start == std::string::npos || value_end < value_start
+        ? std::string()
+        : line.substr(value_start, value_end - value_start + 1);
+    if (name == "etag") {
+        headers->validators.etag = value;
+    } else if (name == "last-modified") {
+        headers->validators.last_modified = value;
+    } else if (name == "retry-after") {
+        headers->retry_after = value;
+    }
+    return length;
+}
+
 namespace {
 
 std::string escape_shell_arg(const std::string& value) {
@@ -47,7 +85,7 @@ std::string format_timestamp() {
     return oss.str();
 }
 
-bool needs_headless_rendering(const std::string& html, int status_code) {
+bool needs_headless_rendering(std::string_view html, int status_code) {
     if (status_code != 200) {
         return false;
     }
@@ -57,7 +95,7 @@ bool needs_headless_rendering(const std::string& html, int status_code) {
     if (html.size() < 256) {
         return true;
     }
-    std::string lowered = html;
+    std::string lowered(html);
     std::transform(lowered.begin(), lowered.end(), lowered.begin(),
                    [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
     if (lowered.find("enable javascript") != std::string::npos ||
@@ -76,6 +114,22 @@ bool needs_headless_rendering(const std::string& html, int status_code) {
     return false;
 }
 
+// Transport errors and server errors worth another attempt later; 429 and
+// 503 go through the host throttle first
+bool is_retryable_status(int status_code) {
+    return status_code == 0 || status_code == 500 || status_code == 502 ||
+           status_code == 503 || status_code == 504;
+}
+
+// Keeps every record, for callers that want the whole crawl back at once
+struct RecordCollector : RecordSink {
+    std::vector<DataRecord> records;
+
+    void push(DataRecord record) override {
+        records.push_back(std::move(record));
+    }
+};
+
 } // namespace
 
 WebCrawler::WebCrawler(const std::string& user_agent)
@@ -88,18 +142,29 @@ WebCrawler::WebCrawler(const std::string& user_agent)
       max_file_size_bytes_(100 * 1024 * 1024),  // 100 MB default
       db_manager_(std::make_unique<RocksDBManager>("rocksdb_queue")),
       text_extractor_(std::make_unique<TextExtractor>()),
+      enable_text_extraction_(false),
       db_path_("rocksdb_queue"),
       blocked_by_robots_(0),
       blocked_by_noindex_(0),
       skipped_by_size_(0),
       sitemaps_found_(0),
       duplicates_detected_(0),
+      dust_rewrites_(0),
+      blocked_by_trap_(0),
+      throttled_by_trap_(0),
+      recrawls_enqueued_(0),
+      pages_changed_(0),
+      not_modified_(0),
+      rate_limited_(0),
+      retries_scheduled_(0),
+      retries_denied_(0),
       http2_requests_(0),
       http11_requests_(0),
       http10_requests_(0),
       total_bytes_downloaded_(0),
       total_duration_ms_(0),
       last_request_duration_ms_(0),
+      last_retry_after_seconds_(-1),
       latency_ema_ms_(0.0),
       consecutive_failures_(0),
       consecutive_successes_(0),
@@ -107,11 +172,26 @@ WebCrawler::WebCrawler(const std::string& user_agent)
       last_request_time_(),
       current_domain_(),
       robots_cache_(),
-      robots_sitemaps_cache_(),
-      robots_rules_cache_(),
-      robots_crawl_delay_cache_(),
-      robots_cache_time_(),
-      robots_sitemaps_cache_time_(),
+      url_canonicalizer_(),
+      enable_dust_learning_(false),
+      dust_learner_(),
+      enable_trap_detection_(false),
+      trap_detector_(),
+      enable_importance_ordering_(false),
+      importance_(),
+      enable_recrawl_(false),
+      recrawl_scheduler_(),
+      last_recrawl_poll_(),
+      host_throttle_(),
+      circuit_breaker_(),
+      retry_budget_(),
+      retry_attempts_(),
+      host_latency_(),
+      robots_prefetch_workers_(0),
+      robots_prefetcher_(),
+      parked_urls_(),
+      deferred_hosts_(),
+      parked_mutex_(),
       crawl_start_time_(),
       visited_urls_memory_(),
       enable_periodic_stats_(false),
@@ -138,6 +218,7 @@ WebCrawler::WebCrawler(const std::string& user_agent)
 }
 
 WebCrawler::~WebCrawler() {
+    robots_prefetcher_.stop();
     stop_stats_reporter();
     curl_global_cleanup();
 }
@@ -170,6 +251,171 @@ void WebCrawler::set_headless_rendering(bool enable, const std::string& chrome_p
     chrome_timeout_seconds_ = std::max(1, timeout_seconds);
 }
 
+void WebCrawler::set_extraction_mode(ExtractionMode mode) {
+    text_extractor_->set_extraction_mode(mode);
+}
+
+void WebCrawler::enable_text_extraction(bool enable) {
+    enable_text_extraction_ = enable;
+}
+
+void WebCrawler::enable_template_learning(bool enable) {
+    text_extractor_->enable_template_learning(enable);
+    if (!enable) {
+        return;
+    }
+    // Learned templates live next to the crawl queue
+    text_extractor_->set_template_persistence(
+        [this](const std::string& host) {
+            return ensure_db_initialized() ? db_manager_->get_host_template(host) : std::string();
+        },
+        [this](const std::string& host, const std::string& data) {
+            if (ensure_db_initialized()) {
+                db_manager_->store_host_template(host, data);
+            }
+        });
+}
+
+void WebCrawler::enable_dust_learning(bool enable) {
+    enable_dust_learning_ = enable;
+    if (!enable) {
+        return;
+    }
+    // Learned rules live next to the crawl queue
+    dust_learner_.set_persistence(
+        [this](const std::string& host) {
+            return ensure_db_initialized() ? db_manager_->get_dust_rules(host) : std::string();
+        },
+        [this](const std::string& host, const std::string& data) {
+            if (ensure_db_initialized()) {
+                db_manager_->store_dust_rules(host, data);
+            }
+        });
+}
+
+void WebCrawler::enable_importance_ordering(bool enable) {
+    enable_importance_ordering_ = enable;
+    if (!enable) {
+        return;
+    }
+    // Scores written by the offline link_graph_rank tool, if it has run
+    importance_.set_rank_lookup([this](const std::string& url) {
+        return ensure_db_initialized() ? db_manager_->get_page_rank(url) : 0.0;
+    });
+}
+
+void WebCrawler::enable_recrawl(bool enable) {
+    enable_recrawl_ = enable;
+}
+
+void WebCrawler::set_recrawl_intervals(long min_interval_seconds, long max_interval_seconds) {
+    recrawl_scheduler_.set_intervals(min_interval_seconds, max_interval_seconds);
+}
+
+void WebCrawler::record_fetch_history(const std::string& url, uint64_t fingerprint, bool not_modified) {
+    if (!ensure_db_initialized()) {
+        return;
+    }
+    int64_t now = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+
+    FetchHistory history;
+    RecrawlScheduler::deserialize(db_manager_->get_fetch_history(url), history);
+    int64_t previous_due = history.next_due;
+    if (not_modified) {
+        fingerprint = history.fingerprint;  // A 304 is an observed "no change"
+    }
+    if (recrawl_scheduler_.record_fetch(history, fingerprint, now)) {
+        pages_changed_++;
+    }
+    db_manager_->store_fetch_history(url, RecrawlScheduler::serialize(history),
+                                     history.next_due, previous_due);
+}
+
+void WebCrawler::enqueue_due_recrawls() {
+    constexpr auto kPollInterval = std::chrono::seconds(10);
+    constexpr size_t kBatch = 500;
+    constexpr int kRecrawlPriority = 0;  // Same as seeds: freshness first
+
+    auto poll_time = std::chrono::steady_clock::now();
+    if (poll_time - last_recrawl_poll_ < kPollInterval) {
+        return;
+    }
+    last_recrawl_poll_ = poll_time;
+
+    int64_t now = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    std::vector<std::string> due = db_manager_->get_due_recrawls(now, kBatch);
+    if (due.empty()) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    for (const auto& url : due) {
+        // Lease the entry: if the refetch fails, the URL comes due again later
+        FetchHistory history;
+        RecrawlScheduler::deserialize(db_manager_->get_fetch_history(url), history);
+        int64_t previous_due = history.next_due;
+        history.next_due = now + recrawl_scheduler_.min_interval();
+        db_manager_->store_fetch_history(url, RecrawlScheduler::serialize(history),
+                                         history.next_due, previous_due);
+
+        visited_urls_memory_.erase(url);
+        db_manager_->unmark_visited(url);
+        if (db_manager_->enqueue_url(url, kRecrawlPriority)) {
+            recrawls_enqueued_++;
+        }
+    }
+    queue_cv_.notify_all();
+
+    std::ostringstream msg;
+    msg << "Recrawl: " << due.size() << " pages due for a revisit";
+    log_info(msg.str());
+}
+
+void WebCrawler::enable_trap_detection(bool enable) {
+    enable_trap_detection_ = enable;
+}
+
+void WebCrawler::set_trap_limits(const TrapLimits& limits) {
+    trap_detector_.set_limits(limits);
+}
+
+void WebCrawler::set_circuit_limits(const CircuitLimits& limits) {
+    circuit_breaker_.set_limits(limits);
+}
+
+std::vector<std::string> WebCrawler::get_trap_prefixes() const {
+    return trap_detector_.flagged_prefixes();
+}
+
+std::map<std::string, std::vector<std::string>> WebCrawler::get_dust_rules() {
+    std::map<std::string, std::vector<std::string>> rules;
+    if (!ensure_db_initialized()) {
+        return rules;
+    }
+    // Straight from RocksDB: rules are stored as soon as they are learned,
+    // and going through the learner would evict the hosts being crawled
+    for (const auto& host : db_manager_->get_dust_hosts()) {
+        std::vector<std::string> dropped = DustLearner::dropped_parameters(db_manager_->get_dust_rules(host));
+        if (!dropped.empty()) {
+            rules[host] = std::move(dropped);
+        }
+    }
+    return rules;
+}
+
+void WebCrawler::set_robots_prefetch_workers(int workers) {
+    robots_prefetch_workers_ = std::max(0, workers);
+}
+
+void WebCrawler::set_url_canonicalization(const std::vector<std::string>& stripped_params, bool sort_query) {
+    if (!stripped_params.empty()) {
+        url_canonicalizer_.set_stripped_params(stripped_params);
+    }
+    url_canonicalizer_.set_sort_query(sort_query);
+}
+
 void WebCrawler::set_clickhouse_config(const ClickHouseConfig& config) {
     clickhouse_config_ = config;
     if (clickhouse_config_.enabled) {
@@ -206,13 +452,230 @@ bool WebCrawler::enqueue_url(const std::string& url, int priority) {
         db_manager_->is_visited(normalized)) {
         return false;
     }
-    bool enqueued = db_manager_->enqueue_url(normalized, priority);
+    bool enqueued = admit_url(normalized, priority);
     if (enqueued) {
         queue_cv_.notify_one();
     }
     return enqueued;
 }
 
+bool WebCrawler::admit_url(const std::string& url, int priority) {
+    constexpr int kTrapDeferredPriority = 200;  // Behind discovered URLs and retries
+    std::string target = url;
+    
+    if (enable_dust_learning_ || enable_trap_detection_) {
+        Url parsed = Url::parse(url);
+        
+        // Drop parameters the host has been seen to ignore
+        if (enable_dust_learning_ && dust_learner_.rewrite(parsed)) {
+            dust_rewrites_++;
+            if (visited_urls_memory_.find(parsed.str()) != visited_urls_memory_.end() ||
+                db_manager_->is_visited(parsed.str())) {
+                return false;
+            }
+        }
+        
+        // Keep calendars, endless paths and facet explosions out of the queue
+        if (enable_trap_detection_) {
+            TrapVerdict verdict = trap_detector_.check(parsed);
+            if (verdict == TrapVerdict::Block) {
+                blocked_by_trap_++;
+                return false;
+            }
+            if (verdict == TrapVerdict::Throttle) {
+                // Over the prefix's allowance: crawled once better URLs run out
+                throttled_by_trap_++;
+                priority = std::max(priority, kTrapDeferredPriority);
+            }
+        }
+        target = parsed.release();
+    }
+    
+    // Rate-limited and failing hosts get their URLs back when their window ends
+    if (host_throttle_.paused_hosts() > 0 || circuit_breaker_.open_hosts() > 0) {
+        std::string domain = get_domain(target);
+        if (host_on_hold(domain)) {
+            park_url(domain, target, priority);
+            return true;
+        }
+    }
+    
+    // Hold back URLs of hosts whose robots.txt is not known yet
+    if (robots_prefetcher_.is_running()) {
+        std::string domain = get_domain(target);
+        std::lock_guard<std::mutex> lock(parked_mutex_);
+        if (!domain.empty() && !robots_cache_.find(domain)) {
+            parked_urls_[domain].emplace_back(target, priority);
+            robots_prefetcher_.schedule(domain);
+            return true;
+        }
+    }
+    return db_manager_->enqueue_url(target, priority);
+}
+
+void WebCrawler::release_parked_urls(const std::string& domain) {
+    if (host_on_hold(domain)) {
+        return;  // resume_paused_hosts() releases them when the window ends
+    }
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        std::lock_guard<std::mutex> parked_lock(parked_mutex_);
+        auto it = parked_urls_.find(domain);
+        bool deferred = deferred_hosts_.erase(domain) > 0;
+        if (it == parked_urls_.end() && !deferred) {
+            return;
+        }
+        if (it != parked_urls_.end()) {
+            for (const auto& [url, priority] : it->second) {
+                db_manager_->enqueue_url(url, priority);
+            }
+            parked_urls_.erase(it);
+        }
+        if (deferred) {
+            db_manager_->release_deferred_urls(domain);
+        }
+    }
+    queue_cv_.notify_all();
+}
+
+void WebCrawler::park_url(const std::string& domain, const std::string& url, int priority) {
+    // Hosts can stay on hold for long: their URLs wait in RocksDB, not in memory
+    std::lock_guard<std::mutex> lock(parked_mutex_);
+    if (db_manager_->defer_url(domain, url, priority)) {
+        deferred_hosts_.insert(domain);
+    } else {
+        parked_urls_[domain].emplace_back(url, priority);
+    }
+}
+
+bool WebCrawler::pause_rate_limited_host(const std::string& url, const std::string& normalized,
+                                         int status_code, int priority,
+                                         const ImportanceEstimator::Credit& credit) {
+    constexpr int kMaxRateLimitRetries = 5;  // Rate-limited responses in a row before giving up on a URL
+
+    std::string domain = get_domain(url);
+    auto pause = host_throttle_.rate_limited(domain, last_retry_after_seconds_, HostThrottle::Clock::now());
+    rate_limited_++;
+
+    std::ostringstream msg;
+    msg << url << " [" << status_code << "] - pausing " << domain << " for " << pause.count() << "s";
+    if (last_retry_after_seconds_ >= 0) {
+        msg << " (Retry-After)";
+    }
+    log_warn(msg.str());
+
+    if (host_throttle_.strikes(domain) > kMaxRateLimitRetries) {
+        return false;
+    }
+
+    // Fetch it again once the window ends
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        visited_urls_memory_.erase(normalized);
+        db_manager_->unmark_visited(normalized);
+    }
+    park_url(domain, url, priority);
+    if (enable_importance_ordering_) {
+        importance_.restore(normalized, credit, priority);
+    }
+    return true;
+}
+
+void WebCrawler::resume_paused_hosts() {
+    for (const auto& host : host_throttle_.expire(HostThrottle::Clock::now())) {
+        log_info("Pause window over, resuming " + host);
+        release_parked_urls(host);
+    }
+    for (const auto& host : circuit_breaker_.cooled_down(CircuitBreaker::Clock::now())) {
+        log_info("Circuit half-open, probing " + host);
+        release_parked_urls(host);
+    }
+}
+
+HostTimeouts WebCrawler::request_timeouts(const std::string& domain) {
+    HostTimeouts defaults;
+    defaults.total = std::chrono::seconds(timeout_);
+    defaults.idle = defaults.total;
+    defaults.connect = std::min<std::chrono::milliseconds>(
+        defaults.total, std::chrono::milliseconds(http_config_.connect_timeout_ms));
+    if (!http_config_.enable_adaptive_timeouts) {
+        return defaults;
+    }
+    return host_latency_.timeouts(domain, defaults);
+}
+
+bool WebCrawler::host_on_hold(const std::string& domain) const {
+    return host_throttle_.is_paused(domain, HostThrottle::Clock::now()) ||
+           circuit_breaker_.is_open(domain, CircuitBreaker::Clock::now());
+}
+
+bool WebCrawler::retry_failed_url(const std::string& url, const std::string& normalized, int status_code,
+                                  int priority, const ImportanceEstimator::Credit& credit) {
+    constexpr int kRetryPriority = 100;  // Behind every discovered URL
+
+    auto it = retry_attempts_.find(normalized);
+    int attempts = it == retry_attempts_.end() ? 0 : it->second;
+    if (attempts >= http_config_.max_retries) {
+        if (it != retry_attempts_.end()) {
+            retry_attempts_.erase(it);
+        }
+        return false;
+    }
+    if (!retry_budget_.try_spend()) {
+        retries_denied_++;
+        if (it != retry_attempts_.end()) {
+            retry_attempts_.erase(it);
+        }
+        return false;
+    }
+    retry_attempts_[normalized] = attempts + 1;
+    retries_scheduled_++;
+
+    std::ostringstream msg;
+    msg << url << " [" << status_code << "] - retry " << (attempts + 1) << "/"
+        << http_config_.max_retries << " rescheduled";
+    log_warn(msg.str());
+
+    // The page keeps its OPIC credit for the next attempt
+    priority = std::max(priority, kRetryPriority);
+    if (enable_importance_ordering_) {
+        importance_.restore(normalized, credit, priority);
+    }
+
+    std::string domain = get_domain(url);
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        visited_urls_memory_.erase(normalized);
+        db_manager_->unmark_visited(normalized);
+        if (!host_on_hold(domain)) {
+            db_manager_->enqueue_url(url, priority);
+            return true;
+        }
+    }
+    park_url(domain, url, priority);
+    return true;
+}
+
+bool WebCrawler::has_parked_urls() const {
+    std::lock_guard<std::mutex> lock(parked_mutex_);
+    if (circuit_breaker_.open_hosts() == 0) {
+        return !parked_urls_.empty() || !deferred_hosts_.empty();
+    }
+    // URLs of hosts behind an open circuit do not keep the crawl alive
+    auto now = CircuitBreaker::Clock::now();
+    for (const auto& entry : parked_urls_) {
+        if (!circuit_breaker_.is_open(entry.first, now)) {
+            return true;
+        }
+    }
+    for (const auto& host : deferred_hosts_) {
+        if (!circuit_breaker_.is_open(host, now)) {
+            return true;
+        }
+    }
+    return false;
+}
+
 int WebCrawler::get_skipped_by_size_count() const {
     return skipped_by_size_;
 }
@@ -230,6 +693,18 @@ CrawlerStats WebCrawler::get_statistics() const {
     stats.blocked_by_noindex = blocked_by_noindex_;
     stats.skipped_by_size = skipped_by_size_;
     stats.sitemaps_found = sitemaps_found_;
+    stats.dust_rewrites = dust_rewrites_;
+    stats.blocked_by_trap = blocked_by_trap_;
+    stats.throttled_by_trap = throttled_by_trap_;
+    stats.trap_prefixes = static_cast<int>(trap_detector_.flagged_prefixes().size());
+    stats.recrawls_enqueued = recrawls_enqueued_;
+    stats.pages_changed = pages_changed_;
+    stats.not_modified = not_modified_;
+    stats.rate_limited = rate_limited_;
+    stats.paused_hosts = static_cast<int>(host_throttle_.paused_hosts());
+    stats.open_circuits = static_cast<int>(circuit_breaker_.open_hosts());
+    stats.retries_scheduled = retries_scheduled_;
+    stats.retries_denied = retries_denied_;
     stats.duplicates_detected = duplicates_detected_;
     stats.http2_requests = http2_requests_;
     stats.http11_requests = http11_requests_;
@@ -252,33 +727,30 @@ int WebCrawler::get_blocked_by_noindex_count() const {
 }
 
 std::string WebCrawler::get_domain(const std::string& url) {
-    size_t start = url.find("://");
-    if (start == std::string::npos) return "";
-    
-    start += 3;
-    size_t end = url.find('/', start);
-    if (end == std::string::npos) end = url.length();
-    
-    return url.substr(start, end - start);
+    return get_domain(Url::parse(url));
 }
 
-std::string WebCrawler::extract_title(const std::string& html) {
+std::string WebCrawler::get_domain(const Url& url) {
+    return std::string(url.authority());
+}
+
+std::string WebCrawler::extract_title(std::string_view html) {
     std::regex title_regex("<title>([^<]+)</title>", std::regex::icase);
-    std::smatch match;
+    std::cmatch match;
     
-    if (std::regex_search(html, match, title_regex)) {
+    if (std::regex_search(html.data(), html.data() + html.size(), match, title_regex)) {
         return match[1].str();
     }
     return "No title";
 }
 
-bool WebCrawler::check_meta_tags(const std::string& html) {
+bool WebCrawler::check_meta_tags(std::string_view html) {
     // Check for noindex meta tag
     std::regex noindex_regex("meta\\s+name=[\"']robots[\"']\\s+content=[\"']([^\"']*)[\"']", 
                             std::regex::icase);
-    std::smatch match;
+    std::cmatch match;
     
-    if (std::regex_search(html, match, noindex_regex)) {
+    if (std::regex_search(html.data(), html.data() + html.size(), match, noindex_regex)) {
         std::string content = match[1].str();
         // Convert to lowercase for comparison
         std::transform(content.begin(), content.end(), content.begin(), ::tolower);
@@ -418,127 +890,62 @@ std::vector<RobotRule> WebCrawler::parse_robots_txt(const std::string& /* host *
 }
 
 bool WebCrawler::is_path_allowed(const std::vector<RobotRule>& rules, const std::string& path) {
-    std::vector<RobotRule> matching_rules;
-    
-    // Find all rules that match our user-agent
+    return compile_robots_rules(rules).is_allowed(path);
+}
+
+RobotsMatcher WebCrawler::compile_robots_rules(const std::vector<RobotRule>& rules) const {
+    // Groups that apply to our user-agent
+    std::vector<const RobotRule*> matching_rules;
     for (const auto& rule : rules) {
         for (const auto& agent : rule.user_agents) {
             if (matches_user_agent(agent, user_agent_)) {
-                matching_rules.push_back(rule);
+                matching_rules.push_back(&rule);
                 break;
             }
         }
     }
-    
-    if (matching_rules.empty()) {
-        return true;  // No rules found, allow everything
-    }
-    
-    // Sort by specificity (higher specificity first)
-    std::sort(matching_rules.begin(), matching_rules.end(),
-              [](const RobotRule& a, const RobotRule& b) {
-                  return a.specificity > b.specificity;
-              });
-    
-    // Combine rules from all matching non-wildcard rules, then add wildcard rules
-    std::vector<std::string> combined_disallows;
-    std::vector<std::string> combined_allows;
-    
-    for (auto& rule : matching_rules) {
-        bool is_wildcard = false;
-        for (const auto& agent : rule.user_agents) {
-            if (agent == "*") {
-                is_wildcard = true;
-                break;
-            }
+
+    auto is_wildcard = [](const RobotRule* rule) {
+        return std::find(rule->user_agents.begin(), rule->user_agents.end(), "*") != rule->user_agents.end();
+    };
+
+    // Named groups are combined; the wildcard group only applies when no
+    // named group has any rule
+    RobotsMatcher matcher;
+    for (bool wildcard : {false, true}) {
+        if (wildcard && matcher.pattern_count() > 0) {
+            break;
         }
-        
-        // Only include non-wildcard rules in combination
-        if (!is_wildcard) {
-            combined_disallows.insert(combined_disallows.end(),
-                                     rule.disallows.begin(), rule.disallows.end());
-            combined_allows.insert(combined_allows.end(),
-                                  rule.allows.begin(), rule.allows.end());
-        }
-    }
-    
-    // If no specific rules, add wildcard rules
-    if (combined_disallows.empty() && combined_allows.empty()) {
-        for (auto& rule : matching_rules) {
-            bool is_wildcard = false;
-            for (const auto& agent : rule.user_agents) {
-                if (agent == "*") {
-                    is_wildcard = true;
-                    break;
-                }
-            }
-            if (is_wildcard) {
-                combined_disallows.insert(combined_disallows.end(),
-                                         rule.disallows.begin(), rule.disallows.end());
-                combined_allows.insert(combined_allows.end(),
-                                      rule.allows.begin(), rule.allows.end());
+        for (const RobotRule* rule : matching_rules) {
+            if (is_wildcard(rule) != wildcard) {
+                continue;
             }
-        }
-    }
-    
-    // Find the longest matching allow and disallow rules
-    std::string best_allow;
-    std::string best_disallow;
-    size_t best_allow_len = 0;
-    size_t best_disallow_len = 0;
-    
-    for (const auto& allow_path : combined_allows) {
-        if (match_path_pattern(allow_path, path)) {
-            // Remove $ suffix for length comparison if present
-            std::string pattern_for_length = allow_path;
-            if (!pattern_for_length.empty() && pattern_for_length.back() == '$') {
-                pattern_for_length.pop_back();
+            for (const auto& pattern : rule->disallows) {
+                matcher.add_pattern(pattern, false);
             }
-            if (pattern_for_length.length() > best_allow_len) {
-                best_allow_len = pattern_for_length.length();
-                best_allow = allow_path;
+            for (const auto& pattern : rule->allows) {
+                matcher.add_pattern(pattern, true);
             }
         }
     }
-    
-    for (const auto& disallow_path : combined_disallows) {
-        if (disallow_path == "/" || match_path_pattern(disallow_path, path)) {
-            // Remove $ suffix for length comparison if present
-            std::string pattern_for_length = disallow_path;
-            if (!pattern_for_length.empty() && pattern_for_length.back() == '$') {
-                pattern_for_length.pop_back();
-            }
-            if (pattern_for_length.length() > best_disallow_len) {
-                best_disallow_len = pattern_for_length.length();
-                best_disallow = disallow_path;
-            }
+
+    // Crawl-delay of the most specific group that sets one; ties take the larger
+    double delay = -1.0;
+    int best_specificity = -1;
+    for (const RobotRule* rule : matching_rules) {
+        if (rule->crawl_delay_seconds < 0.0) {
+            continue;
+        }
+        if (rule->specificity > best_specificity) {
+            best_specificity = rule->specificity;
+            delay = rule->crawl_delay_seconds;
+        } else if (rule->specificity == best_specificity) {
+            delay = std::max(delay, rule->crawl_delay_seconds);
         }
     }
-    
-    // If no rules matched, allow the path
-    if (best_allow.empty() && best_disallow.empty()) {
-        return true;
-    }
-    
-    // If only allow matched, return true
-    if (!best_allow.empty() && best_disallow.empty()) {
-        return true;
-    }
-    
-    // If only disallow matched, return false
-    if (best_allow.empty() && !best_disallow.empty()) {
-        return false;
-    }
-    
-    // Both matched - use longest match
-    if (best_allow_len > best_disallow_len) {
-        return true;
-    } else if (best_disallow_len > best_allow_len) {
-        return false;
-    } else {
-        // Equal length - allow wins (least restrictive)
-        return true;
-    }
+    matcher.set_crawl_delay(delay);
+
+    return matcher;
 }
 
 // Overloaded version that accepts user-agent parameter
@@ -557,105 +964,186 @@ bool WebCrawler::is_path_allowed(const std::vector<RobotRule>& rules, const std:
 }
 
 bool WebCrawler::match_path_pattern(const std::string& pattern, const std::string& path) {
-    // Handle empty pattern (should not match anything except empty path)
-    if (pattern.empty()) {
-        return path.empty();
-    }
-    
-    // Check for $ end marker
-    bool has_end_marker = !pattern.empty() && pattern.back() == '$';
-    std::string actual_pattern = has_end_marker ? pattern.substr(0, pattern.length() - 1) : pattern;
-    
-    // Simple case: no wildcards
-    size_t wildcard_pos = actual_pattern.find('*');
-    if (wildcard_pos == std::string::npos) {
-        // No wildcard - just prefix matching
-        if (path.find(actual_pattern) == 0) {
-            // If has end marker, must match entire path
-            if (has_end_marker) {
-                return path == actual_pattern;
+    return RobotsMatcher::match_pattern(pattern, path);
+}
+
+bool WebCrawler::check_robots_txt(const std::string& url) {
+    Url parsed = Url::parse(url);
+    std::string domain = get_domain(parsed);
+    if (domain.empty()) return true;
+    
+    auto entry = robots_entry(domain);
+    if (!entry) {
+        return true;
+    }
+    return entry->matcher.is_allowed(parsed.request_target());
+}
+
+std::shared_ptr<const RobotsEntry> WebCrawler::robots_entry(const std::string& domain) {
+    return robots_cache_.get(domain, [this](const std::string& host) {
+        return load_robots_entry(host);
+    });
+}
+
+std::shared_ptr<const RobotsEntry> WebCrawler::load_robots_entry(const std::string& domain) {
+    // Persisted copy first: "<fetched_at_unix> <status>\n<body>"
+    if (ensure_db_initialized()) {
+        std::string stored = db_manager_->get_robots_txt(domain);
+        size_t space = stored.find(' ');
+        size_t newline = stored.find('\n');
+        if (space != std::string::npos && newline != std::string::npos && space < newline) {
+            try {
+                long long fetched_unix = std::stoll(stored.substr(0, space));
+                int status_code = std::stoi(stored.substr(space + 1, newline - space - 1));
+                auto fetched_at = std::chrono::system_clock::time_point(std::chrono::seconds(fetched_unix));
+                auto age = std::chrono::duration_cast<std::chrono::seconds>(
+                    std::chrono::system_clock::now() - fetched_at).count();
+                if (age <= http_config_.robots_cache_ttl_seconds) {
+                    return build_robots_entry(domain, status_code, stored.substr(newline + 1), fetched_at);
+                }
+            } catch (const std::exception&) {
+                log_warn("Ignoring malformed stored robots.txt for " + domain);
             }
-            return true;
         }
-        return false;
     }
     
-    // Handle wildcards - use regex matching for flexibility
-    std::string regex_pattern = actual_pattern;
+    int status_code = 0;
+    std::string robots_content = fetch_robots_txt(domain, status_code);
+    auto fetched_at = std::chrono::system_clock::now();
     
-    // Escape special regex characters except *
-    std::string escaped;
-    for (char c : regex_pattern) {
-        if (c == '*') {
-            escaped += ".*";  // * matches 0 or more of any character
-        } else if (c == '.' || c == '+' || c == '?' || c == '[' || c == ']' || 
-                   c == '(' || c == ')' || c == '{' || c == '}' || c == '^' || c == '|') {
-            escaped += '\\';
-            escaped += c;
-        } else {
-            escaped += c;
-        }
+    if (status_code != 200 && status_code != 404) {
+        // Log warning for failed robots.txt fetch (but not 404)
+        std::ostringstream warn_msg;
+        warn_msg << "Failed to fetch robots.txt for " << domain << " (status " << status_code << ")";
+        log_warn(warn_msg.str());
     }
     
-    if (has_end_marker) {
-        escaped += '$';  // End of string anchor
+    // Persist only definitive answers; network errors and 5xx are retried after the TTL
+    if (status_code > 0 && status_code < 500 && ensure_db_initialized()) {
+        std::ostringstream record;
+        record << std::chrono::duration_cast<std::chrono::seconds>(
+                      fetched_at.time_since_epoch()).count()
+               << " " << status_code << "\n" << robots_content;
+        db_manager_->store_robots_txt(domain, record.str());
     }
     
-    try {
-        std::regex re(escaped);
-        return std::regex_match(path, re);
-    } catch (...) {
-        // Fallback if regex is invalid
-        return false;
+    auto entry = build_robots_entry(domain, status_code, robots_content, fetched_at);
+    sitemaps_found_ += entry->sitemaps.size();
+    
+    // Log found sitemaps
+    if (!entry->sitemaps.empty()) {
+        std::ostringstream msg;
+        msg << "Found " << entry->sitemaps.size() << " sitemap(s) in robots.txt for " << domain;
+        log_info(msg.str());
     }
+    return entry;
 }
 
-bool WebCrawler::check_robots_txt(const std::string& url) {
-    std::string domain = get_domain(url);
-    if (domain.empty()) return true;
-    
-    // Extract path from URL
-    size_t path_start = url.find('/', url.find("://") + 3);
-    std::string path = (path_start != std::string::npos) ? url.substr(path_start) : "/";
+std::string WebCrawler::fetch_robots_txt(const std::string& domain, int& status_code) {
+    // RFC 9309 asks for at least five redirect hops, across hosts and schemes.
+    // This runs on prefetch workers, so it keeps away from fetch_html's stats.
+    constexpr int kMaxRobotsRedirects = 5;
     
-    // Check cache for parsed rules with TTL
-    auto rules_it = robots_rules_cache_.find(domain);
-    auto time_it = robots_cache_time_.find(domain);
-    if (rules_it != robots_rules_cache_.end() && time_it != robots_cache_time_.end()) {
-        auto age = std::chrono::duration_cast<std::chrono::seconds>(
-            std::chrono::steady_clock::now() - time_it->second).count();
-        if (age <= http_config_.robots_cache_ttl_seconds) {
-            return is_path_allowed(rules_it->second, path);
+    for (const char* scheme : {"https://", "http://"}) {
+        std::string url = scheme + domain + "/robots.txt";
+        std::string body;
+        status_code = 0;
+        
+        if (http_config_.use_raw_sockets) {
+            RawSocketHttpConfig raw_config;
+            raw_config.timeout = std::chrono::seconds(timeout_);
+            raw_config.retry.max_retries = http_config_.max_retries;
+            raw_config.retry.retry_backoff_ms = http_config_.retry_backoff_ms;
+            raw_config.max_redirects = 0;  // Followed here, so the scheme can change
+            raw_config.io_backend = http_config_.io_backend;
+            
+            std::map<std::string, std::string> request_headers;
+            request_headers["Accept"] = "text/plain";
+            request_headers["Accept-Encoding"] = "identity";
+            for (const auto& [key, value] : headers_) {
+                request_headers[key] = value;
+            }
+            
+            RawSocketHttpClient client(raw_config);
+            for (int hop = 0; hop <= kMaxRobotsRedirects; ++hop) {
+                RawHttpResponse response = client.fetch(url, request_headers);
+                status_code = response.status_code;
+                body = response.body.str();
+                if (status_code < 300 || status_code >= 400 || response.location.empty()) {
+                    break;
+                }
+                url = resolve_relative_url(url, response.location);
+                if (url.empty()) {
+                    break;
+                }
+            }
+        } else {
+            CURL* curl = curl_easy_init();
+            if (!curl) {
+                return "";
+            }
+            struct curl_slist* headers = nullptr;
+            headers = curl_slist_append(headers, "User-Agent: DatasetCrawler/1.0");
+            for (const auto& [key, value] : headers_) {
+                std::string header = key + ": " + value;
+                headers = curl_slist_append(headers, header.c_str());
+            }
+            
+            curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+            curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+            curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_callback);
+            curl_easy_setopt(curl, CURLOPT_WRITEDATA, &body);
+            curl_easy_setopt(curl, CURLOPT_TIMEOUT, timeout_);
+            curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+            curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+            curl_easy_setopt(curl, CURLOPT_MAXREDIRS, static_cast<long>(kMaxRobotsRedirects));
+            curl_easy_setopt(curl, CURLOPT_ACCEPT_ENCODING, "");
+            curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
+            curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L);
+            
+            if (curl_easy_perform(curl) == CURLE_OK) {
+                long http_code = 0;
+                curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
+                status_code = static_cast<int>(http_code);
+            }
+            curl_slist_free_all(headers);
+            curl_easy_cleanup(curl);
+        }
+        
+        // Fall back to plain http only when https could not be reached at all
+        if (status_code > 0) {
+            return body;
         }
     }
-    
-    // Fetch robots.txt
-    std::string robots_url = "https://" + domain + "/robots.txt";
-    int status_code = 0;
-    std::string robots_content = fetch_html(robots_url, status_code);
+    return "";
+}
+
+std::shared_ptr<const RobotsEntry> WebCrawler::build_robots_entry(const std::string& domain,
+                                                                  int status_code,
+                                                                  const std::string& robots_content,
+                                                                  std::chrono::system_clock::time_point fetched_at) {
+    auto entry = std::make_shared<RobotsEntry>();
+    entry->fetched_at = fetched_at;
     
     std::vector<RobotRule> rules;
-    
     if (status_code == 200) {
         rules = parse_robots_txt(domain, robots_content);
-    } else if (status_code != 404) {
-        // Log warning for failed robots.txt fetch (but not 404)
-        std::ostringstream warn_msg;
-        warn_msg << "Failed to fetch robots.txt for request " << url;
-        log_warn(warn_msg.str());
+        entry->sitemaps = extract_sitemap_urls_from_robots(robots_content);
     }
-    
-    // Cache the rules
-    robots_rules_cache_[domain] = rules;
-    robots_cache_time_[domain] = std::chrono::steady_clock::now();
-    
-    return is_path_allowed(rules, path);
+    entry->matcher = compile_robots_rules(rules);
+    return entry;
 }
 
-std::string WebCrawler::fetch_html(const std::string& url, int& status_code) {
+ByteBuffer WebCrawler::fetch_html(const std::string& url, int& status_code,
+                                  const HttpValidators* conditional,
+                                  HttpValidators* validators) {
     auto request_start = std::chrono::steady_clock::now();
+    HttpValidators received;
+    long retry_after = -1;
+    std::string domain = get_domain(url);
+    HostTimeouts deadlines = request_timeouts(domain);
 
-    std::string response;
+    ByteBuffer response;
     std::string content_type;
     std::string error_message;
     std::string scheme;
@@ -666,10 +1154,12 @@ std::string WebCrawler::fetch_html(const std::string& url, int& status_code) {
 
     if (response.empty() && http_config_.use_raw_sockets && (scheme == "http" || scheme == "https")) {
         RawSocketHttpConfig raw_config;
-        raw_config.timeout = std::chrono::seconds(timeout_);
-        raw_config.retry.max_retries = http_config_.max_retries;
-        raw_config.retry.retry_backoff_ms = http_config_.retry_backoff_ms;
+        raw_config.timeout = deadlines.total;
+        raw_config.connect_timeout = deadlines.connect;
+        raw_config.idle_timeout = deadlines.idle;
+        raw_config.retry.max_retries = 0;  // Retried through the frontier instead
         raw_config.max_redirects = http_config_.max_redirects;
+        raw_config.io_backend = http_config_.io_backend;
 
         std::map<std::string, std::string> request_headers;
         request_headers["Accept"] = "text/html,application/xhtml+xml";
@@ -678,13 +1168,28 @@ std::string WebCrawler::fetch_html(const std::string& url, int& status_code) {
         for (const auto& [key, value] : headers_) {
             request_headers[key] = value;
         }
+        if (conditional && !conditional->etag.empty()) {
+            request_headers["If-None-Match"] = conditional->etag;
+        }
+        if (conditional && !conditional->last_modified.empty()) {
+            request_headers["If-Modified-Since"] = conditional->last_modified;
+        }
 
+        // Blocking: this worker waits for the page; fetch_async() is not used here yet
         RawSocketHttpClient client(raw_config);
         RawHttpResponse raw_response = client.fetch(url, request_headers);
         response = raw_response.body;
         content_type = raw_response.content_type;
-        status_code = raw_response.status_code;
+        // A truncated body keeps its status line but is retried like a failed request
+        status_code = raw_response.success ? raw_response.status_code : 0;
         error_message = raw_response.error_message;
+        received = raw_response.validators;
+        retry_after = raw_response.retry_after_seconds;
+        // A phase cut off by its deadline adds the time it was given (a lower
+        // bound), so a host that slowed down or serves a larger page gets
+        // longer deadlines instead of timing out forever
+        host_latency_.record(domain, raw_response.connect_ms, raw_response.first_byte_ms,
+                             raw_response.success || raw_response.timed_out ? raw_response.total_ms : -1);
 
         switch (raw_response.http_version) {
             case HTTPVersion::HTTP_1_0:
@@ -704,132 +1209,178 @@ std::string WebCrawler::fetch_html(const std::string& url, int& status_code) {
             log_error("Raw socket error for " + url + ": " + raw_response.error_message);
         }
     } else if (response.empty()) {
-        int attempts = std::max(1, http_config_.max_retries + 1);
-        for (int attempt = 0; attempt < attempts; ++attempt) {
-            CURL* curl = curl_easy_init();
-            if (!curl) {
-                std::cerr << "Failed to initialize CURL" << std::endl;
-                status_code = 0;
-                return "";
-            }
+        // A single attempt: failures are retried through the frontier (see retry_failed_url)
+        CURL* curl = curl_easy_init();
+        if (!curl) {
+            std::cerr << "Failed to initialize CURL" << std::endl;
+            status_code = 0;
+            return ByteBuffer();
+        }
 
-            response.clear();
-            content_type.clear();
-            struct curl_slist* headers = nullptr;
+        std::string body = ByteBuffer::acquire(0);
+        content_type.clear();
+        struct curl_slist* headers = nullptr;
 
-            // Add default headers
-            headers = curl_slist_append(headers, "User-Agent: DatasetCrawler/1.0");
-            headers = curl_slist_append(headers, "Accept: text/html,application/xhtml+xml");
-            headers = curl_slist_append(headers, "Accept-Language: en-US,en;q=0.9");
-            headers = curl_slist_append(headers, "Accept-Encoding: gzip, deflate, br");
+        // Add default headers
+        headers = curl_slist_append(headers, "User-Agent: DatasetCrawler/1.0");
+        headers = curl_slist_append(headers, "Accept: text/html,application/xhtml+xml");
+        headers = curl_slist_append(headers, "Accept-Language: en-US,en;q=0.9");
+        headers = curl_slist_append(headers, "Accept-Encoding: gzip, deflate, br");
 
-            // Add custom headers
-            for (const auto& [key, value] : headers_) {
-                std::string header = key + ": " + value;
-                headers = curl_slist_append(headers, header.c_str());
+        // Add custom headers
+        for (const auto& [key, value] : headers_) {
+            std::string header = key + ": " + value;
+            headers = curl_slist_append(headers, header.c_str());
+        }
+        if (conditional && !conditional->etag.empty()) {
+            std::string header = "If-None-Match: " + conditional->etag;
+            headers = curl_slist_append(headers, header.c_str());
+        }
+        if (conditional && !conditional->last_modified.empty()) {
+            std::string header = "If-Modified-Since: " + conditional->last_modified;
+            headers = curl_slist_append(headers, header.c_str());
+        }
+        CurlResponseHeaders response_headers;
+
+        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_callback);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &body);
+        curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, header_callback);
+        curl_easy_setopt(curl, CURLOPT_HEADERDATA, &response_headers);
+        curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, static_cast<long>(deadlines.total.count()));
+        curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS, static_cast<long>(deadlines.connect.count()));
+        // Idle deadline: abort when under 1 byte/s for that long
+        curl_easy_setopt(curl, CURLOPT_LOW_SPEED_LIMIT, 1L);
+        curl_easy_setopt(curl, CURLOPT_LOW_SPEED_TIME,
+                         static_cast<long>(std::max<long>(1, (deadlines.idle.count() + 999) / 1000)));
+        curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
+        curl_easy_setopt(curl, CURLOPT_ACCEPT_ENCODING, "gzip, deflate, br");
+
+        // Enable HTTP/2 support (automatically falls back to HTTP/1.1 if HTTP/2 not available)
+        curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2_0);
+
+        // SSL/TLS configuration for BoringSSL
+        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);  // Accept any cert for now
+        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L);  // Don't verify hostname
+
+        // Enable connection reuse
+        curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+        curl_easy_setopt(curl, CURLOPT_TCP_KEEPIDLE, 120L);
+        curl_easy_setopt(curl, CURLOPT_TCP_KEEPINTVL, 60L);
+
+        CURLcode res = curl_easy_perform(curl);
+
+        if (res == CURLE_OPERATION_TIMEDOUT) {
+            // Same censored samples as the raw path: a phase a deadline cut off
+            // counts as having taken at least as long as it was given
+            double connect_time = 0.0;
+            double tls_time = 0.0;
+            double first_byte_time = 0.0;
+            double total_time = 0.0;
+            curl_easy_getinfo(curl, CURLINFO_CONNECT_TIME, &connect_time);
+            curl_easy_getinfo(curl, CURLINFO_APPCONNECT_TIME, &tls_time);
+            curl_easy_getinfo(curl, CURLINFO_STARTTRANSFER_TIME, &first_byte_time);
+            curl_easy_getinfo(curl, CURLINFO_TOTAL_TIME, &total_time);
+            double connected = std::max(connect_time, tls_time);
+            bool https = scheme == "https";
+            if (connect_time <= 0.0 || (https && tls_time <= 0.0)) {
+                host_latency_.record(domain, static_cast<long>(total_time * 1000.0), -1, -1);
+            } else {
+                double first_byte = first_byte_time > 0.0 ? first_byte_time : total_time;
+                host_latency_.record(domain, static_cast<long>(connected * 1000.0),
+                                     static_cast<long>((first_byte - connected) * 1000.0),
+                                     static_cast<long>(total_time * 1000.0));
             }
+        }
 
-            curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-            curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-            curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_callback);
-            curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
-            curl_easy_setopt(curl, CURLOPT_TIMEOUT, timeout_);
-            curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
-            curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
-            curl_easy_setopt(curl, CURLOPT_ACCEPT_ENCODING, "gzip, deflate, br");
-
-            // Enable HTTP/2 support (automatically falls back to HTTP/1.1 if HTTP/2 not available)
-            curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2_0);
-
-            // SSL/TLS configuration for BoringSSL
-            curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);  // Accept any cert for now
-            curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L);  // Don't verify hostname
-
-            // Enable connection reuse
-            curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
-            curl_easy_setopt(curl, CURLOPT_TCP_KEEPIDLE, 120L);
-            curl_easy_setopt(curl, CURLOPT_TCP_KEEPINTVL, 60L);
-
-            CURLcode res = curl_easy_perform(curl);
-
-            if (res != CURLE_OK) {
-                std::string error_msg = std::string(curl_easy_strerror(res));
-                if (error_msg.find("Unsupported") != std::string::npos ||
-                    error_msg.find("Invalid") != std::string::npos ||
-                    error_msg.find("malformed") != std::string::npos) {
-                    log_warn("Failed to parse URL: " + error_msg);
-                } else {
-                    log_error("CURL error for " + url + ": " + error_msg);
-                }
-                error_message = error_msg;
-                status_code = 0;
+        if (res != CURLE_OK) {
+            std::string error_msg = std::string(curl_easy_strerror(res));
+            if (error_msg.find("Unsupported") != std::string::npos ||
+                error_msg.find("Invalid") != std::string::npos ||
+                error_msg.find("malformed") != std::string::npos) {
+                log_warn("Failed to parse URL: " + error_msg);
             } else {
-                long http_code = 0;
-                char* final_url = nullptr;
-                char* content_type_ptr = nullptr;
-                long http_version = 0;
-                curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
-                curl_easy_getinfo(curl, CURLINFO_EFFECTIVE_URL, &final_url);
-                curl_easy_getinfo(curl, CURLINFO_CONTENT_TYPE, &content_type_ptr);
-                curl_easy_getinfo(curl, CURLINFO_HTTP_VERSION, &http_version);
-
-                if (content_type_ptr) {
-                    content_type = std::string(content_type_ptr);
-                }
-
-                std::string http_version_str;
-                switch (http_version) {
-                    case CURL_HTTP_VERSION_1_0:
-                        http_version_str = "HTTP/1.0";
-                        http10_requests_++;
-                        break;
-                    case CURL_HTTP_VERSION_1_1:
-                        http_version_str = "HTTP/1.1";
-                        http11_requests_++;
-                        break;
-                    case CURL_HTTP_VERSION_2_0:
-                        http_version_str = "HTTP/2";
-                        http2_requests_++;
-                        break;
-                    default:
-                        http_version_str = "HTTP/?.?";
-                }
-
-                if (final_url && final_url != url) {
-                    std::string final_url_str(final_url);
-                    if (final_url_str != url) {
-                        std::ostringstream redirect_msg;
-                        redirect_msg << "The start URL \"" << url << "\" has been redirected to \""
-                                    << final_url_str << "\" [" << http_version_str << "]";
-                        log_warn(redirect_msg.str());
-                    }
-                }
-
-                status_code = static_cast<int>(http_code);
+                log_error("CURL error for " + url + ": " + error_msg);
+            }
+            error_message = error_msg;
+            status_code = 0;
+        } else {
+            long http_code = 0;
+            char* final_url = nullptr;
+            char* content_type_ptr = nullptr;
+            long http_version = 0;
+            curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
+            curl_easy_getinfo(curl, CURLINFO_EFFECTIVE_URL, &final_url);
+            curl_easy_getinfo(curl, CURLINFO_CONTENT_TYPE, &content_type_ptr);
+            curl_easy_getinfo(curl, CURLINFO_HTTP_VERSION, &http_version);
+
+            double connect_time = 0.0;
+            double tls_time = 0.0;
+            double first_byte_time = 0.0;
+            double total_time = 0.0;
+            curl_easy_getinfo(curl, CURLINFO_CONNECT_TIME, &connect_time);
+            curl_easy_getinfo(curl, CURLINFO_APPCONNECT_TIME, &tls_time);
+            curl_easy_getinfo(curl, CURLINFO_STARTTRANSFER_TIME, &first_byte_time);
+            curl_easy_getinfo(curl, CURLINFO_TOTAL_TIME, &total_time);
+            double connected = std::max(connect_time, tls_time);
+            host_latency_.record(domain, static_cast<long>(connected * 1000.0),
+                                 static_cast<long>((first_byte_time - connected) * 1000.0),
+                                 static_cast<long>(total_time * 1000.0));
+
+            if (content_type_ptr) {
+                content_type = std::string(content_type_ptr);
             }
 
-            curl_slist_free_all(headers);
-            curl_easy_cleanup(curl);
+            std::string http_version_str;
+            switch (http_version) {
+                case CURL_HTTP_VERSION_1_0:
+                    http_version_str = "HTTP/1.0";
+                    http10_requests_++;
+                    break;
+                case CURL_HTTP_VERSION_1_1:
+                    http_version_str = "HTTP/1.1";
+                    http11_requests_++;
+                    break;
+                case CURL_HTTP_VERSION_2_0:
+                    http_version_str = "HTTP/2";
+                    http2_requests_++;
+                    break;
+                default:
+                    http_version_str = "HTTP/?.?";
+            }
 
-            if (status_code > 0) {
-                break;
+            if (final_url && final_url != url) {
+                std::string final_url_str(final_url);
+                if (final_url_str != url) {
+                    std::ostringstream redirect_msg;
+                    redirect_msg << "The start URL \"" << url << "\" has been redirected to \""
+                                << final_url_str << "\" [" << http_version_str << "]";
+                    log_warn(redirect_msg.str());
+                }
             }
 
-            if (attempt + 1 < attempts) {
-                int backoff = http_config_.retry_backoff_ms * (attempt + 1);
-                std::this_thread::sleep_for(std::chrono::milliseconds(backoff));
+            status_code = static_cast<int>(http_code);
+            received = response_headers.validators;
+            if (!response_headers.retry_after.empty()) {
+                retry_after = parse_retry_after(response_headers.retry_after, std::time(nullptr));
             }
         }
+
+        curl_slist_free_all(headers);
+        curl_easy_cleanup(curl);
+        response = ByteBuffer::adopt(std::move(body));
     }
 
     if (enable_headless_rendering_ && (scheme == "http" || scheme == "https") &&
-        needs_headless_rendering(response, status_code)) {
+        needs_headless_rendering(response.view(), status_code)) {
         int headless_status = 0;
         std::string headless_error;
         std::string rendered = fetch_headless_html(url, headless_status, headless_error);
         if (!rendered.empty()) {
             status_code = headless_status == 0 ? 200 : headless_status;
-            response = rendered;
+            response = ByteBuffer::adopt(std::move(rendered));
             content_type = "text/html";
             error_message = headless_error;
         } else if (!headless_error.empty()) {
@@ -838,12 +1389,12 @@ std::string WebCrawler::fetch_html(const std::string& url, int& status_code) {
     }
     
     // Detect and convert encoding
-    std::string encoding = detect_encoding(response, content_type);
+    std::string encoding = detect_encoding(response.view(), content_type);
     if (encoding != "UTF-8" && encoding != "UTF8") {
         std::ostringstream conv_msg;
         conv_msg << "Converting content from " << encoding << " to UTF-8";
         log_info(conv_msg.str());
-        response = convert_to_utf8(response, encoding);
+        response = ByteBuffer::adopt(convert_to_utf8(response.view(), encoding));
     }
     
     // Track request duration and bytes
@@ -853,9 +1404,20 @@ std::string WebCrawler::fetch_html(const std::string& url, int& status_code) {
     last_request_duration_ms_ = duration_ms;
     request_durations_.push_back(duration_ms);
     total_duration_ms_ += duration_ms;
-    total_bytes_downloaded_ += response.length();
-    report_request_metric(url, status_code, duration_ms, response.length(), content_type, error_message);
+    total_bytes_downloaded_ += response.size();
+    report_request_metric(url, status_code, duration_ms, response.size(), content_type, error_message);
 
+    // 429 is handled by the host throttle; only errors and 5xx count against the host
+    retry_budget_.on_request();
+    if (circuit_breaker_.record(domain, status_code > 0 && status_code < 500,
+                                CircuitBreaker::Clock::now())) {
+        log_warn("Circuit open for " + domain + ": deferring its URLs");
+    }
+
+    last_retry_after_seconds_ = retry_after;
+    if (validators) {
+        *validators = received;
+    }
     return response;
 }
 
@@ -875,7 +1437,6 @@ DataRecord WebCrawler::fetch(const std::string& url) {
             DataRecord blocked_record;
             blocked_record.url = url;
             blocked_record.title = "BLOCKED";
-            blocked_record.content = "";
             blocked_record.timestamp = oss.str();
             blocked_record.status_code = 403;
             blocked_record.was_allowed = false;
@@ -885,7 +1446,21 @@ DataRecord WebCrawler::fetch(const std::string& url) {
         }
     }
     
-    std::string html = fetch_html(url, status_code);
+    // Pages with stored validators are revalidated with a conditional GET
+    bool revalidation = enable_recrawl_ && ensure_db_initialized();
+    std::string page_key = revalidation ? normalize_url(url) : "";
+    HttpValidators conditional;
+    bool revalidate = revalidation &&
+                      db_manager_->get_validators(page_key, conditional.etag, conditional.last_modified);
+    HttpValidators validators;
+    ByteBuffer html = fetch_html(url, status_code, revalidate ? &conditional : nullptr, &validators);
+    bool not_modified = revalidate && status_code == 304;
+    if (not_modified) {
+        html = ByteBuffer::adopt(db_manager_->get_cached_html(page_key));
+        not_modified_++;
+    }
+    // Stored once the record is built; also overwrites validators the server no longer sends
+    bool remember = revalidation && status_code == 200 && (revalidate || !validators.empty());
     
     auto now = std::time(nullptr);
     auto tm = *std::localtime(&now);
@@ -894,16 +1469,30 @@ DataRecord WebCrawler::fetch(const std::string& url) {
     
     DataRecord record;
     record.url = url;
-    record.title = extract_title(html);
-    record.content = html;
+    record.content = html;  // Shares the receive buffer
     record.timestamp = oss.str();
     record.status_code = status_code;
     record.was_allowed = true;
-    record.content_length = html.length();
+    record.content_length = html.size();
     record.was_skipped = false;
 
+    // Unchanged since the last fetch: rebuild the record from the cached page
+    // and what was extracted from it, without parsing it again
+    if (not_modified) {
+        record_fetch_history(page_key, 0, true);
+        if (!db_manager_->get_cached_extract(page_key, record.title, record.text)) {
+            // Cached before titles and text were stored alongside it
+            record.title = extract_title(html.view());
+            if (enable_text_extraction_) {
+                record.text = text_extractor_->extract_from_html(html.view(), url).text;
+            }
+        }
+        return record;
+    }
+    record.title = extract_title(html.view());
+
     if (status_code == 200) {
-        std::string canonical = extract_canonical_url(html, url);
+        std::string canonical = extract_canonical_url(html.view(), url);
         if (!canonical.empty()) {
             std::string normalized = normalize_url(canonical);
             if (!normalized.empty()) {
@@ -913,19 +1502,22 @@ DataRecord WebCrawler::fetch(const std::string& url) {
     }
     
     // Check file size
-    if (html.length() > max_file_size_bytes_) {
+    if (html.size() > max_file_size_bytes_) {
         std::ostringstream warn_msg;
         warn_msg << "Skipped " << url << " - file size " 
-                 << (html.length() / 1024 / 1024) << "MB exceeds limit";
+                 << (html.size() / 1024 / 1024) << "MB exceeds limit";
         log_warn(warn_msg.str());
         skipped_by_size_++;
         record.was_skipped = true;
         record.was_allowed = false;
+        if (remember) {
+            remember_page(page_key, record, validators);
+        }
         return record;
     }
     
     // Check for "No text parsed" condition
-    if (html.length() < 100 && status_code == 200) {
+    if (html.size() < 100 && status_code == 200) {
         std::ostringstream warn_msg;
         warn_msg << "No text parsed from " << url << ".";
         log_warn(warn_msg.str());
@@ -933,16 +1525,32 @@ DataRecord WebCrawler::fetch(const std::string& url) {
     
     // Check meta tags if enabled
     if (respect_meta_tags_ && status_code == 200) {
-        if (!check_meta_tags(html)) {
+        if (!check_meta_tags(html.view())) {
             record.was_allowed = false;
+            if (remember) {
+                remember_page(page_key, record, validators);
+            }
             return record;
         }
     }
 
-    // Check for duplicates if deduplication is enabled
-    if (enable_deduplication_ && status_code == 200 && html.length() > 100) {
-        uint64_t content_hash = calculate_simhash(html);
-        if (is_duplicate(content_hash, 3)) {  // threshold = 3 bits difference
+    // Content fingerprint feeds duplicate detection, DUST learning, trap detection and recrawl scheduling
+    bool needs_fingerprint = enable_deduplication_ || enable_dust_learning_ ||
+                             enable_trap_detection_ || enable_recrawl_;
+    if (needs_fingerprint && status_code == 200 && html.size() > 100) {
+        uint64_t content_hash = calculate_simhash(html.view());
+        Url page = Url::parse(normalize_url(url));
+        if (enable_dust_learning_) {
+            dust_learner_.observe(page, content_hash);
+        }
+        bool duplicate = enable_deduplication_ && is_duplicate(page.str(), content_hash, 3);  // threshold = 3 bits difference
+        if (enable_trap_detection_) {
+            trap_detector_.record_fetch(page, content_hash);
+        }
+        if (enable_recrawl_) {
+            record_fetch_history(page.str(), content_hash);
+        }
+        if (duplicate) {
             std::ostringstream dup_msg;
             dup_msg << "Duplicate content detected for " << url;
             log_warn(dup_msg.str());
@@ -951,12 +1559,34 @@ DataRecord WebCrawler::fetch(const std::string& url) {
         }
     }
 
+    if (enable_text_extraction_ && status_code == 200 && record.was_allowed) {
+        record.text = text_extractor_->extract_from_html(html.view(), url).text;
+    }
+    if (remember) {
+        remember_page(page_key, record, validators);
+    }
+
     return record;
 }
 
+void WebCrawler::remember_page(const std::string& page_key, const DataRecord& record,
+                               const HttpValidators& validators) {
+    // Pages that were not kept are not revalidated, so a 304 never revives them
+    bool kept = record.was_allowed && !record.was_skipped;
+    db_manager_->store_validators(page_key, record.content.view(), record.title, record.text,
+                                  kept ? validators.etag : "", kept ? validators.last_modified : "");
+}
+
 std::vector<DataRecord> WebCrawler::crawl_urls(const std::vector<std::string>& urls,
                                                bool wait_for_new_urls) {
-    std::vector<DataRecord> records;
+    RecordCollector collector;
+    crawl_urls(urls, collector, wait_for_new_urls);
+    return std::move(collector.records);
+}
+
+size_t WebCrawler::crawl_urls(const std::vector<std::string>& urls, RecordSink& sink,
+                              bool wait_for_new_urls) {
+    size_t records = 0;
     constexpr int kInitialPriority = 0;
     constexpr int kDiscoveredPriority = 1;
     
@@ -973,6 +1603,17 @@ std::vector<DataRecord> WebCrawler::crawl_urls(const std::vector<std::string>& u
     std::cout << "INFO: RocksDB initialized successfully" << std::endl;
     log_info("RocksDB initialized successfully");
     
+    if (respect_robots_txt_ && robots_prefetch_workers_ > 0) {
+        robots_prefetcher_.start(static_cast<size_t>(robots_prefetch_workers_),
+                                 [this](const std::string& host) { robots_entry(host); },
+                                 [this](const std::string& host) { release_parked_urls(host); });
+    }
+    
+    // URLs deferred by a run that did not shut down cleanly are due again
+    for (const auto& host : db_manager_->get_deferred_hosts()) {
+        db_manager_->release_deferred_urls(host);
+    }
+    
     // Enqueue initial URLs to RocksDB
     for (const auto& url : urls) {
         enqueue_url(url, kInitialPriority);
@@ -988,46 +1629,48 @@ std::vector<DataRecord> WebCrawler::crawl_urls(const std::vector<std::string>& u
     
     auto crawl_start = std::chrono::steady_clock::now();
     
-    // Process URLs from RocksDB queue
-    while (db_manager_->has_queued_urls()) {
+    // Process URLs from RocksDB queue; hosts still waiting for robots.txt
+    // keep the loop alive even when the queue itself runs dry
+    while (true) {
         if (should_stop()) {
             log_warn("Graceful shutdown requested; stopping crawl loop.");
             break;
         }
-        std::string url = db_manager_->dequeue_url();
-        
-        if (url.empty()) {
-            break;
+        if (enable_recrawl_) {
+            enqueue_due_recrawls();
         }
+        resume_paused_hosts();
 
+        std::string url;
+        int priority = kDiscoveredPriority;
         {
-            std::lock_guard<std::mutex> lock(queue_mutex_);
+            std::unique_lock<std::mutex> lock(queue_mutex_);
             if (!db_manager_->has_queued_urls()) {
-                if (!wait_for_new_urls) {
+                if (!wait_for_new_urls && !has_parked_urls()) {
                     break;
                 }
-            }
-        }
-
-        if (wait_for_new_urls) {
-            std::unique_lock<std::mutex> lock(queue_mutex_);
-            queue_cv_.wait_for(lock, std::chrono::milliseconds(500), [this]() {
-                return should_stop() || (db_manager_ && db_manager_->has_queued_urls());
-            });
-            if (!db_manager_ || !db_manager_->has_queued_urls()) {
+                queue_cv_.wait_for(lock, std::chrono::milliseconds(500), [this]() {
+                    return should_stop() || db_manager_->has_queued_urls();
+                });
                 continue;
             }
-        }
-
-        std::string url;
-        {
-            std::lock_guard<std::mutex> lock(queue_mutex_);
-            url = db_manager_->dequeue_url();
+            url = db_manager_->dequeue_url(&priority);
         }
         if (url.empty()) {
             continue;
         }
         
+        // URLs of a paused or failing host wait out its window without
+        // holding up other hosts
+        if (host_throttle_.paused_hosts() > 0 || circuit_breaker_.open_hosts() > 0) {
+            std::string domain = get_domain(url);
+            if (host_throttle_.is_paused(domain, HostThrottle::Clock::now()) ||
+                !circuit_breaker_.allow(domain, CircuitBreaker::Clock::now())) {
+                park_url(domain, url, priority);
+                continue;
+            }
+        }
+        
         // Skip if already visited (check both memory cache and RocksDB)
         std::string normalized = normalize_url(url);
         {
@@ -1044,12 +1687,37 @@ std::vector<DataRecord> WebCrawler::crawl_urls(const std::vector<std::string>& u
         visited_urls_memory_.insert(normalized);
         db_manager_->mark_visited(normalized);
         current_domain_ = get_domain(url);
+        ImportanceEstimator::Credit credit;
+        if (enable_importance_ordering_) {
+            credit = importance_.take(normalized);
+        }
         
         try {
             DataRecord record = fetch(url);
             
-            if (record.was_allowed && !record.was_skipped) {
-                records.push_back(record);
+            if ((record.status_code == 429 || record.status_code == 503) &&
+                pause_rate_limited_host(url, normalized, record.status_code, priority, credit)) {
+                apply_adaptive_delay(record.status_code);
+                continue;
+            }
+            if (is_retryable_status(record.status_code) &&
+                retry_failed_url(url, normalized, record.status_code, priority, credit)) {
+                apply_adaptive_delay(record.status_code);
+                continue;
+            }
+            if (!retry_attempts_.empty()) {
+                retry_attempts_.erase(normalized);
+            }
+            if (record.status_code >= 200 && record.status_code < 400) {
+                host_throttle_.succeeded(current_domain_);
+            }
+            
+            if (record.status_code == 304) {
+                // Unchanged since a fetch that already went to the sink: no second row
+                log_info(url + " [304 not modified]");
+            } else if (record.was_allowed && !record.was_skipped) {
+                sink.push(record);  // The copy shares the page body
+                records++;
                 
                 if (record.status_code == 200) {
                     std::ostringstream success_msg;
@@ -1057,7 +1725,7 @@ std::vector<DataRecord> WebCrawler::crawl_urls(const std::vector<std::string>& u
                     log_info(success_msg.str());
                     
                     // Extract links from the page
-                    std::vector<std::string> new_links = extract_links_from_html(record.content, url);
+                    std::vector<std::string> new_links = extract_links_from_html(record.content.view(), url);
 
                     // Store link graph edges
                     for (const auto& link : new_links) {
@@ -1070,7 +1738,23 @@ std::vector<DataRecord> WebCrawler::crawl_urls(const std::vector<std::string>& u
                     for (const auto& link : new_links) {
                         if (visited_urls_memory_.find(link) == visited_urls_memory_.end() && !db_manager_->is_visited(link)) {
                             unvisited_links.push_back(link);
-                            db_manager_->enqueue_url(link, kDiscoveredPriority);  // Persist to RocksDB
+                        }
+                    }
+                    if (enable_importance_ordering_) {
+                        importance_.distribute(credit, unvisited_links);
+                    }
+                    for (const auto& link : unvisited_links) {
+                        int priority = kDiscoveredPriority;
+                        if (enable_importance_ordering_) {
+                            // Re-enqueued only when its cash earns a better priority
+                            priority = importance_.claim_priority(link);
+                            if (priority < 0) {
+                                continue;
+                            }
+                        }
+                        std::lock_guard<std::mutex> lock(queue_mutex_);
+                        if (!admit_url(link, priority) && enable_importance_ordering_) {  // Persist to RocksDB
+                            importance_.take(link);
                         }
                     }
                     
@@ -1087,7 +1771,7 @@ std::vector<DataRecord> WebCrawler::crawl_urls(const std::vector<std::string>& u
                 }
             } else if (record.was_skipped) {
                 std::ostringstream skip_msg;
-                skip_msg << url << " [skipped - size limit exceeded]";
+                skip_msg << url << " [skipped]";  // fetch() logged why: size limit or duplicate
                 log_warn(skip_msg.str());
             } else {
                 std::ostringstream blocked_msg;
@@ -1115,18 +1799,42 @@ std::vector<DataRecord> WebCrawler::crawl_urls(const std::vector<std::string>& u
         }
     }
     
+    // URLs still waiting for robots.txt or a pause window go to the persistent
+    // queue for the next run
+    robots_prefetcher_.stop();
+    host_throttle_.clear();
+    circuit_breaker_.clear();
+    std::vector<std::string> parked_hosts;
+    {
+        std::lock_guard<std::mutex> lock(parked_mutex_);
+        for (const auto& entry : parked_urls_) {
+            parked_hosts.push_back(entry.first);
+        }
+        parked_hosts.insert(parked_hosts.end(), deferred_hosts_.begin(), deferred_hosts_.end());
+    }
+    for (const auto& host : parked_hosts) {
+        release_parked_urls(host);
+    }
+    sink.flush();
+    
     auto crawl_end = std::chrono::steady_clock::now();
     long crawl_duration_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
         crawl_end - crawl_start).count();
     
     // Log completion statistics
     std::ostringstream final_msg;
-    final_msg << "Crawling completed. Fetched: " << records.size() << " records, "
+    final_msg << "Crawling completed. Fetched: " << records << " records, "
               << "Blocked by robots.txt: " << blocked_by_robots_ << ", "
               << "Blocked by noindex: " << blocked_by_noindex_ << ", "
               << "Skipped by size: " << skipped_by_size_;
     log_info(final_msg.str());
     
+    if (enable_trap_detection_) {
+        for (const auto& prefix : trap_detector_.flagged_prefixes()) {
+            log_warn("Crawler trap: " + prefix);
+        }
+    }
+    
     // Calculate statistics
     double avg_duration = 0.0;
     double requests_per_minute = 0.0;
@@ -1147,9 +1855,9 @@ std::vector<DataRecord> WebCrawler::crawl_urls(const std::vector<std::string>& u
               << "\"requestsFailedPerMinute\":" 
               << (int)((blocked_by_robots_ + blocked_by_noindex_) * 60000.0 / crawl_duration_ms) << ","
               << "\"requestTotalDurationMillis\":" << crawl_duration_ms << ","
-              << "\"requestsTotal\":" << (records.size() + blocked_by_robots_ + blocked_by_noindex_ + skipped_by_size_) << ","
+              << "\"requestsTotal\":" << (records + blocked_by_robots_ + blocked_by_noindex_ + skipped_by_size_) << ","
               << "\"crawlerRuntimeMillis\":" << crawl_duration_ms << ","
-              << "\"retryHistogram\":[" << (records.size() + blocked_by_robots_ + blocked_by_noindex_ + skipped_by_size_) << "]}";
+              << "\"retryHistogram\":[" << (records + blocked_by_robots_ + blocked_by_noindex_ + skipped_by_size_) << "]}";
     log_info(stats_msg.str());
     
     return records;
@@ -1209,72 +1917,24 @@ std::vector<std::string> WebCrawler::parse_sitemap_index_xml(const std::string&
 }
 
 double WebCrawler::get_crawl_delay_for_domain(const std::string& domain) const {
-    auto it = robots_rules_cache_.find(domain);
-    if (it == robots_rules_cache_.end()) {
+    auto entry = robots_cache_.find(domain);
+    if (!entry) {
         return 0.0;
     }
-
-    double delay = 0.0;
-    int best_specificity = -1;
-    for (const auto& rule : it->second) {
-        for (const auto& agent : rule.user_agents) {
-            if (matches_user_agent(agent, user_agent_) && rule.crawl_delay_seconds >= 0.0) {
-                if (rule.specificity > best_specificity) {
-                    best_specificity = rule.specificity;
-                    delay = rule.crawl_delay_seconds;
-                } else if (rule.specificity == best_specificity) {
-                    delay = std::max(delay, rule.crawl_delay_seconds);
-                }
-                break;
-            }
-        }
-    }
-
-    return delay;
+    return std::max(0.0, entry->matcher.crawl_delay());
 }
 
 std::vector<std::string> WebCrawler::get_sitemaps_from_robots(const std::string& domain) {
-    // Check cache first
-    auto it = robots_sitemaps_cache_.find(domain);
-    auto time_it = robots_sitemaps_cache_time_.find(domain);
-    if (it != robots_sitemaps_cache_.end() && time_it != robots_sitemaps_cache_time_.end()) {
-        auto age = std::chrono::duration_cast<std::chrono::seconds>(
-            std::chrono::steady_clock::now() - time_it->second).count();
-        if (age <= http_config_.sitemaps_cache_ttl_seconds) {
-            return it->second;
-        }
-    }
-    
-    // Fetch robots.txt
-    std::string robots_url = "https://" + domain + "/robots.txt";
-    int status_code = 0;
-    std::string robots_content = fetch_html(robots_url, status_code);
-    
-    if (status_code != 200 || robots_content.empty()) {
-        robots_sitemaps_cache_[domain] = {};
+    auto entry = robots_entry(domain);
+    if (!entry) {
         return {};
     }
-    
-    // Extract Sitemap URLs
-    std::vector<std::string> sitemap_urls = extract_sitemap_urls_from_robots(robots_content);
-    sitemaps_found_ += sitemap_urls.size();
-    
-    // Log found sitemaps
-    if (!sitemap_urls.empty()) {
-        std::ostringstream msg;
-        msg << "Found " << sitemap_urls.size() << " sitemap(s) in robots.txt for " << domain;
-        log_info(msg.str());
-    }
-    
-    // Cache the result
-    robots_sitemaps_cache_[domain] = sitemap_urls;
-    robots_sitemaps_cache_time_[domain] = std::chrono::steady_clock::now();
-    return sitemap_urls;
+    return entry->sitemaps;
 }
 
 std::vector<std::string> WebCrawler::fetch_sitemap_urls(const std::string& sitemap_url) {
     int status_code = 0;
-    std::string sitemap_content = fetch_html(sitemap_url, status_code);
+    std::string sitemap_content = fetch_html(sitemap_url, status_code).str();
     
     if (status_code != 200 || sitemap_content.empty()) {
         log_warn("Failed to fetch sitemap from " + sitemap_url + " (status: " + std::to_string(status_code) + ")");
@@ -1298,128 +1958,36 @@ std::vector<std::string> WebCrawler::fetch_sitemap_urls(const std::string& sitem
 }
 
 bool WebCrawler::is_valid_url(const std::string& url) {
-    if (url.empty()) return false;
-    return url.find("http://") == 0 || url.find("https://") == 0;
+    return is_valid_url(Url::parse(url));
+}
+
+bool WebCrawler::is_valid_url(const Url& url) {
+    return url.valid() && url.is_http();
 }
 
 std::string WebCrawler::normalize_url(const std::string& url) {
-    if (!is_valid_url(url)) return "";
-    
-    // Remove fragment (#)
-    size_t hash_pos = url.find('#');
-    std::string normalized = (hash_pos != std::string::npos) ? url.substr(0, hash_pos) : url;
-    
-    // Convert to lowercase (scheme and host only)
-    size_t scheme_end = normalized.find("://");
-    if (scheme_end != std::string::npos) {
-        size_t path_start = normalized.find('/', scheme_end + 3);
-        if (path_start == std::string::npos) {
-            path_start = normalized.length();
-        }
-        std::string host_part = normalized.substr(0, path_start);
-        std::transform(host_part.begin(), host_part.end(), host_part.begin(), 
-                      [](unsigned char c) { return std::tolower(c); });
-        normalized = host_part + normalized.substr(path_start);
-    }
-    
-    // Remove trailing slash if not root
-    if (normalized.length() > 1 && normalized.back() == '/' && 
-        normalized.find('/', 8) != normalized.length() - 1) {
-        // Keep root slash but remove trailing slashes on paths
-        size_t last_slash = normalized.rfind('/');
-        if (last_slash > 8) {  // 8 = length of "https://"
-            normalized = normalized.substr(0, normalized.length() - 1);
-        }
-    }
-    
-    return normalized;
+    Url parsed = Url::parse(url);
+    if (!is_valid_url(parsed)) return "";
+    url_canonicalizer_.canonicalize(parsed);
+    return parsed.release();
 }
 
 std::string WebCrawler::resolve_relative_url(const std::string& base_url, const std::string& relative_url) {
     if (relative_url.empty()) return "";
     
-    // Already absolute URL
-    if (is_valid_url(relative_url)) {
-        return normalize_url(relative_url);
-    }
-    
-    // Protocol-relative URL (//domain.com/path)
-    if (relative_url.substr(0, 2) == "//") {
-        size_t scheme_end = base_url.find("://");
-        if (scheme_end != std::string::npos) {
-            std::string scheme = base_url.substr(0, scheme_end);
-            std::string result = scheme + ":" + relative_url;
-            return normalize_url(result);
-        }
-        return "";
-    }
-    
-    // Parse base URL
-    size_t scheme_end = base_url.find("://");
-    if (scheme_end == std::string::npos) return "";
-    
-    size_t host_start = scheme_end + 3;
-    size_t path_start = base_url.find('/', host_start);
-    if (path_start == std::string::npos) path_start = base_url.length();
-    
-    std::string scheme = base_url.substr(0, scheme_end + 3);
-    std::string host = base_url.substr(host_start, path_start - host_start);
-    
-    std::string result;
-    std::string path;
-    
-    if (relative_url[0] == '/') {
-        // Absolute path
-        path = relative_url;
-    } else {
-        // Relative path - start from directory of base URL
-        std::string base_path = base_url.substr(path_start);
-        size_t last_slash = base_path.rfind('/');
-        if (last_slash != std::string::npos) {
-            base_path = base_path.substr(0, last_slash + 1);
-        } else {
-            base_path = "/";
-        }
-        path = base_path + relative_url;
-    }
-    
-    // Resolve .. and . in path
-    std::vector<std::string> segments;
-    std::istringstream iss(path);
-    std::string segment;
-    
-    while (std::getline(iss, segment, '/')) {
-        if (segment == "." || segment.empty()) {
-            continue;
-        } else if (segment == "..") {
-            if (!segments.empty()) {
-                segments.pop_back();
-            }
-        } else {
-            segments.push_back(segment);
-        }
-    }
-    
-    // Rebuild path
-    std::string resolved_path = "/";
-    for (size_t i = 0; i < segments.size(); ++i) {
-        resolved_path += segments[i];
-        if (i < segments.size() - 1 || path.back() == '/') {
-            resolved_path += "/";
-        }
-    }
-    
-    result = scheme + host + resolved_path;
-    return normalize_url(result);
+    Url resolved = Url::resolve(Url::parse(base_url), relative_url);
+    if (!is_valid_url(resolved)) return "";
+    url_canonicalizer_.canonicalize(resolved);
+    return resolved.release();
 }
 
-std::string WebCrawler::extract_canonical_url(const std::string& html, const std::string& base_url) {
+std::string WebCrawler::extract_canonical_url(std::string_view html, const std::string& base_url) {
     // Look for <link rel="canonical" href="...">
     std::regex canonical_regex(R"(<link\s+[^>]*rel=["\']?canonical["\']?[^>]*href=["\']([^"\']+)["\'][^>]*>)", 
                                std::regex::icase);
-    std::smatch match;
+    std::cmatch match;
     
-    if (std::regex_search(html, match, canonical_regex)) {
+    if (std::regex_search(html.data(), html.data() + html.size(), match, canonical_regex)) {
         std::string canonical = match[1].str();
         return resolve_relative_url(base_url, canonical);
     }
@@ -1427,32 +1995,33 @@ std::string WebCrawler::extract_canonical_url(const std::string& html, const std
     return "";
 }
 
-std::vector<std::string> WebCrawler::extract_links_from_html(const std::string& html, const std::string& base_url) {
+std::vector<std::string> WebCrawler::extract_links_from_html(std::string_view html, const std::string& base_url) {
     std::vector<std::string> links;
     std::set<std::string> unique_links;  // To avoid duplicates
     
     // Extract all href attributes from <a> tags
     std::regex link_regex(R"(href=["\']([^"\']+)["\'])", std::regex::icase);
     
-    auto links_begin = std::sregex_iterator(html.begin(), html.end(), link_regex);
-    auto links_end = std::sregex_iterator();
+    auto links_begin = std::cregex_iterator(html.data(), html.data() + html.size(), link_regex);
+    auto links_end = std::cregex_iterator();
+    
+    // Parse the base once; each link is resolved straight into its own buffer
+    Url base = Url::parse(base_url);
     
     for (auto it = links_begin; it != links_end; ++it) {
-        std::string url = it->str(1);
+        const auto& match = (*it)[1];
+        std::string_view url(&*match.first, static_cast<size_t>(match.length()));
         
         // Skip certain URLs
-        if (url.empty() || url[0] == '#' || url.find("javascript:") == 0 || 
-            url.find("mailto:") == 0 || url.find("tel:") == 0) {
+        if (url.empty() || url[0] == '#' || url.compare(0, 11, "javascript:") == 0 ||
+            url.compare(0, 7, "mailto:") == 0 || url.compare(0, 4, "tel:") == 0) {
             continue;
         }
         
-        // Resolve relative URLs
-        std::string resolved = resolve_relative_url(base_url, url);
-        if (!resolved.empty()) {
-            std::string normalized = normalize_url(resolved);
-            if (!normalized.empty() && is_valid_url(normalized)) {
-                unique_links.insert(normalized);
-            }
+        Url resolved = Url::resolve(base, url);
+        if (is_valid_url(resolved)) {
+            url_canonicalizer_.canonicalize(resolved);
+            unique_links.insert(resolved.release());
         }
     }
     
@@ -1471,7 +2040,7 @@ std::vector<std::string> WebCrawler::extract_links_from_html(const std::string&
 /**
  * Detect encoding from Content-Type header and HTML meta tags
  */
-std::string WebCrawler::detect_encoding(const std::string& content, const std::string& content_type) {
+std::string WebCrawler::detect_encoding(std::string_view content, const std::string& content_type) {
     std::string encoding = "UTF-8";  // Default encoding
     
     // Try to extract encoding from Content-Type header
@@ -1500,8 +2069,8 @@ std::string WebCrawler::detect_encoding(const std::string& content, const std::s
     // Try to extract encoding from meta charset tag
     std::regex meta_charset_regex(R"(<meta\s+charset\s*=\s*[\"']?([^\s\"'>]+)[\"']?)", 
                                    std::regex::icase);
-    std::smatch match;
-    if (std::regex_search(content, match, meta_charset_regex)) {
+    std::cmatch match;
+    if (std::regex_search(content.data(), content.data() + content.size(), match, meta_charset_regex)) {
         encoding = match[1].str();
         std::transform(encoding.begin(), encoding.end(), encoding.begin(), ::toupper);
         return encoding;
@@ -1510,7 +2079,7 @@ std::string WebCrawler::detect_encoding(const std::string& content, const std::s
     // Try alternative meta tag format
     std::regex meta_http_equiv_regex(R"(<meta\s+http-equiv\s*=\s*[\"']?content-type[\"']?\s+content\s*=\s*[\"']([^\"']*)[\"'])",
                                      std::regex::icase);
-    if (std::regex_search(content, match, meta_http_equiv_regex)) {
+    if (std::regex_search(content.data(), content.data() + content.size(), match, meta_http_equiv_regex)) {
         std::string content_type_meta = match[1].str();
         size_t charset_pos = content_type_meta.find("charset=");
         if (charset_pos != std::string::npos) {
@@ -1530,9 +2099,9 @@ std::string WebCrawler::detect_encoding(const std::string& content, const std::s
 /**
  * Convert content from source encoding to UTF-8
  */
-std::string WebCrawler::convert_to_utf8(const std::string& content, const std::string& from_encoding) {
+std::string WebCrawler::convert_to_utf8(std::string_view content, const std::string& from_encoding) {
     if (content.empty()) {
-        return content;
+        return std::string();
     }
     
     std::string normalized_encoding = from_encoding;
@@ -1541,7 +2110,7 @@ std::string WebCrawler::convert_to_utf8(const std::string& content, const std::s
     
     // If already UTF-8, return as is
     if (normalized_encoding == "UTF-8" || normalized_encoding == "UTF8") {
-        return content;
+        return std::string(content);
     }
     
     // Open iconv conversion descriptor
@@ -1550,7 +2119,7 @@ std::string WebCrawler::convert_to_utf8(const std::string& content, const std::s
         std::ostringstream err_msg;
         err_msg << "Unsupported encoding: " << normalized_encoding << ", keeping original content";
         log_warn(err_msg.str());
-        return content;
+        return std::string(content);
     }
     
     // Allocate output buffer (use 4x input size to be safe)
@@ -1558,7 +2127,7 @@ std::string WebCrawler::convert_to_utf8(const std::string& content, const std::s
     size_t out_size = in_bytes * 4 + 1;
     char* out_buf = new char[out_size];
     
-    const char* in_ptr = content.c_str();
+    const char* in_ptr = content.data();
     char* out_ptr = out_buf;
     size_t in_left = in_bytes;
     size_t out_left = out_size - 1;
@@ -1637,10 +2206,12 @@ void WebCrawler::apply_adaptive_delay(int status_code) {
 
     auto now = std::chrono::steady_clock::now();
     bool success = status_code >= 200 && status_code < 400;
+    // 429/503 pause only their own host (see pause_rate_limited_host)
+    bool rate_limited = status_code == 429 || status_code == 503;
     if (success) {
         consecutive_successes_++;
         consecutive_failures_ = 0;
-    } else {
+    } else if (!rate_limited) {
         consecutive_failures_++;
         consecutive_successes_ = 0;
     }
@@ -1665,17 +2236,12 @@ void WebCrawler::apply_adaptive_delay(int status_code) {
     int base_delay = std::max(http_config_.base_delay_ms, latency_based);
     int delay_ms = static_cast<int>(base_delay * queue_adjust);
 
-    if (!success) {
+    if (!success && !rate_limited) {
         delay_ms += http_config_.failure_backoff_ms * consecutive_failures_;
     } else if (consecutive_successes_ > 3) {
         delay_ms = static_cast<int>(delay_ms * 0.8);
     }
 
-    if (status_code == 429 || status_code == 503) {
-        int exponent = std::min(consecutive_failures_, 6);
-        delay_ms = static_cast<int>(delay_ms * std::pow(2.0, exponent));
-    }
-
     if (last_delay_ms_ > 0) {
         delay_ms = static_cast<int>(0.7 * last_delay_ms_ + 0.3 * delay_ms);
     }
@@ -1718,6 +2284,17 @@ bool WebCrawler::should_stop() const {
     return false;
 }
 
+bool WebCrawler::ensure_db_initialized() {
+    if (db_initialized_) {
+        return true;
+    }
+    db_initialized_ = db_manager_->init();
+    if (!db_initialized_) {
+        log_error("Failed to initialize RocksDB at " + db_path_);
+    }
+    return db_initialized_;
+}
+
 void WebCrawler::report_request_metric(const std::string& url,
                                        int status_code,
                                        long duration_ms,
@@ -1830,6 +2407,14 @@ std::string WebCrawler::format_stats_message(const CrawlerStats& stats) {
     message << "Blocked (noindex): " << stats.blocked_by_noindex << " | ";
     message << "Skipped (size): " << stats.skipped_by_size << " | ";
     message << "Duplicates: " << stats.duplicates_detected << " | ";
+    message << "DUST rewrites: " << stats.dust_rewrites << " | ";
+    message << "Traps: " << stats.trap_prefixes << " (blocked " << stats.blocked_by_trap
+            << ", throttled " << stats.throttled_by_trap << ") | ";
+    message << "Recrawls: " << stats.recrawls_enqueued << " (changed " << stats.pages_changed
+            << ", not modified " << stats.not_modified << ") | ";
+    message << "Rate limited: " << stats.rate_limited << " (paused hosts " << stats.paused_hosts << ") | ";
+    message << "Open circuits: " << stats.open_circuits << " | ";
+    message << "Retries: " << stats.retries_scheduled << " (denied " << stats.retries_denied << ") | ";
     message << "HTTP/2: " << stats.http2_requests << " | ";
     message << "HTTP/1.1: " << stats.http11_requests << " | ";
     message << "Data: " << (stats.total_bytes_downloaded / (1024 * 1024)) << " MB | ";
@@ -1866,7 +2451,7 @@ int WebCrawler::get_duplicates_detected_count() const {
  * Calculate SimHash for content deduplication
  * SimHash is a technique for generating a hash that is similar for similar documents
  */
-uint64_t WebCrawler::calculate_simhash(const std::string& content) {
+uint64_t WebCrawler::calculate_simhash(std::string_view content) {
     if (content.empty()) {
         return 0;
     }
@@ -1941,24 +2526,35 @@ int WebCrawler::hamming_distance(uint64_t hash1, uint64_t hash2) {
  * Check if content is a duplicate based on SimHash
  * threshold: maximum hamming distance to consider as duplicate (0-64)
  */
-bool WebCrawler::is_duplicate(uint64_t content_hash, int threshold) {
+bool WebCrawler::is_duplicate(const std::string& url, uint64_t content_hash, int threshold) {
     if (!enable_deduplication_) {
         return false;
     }
     
+    size_t url_hash = std::hash<std::string>()(url);
     std::lock_guard<std::mutex> lock(dedup_mutex_);
     
-    // Check against all previously stored hashes
-    for (uint64_t stored_hash : content_hashes_) {
-        int distance = hamming_distance(content_hash, stored_hash);
+    // Check against the hashes of other URLs; a revisited page is not a
+    // duplicate of its own earlier fetch
+    auto own = content_hashes_.end();
+    for (auto it = content_hashes_.begin(); it != content_hashes_.end(); ++it) {
+        if (it->first == url_hash) {
+            own = it;
+            continue;
+        }
+        int distance = hamming_distance(content_hash, it->second);
         if (distance <= threshold) {
             duplicates_detected_++;
             return true;
         }
     }
     
-    // Add this hash to the collection
-    content_hashes_.push_back(content_hash);
+    // Add this hash to the collection, or replace the URL's previous one
+    if (own != content_hashes_.end()) {
+        own->second = content_hash;
+    } else {
+        content_hashes_.emplace_back(url_hash, content_hash);
+    }
     return false;
 }
 
@@ -1967,6 +2563,14 @@ bool WebCrawler::is_duplicate(uint64_t content_hash, int threshold) {
  */
 void WebCrawler::set_http_config(const HTTPConfig& config) {
     http_config_ = config;
+    host_throttle_.set_limits(std::chrono::seconds(http_config_.rate_limit_pause_seconds),
+                              std::chrono::seconds(http_config_.max_retry_after_seconds));
+    retry_budget_.configure(http_config_.retry_budget_ratio, 10.0);  // Burst of up to 10 retries
+    TimeoutPolicy timeout_policy;
+    timeout_policy.multiplier = http_config_.adaptive_timeout_multiplier;
+    host_latency_.set_policy(timeout_policy);
+    robots_cache_.configure(static_cast<size_t>(std::max(1, http_config_.robots_cache_max_hosts)),
+                            http_config_.robots_cache_ttl_seconds);
     
     if (http_config_.enable_http2) {
         log_info("HTTP/2 support enabled (with HTTP/1.1 fallback)");
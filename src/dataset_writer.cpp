@@ -13,7 +13,9 @@ ParquetDatasetWriter::~ParquetDatasetWriter() {
 
 void ParquetDatasetWriter::write_records(const std::string& filepath, 
                                          const std::vector<DataRecord>& records) {
-    if (filepath.find(".json") != std::string::npos) {
+    if (filepath.size() >= 8 && filepath.compare(filepath.size() - 8, 8, ".parquet") == 0) {
+        write_parquet(filepath, records);
+    } else if (filepath.find(".json") != std::string::npos) {
         write_json_internal(filepath, records);
     } else {
         write_json_internal(filepath + ".json", records);
@@ -35,25 +37,8 @@ void ParquetDatasetWriter::write_json_internal(const std::string& filepath,
         }
 
         file << "[\n";
-        
-        for (size_t i = 0; i < records.size(); ++i) {
-            const auto& record = records[i];
-            
-            file << "  {\n";
-            file << "    \"url\": \"" << escape_json(record.url) << "\",\n";
-            file << "    \"title\": \"" << escape_json(record.title) << "\",\n";
-            file << "    \"content_length\": " << record.content.size() << ",\n";
-            file << "    \"timestamp\": \"" << record.timestamp << "\",\n";
-            file << "    \"status_code\": " << record.status_code << "\n";
-            file << "  }";
-            
-            if (i < records.size() - 1) {
-                file << ",";
-            }
-            file << "\n";
-        }
-        
-        file << "]\n";
+        write_json_rows(file, records, true);
+        file << (records.empty() ? "" : "\n") << "]\n";
         file.close();
         
         std::ostringstream msg;
@@ -75,32 +60,8 @@ void ParquetDatasetWriter::write_csv(const std::string& filepath,
         throw std::runtime_error("Failed to open CSV file: " + filepath);
     }
 
-    // Write header
-    file << "url,title,content_length,timestamp,status_code\n";
-
-    // Write records
-    for (const auto& record : records) {
-        auto escape_csv = [](const std::string& value) -> std::string {
-            std::string escaped = "\"";
-            for (char c : value) {
-                if (c == '"') {
-                    escaped += "\"\"";
-                } else if (c == '\n' || c == '\r') {
-                    escaped += " ";
-                } else {
-                    escaped += c;
-                }
-            }
-            escaped += "\"";
-            return escaped;
-        };
-
-        file << escape_csv(record.url) << ","
-             << escape_csv(record.title) << ","
-             << record.content.size() << ","
-             << escape_csv(record.timestamp) << ","
-             << record.status_code << "\n";
-    }
+    write_csv_header(file);
+    write_csv_rows(file, records);
 
     file.close();
     
@@ -109,6 +70,70 @@ void ParquetDatasetWriter::write_csv(const std::string& filepath,
     log_info(msg.str());
 }
 
+void ParquetDatasetWriter::write_parquet(const std::string& filepath,
+                                         const std::vector<DataRecord>& records) {
+    ParquetFileWriter writer(parquet_options_);
+    if (!writer.open(filepath) || !writer.write(records) || !writer.close()) {
+        throw std::runtime_error("Failed to write Parquet file: " + filepath);
+    }
+
+    std::ostringstream msg;
+    msg << "Successfully wrote " << records.size() << " records to " << filepath << " ("
+        << writer.row_groups() << " row groups, " << writer.bytes_written() << " bytes)";
+    log_info(msg.str());
+}
+
+void ParquetDatasetWriter::set_parquet_options(const ParquetWriterOptions& options) {
+    parquet_options_ = options;
+}
+
+void ParquetDatasetWriter::write_json_rows(std::ostream& out, const std::vector<DataRecord>& records,
+                                           bool first) {
+    for (const auto& record : records) {
+        if (!first) {
+            out << ",\n";
+        }
+        first = false;
+
+        out << "  {\n";
+        out << "    \"url\": \"" << escape_json(record.url) << "\",\n";
+        out << "    \"title\": \"" << escape_json(record.title) << "\",\n";
+        out << "    \"content_length\": " << record.content.size() << ",\n";
+        out << "    \"timestamp\": \"" << record.timestamp << "\",\n";
+        out << "    \"status_code\": " << record.status_code << "\n";
+        out << "  }";
+    }
+}
+
+void ParquetDatasetWriter::write_csv_header(std::ostream& out) {
+    out << "url,title,content_length,timestamp,status_code\n";
+}
+
+void ParquetDatasetWriter::write_csv_rows(std::ostream& out, const std::vector<DataRecord>& records) {
+    auto escape_csv = [](const std::string& value) -> std::string {
+        std::string escaped = "\"";
+        for (char c : value) {
+            if (c == '"') {
+                escaped += "\"\"";
+            } else if (c == '\n' || c == '\r') {
+                escaped += " ";
+            } else {
+                escaped += c;
+            }
+        }
+        escaped += "\"";
+        return escaped;
+    };
+
+    for (const auto& record : records) {
+        out << escape_csv(record.url) << ","
+            << escape_csv(record.title) << ","
+            << record.content.size() << ","
+            << escape_csv(record.timestamp) << ","
+            << record.status_code << "\n";
+    }
+}
+
 std::string ParquetDatasetWriter::escape_json(const std::string& value) {
     std::string escaped;
     for (char c : value) {
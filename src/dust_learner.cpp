@@ -0,0 +1,344 @@
+#include "dust_learner.h"
+#include "logger.h"
+#include <algorithm>
+#include <bitset>
+#include <sstream>
+#include <string_view>
+
+namespace {
+
+constexpr uint64_t kFnvOffset = 1469598103934665603ULL;
+constexpr uint64_t kFnvPrime = 1099511628211ULL;
+constexpr size_t kMaxParamsPerUrl = 32;
+constexpr size_t kMaxParamsPerHost = 256;
+
+uint64_t hash_bytes(uint64_t hash, std::string_view data) {
+    for (char c : data) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= kFnvPrime;
+    }
+    return hash;
+}
+
+std::string_view param_name(std::string_view param) {
+    return param.substr(0, param.find('='));
+}
+
+std::string_view param_value(std::string_view param) {
+    size_t equals = param.find('=');
+    return equals == std::string_view::npos ? std::string_view() : param.substr(equals + 1);
+}
+
+} // namespace
+
+DustLearner::DustLearner(size_t max_hosts)
+    : max_hosts_(max_hosts > 0 ? max_hosts : 1),
+      min_support_(5),
+      min_confidence_(0.95) {
+}
+
+void DustLearner::set_min_support(size_t pairs) {
+    min_support_ = std::max<size_t>(1, pairs);
+}
+
+void DustLearner::set_min_confidence(double confidence) {
+    min_confidence_ = std::min(1.0, std::max(0.5, confidence));
+}
+
+void DustLearner::set_persistence(Loader loader, Saver saver) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    loader_ = std::move(loader);
+    saver_ = std::move(saver);
+}
+
+bool DustLearner::observe(const Url& url, uint64_t fingerprint) {
+    // Pages without a query are still recorded: they pair with their parameterized variants
+    if (!url.valid()) {
+        return false;
+    }
+
+    std::vector<std::string_view> params;
+    std::string_view query = url.query();
+    size_t start = 0;
+    while (start < query.size() && params.size() < kMaxParamsPerUrl) {
+        size_t end = query.find('&', start);
+        if (end == std::string_view::npos) end = query.size();
+        if (end > start) {
+            params.push_back(query.substr(start, end - start));
+        }
+        start = end + 1;
+    }
+
+    // Key of the URL with parameter `skip` left out (all parameters kept for npos)
+    const std::string& spec = url.str();
+    std::string_view prefix(spec.data(), static_cast<size_t>(url.path().data() - spec.data()) + url.path().size());
+    uint64_t prefix_hash = hash_bytes(kFnvOffset, prefix);
+    auto key_without = [&](size_t skip) {
+        uint64_t hash = prefix_hash;
+        for (size_t i = 0; i < params.size(); ++i) {
+            if (i == skip) continue;
+            hash = hash_bytes(hash, params[i]);
+            hash = hash_bytes(hash, "&");
+        }
+        return hash;
+    };
+    auto same_content = [fingerprint](uint64_t other) {
+        return static_cast<int>(std::bitset<64>(fingerprint ^ other).count()) <= kSameContentBits;
+    };
+
+    std::string host(url.host());
+    std::lock_guard<std::mutex> lock(mutex_);
+    HostRules& entry = lookup(host);
+    bool learned = false;
+
+    // Pages that were this URL plus one more parameter
+    uint64_t full_key = key_without(std::string_view::npos);
+    auto it = entry.samples.find(full_key);
+    if (it != entry.samples.end()) {
+        for (const auto& sample : it->second) {
+            if (sample.param == 0) continue;  // This same URL, fetched before
+            auto name = entry.names.find(sample.param);
+            if (name != entry.names.end()) {
+                learned |= record(entry, name->second, same_content(sample.fingerprint));
+            }
+        }
+    }
+
+    // Pages that differ from this one in the value or presence of one parameter
+    std::vector<uint64_t> keys(params.size());
+    for (size_t i = 0; i < params.size(); ++i) {
+        keys[i] = key_without(i);
+        uint64_t name_hash = hash_bytes(kFnvOffset, param_name(params[i]));
+        uint64_t value_hash = hash_bytes(kFnvOffset, param_value(params[i]));
+        auto found = entry.samples.find(keys[i]);
+        if (found == entry.samples.end()) continue;
+        for (const auto& sample : found->second) {
+            bool without_param = sample.param == 0;
+            bool other_value = sample.param == name_hash && sample.value != value_hash;
+            if (without_param || other_value) {
+                learned |= record(entry, std::string(param_name(params[i])), same_content(sample.fingerprint));
+            }
+        }
+    }
+
+    // Remember this page under all of its keys
+    auto remember = [&entry](uint64_t key, const Sample& sample) {
+        if (entry.sample_count >= kMaxSamplesPerHost) return;
+        auto& bucket = entry.samples[key];
+        if (bucket.size() >= kMaxSamplesPerKey) {
+            bucket.erase(bucket.begin());
+            --entry.sample_count;
+        }
+        bucket.push_back(sample);
+        ++entry.sample_count;
+    };
+    remember(full_key, Sample{0, 0, fingerprint});
+    for (size_t i = 0; i < params.size(); ++i) {
+        std::string_view name = param_name(params[i]);
+        if (entry.params.size() >= kMaxParamsPerHost && entry.params.find(std::string(name)) == entry.params.end()) {
+            continue;
+        }
+        uint64_t name_hash = hash_bytes(kFnvOffset, name);
+        entry.params.emplace(std::string(name), ParamStat());
+        entry.names.emplace(name_hash, std::string(name));
+        remember(keys[i], Sample{name_hash, hash_bytes(kFnvOffset, param_value(params[i])), fingerprint});
+    }
+
+    if (learned) {
+        rebuild_rewriter(entry);
+        forget_stored(host);
+        if (saver_) {
+            saver_(host, serialize(entry));
+        }
+    }
+    return learned;
+}
+
+bool DustLearner::record(HostRules& entry, const std::string& name, bool same_content) {
+    auto it = entry.params.find(name);
+    if (it == entry.params.end()) {
+        if (entry.params.size() >= kMaxParamsPerHost) return false;
+        it = entry.params.emplace(name, ParamStat()).first;
+    }
+    ParamStat& stat = it->second;
+    if (stat.dropped) {
+        return false;
+    }
+    if (same_content) {
+        ++stat.agree;
+    } else {
+        ++stat.disagree;
+    }
+
+    double total = static_cast<double>(stat.agree + stat.disagree);
+    if (stat.agree >= min_support_ && stat.agree >= min_confidence_ * total) {
+        stat.dropped = true;
+        std::ostringstream msg;
+        msg << "DustLearner: Dropping parameter '" << name << "' (" << stat.agree
+            << " identical / " << stat.disagree << " different page pairs)";
+        Logger::instance().info(msg.str());
+        return true;
+    }
+    return false;
+}
+
+bool DustLearner::rewrite(Url& url) {
+    if (!url.valid() || !url.has_query()) {
+        return false;
+    }
+    std::string host(url.host());
+    size_t before = url.str().size();
+    std::shared_ptr<const UrlCanonicalizer> rewriter;
+    Loader loader;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto learning = hosts_.find(host);
+        if (learning != hosts_.end()) {
+            if (!learning->second.has_rules) {
+                return false;
+            }
+            learning->second.rewriter.canonicalize(url);
+            return url.str().size() != before;
+        }
+        auto stored = stored_.find(host);
+        if (stored != stored_.end()) {
+            stored_lru_.splice(stored_lru_.begin(), stored_lru_, stored->second.lru_position);
+            rewriter = stored->second.rewriter;
+        } else {
+            loader = loader_;
+        }
+    }
+    if (loader) {
+        rewriter = load_rewriter(host, loader);
+    }
+    if (!rewriter) {
+        return false;
+    }
+    rewriter->canonicalize(url);
+    return url.str().size() != before;
+}
+
+std::shared_ptr<const UrlCanonicalizer> DustLearner::load_rewriter(const std::string& host,
+                                                                   const Loader& loader) {
+    std::shared_ptr<const UrlCanonicalizer> rewriter;
+    std::vector<std::string> dropped = dropped_parameters(loader(host));
+    if (!dropped.empty()) {
+        auto compiled = std::make_shared<UrlCanonicalizer>();
+        compiled->set_stripped_params(dropped);
+        rewriter = std::move(compiled);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    // A host that started learning meanwhile has fresher rules than the store
+    if (hosts_.count(host) == 0 && stored_.count(host) == 0) {
+        if (stored_.size() >= max_hosts_) {
+            stored_.erase(stored_lru_.back());
+            stored_lru_.pop_back();
+        }
+        stored_lru_.push_front(host);
+        stored_[host] = StoredRules{rewriter, stored_lru_.begin()};
+    }
+    return rewriter;
+}
+
+void DustLearner::forget_stored(const std::string& host) {
+    auto it = stored_.find(host);
+    if (it != stored_.end()) {
+        stored_lru_.erase(it->second.lru_position);
+        stored_.erase(it);
+    }
+}
+
+std::vector<std::string> DustLearner::rules(const std::string& host) {
+    Loader loader;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = hosts_.find(host);
+        if (it != hosts_.end()) {
+            return dropped_names(it->second);
+        }
+        loader = loader_;
+    }
+    return loader ? dropped_parameters(loader(host)) : std::vector<std::string>();
+}
+
+std::vector<std::string> DustLearner::dropped_parameters(const std::string& data) {
+    HostRules entry;
+    deserialize(data, entry);
+    return dropped_names(entry);
+}
+
+std::vector<std::string> DustLearner::dropped_names(const HostRules& entry) {
+    std::vector<std::string> names;
+    for (const auto& [name, stat] : entry.params) {
+        if (stat.dropped) {
+            names.push_back(name);
+        }
+    }
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+DustLearner::HostRules& DustLearner::lookup(const std::string& host) {
+    auto it = hosts_.find(host);
+    if (it != hosts_.end()) {
+        lru_.splice(lru_.begin(), lru_, it->second.lru_position);
+        return it->second;
+    }
+
+    // Rules were saved when learned; pending evidence of an evicted host is lost
+    if (hosts_.size() >= max_hosts_) {
+        hosts_.erase(lru_.back());
+        lru_.pop_back();
+    }
+
+    lru_.push_front(host);
+    HostRules& entry = hosts_[host];
+    entry.lru_position = lru_.begin();
+
+    if (loader_) {
+        std::string data = loader_(host);
+        if (!data.empty()) {
+            deserialize(data, entry);
+            rebuild_rewriter(entry);
+        }
+    }
+    return entry;
+}
+
+void DustLearner::rebuild_rewriter(HostRules& entry) {
+    std::vector<std::string> dropped;
+    for (const auto& [name, stat] : entry.params) {
+        if (stat.dropped) {
+            dropped.push_back(name);
+        }
+    }
+    entry.rewriter.set_stripped_params(dropped);
+    entry.has_rules = !dropped.empty();
+}
+
+std::string DustLearner::serialize(const HostRules& entry) {
+    std::ostringstream out;
+    for (const auto& [name, stat] : entry.params) {
+        if (stat.agree == 0 && stat.disagree == 0) continue;
+        out << (stat.dropped ? "-" : "") << name << " " << stat.agree << " " << stat.disagree << "\n";
+    }
+    return out.str();
+}
+
+void DustLearner::deserialize(const std::string& data, HostRules& entry) {
+    std::istringstream in(data);
+    std::string name;
+    uint32_t agree = 0;
+    uint32_t disagree = 0;
+    while (in >> name >> agree >> disagree) {
+        bool dropped = name.size() > 1 && name[0] == '-';
+        if (dropped) {
+            name.erase(0, 1);
+        }
+        ParamStat& stat = entry.params[name];
+        stat.agree = agree;
+        stat.disagree = disagree;
+        stat.dropped = dropped;
+    }
+}
@@ -0,0 +1,321 @@
+#include "event_loop.h"
+#include "logger.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr int kMaxEvents = 256;
+constexpr unsigned kRingEntries = 1024;
+
+// io_uring poll tokens: tag bit, 30-bit sequence, direction bit, fd. The
+// tag keeps them apart from receive completions, whose user_data is an
+// awaiter address, and from linked timeouts, whose user_data is 0.
+constexpr uint64_t kPollTag = 1ULL << 63;
+constexpr uint64_t kWriteBit = 1ULL << 32;
+
+uint64_t poll_token(uint64_t sequence, int fd, bool write) {
+    return kPollTag | ((sequence & 0x3fffffff) << 33) | (write ? kWriteBit : 0) |
+           static_cast<uint32_t>(fd);
+}
+
+} // namespace
+
+EventLoop::EventLoop(IoBackend backend) {
+    if (backend != IoBackend::Epoll) {
+        ring_ = IoUringQueue::create(kRingEntries);
+        static std::atomic<bool> warned{false};
+        if (!ring_ && backend == IoBackend::IoUring && !warned.exchange(true)) {
+            log_warn("io_uring is not available, raw-socket fetches use epoll");
+        }
+    }
+    if (!ring_) {
+        epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+        if (epoll_fd_ < 0) {
+            log_error("epoll_create1 failed: " + std::string(std::strerror(errno)));
+        }
+    }
+}
+
+EventLoop::~EventLoop() {
+    if (epoll_fd_ >= 0) {
+        close(epoll_fd_);
+    }
+}
+
+EventLoop::Wait EventLoop::readable(int fd, Clock::time_point deadline) {
+    return Wait(*this, {fd}, EPOLLIN, deadline);
+}
+
+EventLoop::Wait EventLoop::writable(int fd, Clock::time_point deadline) {
+    return Wait(*this, {fd}, EPOLLOUT, deadline);
+}
+
+EventLoop::Wait EventLoop::any_writable(std::vector<int> fds, Clock::time_point deadline) {
+    return Wait(*this, std::move(fds), EPOLLOUT, deadline);
+}
+
+EventLoop::Wait EventLoop::sleep_until(Clock::time_point deadline) {
+    return Wait(*this, {}, 0, deadline);
+}
+
+Task<long> EventLoop::receive(int fd, char* buffer, size_t size, Clock::time_point deadline) {
+    while (true) {
+        if (ring_) {
+            long received = co_await RingReceive(*this, fd, buffer, size, deadline);
+            if (received == -ECANCELED) {
+                co_return -ETIME;  // The linked timeout fired first
+            }
+            if (received != -EAGAIN) {
+                co_return received;
+            }
+        } else {
+            ssize_t received = recv(fd, buffer, size, 0);
+            if (received >= 0) {
+                co_return static_cast<long>(received);
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                co_return -errno;
+            }
+        }
+        if (!co_await readable(fd, deadline)) {
+            co_return -ETIME;
+        }
+    }
+}
+
+void EventLoop::RingReceive::await_suspend(std::coroutine_handle<> handle) {
+    handle_ = handle;
+    loop_.parked_++;
+    if (!loop_.ring_->recv(fd_, buffer_, size_, reinterpret_cast<uint64_t>(this), deadline_)) {
+        result_ = -EAGAIN;  // Retried after a readiness wait
+        loop_.failed_receives_.push_back(this);
+    }
+}
+
+void EventLoop::forget(int fd) {
+    auto it = watches_.find(fd);
+    if (it == watches_.end()) {
+        return;
+    }
+    Watch& watch = it->second;
+    if (ring_) {
+        // An in-flight poll pins the socket open until it is removed
+        if (watch.read_poll != 0) {
+            ring_->poll_remove(watch.read_poll);
+        }
+        if (watch.write_poll != 0) {
+            ring_->poll_remove(watch.write_poll);
+        }
+    } else if (watch.registered) {
+        epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+    }
+    watches_.erase(it);
+}
+
+void EventLoop::park(Wait* wait) {
+    parked_++;
+    wait->timer_ = wait->deadline_ == Clock::time_point::max()
+        ? timers_.end() : timers_.emplace(wait->deadline_, wait);
+
+    bool armed = true;
+    for (int fd : wait->fds_) {
+        Watch& watch = watches_[fd];
+        if (wait->events_ & EPOLLIN) {
+            watch.reader = wait;
+        }
+        if (wait->events_ & EPOLLOUT) {
+            watch.writer = wait;
+        }
+        armed = arm(fd, watch) && armed;
+    }
+    if (!armed) {
+        // Let the coroutine retry its operation and see the error itself
+        failed_.push_back(wait);
+    }
+}
+
+bool EventLoop::arm(int fd, Watch& watch) {
+    return ring_ ? arm_ring(fd, watch) : arm_epoll(fd, watch);
+}
+
+bool EventLoop::arm_epoll(int fd, Watch& watch) {
+    struct epoll_event event {};
+    event.events = EPOLLONESHOT;
+    if (watch.reader) {
+        event.events |= EPOLLIN | EPOLLRDHUP;
+    }
+    if (watch.writer) {
+        event.events |= EPOLLOUT;
+    }
+    event.data.fd = fd;
+
+    // Sockets closed without forget() leave stale entries; the kernel has
+    // already dropped them, and a reused descriptor may or may not be known
+    int op = watch.registered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+    int result = epoll_ctl(epoll_fd_, op, fd, &event);
+    if (result < 0 && errno == ENOENT) {
+        result = epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event);
+    } else if (result < 0 && errno == EEXIST) {
+        result = epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &event);
+    }
+    watch.registered = result == 0;
+    return result == 0;
+}
+
+bool EventLoop::arm_ring(int fd, Watch& watch) {
+    // A poll still in flight from an earlier, timed-out wait serves the new one
+    if (watch.reader && watch.read_poll == 0) {
+        uint64_t token = poll_token(++next_poll_, fd, false);
+        if (!ring_->poll(fd, POLLIN | POLLRDHUP, token)) {
+            return false;
+        }
+        watch.read_poll = token;
+    }
+    if (watch.writer && watch.write_poll == 0) {
+        uint64_t token = poll_token(++next_poll_, fd, true);
+        if (!ring_->poll(fd, POLLOUT, token)) {
+            return false;
+        }
+        watch.write_poll = token;
+    }
+    return true;
+}
+
+void EventLoop::unpark(Wait* wait, bool ready, std::vector<std::coroutine_handle<>>& wake) {
+    for (int fd : wait->fds_) {
+        auto it = watches_.find(fd);
+        if (it == watches_.end()) {
+            continue;
+        }
+        if (it->second.reader == wait) {
+            it->second.reader = nullptr;
+        }
+        if (it->second.writer == wait) {
+            it->second.writer = nullptr;
+        }
+    }
+    if (wait->timer_ != timers_.end()) {
+        timers_.erase(wait->timer_);
+        wait->timer_ = timers_.end();
+    }
+    wait->ready_ = ready;
+    parked_--;
+    wake.push_back(wait->handle_);
+}
+
+void EventLoop::on_ready(int fd, bool readable, bool writable, std::vector<std::coroutine_handle<>>& wake) {
+    auto it = watches_.find(fd);
+    if (it == watches_.end()) {
+        return;
+    }
+    // unpark() only clears slots, so this reference stays valid
+    Watch& watch = it->second;
+    if (readable && watch.reader) {
+        unpark(watch.reader, true, wake);
+    }
+    if (writable && watch.writer) {
+        unpark(watch.writer, true, wake);
+    }
+}
+
+void EventLoop::wait_events(int timeout_ms, std::vector<std::coroutine_handle<>>& wake) {
+    if (ring_) {
+        std::vector<IoUringQueue::Completion> completions;
+        if (!ring_->wait(timeout_ms, completions)) {
+            log_error("io_uring_enter failed: " + std::string(std::strerror(errno)));
+        }
+        for (const auto& completion : completions) {
+            if (completion.user_data == 0) {
+                continue;  // Linked timeout or poll removal
+            }
+            if (!(completion.user_data & kPollTag)) {
+                auto* receive = reinterpret_cast<RingReceive*>(completion.user_data);
+                receive->result_ = completion.result;
+                parked_--;
+                wake.push_back(receive->handle_);
+                continue;
+            }
+            int fd = static_cast<int>(static_cast<uint32_t>(completion.user_data));
+            bool write = completion.user_data & kWriteBit;
+            auto it = watches_.find(fd);
+            if (it == watches_.end()) {
+                continue;
+            }
+            uint64_t& in_flight = write ? it->second.write_poll : it->second.read_poll;
+            if (in_flight != completion.user_data) {
+                continue;  // Removed, from a socket since forgotten
+            }
+            in_flight = 0;
+            on_ready(fd, !write, write, wake);
+        }
+        return;
+    }
+
+    struct epoll_event events[kMaxEvents];
+    int count = epoll_wait(epoll_fd_, events, kMaxEvents, timeout_ms);
+    if (count < 0 && errno != EINTR) {
+        log_error("epoll_wait failed: " + std::string(std::strerror(errno)));
+    }
+    for (int i = 0; i < count; ++i) {
+        int fd = events[i].data.fd;
+        uint32_t ready = events[i].events;
+        on_ready(fd, ready & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR),
+                 ready & (EPOLLOUT | EPOLLHUP | EPOLLERR), wake);
+        // One-shot: re-arm for whoever is still waiting on the other direction
+        auto it = watches_.find(fd);
+        if (it != watches_.end() && (it->second.reader || it->second.writer)) {
+            arm_epoll(fd, it->second);
+        }
+    }
+}
+
+bool EventLoop::run_once() {
+    if (parked_ == 0) {
+        return false;
+    }
+
+    std::vector<std::coroutine_handle<>> wake;
+    for (Wait* wait : failed_) {
+        unpark(wait, true, wake);
+    }
+    failed_.clear();
+    for (RingReceive* receive : failed_receives_) {
+        parked_--;
+        wake.push_back(receive->handle_);
+    }
+    failed_receives_.clear();
+
+    int timeout_ms = -1;
+    if (!wake.empty()) {
+        timeout_ms = 0;
+    } else if (!timers_.empty()) {
+        auto until = timers_.begin()->first - Clock::now();
+        auto ms = std::chrono::ceil<std::chrono::milliseconds>(until).count();
+        timeout_ms = static_cast<int>(std::clamp<long long>(ms, 0, INT_MAX));
+    }
+    wait_events(timeout_ms, wake);
+
+    auto now = Clock::now();
+    while (!timers_.empty() && timers_.begin()->first <= now) {
+        unpark(timers_.begin()->second, false, wake);
+    }
+
+    for (auto handle : wake) {
+        handle.resume();
+    }
+    return true;
+}
+
+void EventLoop::run(const std::function<bool()>& finished) {
+    while (!finished() && run_once()) {
+    }
+}
@@ -0,0 +1,121 @@
+#include "host_latency.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+std::chrono::milliseconds derive(long percentile_ms, double multiplier,
+                                 std::chrono::milliseconds minimum,
+                                 std::chrono::milliseconds maximum) {
+    if (percentile_ms < 0) {
+        return maximum;
+    }
+    auto scaled = std::chrono::milliseconds(static_cast<long>(percentile_ms * multiplier));
+    return std::min(maximum, std::max(minimum, scaled));
+}
+
+} // namespace
+
+HostLatencyTracker::HostLatencyTracker(const TimeoutPolicy& policy, size_t max_hosts)
+    : policy_(policy),
+      max_hosts_(max_hosts > 0 ? max_hosts : 1) {}
+
+void HostLatencyTracker::set_policy(const TimeoutPolicy& policy) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    policy_ = policy;
+}
+
+void HostLatencyTracker::record(const std::string& host, long connect_ms, long first_byte_ms, long total_ms) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = hosts_.find(host);
+    if (it == hosts_.end()) {
+        if (hosts_.size() >= max_hosts_) {
+            hosts_.erase(lru_.back());
+            lru_.pop_back();
+        }
+        lru_.push_front(host);
+        it = hosts_.emplace(host, HostStats()).first;
+        it->second.lru_position = lru_.begin();
+    } else {
+        lru_.splice(lru_.begin(), lru_, it->second.lru_position);
+    }
+
+    HostStats& stats = it->second;
+    const long samples[3] = {connect_ms, first_byte_ms, total_ms};
+    for (size_t i = 0; i < 3; ++i) {
+        if (samples[i] >= 0) {
+            stats.metrics[i].add(samples[i]);
+        }
+    }
+}
+
+HostTimeouts HostLatencyTracker::timeouts(const std::string& host, const HostTimeouts& defaults) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = hosts_.find(host);
+    if (it == hosts_.end()) {
+        return defaults;
+    }
+
+    const HostStats& stats = it->second;
+    auto metric_percentile = [&](LatencyMetric metric) -> long {
+        const Histogram& histogram = stats.metrics[static_cast<size_t>(metric)];
+        return histogram.total >= policy_.min_samples ? histogram.percentile(policy_.percentile) : -1;
+    };
+
+    HostTimeouts result;
+    result.connect = derive(metric_percentile(LatencyMetric::Connect), policy_.multiplier,
+                            std::min(policy_.min_connect, defaults.connect), defaults.connect);
+    result.idle = derive(metric_percentile(LatencyMetric::FirstByte), policy_.multiplier,
+                         std::min(policy_.min_idle, defaults.idle), defaults.idle);
+    result.total = derive(metric_percentile(LatencyMetric::Total), policy_.multiplier,
+                          std::min(policy_.min_total, defaults.total), defaults.total);
+    return result;
+}
+
+long HostLatencyTracker::percentile(const std::string& host, LatencyMetric metric, double p) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = hosts_.find(host);
+    if (it == hosts_.end()) {
+        return -1;
+    }
+    return it->second.metrics[static_cast<size_t>(metric)].percentile(p);
+}
+
+void HostLatencyTracker::Histogram::add(long ms) {
+    counts[bucket_of(ms)]++;
+    if (++total >= kDecayAt) {
+        total = 0;
+        for (auto& count : counts) {
+            count /= 2;
+            total += count;
+        }
+    }
+}
+
+long HostLatencyTracker::Histogram::percentile(double p) const {
+    if (total == 0) {
+        return -1;
+    }
+    uint64_t rank = static_cast<uint64_t>(std::ceil(std::clamp(p, 0.0, 1.0) * total));
+    rank = std::max<uint64_t>(rank, 1);
+    uint64_t seen = 0;
+    for (size_t bucket = 0; bucket < kBuckets; ++bucket) {
+        seen += counts[bucket];
+        if (seen >= rank) {
+            return bucket_upper_ms(bucket);
+        }
+    }
+    return bucket_upper_ms(kBuckets - 1);
+}
+
+size_t HostLatencyTracker::bucket_of(long ms) {
+    if (ms <= 0) {
+        return 0;
+    }
+    auto bucket = static_cast<size_t>(std::floor(4.0 * std::log2(static_cast<double>(ms) + 1.0)));
+    return std::min(bucket, kBuckets - 1);
+}
+
+long HostLatencyTracker::bucket_upper_ms(size_t bucket) {
+    return static_cast<long>(std::ceil(std::exp2((bucket + 1) / 4.0) - 1.0));
+}
@@ -0,0 +1,88 @@
+#include "host_throttle.h"
+#include <algorithm>
+
+HostThrottle::HostThrottle(std::chrono::seconds default_pause, std::chrono::seconds max_pause) {
+    set_limits(default_pause, max_pause);
+}
+
+void HostThrottle::set_limits(std::chrono::seconds default_pause, std::chrono::seconds max_pause) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    default_pause_ = std::max(std::chrono::seconds(1), default_pause);
+    max_pause_ = std::max(default_pause_, max_pause);
+}
+
+std::chrono::seconds HostThrottle::rate_limited(const std::string& host, long retry_after_seconds,
+                                                Clock::time_point now) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    HostState& state = hosts_[host];
+    state.strikes++;
+
+    std::chrono::seconds pause;
+    if (retry_after_seconds >= 0) {
+        pause = std::chrono::seconds(std::min<long>(retry_after_seconds,
+                                                    static_cast<long>(max_pause_.count())));
+    } else {
+        int doublings = std::min(state.strikes - 1, kMaxDoublings);
+        pause = std::min(max_pause_, default_pause_ * (1 << doublings));
+    }
+
+    Clock::time_point resume_at = now + pause;
+    if (!state.paused) {
+        state.paused = true;
+        state.resume_at = resume_at;
+        paused_count_++;
+    } else {
+        state.resume_at = std::max(state.resume_at, resume_at);
+    }
+    return pause;
+}
+
+void HostThrottle::succeeded(const std::string& host) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = hosts_.find(host);
+    if (it != hosts_.end() && !it->second.paused) {
+        hosts_.erase(it);
+    }
+}
+
+bool HostThrottle::is_paused(const std::string& host, Clock::time_point now) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (paused_count_ == 0) {
+        return false;
+    }
+    auto it = hosts_.find(host);
+    return it != hosts_.end() && it->second.paused && now < it->second.resume_at;
+}
+
+int HostThrottle::strikes(const std::string& host) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = hosts_.find(host);
+    return it == hosts_.end() ? 0 : it->second.strikes;
+}
+
+std::vector<std::string> HostThrottle::expire(Clock::time_point now) {
+    std::vector<std::string> resumed;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (paused_count_ == 0) {
+        return resumed;
+    }
+    for (auto& [host, state] : hosts_) {
+        if (state.paused && now >= state.resume_at) {
+            state.paused = false;
+            paused_count_--;
+            resumed.push_back(host);
+        }
+    }
+    return resumed;
+}
+
+size_t HostThrottle::paused_hosts() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return paused_count_;
+}
+
+void HostThrottle::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    hosts_.clear();
+    paused_count_ = 0;
+}
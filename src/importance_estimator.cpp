@@ -0,0 +1,166 @@
+#include "importance_estimator.h"
+#include "url.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Score range mapped onto the priority levels; one unit = one doubling of cash
+constexpr double kBestScore = 4.0;
+constexpr double kWorstScore = -40.0;
+constexpr double kMaxRankBoost = 1024.0;
+
+} // namespace
+
+ImportanceEstimator::ImportanceEstimator(size_t max_tracked)
+    : max_tracked_(max_tracked),
+      depth_weight_(0.5),
+      host_weight_(1.0) {
+}
+
+void ImportanceEstimator::set_weights(double depth_weight, double host_weight) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    depth_weight_ = std::max(0.0, depth_weight);
+    host_weight_ = std::max(0.0, host_weight);
+}
+
+void ImportanceEstimator::set_rank_lookup(RankLookup lookup) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    rank_lookup_ = std::move(lookup);
+}
+
+ImportanceEstimator::Credit ImportanceEstimator::take(const std::string& url) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Credit credit;
+    auto it = pages_.find(url);
+    if (it == pages_.end()) {
+        return credit;
+    }
+    credit.cash = it->second.cash;
+    credit.depth = it->second.depth;
+    if (it->second.queued_priority >= 0) {
+        auto host = queued_per_host_.find(it->second.host);
+        if (host != queued_per_host_.end() && --host->second == 0) {
+            queued_per_host_.erase(host);
+        }
+    }
+    pages_.erase(it);
+    return credit;
+}
+
+void ImportanceEstimator::distribute(const Credit& credit, const std::vector<std::string>& links) {
+    if (links.empty()) {
+        return;
+    }
+    double share = credit.cash / static_cast<double>(links.size());
+    std::vector<double> ranks = lookup_ranks(links);
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t i = 0; i < links.size(); ++i) {
+        PageState* page = track(links[i], credit.depth + 1, ranks[i]);
+        if (page) {
+            page->cash += share;
+        }
+    }
+}
+
+void ImportanceEstimator::restore(const std::string& url, const Credit& credit, int priority) {
+    std::vector<double> ranks = lookup_ranks({url});
+    std::lock_guard<std::mutex> lock(mutex_);
+    PageState* page = track(url, credit.depth, ranks[0]);
+    if (!page) {
+        return;
+    }
+    page->cash += credit.cash;
+    if (page->queued_priority < 0) {
+        ++queued_per_host_[page->host];
+    }
+    page->queued_priority = priority;
+}
+
+ImportanceEstimator::PageState* ImportanceEstimator::track(const std::string& url, int depth, double rank) {
+    auto it = pages_.find(url);
+    if (it == pages_.end()) {
+        if (pages_.size() >= max_tracked_) {
+            return nullptr;
+        }
+        PageState page;
+        page.depth = depth;
+        page.host = std::string(Url::parse(url).host());
+        if (rank > 0.0) {
+            page.rank = std::min(kMaxRankBoost, std::max(1.0 / kMaxRankBoost, rank));
+        }
+        it = pages_.emplace(url, std::move(page)).first;
+    }
+    it->second.depth = std::min(it->second.depth, depth);
+    return &it->second;
+}
+
+std::vector<double> ImportanceEstimator::lookup_ranks(const std::vector<std::string>& urls) {
+    std::vector<double> ranks(urls.size(), 0.0);
+    RankLookup lookup;
+    std::vector<size_t> untracked;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!rank_lookup_) {
+            return ranks;
+        }
+        lookup = rank_lookup_;
+        for (size_t i = 0; i < urls.size(); ++i) {
+            if (pages_.find(urls[i]) == pages_.end()) {
+                untracked.push_back(i);
+            }
+        }
+    }
+    // A store read per URL: done without the lock, so take() and
+    // claim_priority() on the crawl loop never wait for it
+    for (size_t i : untracked) {
+        ranks[i] = lookup(urls[i]);
+    }
+    return ranks;
+}
+
+int ImportanceEstimator::claim_priority(const std::string& url) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = pages_.find(url);
+    if (it == pages_.end()) {
+        // Not credited by any page (tracking is full): lowest priority
+        return kFirstPriority + kLevels - 1;
+    }
+    PageState& page = it->second;
+    int priority = priority_for(page);
+    if (page.queued_priority >= 0 && page.queued_priority <= priority) {
+        return -1;
+    }
+    if (page.queued_priority < 0) {
+        ++queued_per_host_[page.host];
+    }
+    page.queued_priority = priority;
+    return priority;
+}
+
+double ImportanceEstimator::cash(const std::string& url) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = pages_.find(url);
+    return it == pages_.end() ? 0.0 : it->second.cash;
+}
+
+int ImportanceEstimator::priority_for(const PageState& page) const {
+    size_t host_queued = 0;
+    auto host = queued_per_host_.find(page.host);
+    if (host != queued_per_host_.end()) {
+        host_queued = host->second;
+    }
+    if (page.queued_priority >= 0 && host_queued > 0) {
+        --host_queued;  // Do not count the page against itself
+    }
+
+    double score = std::log2(std::max(page.cash, 1e-12))
+                 + std::log2(page.rank)
+                 - depth_weight_ * page.depth
+                 - host_weight_ * std::log2(1.0 + static_cast<double>(host_queued));
+    score = std::min(kBestScore, std::max(kWorstScore, score));
+
+    double position = (kBestScore - score) / (kBestScore - kWorstScore);
+    int level = static_cast<int>(position * (kLevels - 1) + 0.5);
+    return kFirstPriority + level;
+}
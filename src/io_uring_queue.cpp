@@ -0,0 +1,202 @@
+#include "io_uring_queue.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+unsigned load_acquire(unsigned* value) {
+    return std::atomic_ref<unsigned>(*value).load(std::memory_order_acquire);
+}
+
+void store_release(unsigned* value, unsigned update) {
+    std::atomic_ref<unsigned>(*value).store(update, std::memory_order_release);
+}
+
+} // namespace
+
+std::unique_ptr<IoUringQueue> IoUringQueue::create(unsigned entries) {
+    struct io_uring_params params {};
+    int ring_fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+    if (ring_fd < 0) {
+        return nullptr;
+    }
+
+    std::unique_ptr<IoUringQueue> queue(new IoUringQueue());
+    queue->ring_fd_ = ring_fd;
+    // Single mmap (5.4) and timed waits through io_uring_enter (5.11)
+    if (!(params.features & IORING_FEAT_SINGLE_MMAP) || !(params.features & IORING_FEAT_EXT_ARG)) {
+        return nullptr;
+    }
+
+    size_t sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    size_t cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    size_t ring_size = std::max(sq_size, cq_size);
+    void* ring = mmap(nullptr, ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      ring_fd, IORING_OFF_SQ_RING);
+    if (ring == MAP_FAILED) {
+        return nullptr;
+    }
+    queue->ring_ = ring;
+    queue->ring_size_ = ring_size;
+
+    size_t sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    void* sqes = mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      ring_fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        return nullptr;
+    }
+    queue->sqes_ = static_cast<struct io_uring_sqe*>(sqes);
+    queue->sqes_size_ = sqes_size;
+
+    char* base = static_cast<char*>(ring);
+    queue->sq_head_ = reinterpret_cast<unsigned*>(base + params.sq_off.head);
+    queue->sq_tail_ = reinterpret_cast<unsigned*>(base + params.sq_off.tail);
+    queue->sq_array_ = reinterpret_cast<unsigned*>(base + params.sq_off.array);
+    queue->sq_mask_ = *reinterpret_cast<unsigned*>(base + params.sq_off.ring_mask);
+    queue->sq_entries_ = params.sq_entries;
+    queue->local_tail_ = *queue->sq_tail_;
+    queue->cq_head_ = reinterpret_cast<unsigned*>(base + params.cq_off.head);
+    queue->cq_tail_ = reinterpret_cast<unsigned*>(base + params.cq_off.tail);
+    queue->cq_mask_ = *reinterpret_cast<unsigned*>(base + params.cq_off.ring_mask);
+    queue->cqes_ = reinterpret_cast<struct io_uring_cqe*>(base + params.cq_off.cqes);
+    return queue;
+}
+
+IoUringQueue::~IoUringQueue() {
+    if (sqes_) {
+        munmap(sqes_, sqes_size_);
+    }
+    if (ring_) {
+        munmap(ring_, ring_size_);
+    }
+    if (ring_fd_ >= 0) {
+        close(ring_fd_);
+    }
+}
+
+bool IoUringQueue::poll(int fd, uint32_t events, uint64_t user_data) {
+    if (!reserve(1)) {
+        return false;
+    }
+    struct io_uring_sqe* sqe = next_sqe();
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    sqe->poll32_events = events;
+    sqe->user_data = user_data;
+    return true;
+}
+
+bool IoUringQueue::poll_remove(uint64_t target_user_data) {
+    if (!reserve(1)) {
+        return false;
+    }
+    struct io_uring_sqe* sqe = next_sqe();
+    sqe->opcode = IORING_OP_POLL_REMOVE;
+    sqe->fd = -1;
+    sqe->addr = target_user_data;
+    sqe->user_data = 0;
+    return true;
+}
+
+bool IoUringQueue::recv(int fd, void* buffer, size_t size, uint64_t user_data,
+                        std::chrono::steady_clock::time_point deadline) {
+    bool timed = deadline != std::chrono::steady_clock::time_point::max();
+    if (!reserve(timed ? 2 : 1)) {
+        return false;
+    }
+    struct io_uring_sqe* sqe = next_sqe();
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>(buffer);
+    sqe->len = static_cast<uint32_t>(size);
+    sqe->user_data = user_data;
+    if (!timed) {
+        return true;
+    }
+
+    // steady_clock is CLOCK_MONOTONIC, the clock of absolute io_uring timeouts
+    auto since_boot = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch()).count();
+    struct __kernel_timespec& timeout = timeouts_.emplace_back();
+    timeout.tv_sec = since_boot / 1000000000;
+    timeout.tv_nsec = since_boot % 1000000000;
+
+    sqe->flags |= IOSQE_IO_LINK;
+    struct io_uring_sqe* timeout_sqe = next_sqe();
+    timeout_sqe->opcode = IORING_OP_LINK_TIMEOUT;
+    timeout_sqe->fd = -1;
+    timeout_sqe->addr = reinterpret_cast<uint64_t>(&timeout);
+    timeout_sqe->len = 1;
+    timeout_sqe->timeout_flags = IORING_TIMEOUT_ABS;
+    timeout_sqe->user_data = 0;
+    return true;
+}
+
+bool IoUringQueue::wait(int timeout_ms, std::vector<Completion>& completions) {
+    // Completions already waiting only need the submission half of the call
+    bool ready = load_acquire(cq_tail_) != *cq_head_;
+    bool submitted = submit_pending(ready || timeout_ms == 0 ? 0 : 1, timeout_ms);
+    reap(completions);
+    return submitted;
+}
+
+bool IoUringQueue::reserve(unsigned count) {
+    if (local_tail_ - load_acquire(sq_head_) + count <= sq_entries_) {
+        return true;
+    }
+    // Ring full: hand what is queued to the kernel to make room
+    return submit_pending(0, 0) && local_tail_ - load_acquire(sq_head_) + count <= sq_entries_;
+}
+
+struct io_uring_sqe* IoUringQueue::next_sqe() {
+    unsigned index = local_tail_ & sq_mask_;
+    struct io_uring_sqe* sqe = &sqes_[index];
+    std::memset(sqe, 0, sizeof(*sqe));
+    sq_array_[index] = index;
+    local_tail_++;
+    return sqe;
+}
+
+bool IoUringQueue::submit_pending(unsigned wait_for, int timeout_ms) {
+    unsigned to_submit = local_tail_ - *sq_tail_;
+    if (to_submit == 0 && wait_for == 0) {
+        return true;
+    }
+    store_release(sq_tail_, local_tail_);
+
+    unsigned flags = wait_for > 0 ? IORING_ENTER_GETEVENTS : 0;
+    struct __kernel_timespec wait_timeout {};
+    struct io_uring_getevents_arg arg {};
+    void* argp = nullptr;
+    size_t arg_size = 0;
+    if (wait_for > 0 && timeout_ms >= 0) {
+        wait_timeout.tv_sec = timeout_ms / 1000;
+        wait_timeout.tv_nsec = static_cast<long long>(timeout_ms % 1000) * 1000000;
+        arg.ts = reinterpret_cast<uint64_t>(&wait_timeout);
+        flags |= IORING_ENTER_EXT_ARG;
+        argp = &arg;
+        arg_size = sizeof(arg);
+    }
+
+    long result = syscall(__NR_io_uring_enter, ring_fd_, to_submit, wait_for, flags, argp, arg_size);
+    if (load_acquire(sq_head_) == local_tail_) {
+        timeouts_.clear();  // The kernel copied every queued timespec
+    }
+    return result >= 0 || errno == ETIME || errno == EINTR || errno == EBUSY;
+}
+
+void IoUringQueue::reap(std::vector<Completion>& completions) {
+    unsigned head = *cq_head_;
+    unsigned tail = load_acquire(cq_tail_);
+    while (head != tail) {
+        const struct io_uring_cqe& cqe = cqes_[head & cq_mask_];
+        completions.push_back(Completion{cqe.user_data, cqe.res});
+        ++head;
+    }
+    store_release(cq_head_, head);
+}
@@ -0,0 +1,235 @@
+#include "link_graph.h"
+#include "url.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+namespace {
+
+/**
+ * Run fn(begin, end, thread_index) over [0, count), one contiguous range per thread
+ */
+template <typename Fn>
+void parallel_for(size_t count, size_t threads, Fn fn) {
+    threads = std::max<size_t>(1, std::min(threads, count / 4096 + 1));
+    if (threads == 1) {
+        fn(0, count, 0);
+        return;
+    }
+    std::vector<std::thread> workers;
+    size_t step = (count + threads - 1) / threads;
+    for (size_t t = 0; t < threads; ++t) {
+        size_t begin = std::min(count, t * step);
+        size_t end = std::min(count, begin + step);
+        workers.emplace_back([&fn, begin, end, t]() { fn(begin, end, t); });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+} // namespace
+
+LinkGraph::LinkGraph()
+    : arena_used_(kArenaChunk) {
+}
+
+std::string_view LinkGraph::store(std::string_view text) {
+    if (text.empty()) {
+        return std::string_view();  // Before any chunk exists there is nothing to point into
+    }
+    char* data = nullptr;
+    if (text.size() > kArenaChunk / 16) {
+        oversized_.push_back(std::make_unique<char[]>(text.size()));
+        data = oversized_.back().get();
+    } else {
+        if (arena_used_ + text.size() > kArenaChunk) {
+            arena_.push_back(std::make_unique<char[]>(kArenaChunk));
+            arena_used_ = 0;
+        }
+        data = arena_.back().get() + arena_used_;
+        arena_used_ += text.size();
+    }
+    std::memcpy(data, text.data(), text.size());
+    return std::string_view(data, text.size());
+}
+
+uint32_t LinkGraph::add_node(std::string_view url) {
+    auto it = ids_.find(url);
+    if (it != ids_.end()) {
+        return it->second;
+    }
+    std::string_view stored = store(url);
+    uint32_t id = static_cast<uint32_t>(urls_.size());
+    urls_.push_back(stored);
+    ids_.emplace(stored, id);
+    return id;
+}
+
+void LinkGraph::add_edge(uint32_t from, uint32_t to) {
+    if (from != to) {
+        edges_.emplace_back(from, to);
+    }
+}
+
+void LinkGraph::finalize(size_t threads) {
+    size_t nodes = urls_.size();
+    ids_.clear();  // Lookups are no longer needed; frees the largest index
+    ids_.rehash(0);
+
+    // Degrees
+    std::vector<std::atomic<uint32_t>> in_counts(nodes);
+    std::vector<std::atomic<uint32_t>> out_counts(nodes);
+    parallel_for(edges_.size(), threads, [&](size_t begin, size_t end, size_t) {
+        for (size_t i = begin; i < end; ++i) {
+            out_counts[edges_[i].first].fetch_add(1, std::memory_order_relaxed);
+            in_counts[edges_[i].second].fetch_add(1, std::memory_order_relaxed);
+        }
+    });
+
+    in_offsets_.assign(nodes + 1, 0);
+    out_degrees_.assign(nodes, 0);
+    for (size_t v = 0; v < nodes; ++v) {
+        in_offsets_[v + 1] = in_offsets_[v] + in_counts[v].load(std::memory_order_relaxed);
+        out_degrees_[v] = out_counts[v].load(std::memory_order_relaxed);
+    }
+
+    // Scatter sources into their target's slot range
+    std::vector<std::atomic<uint64_t>> cursors(nodes);
+    for (size_t v = 0; v < nodes; ++v) {
+        cursors[v].store(in_offsets_[v], std::memory_order_relaxed);
+    }
+    in_sources_.assign(edges_.size(), 0);
+    parallel_for(edges_.size(), threads, [&](size_t begin, size_t end, size_t) {
+        for (size_t i = begin; i < end; ++i) {
+            uint64_t slot = cursors[edges_[i].second].fetch_add(1, std::memory_order_relaxed);
+            in_sources_[slot] = edges_[i].first;
+        }
+    });
+
+    edges_.clear();
+    edges_.shrink_to_fit();
+}
+
+size_t LinkGraph::node_count() const {
+    return urls_.size();
+}
+
+size_t LinkGraph::edge_count() const {
+    return in_sources_.empty() ? edges_.size() : in_sources_.size();
+}
+
+std::string_view LinkGraph::url(uint32_t id) const {
+    return urls_[id];
+}
+
+uint32_t LinkGraph::in_degree(uint32_t id) const {
+    return static_cast<uint32_t>(in_offsets_[id + 1] - in_offsets_[id]);
+}
+
+uint32_t LinkGraph::out_degree(uint32_t id) const {
+    return out_degrees_[id];
+}
+
+std::vector<double> LinkGraph::pagerank(double damping,
+                                        int max_iterations,
+                                        double tolerance,
+                                        size_t threads,
+                                        int* iterations_run) const {
+    size_t nodes = urls_.size();
+    std::vector<double> rank(nodes, nodes > 0 ? 1.0 / static_cast<double>(nodes) : 0.0);
+    if (iterations_run) *iterations_run = 0;
+    if (nodes == 0) {
+        return rank;
+    }
+
+    size_t workers = std::max<size_t>(1, threads);
+    std::vector<double> next(nodes, 0.0);
+    std::vector<double> contribution(nodes, 0.0);
+    std::vector<double> partial(workers, 0.0);
+
+    for (int iteration = 0; iteration < max_iterations; ++iteration) {
+        // Share each page passes to every outlink; dangling pages feed everyone
+        std::fill(partial.begin(), partial.end(), 0.0);
+        parallel_for(nodes, workers, [&](size_t begin, size_t end, size_t t) {
+            double dangling = 0.0;
+            for (size_t u = begin; u < end; ++u) {
+                if (out_degrees_[u] == 0) {
+                    contribution[u] = 0.0;
+                    dangling += rank[u];
+                } else {
+                    contribution[u] = rank[u] / out_degrees_[u];
+                }
+            }
+            partial[t] = dangling;
+        });
+        double dangling = 0.0;
+        for (double value : partial) dangling += value;
+        double base = (1.0 - damping) / static_cast<double>(nodes) + damping * dangling / static_cast<double>(nodes);
+
+        // Pull from incoming edges
+        std::fill(partial.begin(), partial.end(), 0.0);
+        parallel_for(nodes, workers, [&](size_t begin, size_t end, size_t t) {
+            double delta = 0.0;
+            for (size_t v = begin; v < end; ++v) {
+                double sum = 0.0;
+                for (uint64_t k = in_offsets_[v]; k < in_offsets_[v + 1]; ++k) {
+                    sum += contribution[in_sources_[k]];
+                }
+                next[v] = base + damping * sum;
+                delta += std::fabs(next[v] - rank[v]);
+            }
+            partial[t] = delta;
+        });
+        double delta = 0.0;
+        for (double value : partial) delta += value;
+
+        rank.swap(next);
+        if (iterations_run) *iterations_run = iteration + 1;
+        if (delta < tolerance) {
+            break;
+        }
+    }
+    return rank;
+}
+
+std::vector<LinkGraph::HostStats> LinkGraph::aggregate_hosts(const std::vector<double>& ranks) const {
+    size_t nodes = urls_.size();
+    std::vector<HostStats> hosts;
+    std::unordered_map<std::string, uint32_t> host_ids;
+    std::vector<uint32_t> host_of(nodes);
+
+    for (size_t v = 0; v < nodes; ++v) {
+        std::string host(Url::parse(std::string(urls_[v])).host());
+        auto inserted = host_ids.emplace(host, static_cast<uint32_t>(hosts.size()));
+        if (inserted.second) {
+            hosts.emplace_back();
+            hosts.back().host = std::move(host);
+        }
+        uint32_t id = inserted.first->second;
+        host_of[v] = id;
+        hosts[id].pages++;
+        if (v < ranks.size()) {
+            hosts[id].rank += ranks[v];
+        }
+    }
+
+    // Distinct (source host, target host) pairs across hosts
+    std::vector<uint64_t> pairs;
+    for (size_t v = 0; v < nodes; ++v) {
+        for (uint64_t k = in_offsets_[v]; k < in_offsets_[v + 1]; ++k) {
+            uint32_t from = host_of[in_sources_[k]];
+            if (from != host_of[v]) {
+                pairs.push_back((static_cast<uint64_t>(host_of[v]) << 32) | from);
+            }
+        }
+    }
+    std::sort(pairs.begin(), pairs.end());
+    pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+    for (uint64_t pair : pairs) {
+        hosts[pair >> 32].linking_hosts++;
+    }
+    return hosts;
+}
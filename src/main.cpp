@@ -1,5 +1,5 @@
 #include "crawler.h"
-#include "dataset_writer.h"
+#include "sharded_dataset_sink.h"
 #include "logger.h"
 #include "config_loader.h"
 #include "http_config.h"
@@ -9,7 +9,7 @@
 #include <vector>
 #include <atomic>
 #include <csignal>
-#include <filesystem>
+#include <algorithm>
 
 namespace {
 
@@ -61,6 +61,8 @@ int main(int argc, char* argv[]) {
         // Enable robots.txt and meta-tag checking
         crawler.set_respect_robots_txt(config.respect_robots_txt);
         crawler.set_respect_meta_tags(config.respect_meta_tags);
+        crawler.set_robots_prefetch_workers(config.robots_prefetch_workers);
+        crawler.set_url_canonicalization(config.strip_query_params, config.sort_query_params);
 
         // Configure HTTP/2 support with BoringSSL
         HTTPConfig http_config;
@@ -76,6 +78,45 @@ int main(int argc, char* argv[]) {
                                        config.chrome_path,
                                        config.chrome_timeout_seconds);
 
+        if (config.extraction_mode == "main_content") {
+            crawler.set_extraction_mode(ExtractionMode::MainContent);
+            log_info("Main-content extraction enabled");
+        } else if (config.extraction_mode != "full") {
+            log_warn("Unknown extraction mode '" + config.extraction_mode + "', using full page");
+        }
+
+        // Parquet rows carry the extracted text rather than the raw HTML
+        if (config.output_format.find("parquet") != std::string::npos) {
+            crawler.enable_text_extraction(true);
+            log_info("Text extraction enabled for Parquet output");
+        }
+
+        if (config.learn_templates) {
+            crawler.enable_template_learning(true);
+            log_info("Per-host template learning enabled");
+        }
+
+        if (config.learn_dust_rules) {
+            crawler.enable_dust_learning(true);
+            log_info("Per-host DUST parameter learning enabled");
+        }
+
+        crawler.enable_trap_detection(config.detect_crawler_traps);
+        if (!config.detect_crawler_traps) {
+            log_warn("Crawler-trap detection disabled");
+        }
+
+        crawler.enable_importance_ordering(config.importance_ordering);
+
+        if (config.recrawl) {
+            crawler.enable_recrawl(true);
+            crawler.set_recrawl_intervals(config.recrawl_min_interval, config.recrawl_max_interval);
+            log_info("Incremental recrawl enabled");
+        }
+        if (!config.importance_ordering) {
+            log_info("Frontier order: FIFO by discovery time");
+        }
+
         ClickHouseConfig clickhouse_config;
         clickhouse_config.enabled = config.clickhouse_enabled;
         clickhouse_config.endpoint = config.clickhouse_endpoint;
@@ -119,40 +160,27 @@ int main(int argc, char* argv[]) {
             api_thread = std::thread(run_api_server, &crawler, config, &stop_flag);
         }
 
+        // Records are written in shards while the crawl runs
+        ShardedDatasetSinkConfig sink_config;
+        sink_config.output_dir = config.output_dir.empty() ? "." : config.output_dir;
+        sink_config.format = config.output_format;
+        sink_config.batch_size = static_cast<size_t>(std::max(config.batch_size, 1));
+        sink_config.max_shard_bytes = static_cast<size_t>(std::max(config.shard_max_mb, 1L)) * 1024 * 1024;
+        sink_config.max_shard_age = std::chrono::seconds(std::max(config.shard_max_seconds, 1L));
+        sink_config.parquet.compression = ParquetFileWriter::parse_compression(config.compression);
+        sink_config.parquet.row_group_rows = static_cast<size_t>(std::max(config.row_group_size, 1));
+        ShardedDatasetSink sink(sink_config);
+
         // Crawl URLs
-        auto records = crawler.crawl_urls(initial_urls, config.api_enabled);
+        size_t records = crawler.crawl_urls(initial_urls, sink, config.api_enabled);
 
         stop_flag.store(true);
         if (api_thread.joinable()) {
             api_thread.join();
         }
 
-        // Write to files
-        ParquetDatasetWriter writer;
-
-        if (!config.output_dir.empty()) {
-            std::error_code ec;
-            std::filesystem::create_directories(config.output_dir, ec);
-            if (ec) {
-                std::ostringstream warn_msg;
-                warn_msg << "Failed to create output directory " << config.output_dir
-                         << ": " << ec.message();
-                log_warn(warn_msg.str());
-            }
-        }
-        
-        if (config.output_format == "json" || config.output_format == "both") {
-            std::string json_path = config.output_dir + "/dataset.json";
-            writer.write_records(json_path, records);
-        }
-        
-        if (config.output_format == "csv" || config.output_format == "both") {
-            std::string csv_path = config.output_dir + "/dataset.csv";
-            writer.write_csv(csv_path, records);
-        }
-
         std::ostringstream summary;
-        summary << "Crawling complete. Total records: " << records.size();
+        summary << "Crawling complete. Total records: " << records;
         log_info(summary.str());
 
         g_stop_flag = nullptr;
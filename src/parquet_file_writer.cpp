@@ -0,0 +1,670 @@
+#include "parquet_file_writer.h"
+#include "logger.h"
+#include "url.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <string_view>
+#include <zlib.h>
+
+#ifdef CRAWLER_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace {
+
+constexpr char kMagic[] = "PAR1";
+constexpr const char* kCreatedBy = "DatasetCrawler version 1.0.0";
+
+// parquet.thrift enums
+constexpr int kTypeInt32 = 1;
+constexpr int kTypeInt64 = 2;
+constexpr int kTypeByteArray = 6;
+constexpr int kRequired = 0;
+constexpr int kConvertedUtf8 = 0;
+constexpr int kEncodingPlain = 0;
+constexpr int kEncodingRle = 3;
+constexpr int kEncodingRleDictionary = 8;
+constexpr int kPageData = 0;
+constexpr int kPageDictionary = 2;
+constexpr int kCodecUncompressed = 0;
+constexpr int kCodecSnappy = 1;
+constexpr int kCodecGzip = 2;
+constexpr int kCodecZstd = 6;
+
+struct ColumnSpec {
+    const char* name;
+    int type;
+    bool utf8;
+    bool dictionary;
+};
+
+// Column order of the file; flush_row_group() writes the chunks in this order
+constexpr ColumnSpec kColumns[] = {
+    {"url", kTypeByteArray, true, false},
+    {"host", kTypeByteArray, true, true},
+    {"title", kTypeByteArray, true, false},
+    {"text", kTypeByteArray, true, false},
+    {"content_length", kTypeInt64, false, false},
+    {"status_code", kTypeInt32, false, false},
+    {"timestamp", kTypeByteArray, true, false},
+};
+constexpr size_t kColumnCount = sizeof(kColumns) / sizeof(kColumns[0]);
+
+/**
+ * Thrift compact protocol, as much of it as the Parquet footer and page
+ * headers need. Fields must be written in increasing id order per struct.
+ */
+class ThriftWriter {
+public:
+    static constexpr uint8_t kI32 = 5;
+    static constexpr uint8_t kI64 = 6;
+    static constexpr uint8_t kBinary = 8;
+    static constexpr uint8_t kList = 9;
+    static constexpr uint8_t kStruct = 12;
+
+    explicit ThriftWriter(std::string& out) : out_(out) {}
+
+    void field_i32(int16_t id, int32_t value) {
+        field_header(id, kI32);
+        varint(zigzag(value));
+    }
+
+    void field_i64(int16_t id, int64_t value) {
+        field_header(id, kI64);
+        varint(zigzag(value));
+    }
+
+    void field_binary(int16_t id, std::string_view value) {
+        field_header(id, kBinary);
+        binary(value);
+    }
+
+    void begin_struct(int16_t id) {
+        field_header(id, kStruct);
+        last_field_.push_back(0);
+    }
+
+    void begin_list(int16_t id, uint8_t element_type, size_t size) {
+        field_header(id, kList);
+        if (size < 15) {
+            out_.push_back(static_cast<char>((size << 4) | element_type));
+        } else {
+            out_.push_back(static_cast<char>(0xf0 | element_type));
+            varint(size);
+        }
+    }
+
+    void element_i32(int32_t value) {
+        varint(zigzag(value));
+    }
+
+    void element_binary(std::string_view value) {
+        binary(value);
+    }
+
+    // Struct elements of a list have no field header
+    void begin_element() {
+        last_field_.push_back(0);
+    }
+
+    void end_struct() {
+        out_.push_back(0);
+        last_field_.pop_back();
+    }
+
+    // Stop field of the outermost struct
+    void end() {
+        out_.push_back(0);
+    }
+
+private:
+    std::string& out_;
+    std::vector<int16_t> last_field_{0};
+
+    static uint64_t zigzag(int64_t value) {
+        return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+    }
+
+    void varint(uint64_t value) {
+        while (value >= 0x80) {
+            out_.push_back(static_cast<char>((value & 0x7f) | 0x80));
+            value >>= 7;
+        }
+        out_.push_back(static_cast<char>(value));
+    }
+
+    void binary(std::string_view value) {
+        varint(value.size());
+        out_.append(value.data(), value.size());
+    }
+
+    void field_header(int16_t id, uint8_t type) {
+        int delta = id - last_field_.back();
+        if (delta > 0 && delta <= 15) {
+            out_.push_back(static_cast<char>((delta << 4) | type));
+        } else {
+            out_.push_back(static_cast<char>(type));
+            varint(zigzag(id));
+        }
+        last_field_.back() = id;
+    }
+};
+
+void append_u32(std::string& out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(static_cast<char>(value >> (8 * i)));
+    }
+}
+
+void append_u64(std::string& out, uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        out.push_back(static_cast<char>(value >> (8 * i)));
+    }
+}
+
+// PLAIN BYTE_ARRAY: 4-byte little-endian length, then the bytes
+void append_plain(std::string& out, std::string_view value) {
+    append_u32(out, static_cast<uint32_t>(value.size()));
+    out.append(value.data(), value.size());
+}
+
+void append_varint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+// Bit-packed run of the RLE/bit-packing hybrid; the values are padded to groups of 8
+void append_bit_packed(std::string& out, const uint32_t* values, size_t count, int bit_width) {
+    size_t groups = (count + 7) / 8;
+    append_varint(out, (groups << 1) | 1);
+    uint64_t bits = 0;
+    int pending = 0;
+    for (size_t i = 0; i < groups * 8; ++i) {
+        bits |= static_cast<uint64_t>(i < count ? values[i] : 0) << pending;
+        pending += bit_width;
+        while (pending >= 8) {
+            out.push_back(static_cast<char>(bits & 0xff));
+            bits >>= 8;
+            pending -= 8;
+        }
+    }
+}
+
+void append_rle_run(std::string& out, uint32_t value, size_t count, int bit_width) {
+    append_varint(out, count << 1);
+    for (int i = 0; i < (bit_width + 7) / 8; ++i) {
+        out.push_back(static_cast<char>(value >> (8 * i)));
+    }
+}
+
+/**
+ * RLE/bit-packing hybrid for dictionary indices: runs of 8 or more equal
+ * values become RLE runs, everything else is bit-packed. Bit-packed runs
+ * hold whole groups of 8, so a run is entered only on a group boundary.
+ */
+std::string encode_dictionary_indices(const std::vector<uint32_t>& ids, int bit_width) {
+    constexpr size_t kMaxPackedRun = 63 * 8;
+    std::string out;
+    out.push_back(static_cast<char>(bit_width));
+
+    auto flush_literals = [&](size_t begin, size_t end) {
+        while (begin < end) {
+            size_t count = std::min(end - begin, kMaxPackedRun);
+            append_bit_packed(out, ids.data() + begin, count, bit_width);
+            begin += count;
+        }
+    };
+
+    size_t literal_start = 0;
+    size_t i = 0;
+    while (i < ids.size()) {
+        size_t run = 1;
+        while (i + run < ids.size() && ids[i + run] == ids[i]) {
+            run++;
+        }
+        size_t pad = (8 - (i - literal_start) % 8) % 8;
+        if (run >= pad + 8) {
+            flush_literals(literal_start, i + pad);
+            append_rle_run(out, ids[i], run - pad, bit_width);
+            i += run;
+            literal_start = i;
+        } else {
+            i += run;
+        }
+    }
+    flush_literals(literal_start, ids.size());
+    return out;
+}
+
+// Snappy raw format (the Parquet SNAPPY codec), greedy matching within 64 KiB blocks
+class SnappyCompressor {
+public:
+    std::string compress(std::string_view input) {
+        std::string out;
+        out.reserve(input.size() / 2 + 16);
+        append_varint(out, input.size());
+        for (size_t start = 0; start < input.size(); start += kBlockSize) {
+            compress_block(input.substr(start, kBlockSize), out);
+        }
+        return out;
+    }
+
+private:
+    static constexpr size_t kBlockSize = 1 << 16;
+    static constexpr int kHashBits = 14;
+    std::vector<int32_t> table_ = std::vector<int32_t>(1 << kHashBits);
+
+    static uint32_t load32(const char* p) {
+        uint32_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    static void literal(std::string& out, const char* data, size_t length) {
+        size_t n = length - 1;
+        if (n < 60) {
+            out.push_back(static_cast<char>(n << 2));
+        } else {
+            int bytes = n < (1u << 8) ? 1 : n < (1u << 16) ? 2 : n < (1u << 24) ? 3 : 4;
+            out.push_back(static_cast<char>((59 + bytes) << 2));
+            for (int i = 0; i < bytes; ++i) {
+                out.push_back(static_cast<char>(n >> (8 * i)));
+            }
+        }
+        out.append(data, length);
+    }
+
+    static void copy_upto_64(std::string& out, size_t offset, size_t length) {
+        if (length >= 4 && length < 12 && offset < 2048) {
+            out.push_back(static_cast<char>(1 | ((length - 4) << 2) | ((offset >> 8) << 5)));
+            out.push_back(static_cast<char>(offset & 0xff));
+        } else {
+            out.push_back(static_cast<char>(2 | ((length - 1) << 2)));
+            out.push_back(static_cast<char>(offset & 0xff));
+            out.push_back(static_cast<char>(offset >> 8));
+        }
+    }
+
+    static void copy(std::string& out, size_t offset, size_t length) {
+        while (length >= 68) {
+            copy_upto_64(out, offset, 64);
+            length -= 64;
+        }
+        if (length > 64) {
+            copy_upto_64(out, offset, 60);
+            length -= 60;
+        }
+        copy_upto_64(out, offset, length);
+    }
+
+    void compress_block(std::string_view block, std::string& out) {
+        std::fill(table_.begin(), table_.end(), -1);
+        const char* data = block.data();
+        size_t size = block.size();
+        size_t literal_start = 0;
+        size_t ip = 0;
+        while (ip + 4 <= size) {
+            uint32_t bytes = load32(data + ip);
+            uint32_t hash = (bytes * 0x1e35a7bdu) >> (32 - kHashBits);
+            int32_t candidate = table_[hash];
+            table_[hash] = static_cast<int32_t>(ip);
+            if (candidate < 0 || load32(data + candidate) != bytes) {
+                // Skip ahead faster the longer nothing has matched
+                ip += 1 + ((ip - literal_start) >> 5);
+                continue;
+            }
+            size_t length = 4;
+            while (ip + length < size && data[candidate + length] == data[ip + length]) {
+                length++;
+            }
+            if (literal_start < ip) {
+                literal(out, data + literal_start, ip - literal_start);
+            }
+            copy(out, ip - static_cast<size_t>(candidate), length);
+            ip += length;
+            literal_start = ip;
+        }
+        if (literal_start < size) {
+            literal(out, data + literal_start, size - literal_start);
+        }
+    }
+};
+
+bool gzip_compress(const std::string& input, std::string& output) {
+    z_stream stream {};
+    if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return false;
+    }
+    output.resize(deflateBound(&stream, input.size()));
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+    stream.avail_in = static_cast<uInt>(input.size());
+    stream.next_out = reinterpret_cast<Bytef*>(output.data());
+    stream.avail_out = static_cast<uInt>(output.size());
+    int result = deflate(&stream, Z_FINISH);
+    output.resize(stream.total_out);
+    deflateEnd(&stream);
+    return result == Z_STREAM_END;
+}
+
+bool compress_page(ParquetCompression compression, int zstd_level, const std::string& input,
+                   std::string& output) {
+    switch (compression) {
+        case ParquetCompression::Snappy:
+            output = SnappyCompressor().compress(input);
+            return true;
+        case ParquetCompression::Gzip:
+            return gzip_compress(input, output);
+        case ParquetCompression::Zstd: {
+#ifdef CRAWLER_HAVE_ZSTD
+            output.resize(ZSTD_compressBound(input.size()));
+            size_t size = ZSTD_compress(output.data(), output.size(), input.data(), input.size(), zstd_level);
+            if (ZSTD_isError(size)) {
+                return false;
+            }
+            output.resize(size);
+            return true;
+#else
+            (void)zstd_level;
+            return false;
+#endif
+        }
+        case ParquetCompression::None:
+            break;
+    }
+    output = input;
+    return true;
+}
+
+int codec_id(ParquetCompression compression) {
+    switch (compression) {
+        case ParquetCompression::Snappy:
+            return kCodecSnappy;
+        case ParquetCompression::Gzip:
+            return kCodecGzip;
+        case ParquetCompression::Zstd:
+            return kCodecZstd;
+        case ParquetCompression::None:
+            break;
+    }
+    return kCodecUncompressed;
+}
+
+} // namespace
+
+ParquetFileWriter::ParquetFileWriter(ParquetWriterOptions options)
+    : options_(options) {
+    options_.row_group_rows = std::max<size_t>(options_.row_group_rows, 1);
+#ifndef CRAWLER_HAVE_ZSTD
+    if (options_.compression == ParquetCompression::Zstd) {
+        static std::atomic<bool> warned{false};
+        if (!warned.exchange(true)) {
+            log_warn("Built without zstd; Parquet pages are compressed with snappy instead");
+        }
+        options_.compression = ParquetCompression::Snappy;
+    }
+#endif
+}
+
+ParquetFileWriter::~ParquetFileWriter() {
+    if (file_.is_open()) {
+        close();
+    }
+}
+
+ParquetCompression ParquetFileWriter::parse_compression(const std::string& name) {
+    std::string lowered = name;
+    std::transform(lowered.begin(), lowered.end(), lowered.begin(), ::tolower);
+    if (lowered == "none" || lowered == "uncompressed") {
+        return ParquetCompression::None;
+    }
+    if (lowered == "gzip") {
+        return ParquetCompression::Gzip;
+    }
+    if (lowered == "zstd") {
+        return ParquetCompression::Zstd;
+    }
+    if (lowered != "snappy") {
+        log_warn("Unknown Parquet compression '" + name + "', using snappy");
+    }
+    return ParquetCompression::Snappy;
+}
+
+bool ParquetFileWriter::open(const std::string& path) {
+    if (file_.is_open()) {
+        close();
+    }
+    file_.open(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file_.is_open()) {
+        log_error("Failed to open Parquet file: " + path);
+        return false;
+    }
+    path_ = path;
+    offset_ = 0;
+    total_rows_ = 0;
+    buffers_ = ColumnBuffers();
+    row_groups_.clear();
+    return write_bytes(std::string(kMagic, 4));
+}
+
+bool ParquetFileWriter::write(const std::vector<DataRecord>& records) {
+    if (!file_.is_open()) {
+        return false;
+    }
+    for (const auto& record : records) {
+        add_row(record);
+        if (buffers_.rows >= options_.row_group_rows || buffers_.bytes() >= options_.row_group_bytes) {
+            if (!flush_row_group()) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool ParquetFileWriter::close() {
+    if (!file_.is_open()) {
+        return false;
+    }
+    bool ok = flush_row_group() && write_footer();
+    file_.close();
+    if (!ok) {
+        log_error("Failed to write Parquet file: " + path_);
+    }
+    return ok;
+}
+
+void ParquetFileWriter::add_row(const DataRecord& record) {
+    ColumnBuffers& columns = buffers_;
+    append_plain(columns.url, record.url);
+    std::string host(Url::parse(record.url).host());
+    auto [entry, inserted] = columns.host_dictionary.emplace(host, static_cast<uint32_t>(columns.hosts.size()));
+    if (inserted) {
+        columns.dictionary_bytes += host.size() + 4;
+        columns.hosts.push_back(std::move(host));
+    }
+    columns.host_ids.push_back(entry->second);
+    append_plain(columns.title, record.title);
+    append_plain(columns.text, record.text);
+    append_u64(columns.content_length, record.content_length);
+    append_u32(columns.status_code, static_cast<uint32_t>(record.status_code));
+    append_plain(columns.timestamp, record.timestamp);
+    columns.rows++;
+}
+
+bool ParquetFileWriter::flush_row_group() {
+    ColumnBuffers& columns = buffers_;
+    if (columns.rows == 0) {
+        return true;
+    }
+    RowGroupInfo group;
+    group.num_rows = static_cast<int64_t>(columns.rows);
+    group.file_offset = static_cast<int64_t>(offset_);
+    group.columns.resize(kColumnCount);
+    int32_t rows = static_cast<int32_t>(columns.rows);
+
+    const std::string* plain[kColumnCount] = {
+        &columns.url, nullptr, &columns.title, &columns.text,
+        &columns.content_length, &columns.status_code, &columns.timestamp,
+    };
+    for (size_t i = 0; i < kColumnCount; ++i) {
+        ColumnChunkInfo& chunk = group.columns[i];
+        chunk.num_values = rows;
+        if (!kColumns[i].dictionary) {
+            if (!write_page(kPageData, *plain[i], rows, kEncodingPlain, chunk)) {
+                return false;
+            }
+            continue;
+        }
+
+        std::string dictionary;
+        for (const auto& value : columns.hosts) {
+            append_plain(dictionary, value);
+        }
+        int bit_width = 1;
+        while ((static_cast<uint64_t>(1) << bit_width) < columns.hosts.size()) {
+            bit_width++;
+        }
+        if (!write_page(kPageDictionary, dictionary, static_cast<int32_t>(columns.hosts.size()),
+                        kEncodingPlain, chunk) ||
+            !write_page(kPageData, encode_dictionary_indices(columns.host_ids, bit_width), rows,
+                        kEncodingRleDictionary, chunk)) {
+            return false;
+        }
+    }
+
+    total_rows_ += columns.rows;
+    row_groups_.push_back(std::move(group));
+    buffers_ = ColumnBuffers();
+    return true;
+}
+
+bool ParquetFileWriter::write_page(int page_type, const std::string& body, int32_t num_values, int encoding,
+                                   ColumnChunkInfo& chunk) {
+    std::string compressed;
+    if (!compress_page(options_.compression, options_.zstd_level, body, compressed)) {
+        log_error("Failed to compress a Parquet page for " + path_);
+        return false;
+    }
+
+    std::string header;
+    ThriftWriter thrift(header);
+    thrift.field_i32(1, page_type);
+    thrift.field_i32(2, static_cast<int32_t>(body.size()));
+    thrift.field_i32(3, static_cast<int32_t>(compressed.size()));
+    if (page_type == kPageDictionary) {
+        thrift.begin_struct(7);
+        thrift.field_i32(1, num_values);
+        thrift.field_i32(2, encoding);
+        thrift.end_struct();
+    } else {
+        thrift.begin_struct(5);
+        thrift.field_i32(1, num_values);
+        thrift.field_i32(2, encoding);
+        thrift.field_i32(3, kEncodingRle);
+        thrift.field_i32(4, kEncodingRle);
+        thrift.end_struct();
+    }
+    thrift.end();
+
+    if (page_type == kPageDictionary) {
+        chunk.dictionary_page_offset = static_cast<int64_t>(offset_);
+    } else {
+        chunk.data_page_offset = static_cast<int64_t>(offset_);
+    }
+    chunk.uncompressed_size += static_cast<int64_t>(header.size() + body.size());
+    chunk.compressed_size += static_cast<int64_t>(header.size() + compressed.size());
+    return write_bytes(header) && write_bytes(compressed);
+}
+
+bool ParquetFileWriter::write_footer() {
+    std::string footer;
+    ThriftWriter thrift(footer);
+    thrift.field_i32(1, 1);
+
+    thrift.begin_list(2, ThriftWriter::kStruct, kColumnCount + 1);
+    thrift.begin_element();
+    thrift.field_binary(4, "schema");
+    thrift.field_i32(5, static_cast<int32_t>(kColumnCount));
+    thrift.end_struct();
+    for (const auto& column : kColumns) {
+        thrift.begin_element();
+        thrift.field_i32(1, column.type);
+        thrift.field_i32(3, kRequired);
+        thrift.field_binary(4, column.name);
+        if (column.utf8) {
+            thrift.field_i32(6, kConvertedUtf8);
+            thrift.begin_struct(10);  // LogicalType: STRING
+            thrift.begin_struct(1);
+            thrift.end_struct();
+            thrift.end_struct();
+        }
+        thrift.end_struct();
+    }
+
+    thrift.field_i64(3, static_cast<int64_t>(total_rows_));
+
+    thrift.begin_list(4, ThriftWriter::kStruct, row_groups_.size());
+    for (const auto& group : row_groups_) {
+        int64_t uncompressed = 0;
+        int64_t compressed = 0;
+        thrift.begin_element();
+        thrift.begin_list(1, ThriftWriter::kStruct, group.columns.size());
+        for (size_t i = 0; i < group.columns.size(); ++i) {
+            const ColumnChunkInfo& chunk = group.columns[i];
+            uncompressed += chunk.uncompressed_size;
+            compressed += chunk.compressed_size;
+            int64_t chunk_start = chunk.dictionary_page_offset >= 0 ? chunk.dictionary_page_offset
+                                                                    : chunk.data_page_offset;
+            thrift.begin_element();
+            thrift.field_i64(2, chunk_start);
+            thrift.begin_struct(3);
+            thrift.field_i32(1, kColumns[i].type);
+            if (kColumns[i].dictionary) {
+                thrift.begin_list(2, ThriftWriter::kI32, 3);
+                thrift.element_i32(kEncodingPlain);
+                thrift.element_i32(kEncodingRle);
+                thrift.element_i32(kEncodingRleDictionary);
+            } else {
+                thrift.begin_list(2, ThriftWriter::kI32, 2);
+                thrift.element_i32(kEncodingPlain);
+                thrift.element_i32(kEncodingRle);
+            }
+            thrift.begin_list(3, ThriftWriter::kBinary, 1);
+            thrift.element_binary(kColumns[i].name);
+            thrift.field_i32(4, codec_id(options_.compression));
+            thrift.field_i64(5, chunk.num_values);
+            thrift.field_i64(6, chunk.uncompressed_size);
+            thrift.field_i64(7, chunk.compressed_size);
+            thrift.field_i64(9, chunk.data_page_offset);
+            if (chunk.dictionary_page_offset >= 0) {
+                thrift.field_i64(11, chunk.dictionary_page_offset);
+            }
+            thrift.end_struct();
+            thrift.end_struct();
+        }
+        thrift.field_i64(2, uncompressed);
+        thrift.field_i64(3, group.num_rows);
+        thrift.field_i64(5, group.file_offset);
+        thrift.field_i64(6, compressed);
+        thrift.end_struct();
+    }
+
+    thrift.field_binary(6, kCreatedBy);
+    thrift.end();
+
+    std::string trailer;
+    append_u32(trailer, static_cast<uint32_t>(footer.size()));
+    trailer.append(kMagic, 4);
+    return write_bytes(footer) && write_bytes(trailer);
+}
+
+bool ParquetFileWriter::write_bytes(const std::string& bytes) {
+    file_.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    offset_ += bytes.size();
+    return static_cast<bool>(file_);
+}
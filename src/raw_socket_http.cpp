@@ -1,57 +1,26 @@
 #include "raw_socket_http.h"
+#include "address_cache.h"
+#include "connection_race.h"
+#include "url.h"
 
 #include <algorithm>
 #include <cctype>
 #include <cerrno>
+#include <charconv>
 #include <cstring>
-#include <fcntl.h>
+#include <ctime>
 #include <map>
 #include <netdb.h>
 #include <openssl/err.h>
 #include <openssl/ssl.h>
-#include <poll.h>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <sys/socket.h>
 #include <unistd.h>
 
 namespace {
 
-struct ParsedUrl {
-    std::string scheme;
-    std::string host;
-    std::string path;
-    int port = 80;
-    bool valid = false;
-};
-
-ParsedUrl parse_url(const std::string& url) {
-    ParsedUrl parsed;
-    const std::string scheme_delim = "://";
-    auto scheme_pos = url.find(scheme_delim);
-    if (scheme_pos == std::string::npos) {
-        return parsed;
-    }
-
-    parsed.scheme = url.substr(0, scheme_pos);
-    std::string rest = url.substr(scheme_pos + scheme_delim.size());
-    auto path_pos = rest.find('/');
-    std::string host_port = path_pos == std::string::npos ? rest : rest.substr(0, path_pos);
-    parsed.path = path_pos == std::string::npos ? "/" : rest.substr(path_pos);
-
-    auto port_pos = host_port.find(':');
-    if (port_pos != std::string::npos) {
-        parsed.host = host_port.substr(0, port_pos);
-        parsed.port = std::stoi(host_port.substr(port_pos + 1));
-    } else {
-        parsed.host = host_port;
-        parsed.port = parsed.scheme == "https" ? 443 : 80;
-    }
-
-    parsed.valid = !parsed.scheme.empty() && !parsed.host.empty();
-    return parsed;
-}
-
 HTTPVersion parse_http_version(const std::string& status_line) {
     if (status_line.find("HTTP/1.0") == 0) {
         return HTTPVersion::HTTP_1_0;
@@ -82,13 +51,21 @@ std::string trim(const std::string& value) {
 
 struct ParsedHeaders {
     size_t header_end = std::string::npos;
+    int status_code = 0;
     bool chunked = false;
     bool has_content_length = false;
     size_t content_length = 0;
     std::string location;
     std::string content_type;
+    HttpValidators validators;
+    std::string retry_after;
 };
 
+// 1xx, 204 and 304 responses never carry a body, whatever their headers say
+bool status_has_body(int status_code) {
+    return (status_code < 100 || status_code >= 200) && status_code != 204 && status_code != 304;
+}
+
 ParsedHeaders parse_headers(const std::string& buffer) {
     ParsedHeaders headers;
     headers.header_end = buffer.find("\r\n\r\n");
@@ -100,6 +77,9 @@ ParsedHeaders parse_headers(const std::string& buffer) {
     std::istringstream header_stream(header_block);
     std::string status_line;
     std::getline(header_stream, status_line);
+    std::istringstream status_parser(status_line);
+    std::string http_version;
+    status_parser >> http_version >> headers.status_code;
 
     std::string header_line;
     while (std::getline(header_stream, header_line)) {
@@ -126,119 +106,109 @@ ParsedHeaders parse_headers(const std::string& buffer) {
             headers.chunked = true;
         } else if (key == "location") {
             headers.location = value;
+        } else if (key == "etag") {
+            headers.validators.etag = value;
+        } else if (key == "last-modified") {
+            headers.validators.last_modified = value;
+        } else if (key == "retry-after") {
+            headers.retry_after = value;
         }
     }
 
     return headers;
 }
 
-bool decode_chunked_body(const std::string& input, std::string& output, bool& complete) {
-    complete = false;
+// Parse the chunk-size line at pos, moving pos past it
+bool read_chunk_size(std::string_view input, size_t& pos, size_t& chunk_size) {
+    size_t line_end = input.find("\r\n", pos);
+    if (line_end == std::string_view::npos) {
+        return false;
+    }
+    std::string_view size_str = input.substr(pos, line_end - pos);
+    size_str = size_str.substr(0, size_str.find(';'));
+    while (!size_str.empty() && (size_str.front() == ' ' || size_str.front() == '\t')) {
+        size_str.remove_prefix(1);
+    }
+    auto [end, error] = std::from_chars(size_str.data(), size_str.data() + size_str.size(), chunk_size, 16);
+    if (error != std::errc() || end == size_str.data()) {
+        return false;
+    }
+    pos = line_end + 2;
+    return true;
+}
+
+// True if the input holds every chunk up to and including the last one
+bool chunked_body_complete(std::string_view input) {
     size_t pos = 0;
-    output.clear();
-    while (true) {
-        size_t line_end = input.find("\r\n", pos);
-        if (line_end == std::string::npos) {
-            return false;
-        }
-        std::string size_str = input.substr(pos, line_end - pos);
-        size_t semicolon = size_str.find(';');
-        if (semicolon != std::string::npos) {
-            size_str = size_str.substr(0, semicolon);
-        }
-        size_t chunk_size = 0;
-        std::istringstream size_stream(size_str);
-        size_stream >> std::hex >> chunk_size;
-        if (size_stream.fail()) {
-            return false;
-        }
-        pos = line_end + 2;
+    size_t chunk_size = 0;
+    while (read_chunk_size(input, pos, chunk_size)) {
         if (chunk_size == 0) {
-            complete = true;
             return true;
         }
         if (pos + chunk_size + 2 > input.size()) {
             return false;
         }
-        output.append(input, pos, chunk_size);
         pos += chunk_size + 2;
     }
+    return false;
 }
 
-std::string resolve_redirect(const ParsedUrl& base, const std::string& location) {
-    if (location.empty()) {
-        return "";
-    }
-    if (location.find("http://") == 0 || location.find("https://") == 0) {
-        return location;
-    }
-    if (location.rfind("//", 0) == 0) {
-        return base.scheme + ":" + location;
-    }
-    if (!location.empty() && location[0] == '/') {
-        return base.scheme + "://" + base.host + location;
+// Decode a complete chunked body in place: chunk data is moved down over
+// the size lines, so the body needs no second buffer
+// @return End of the decoded body
+size_t decode_chunked_body(std::string& buffer, size_t start) {
+    std::string_view input(buffer);
+    size_t pos = start;
+    size_t out = start;
+    size_t chunk_size = 0;
+    while (read_chunk_size(input, pos, chunk_size) && chunk_size != 0 &&
+           pos + chunk_size <= buffer.size()) {
+        std::memmove(buffer.data() + out, buffer.data() + pos, chunk_size);
+        out += chunk_size;
+        pos += chunk_size + 2;
     }
-    return base.scheme + "://" + base.host + "/" + location;
-}
-
-void set_socket_timeouts(int socket_fd, std::chrono::seconds timeout) {
-    struct timeval tv {};
-    tv.tv_sec = static_cast<long>(timeout.count());
-    tv.tv_usec = 0;
-    setsockopt(socket_fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
-    setsockopt(socket_fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    return out;
 }
 
-int connect_with_timeout(struct addrinfo* addr_info, std::chrono::seconds timeout, std::string& error) {
-    int socket_fd = socket(addr_info->ai_family, addr_info->ai_socktype, addr_info->ai_protocol);
-    if (socket_fd < 0) {
-        error = std::strerror(errno);
-        return -1;
-    }
-
-    int flags = fcntl(socket_fd, F_GETFL, 0);
-    if (flags < 0 || fcntl(socket_fd, F_SETFL, flags | O_NONBLOCK) < 0) {
-        error = "failed to set non-blocking socket";
-        close(socket_fd);
-        return -1;
-    }
-
-    int connect_result = connect(socket_fd, addr_info->ai_addr, addr_info->ai_addrlen);
-    if (connect_result == 0) {
-        fcntl(socket_fd, F_SETFL, flags);
-        set_socket_timeouts(socket_fd, timeout);
-        return socket_fd;
+// True once the buffer holds a whole response, so keep-alive reads can stop
+// without waiting for the server to close the connection. Headers are parsed
+// once into the caller's ParsedHeaders.
+bool response_complete(const std::string& buffer, ParsedHeaders& headers) {
+    if (headers.header_end == std::string::npos) {
+        headers = parse_headers(buffer);
+        if (headers.header_end == std::string::npos) {
+            return false;
+        }
     }
-    if (errno != EINPROGRESS) {
-        error = std::strerror(errno);
-        close(socket_fd);
-        return -1;
+    if (!status_has_body(headers.status_code)) {
+        return true;
     }
-
-    struct pollfd pfd {};
-    pfd.fd = socket_fd;
-    pfd.events = POLLOUT;
-    int poll_result = poll(&pfd, 1, static_cast<int>(timeout.count() * 1000));
-    if (poll_result <= 0) {
-        error = poll_result == 0 ? "connect timeout" : std::strerror(errno);
-        close(socket_fd);
-        return -1;
+    size_t body_start = headers.header_end + 4;
+    if (headers.chunked) {
+        static const std::string kLastChunk = "0\r\n\r\n";
+        if (buffer.size() < body_start + kLastChunk.size() ||
+            buffer.compare(buffer.size() - kLastChunk.size(), kLastChunk.size(), kLastChunk) != 0) {
+            return false;
+        }
+        return chunked_body_complete(std::string_view(buffer).substr(body_start));
     }
+    return headers.has_content_length && buffer.size() - body_start >= headers.content_length;
+}
 
-    int socket_error = 0;
-    socklen_t len = sizeof(socket_error);
-    if (getsockopt(socket_fd, SOL_SOCKET, SO_ERROR, &socket_error, &len) != 0 || socket_error != 0) {
-        error = socket_error == 0 ? "connect failed" : std::strerror(socket_error);
-        close(socket_fd);
-        return -1;
+std::string resolve_redirect(const Url& base, const std::string& location) {
+    if (location.empty()) {
+        return "";
     }
+    return Url::resolve(base, location).release();
+}
 
-    fcntl(socket_fd, F_SETFL, flags);
-    set_socket_timeouts(socket_fd, timeout);
-    return socket_fd;
+long elapsed_ms(std::chrono::steady_clock::time_point since) {
+    return static_cast<long>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - since).count());
 }
 
-RawHttpResponse parse_http_response(const std::string& buffer, const std::string& url) {
+// Takes the receive buffer over; the body is a slice of it, not a copy
+RawHttpResponse parse_http_response(std::string&& buffer, const std::string& url) {
     RawHttpResponse response;
     ParsedHeaders headers = parse_headers(buffer);
     if (headers.header_end == std::string::npos) {
@@ -247,10 +217,14 @@ RawHttpResponse parse_http_response(const std::string& buffer, const std::string
     }
 
     std::string header_block = buffer.substr(0, headers.header_end);
-    std::string body = buffer.substr(headers.header_end + 4);
+    size_t body_start = headers.header_end + 4;
     response.final_url = url;
     response.content_type = headers.content_type;
     response.location = headers.location;
+    response.validators = headers.validators;
+    if (!headers.retry_after.empty()) {
+        response.retry_after_seconds = parse_retry_after(headers.retry_after, std::time(nullptr));
+    }
 
     std::istringstream header_stream(header_block);
     std::string status_line;
@@ -264,449 +238,406 @@ RawHttpResponse parse_http_response(const std::string& buffer, const std::string
         status_parser >> http_version >> response.status_code;
     }
 
-    if (headers.chunked) {
-        bool complete = false;
-        std::string decoded;
-        if (decode_chunked_body(body, decoded, complete) && complete) {
-            response.body = decoded;
+    size_t body_end = buffer.size();
+    if (!status_has_body(response.status_code)) {
+        body_end = body_start;
+    } else if (headers.chunked) {
+        if (chunked_body_complete(std::string_view(buffer).substr(body_start))) {
+            body_end = decode_chunked_body(buffer, body_start);
         } else {
             response.error_message = "incomplete chunked response";
-            response.body = body;
         }
     } else if (headers.has_content_length) {
-        response.body = body.substr(0, headers.content_length);
-    } else {
-        response.body = body;
+        if (body_end - body_start < headers.content_length) {
+            response.error_message = "incomplete response body";
+        }
+        body_end = std::min(body_end, body_start + headers.content_length);
     }
+    response.body = ByteBuffer::adopt(std::move(buffer)).slice(body_start, body_end - body_start);
 
-    response.success = response.status_code > 0;
+    // A body cut short is a failed fetch, not a page to keep
+    response.success = response.status_code > 0 && response.error_message.empty();
     return response;
 }
 
-class HttpFetchCoroutine : public CoroutineTask {
-public:
-    HttpFetchCoroutine(const std::string& url,
-                       const std::map<std::string, std::string>& headers,
-                       std::chrono::seconds timeout)
-        : url_(url),
-          headers_(headers),
-          timeout_(timeout),
-          start_time_(std::chrono::steady_clock::now()) {
-        parsed_ = parse_url(url);
-    }
-
-    ~HttpFetchCoroutine() override {
-        if (socket_fd_ >= 0) {
-            close(socket_fd_);
-        }
-        if (addr_info_) {
-            freeaddrinfo(addr_info_);
-        }
-    }
-
-    bool step() override {
-        if (complete_) {
-            return false;
-        }
+// Bytes requested per read; responses are read straight into their buffer
+constexpr size_t kReadSize = 16384;
 
-        if (!parsed_.valid || parsed_.scheme != "http") {
-            response_.error_message = "raw socket fetch supports http:// only";
-            complete_ = true;
-            return false;
-        }
+// Connection::receive/transmit results besides a byte count
+constexpr long kWouldBlock = -1;
+constexpr long kFailed = -2;
 
-        if (std::chrono::steady_clock::now() - start_time_ > timeout_) {
-            response_.error_message = "raw socket fetch timeout";
-            complete_ = true;
-            return false;
-        }
+bool is_redirect(int status_code) {
+    return status_code == 301 || status_code == 302 || status_code == 303 ||
+           status_code == 307 || status_code == 308;
+}
 
-        switch (state_) {
-            case State::Init:
-                if (!init_socket()) {
-                    complete_ = true;
-                    return false;
-                }
-                return true;
-            case State::Connecting:
-                return handle_connecting();
-            case State::Sending:
-                return handle_sending();
-            case State::Reading:
-                return handle_reading();
-        }
+SSL_CTX* tls_context() {
+    static SSL_CTX* context = SSL_CTX_new(TLS_client_method());
+    return context;
+}
 
-        return false;
-    }
+std::string build_request(const Url& parsed, const std::map<std::string, std::string>& headers) {
+    std::ostringstream request_stream;
+    request_stream << "GET " << parsed.request_target() << " HTTP/1.1\r\n";
+    request_stream << "Host: " << parsed.authority() << "\r\n";
+    request_stream << "Connection: keep-alive\r\n";
+    request_stream << "User-Agent: DatasetCrawler/1.0\r\n";
+    for (const auto& header : headers) {
+        request_stream << header.first << ": " << header.second << "\r\n";
+    }
+    request_stream << "\r\n";
+    return request_stream.str();
+}
 
-    bool is_complete() const override {
-        return complete_;
-    }
+/**
+ * Connected non-blocking socket, optionally wrapped in TLS, whose I/O
+ * suspends on the event loop until the socket is ready or a deadline
+ * passes. Plain sockets receive through the event loop (an io_uring
+ * receive where available); TLS reads go through OpenSSL, which needs
+ * the data on the socket, so they wait for readiness instead.
+ */
+class Connection {
+public:
+    Connection(EventLoop& loop, int fd)
+        : loop_(loop), fd_(fd) {}
 
-    const RawHttpResponse& response() const {
-        return response_;
+    ~Connection() {
+        if (ssl_) {
+            SSL_shutdown(ssl_);  // Best effort on a non-blocking socket
+            SSL_free(ssl_);
+        }
+        loop_.forget(fd_);
+        close(fd_);
     }
 
-private:
-    enum class State {
-        Init,
-        Connecting,
-        Sending,
-        Reading
-    };
-
-    bool init_socket() {
-        struct addrinfo hints {};
-        hints.ai_family = AF_UNSPEC;
-        hints.ai_socktype = SOCK_STREAM;
-
-        const std::string port_str = std::to_string(parsed_.port);
-        int result = getaddrinfo(parsed_.host.c_str(), port_str.c_str(), &hints, &addr_info_);
-        if (result != 0) {
-            response_.error_message = gai_strerror(result);
-            return false;
-        }
+    Connection(const Connection&) = delete;
+    Connection& operator=(const Connection&) = delete;
 
-        socket_fd_ = socket(addr_info_->ai_family, addr_info_->ai_socktype, addr_info_->ai_protocol);
-        if (socket_fd_ < 0) {
-            response_.error_message = std::strerror(errno);
-            return false;
+    Task<bool> handshake(std::string host, EventLoop::Clock::time_point deadline) {
+        ssl_ = SSL_new(tls_context());
+        if (!ssl_) {
+            error_ = "failed to create SSL session";
+            co_return false;
         }
-
-        int flags = fcntl(socket_fd_, F_GETFL, 0);
-        if (flags < 0 || fcntl(socket_fd_, F_SETFL, flags | O_NONBLOCK) < 0) {
-            response_.error_message = "failed to set non-blocking socket";
-            return false;
+        SSL_set_fd(ssl_, fd_);
+        SSL_set_tlsext_host_name(ssl_, host.c_str());
+        while (true) {
+            int result = SSL_connect(ssl_);
+            if (result == 1) {
+                co_return true;
+            }
+            int want = SSL_get_error(ssl_, result);
+            if (want != SSL_ERROR_WANT_READ && want != SSL_ERROR_WANT_WRITE) {
+                error_ = "TLS handshake failed";
+                co_return false;
+            }
+            if (!co_await wait_for(want, deadline)) {
+                timed_out_ = true;
+                error_ = "connect timeout";
+                co_return false;
+            }
         }
+    }
 
-        int connect_result = connect(socket_fd_, addr_info_->ai_addr, addr_info_->ai_addrlen);
-        if (connect_result == 0) {
-            state_ = State::Sending;
-        } else if (errno == EINPROGRESS) {
-            state_ = State::Connecting;
-        } else {
-            response_.error_message = std::strerror(errno);
-            return false;
+    Task<bool> write_all(const std::string& data, EventLoop::Clock::time_point deadline) {
+        size_t offset = 0;
+        while (offset < data.size()) {
+            int want = 0;
+            long written = transmit(data.data() + offset, data.size() - offset, want);
+            if (written == kFailed) {
+                co_return false;
+            }
+            if (written == kWouldBlock) {
+                if (!co_await wait_for(want, deadline)) {
+                    timed_out_ = true;
+                    error_ = "raw socket fetch timeout";
+                    co_return false;
+                }
+                continue;
+            }
+            offset += static_cast<size_t>(written);
         }
-
-        build_request();
-        return true;
+        co_return true;
     }
 
-    bool handle_connecting() {
-        struct pollfd pfd {};
-        pfd.fd = socket_fd_;
-        pfd.events = POLLOUT;
-        int poll_result = poll(&pfd, 1, 0);
-        if (poll_result == 0) {
-            return true;
-        }
-        if (poll_result < 0) {
-            response_.error_message = std::strerror(errno);
-            complete_ = true;
-            return false;
+    /**
+     * Read what is available, waiting until the deadline for it
+     * @return Bytes read, 0 once the peer closed, kFailed on error or
+     *         timeout (see timed_out())
+     */
+    Task<long> read_some(char* buffer, size_t size, EventLoop::Clock::time_point deadline) {
+        if (!ssl_) {
+            long received = co_await loop_.receive(fd_, buffer, size, deadline);
+            if (received >= 0) {
+                co_return received;
+            }
+            timed_out_ = received == -ETIME;
+            if (!timed_out_) {
+                error_ = std::strerror(static_cast<int>(-received));
+            }
+            co_return kFailed;
         }
 
-        int error = 0;
-        socklen_t len = sizeof(error);
-        if (getsockopt(socket_fd_, SOL_SOCKET, SO_ERROR, &error, &len) != 0 || error != 0) {
-            response_.error_message = error == 0 ? "connect failed" : std::strerror(error);
-            complete_ = true;
-            return false;
+        while (true) {
+            int result = SSL_read(ssl_, buffer, static_cast<int>(size));
+            if (result > 0) {
+                co_return result;
+            }
+            int want = SSL_get_error(ssl_, result);
+            if (want != SSL_ERROR_WANT_READ && want != SSL_ERROR_WANT_WRITE) {
+                // close_notify, or servers that just close the socket: either way
+                // the response ends here and the parser judges what arrived
+                co_return 0;
+            }
+            if (!co_await wait_for(want, deadline)) {
+                timed_out_ = true;
+                co_return kFailed;
+            }
         }
-
-        state_ = State::Sending;
-        return true;
     }
 
-    bool handle_sending() {
-        if (request_offset_ >= request_.size()) {
-            state_ = State::Reading;
-            return true;
-        }
+    bool timed_out() const {
+        return timed_out_;
+    }
 
-        ssize_t sent = send(socket_fd_, request_.data() + request_offset_,
-                            request_.size() - request_offset_, 0);
-        if (sent < 0) {
-            if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                return true;
-            }
-            response_.error_message = std::strerror(errno);
-            complete_ = true;
-            return false;
-        }
+    const std::string& error() const {
+        return error_;
+    }
 
-        request_offset_ += static_cast<size_t>(sent);
-        return true;
+private:
+    // Readiness an operation asked for, as an SSL_ERROR_WANT_* code
+    EventLoop::Wait wait_for(int want, EventLoop::Clock::time_point deadline) {
+        return want == SSL_ERROR_WANT_WRITE ? loop_.writable(fd_, deadline)
+                                            : loop_.readable(fd_, deadline);
     }
 
-    bool handle_reading() {
-        char buffer[4096];
-        ssize_t received = recv(socket_fd_, buffer, sizeof(buffer), 0);
-        if (received == 0) {
-            finalize_response();
-            complete_ = true;
-            return false;
-        }
-        if (received < 0) {
-            if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                return true;
+    long transmit(const char* data, size_t size, int& want) {
+        if (ssl_) {
+            int result = SSL_write(ssl_, data, static_cast<int>(size));
+            if (result > 0) {
+                return result;
             }
-            response_.error_message = std::strerror(errno);
-            complete_ = true;
-            return false;
-        }
-
-        response_buffer_.append(buffer, static_cast<size_t>(received));
-        if (!headers_parsed_) {
-            ParsedHeaders headers = parse_headers(response_buffer_);
-            if (headers.header_end != std::string::npos) {
-                headers_parsed_ = true;
-                header_end_pos_ = headers.header_end;
-                content_length_ = headers.content_length;
-                has_content_length_ = headers.has_content_length;
-                chunked_ = headers.chunked;
+            int error = SSL_get_error(ssl_, result);
+            if (error == SSL_ERROR_WANT_READ || error == SSL_ERROR_WANT_WRITE) {
+                want = error;
+                return kWouldBlock;
             }
+            error_ = "TLS write failed";
+            return kFailed;
         }
-
-        if (headers_parsed_) {
-            std::string body = response_buffer_.substr(header_end_pos_ + 4);
-            if (chunked_) {
-                bool complete = false;
-                std::string decoded;
-                if (decode_chunked_body(body, decoded, complete) && complete) {
-                    response_buffer_ = response_buffer_.substr(0, header_end_pos_ + 4) + decoded;
-                    finalize_response();
-                    complete_ = true;
-                    return false;
-                }
-            } else if (has_content_length_) {
-                if (body.size() >= content_length_) {
-                    response_buffer_.resize(header_end_pos_ + 4 + content_length_);
-                    finalize_response();
-                    complete_ = true;
-                    return false;
-                }
-            }
+        ssize_t result = send(fd_, data, size, MSG_NOSIGNAL);
+        if (result >= 0) {
+            return static_cast<long>(result);
         }
-        return true;
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+            want = SSL_ERROR_WANT_WRITE;
+            return kWouldBlock;
+        }
+        error_ = std::strerror(errno);
+        return kFailed;
     }
 
-    void build_request() {
-        std::ostringstream request_stream;
-        request_stream << "GET " << parsed_.path << " HTTP/1.1\r\n";
-        request_stream << "Host: " << parsed_.host << "\r\n";
-        request_stream << "Connection: keep-alive\r\n";
-        request_stream << "User-Agent: DatasetCrawler/1.0\r\n";
-        for (const auto& header : headers_) {
-            request_stream << header.first << ": " << header.second << "\r\n";
-        }
-        request_stream << "\r\n";
-        request_ = request_stream.str();
-    }
-
-    void finalize_response() {
-        response_ = parse_http_response(response_buffer_, url_);
-    }
-
-    std::string url_;
-    std::map<std::string, std::string> headers_;
-    std::chrono::seconds timeout_;
-    std::chrono::steady_clock::time_point start_time_;
-    ParsedUrl parsed_;
-    struct addrinfo* addr_info_ = nullptr;
-    int socket_fd_ = -1;
-    State state_ = State::Init;
-    bool complete_ = false;
-    std::string request_;
-    size_t request_offset_ = 0;
-    std::string response_buffer_;
-    RawHttpResponse response_;
-    bool headers_parsed_ = false;
-    size_t header_end_pos_ = 0;
-    size_t content_length_ = 0;
-    bool has_content_length_ = false;
-    bool chunked_ = false;
+    EventLoop& loop_;
+    int fd_;
+    SSL* ssl_ = nullptr;
+    bool timed_out_ = false;
+    std::string error_;
 };
 
-} // namespace
-
-void RoundRobinScheduler::add_task(const std::shared_ptr<CoroutineTask>& task) {
-    tasks_.push_back(task);
-}
+// Happy Eyeballs connect; the socket comes back non-blocking, or -1 with error set
+Task<int> race_connect(EventLoop& loop, std::string host, int port,
+                       EventLoop::Clock::time_point deadline, std::string& error) {
+    std::vector<ResolvedAddress> candidates = AddressCache::instance().resolve(host, port, error);
+    if (candidates.empty()) {
+        co_return -1;
+    }
 
-void RoundRobinScheduler::run() {
-    while (!tasks_.empty()) {
-        for (size_t index = 0; index < tasks_.size();) {
-            auto& task = tasks_[index];
-            bool should_continue = task->step();
-            if (task->is_complete() || !should_continue) {
-                tasks_.erase(tasks_.begin() + static_cast<long>(index));
-                continue;
-            }
-            ++index;
+    ConnectionRace race(loop, std::move(candidates));
+    while (true) {
+        int socket_fd = race.step();
+        if (socket_fd >= 0) {
+            AddressCache::instance().remember_family(host, race.winner_family());
+            co_return socket_fd;
         }
-        if (!tasks_.empty()) {
-            poll(nullptr, 0, 5);
+        if (race.failed()) {
+            error = race.error();
+            co_return -1;
         }
+        if (EventLoop::Clock::now() >= deadline) {
+            error = "connect timeout";
+            co_return -1;
+        }
+        co_await loop.any_writable(race.pending(), std::min(deadline, race.next_attempt_at()));
     }
 }
 
-RawSocketHttpClient::RawSocketHttpClient(const RawSocketHttpConfig& config)
-    : config_(config) {}
-
-RawHttpResponse RawSocketHttpClient::fetch(const std::string& url,
-                                           const std::map<std::string, std::string>& headers) {
+// One request without redirects or retries; config carries effective timeouts
+Task<RawHttpResponse> fetch_once(EventLoop& loop, const std::string& url,
+                                 const std::map<std::string, std::string>& headers,
+                                 const RawSocketHttpConfig& config) {
     RawHttpResponse response;
-    ParsedUrl parsed = parse_url(url);
-    std::string current_url = url;
-    int attempts = std::max(1, config_.retry.max_retries + 1);
-
-    if (parsed.valid && parsed.scheme == "https") {
-        int redirects_remaining = std::max(0, config_.max_redirects);
-        for (int attempt = 0; attempt < attempts; ++attempt) {
-            std::string error;
-            struct addrinfo hints {};
-            hints.ai_family = AF_UNSPEC;
-            hints.ai_socktype = SOCK_STREAM;
-
-            struct addrinfo* addr_info = nullptr;
-            parsed = parse_url(current_url);
-            const std::string port_str = std::to_string(parsed.port);
-            int result = getaddrinfo(parsed.host.c_str(), port_str.c_str(), &hints, &addr_info);
-            if (result != 0) {
-                response.error_message = gai_strerror(result);
-                return response;
-            }
-
-            int socket_fd = connect_with_timeout(addr_info, config_.timeout, error);
-            if (socket_fd < 0) {
-                freeaddrinfo(addr_info);
-                response.error_message = error;
-                continue;
-            }
-
-            SSL_CTX* ctx = SSL_CTX_new(TLS_client_method());
-            if (!ctx) {
-                response.error_message = "failed to create SSL context";
-                close(socket_fd);
-                freeaddrinfo(addr_info);
-                return response;
-            }
-
-            SSL* ssl = SSL_new(ctx);
-            if (!ssl) {
-                response.error_message = "failed to create SSL session";
-                SSL_CTX_free(ctx);
-                close(socket_fd);
-                freeaddrinfo(addr_info);
-                return response;
-            }
+    auto start_time = EventLoop::Clock::now();
+    auto deadline = start_time + config.timeout;
+    Url parsed = Url::parse(url);
+    bool tls = parsed.valid() && parsed.scheme() == "https";
+    if (!parsed.valid() || (!tls && parsed.scheme() != "http")) {
+        response.error_message = "raw socket fetch supports http:// and https:// only";
+        co_return response;
+    }
+
+    const std::string host(parsed.host());
+    std::string error;
+    auto connect_deadline = start_time + config.connect_timeout;
+    int socket_fd = co_await race_connect(loop, host, parsed.port(), connect_deadline, error);
+    if (socket_fd < 0) {
+        response.error_message = error;
+        response.total_ms = elapsed_ms(start_time);
+        if (EventLoop::Clock::now() >= connect_deadline) {
+            response.connect_ms = response.total_ms;  // Censored: at least this long
+        }
+        co_return response;
+    }
 
-            SSL_set_fd(ssl, socket_fd);
-            SSL_set_tlsext_host_name(ssl, parsed.host.c_str());
-            if (SSL_connect(ssl) <= 0) {
-                response.error_message = "TLS handshake failed";
-                SSL_free(ssl);
-                SSL_CTX_free(ctx);
-                close(socket_fd);
-                freeaddrinfo(addr_info);
-                continue;
-            }
+    Connection connection(loop, socket_fd);
+    if (tls && !co_await connection.handshake(host, connect_deadline)) {
+        response.error_message = connection.error();
+        response.total_ms = elapsed_ms(start_time);
+        if (connection.timed_out()) {
+            response.connect_ms = response.total_ms;  // Censored: at least this long
+        }
+        co_return response;
+    }
+    response.connect_ms = elapsed_ms(start_time);  // Includes the TLS handshake
 
-            std::ostringstream request_stream;
-            request_stream << "GET " << parsed.path << " HTTP/1.1\r\n";
-            request_stream << "Host: " << parsed.host << "\r\n";
-            request_stream << "Connection: keep-alive\r\n";
-            request_stream << "User-Agent: DatasetCrawler/1.0\r\n";
-            for (const auto& header : headers) {
-                request_stream << header.first << ": " << header.second << "\r\n";
-            }
-            request_stream << "\r\n";
-            std::string request = request_stream.str();
-
-            size_t total_written = 0;
-            while (total_written < request.size()) {
-                int written = SSL_write(ssl, request.data() + total_written,
-                                        static_cast<int>(request.size() - total_written));
-                if (written <= 0) {
-                    response.error_message = "TLS write failed";
-                    break;
-                }
-                total_written += static_cast<size_t>(written);
-            }
+    std::string request = build_request(parsed, headers);
+    if (!co_await connection.write_all(request, deadline)) {
+        response.error_message = connection.error();
+        response.total_ms = elapsed_ms(start_time);
+        response.timed_out = connection.timed_out();
+        co_return response;
+    }
 
-            std::string response_buffer;
-            if (total_written == request.size()) {
-                char buffer[4096];
-                int read_bytes = 0;
-                while ((read_bytes = SSL_read(ssl, buffer, sizeof(buffer))) > 0) {
-                    response_buffer.append(buffer, static_cast<size_t>(read_bytes));
-                }
-                if (!response_buffer.empty()) {
-                    response = parse_http_response(response_buffer, current_url);
-                } else if (response.error_message.empty()) {
-                    response.error_message = "empty HTTPS response";
-                }
+    auto request_sent = EventLoop::Clock::now();
+    long first_byte_ms = -1;
+    std::string response_buffer = ByteBuffer::acquire(kReadSize);
+    std::string read_error;
+    bool timed_out = false;
+    ParsedHeaders received_headers;
+    while (true) {
+        auto now = EventLoop::Clock::now();
+        if (now >= deadline) {
+            read_error = "raw socket fetch timeout";
+            timed_out = true;
+            break;
+        }
+        size_t used = response_buffer.size();
+        response_buffer.resize(used + kReadSize);
+        long received = co_await connection.read_some(response_buffer.data() + used, kReadSize,
+                                                       std::min(deadline, now + config.idle_timeout));
+        response_buffer.resize(used + static_cast<size_t>(std::max(0L, received)));
+        if (received > 0) {
+            if (first_byte_ms < 0) {
+                first_byte_ms = elapsed_ms(request_sent);
             }
-
-            SSL_shutdown(ssl);
-            SSL_free(ssl);
-            SSL_CTX_free(ctx);
-            close(socket_fd);
-            freeaddrinfo(addr_info);
-
-            if (response.success) {
-                if (response.status_code == 301 || response.status_code == 302 ||
-                    response.status_code == 303 || response.status_code == 307 ||
-                    response.status_code == 308) {
-                    std::string next_url = resolve_redirect(parsed, response.location);
-                    if (!next_url.empty() && redirects_remaining > 0) {
-                        current_url = next_url;
-                        redirects_remaining--;
-                        continue;
-                    }
-                }
-                return response;
+            if (response_complete(response_buffer, received_headers)) {
+                break;
             }
-
-            if (attempt + 1 < attempts) {
-                int backoff = config_.retry.retry_backoff_ms * (attempt + 1);
-                poll(nullptr, 0, backoff);
+            continue;
+        }
+        if (received == 0) {
+            break;  // Closed by the server
+        }
+        if (!connection.timed_out()) {
+            read_error = connection.error();
+        } else if (EventLoop::Clock::now() >= deadline) {
+            read_error = "raw socket fetch timeout";
+            timed_out = true;
+        } else if (!response_complete(response_buffer, received_headers)) {
+            // A silent server, or one that went quiet before the end of its
+            // body: a truncated page must not pass for a good response
+            read_error = "read idle timeout";
+            if (first_byte_ms < 0) {
+                first_byte_ms = elapsed_ms(request_sent);  // Censored: at least this long
             }
         }
+        break;
+    }
+    if (timed_out && first_byte_ms < 0) {
+        first_byte_ms = elapsed_ms(request_sent);  // Censored: at least this long
+    }
 
-        return response;
+    long connect_ms = response.connect_ms;
+    if (!read_error.empty()) {
+        response.error_message = read_error;
+    } else if (!response_buffer.empty()) {
+        response = parse_http_response(std::move(response_buffer), url);
+    } else {
+        response.error_message = "empty response";
     }
+    response.connect_ms = connect_ms;
+    response.first_byte_ms = first_byte_ms;
+    response.total_ms = elapsed_ms(start_time);
+    response.timed_out = timed_out;
+    co_return response;
+}
 
-    int redirects_remaining = std::max(0, config_.max_redirects);
-    for (int attempt = 0; attempt < attempts; ++attempt) {
-        auto task = std::make_shared<HttpFetchCoroutine>(current_url, headers, config_.timeout);
-        RoundRobinScheduler scheduler;
-        scheduler.add_task(task);
-        scheduler.run();
+// Redirects and retries around fetch_once; takes everything by value so the
+// caller's arguments may go away while it is suspended
+Task<RawHttpResponse> fetch_with_retries(EventLoop& loop, RawSocketHttpConfig config, std::string url,
+                                         std::map<std::string, std::string> headers) {
+    config.connect_timeout = config.connect_timeout.count() > 0
+        ? std::min(config.connect_timeout, config.timeout) : config.timeout;
+    config.idle_timeout = config.idle_timeout.count() > 0
+        ? std::min(config.idle_timeout, config.timeout) : config.timeout;
 
-        response = task->response();
+    RawHttpResponse response;
+    int attempts = std::max(1, config.retry.max_retries + 1);
+    int redirects_remaining = std::max(0, config.max_redirects);
+    for (int attempt = 0; attempt < attempts;) {
+        response = co_await fetch_once(loop, url, headers, config);
         if (response.success) {
-            if (response.status_code == 301 || response.status_code == 302 ||
-                response.status_code == 303 || response.status_code == 307 ||
-                response.status_code == 308) {
-                ParsedUrl current_parsed = parse_url(current_url);
-                std::string next_url = resolve_redirect(current_parsed, response.location);
-                if (!next_url.empty() && redirects_remaining > 0) {
-                    current_url = next_url;
+            if (is_redirect(response.status_code) && redirects_remaining > 0) {
+                std::string next_url = resolve_redirect(Url::parse(url), response.location);
+                if (!next_url.empty()) {
+                    url = next_url;
                     redirects_remaining--;
                     continue;
                 }
             }
-            return response;
+            co_return response;
         }
 
-        if (attempt + 1 < attempts) {
-            int backoff = config_.retry.retry_backoff_ms * (attempt + 1);
-            poll(nullptr, 0, backoff);
+        if (++attempt < attempts) {
+            auto backoff = std::chrono::milliseconds(config.retry.retry_backoff_ms * attempt);
+            co_await loop.sleep_until(EventLoop::Clock::now() + backoff);
         }
     }
+    co_return response;
+}
 
-    return response;
+// The calling thread's loop for a backend, reused by every blocking fetch on it
+EventLoop& thread_loop(IoBackend backend) {
+    thread_local std::map<IoBackend, std::unique_ptr<EventLoop>> loops;
+    auto& loop = loops[backend];
+    if (!loop) {
+        loop = std::make_unique<EventLoop>(backend);
+    }
+    return *loop;
+}
+
+} // namespace
+
+RawSocketHttpClient::RawSocketHttpClient(const RawSocketHttpConfig& config)
+    : config_(config) {}
+
+RawHttpResponse RawSocketHttpClient::fetch(const std::string& url,
+                                           const std::map<std::string, std::string>& headers) {
+    EventLoop& loop = thread_loop(config_.io_backend);
+    return loop.run(fetch_async(loop, url, headers));
+}
+
+Task<RawHttpResponse> RawSocketHttpClient::fetch_async(EventLoop& loop, const std::string& url,
+                                                       const std::map<std::string, std::string>& headers) const {
+    return fetch_with_retries(loop, config_, url, headers);
 }
@@ -0,0 +1,91 @@
+#include "recrawl_scheduler.h"
+#include <algorithm>
+#include <bitset>
+#include <cmath>
+#include <sstream>
+
+RecrawlScheduler::RecrawlScheduler(int64_t min_interval, int64_t max_interval)
+    : min_interval_(1),
+      max_interval_(1),
+      target_probability_(0.5) {
+    set_intervals(min_interval, max_interval);
+}
+
+void RecrawlScheduler::set_intervals(int64_t min_interval, int64_t max_interval) {
+    min_interval_ = std::max<int64_t>(1, min_interval);
+    max_interval_ = std::max(min_interval_, max_interval);
+}
+
+void RecrawlScheduler::set_target_probability(double probability) {
+    target_probability_ = std::min(0.95, std::max(0.05, probability));
+}
+
+int64_t RecrawlScheduler::min_interval() const {
+    return min_interval_;
+}
+
+bool RecrawlScheduler::record_fetch(FetchHistory& history, uint64_t fingerprint, int64_t now) const {
+    bool changed = false;
+    if (history.fetches == 0) {
+        history.first_fetch = now;
+    } else {
+        changed = static_cast<int>(std::bitset<64>(history.fingerprint ^ fingerprint).count()) > kSameContentBits;
+        if (changed) {
+            ++history.changes;
+        }
+    }
+    ++history.fetches;
+    history.last_fetch = now;
+    history.fingerprint = fingerprint;
+    history.next_due = now + revisit_interval(history);
+    return changed;
+}
+
+double RecrawlScheduler::change_rate(const FetchHistory& history) {
+    if (history.fetches < 2 || history.changes == 0 || history.last_fetch <= history.first_fetch) {
+        return 0.0;
+    }
+    double revisits = static_cast<double>(history.fetches - 1);
+    double changes = std::min(static_cast<double>(history.changes), revisits);
+    double mean_interval = static_cast<double>(history.last_fetch - history.first_fetch) / revisits;
+    return -std::log((revisits - changes + 0.5) / (revisits + 0.5)) / mean_interval;
+}
+
+int64_t RecrawlScheduler::revisit_interval(const FetchHistory& history) const {
+    if (history.fetches < 2) {
+        return clamp(static_cast<double>(kInitialInterval));
+    }
+    double rate = change_rate(history);
+    if (rate <= 0.0) {
+        // Never seen to change: back off
+        double mean_interval = static_cast<double>(history.last_fetch - history.first_fetch) /
+                               static_cast<double>(history.fetches - 1);
+        return clamp(2.0 * std::max(mean_interval, static_cast<double>(min_interval_)));
+    }
+    return clamp(-std::log(1.0 - target_probability_) / rate);
+}
+
+int64_t RecrawlScheduler::clamp(double seconds) const {
+    if (!(seconds < static_cast<double>(max_interval_))) {
+        return max_interval_;
+    }
+    return std::max(min_interval_, static_cast<int64_t>(seconds));
+}
+
+std::string RecrawlScheduler::serialize(const FetchHistory& history) {
+    std::ostringstream out;
+    out << history.first_fetch << " " << history.last_fetch << " " << history.fetches << " "
+        << history.changes << " " << history.fingerprint << " " << history.next_due;
+    return out.str();
+}
+
+bool RecrawlScheduler::deserialize(const std::string& data, FetchHistory& history) {
+    std::istringstream in(data);
+    FetchHistory parsed;
+    if (!(in >> parsed.first_fetch >> parsed.last_fetch >> parsed.fetches >> parsed.changes >>
+          parsed.fingerprint >> parsed.next_due)) {
+        return false;
+    }
+    history = parsed;
+    return true;
+}
@@ -0,0 +1,35 @@
+#include "retry_budget.h"
+#include <algorithm>
+
+RetryBudget::RetryBudget(double ratio, double reserve)
+    : ratio_(0.0),
+      reserve_(0.0),
+      balance_(0.0) {
+    configure(ratio, reserve);
+}
+
+void RetryBudget::configure(double ratio, double reserve) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ratio_ = std::max(0.0, ratio);
+    reserve_ = std::max(0.0, reserve);
+    balance_ = reserve_;
+}
+
+void RetryBudget::on_request() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    balance_ = std::min(reserve_, balance_ + ratio_);
+}
+
+bool RetryBudget::try_spend() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (balance_ < 1.0) {
+        return false;
+    }
+    balance_ -= 1.0;
+    return true;
+}
+
+double RetryBudget::balance() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return balance_;
+}
@@ -0,0 +1,99 @@
+#include "robots_cache.h"
+#include "logger.h"
+
+RobotsCache::RobotsCache(size_t max_hosts, long ttl_seconds)
+    : max_hosts_(max_hosts > 0 ? max_hosts : 1),
+      ttl_seconds_(ttl_seconds) {
+}
+
+void RobotsCache::configure(size_t max_hosts, long ttl_seconds) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    max_hosts_ = max_hosts > 0 ? max_hosts : 1;
+    ttl_seconds_ = ttl_seconds;
+    while (entries_.size() > max_hosts_) {
+        entries_.erase(lru_.back());
+        lru_.pop_back();
+    }
+}
+
+std::shared_ptr<const RobotsEntry> RobotsCache::get(const std::string& host, const Loader& loader) {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    auto it = entries_.find(host);
+    if (it != entries_.end() && is_fresh(*it->second.entry)) {
+        lru_.splice(lru_.begin(), lru_, it->second.lru_position);
+        return it->second.entry;
+    }
+
+    // Someone is already loading this host: wait for their result
+    auto flight_it = in_flight_.find(host);
+    if (flight_it != in_flight_.end()) {
+        std::shared_ptr<InFlight> flight = flight_it->second;
+        loaded_cv_.wait(lock, [&flight] { return flight->done; });
+        return flight->result;
+    }
+
+    auto flight = std::make_shared<InFlight>();
+    in_flight_[host] = flight;
+    lock.unlock();
+
+    std::shared_ptr<const RobotsEntry> entry;
+    try {
+        entry = loader(host);
+    } catch (const std::exception& e) {
+        Logger::instance().error("RobotsCache: Failed to load robots.txt for " + host + ": " + e.what());
+    } catch (...) {
+        Logger::instance().error("RobotsCache: Failed to load robots.txt for " + host);
+    }
+
+    lock.lock();
+    if (entry) {
+        insert_locked(host, entry);
+    }
+    flight->result = entry;
+    flight->done = true;
+    in_flight_.erase(host);
+    loaded_cv_.notify_all();
+    return entry;
+}
+
+std::shared_ptr<const RobotsEntry> RobotsCache::find(const std::string& host) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(host);
+    if (it == entries_.end() || !is_fresh(*it->second.entry)) {
+        return nullptr;
+    }
+    return it->second.entry;
+}
+
+size_t RobotsCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+long RobotsCache::ttl_seconds() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return ttl_seconds_;
+}
+
+bool RobotsCache::is_fresh(const RobotsEntry& entry) const {
+    auto age = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now() - entry.fetched_at).count();
+    return age <= ttl_seconds_;
+}
+
+void RobotsCache::insert_locked(const std::string& host, std::shared_ptr<const RobotsEntry> entry) {
+    auto it = entries_.find(host);
+    if (it != entries_.end()) {
+        it->second.entry = std::move(entry);
+        lru_.splice(lru_.begin(), lru_, it->second.lru_position);
+        return;
+    }
+
+    if (entries_.size() >= max_hosts_) {
+        entries_.erase(lru_.back());
+        lru_.pop_back();
+    }
+    lru_.push_front(host);
+    entries_[host] = Slot{std::move(entry), lru_.begin()};
+}
@@ -0,0 +1,186 @@
+#include "robots_matcher.h"
+#include <algorithm>
+
+namespace {
+
+// Allow wins when both verdicts apply at the same length
+uint8_t merge_verdict(uint8_t current, bool allow) {
+    return allow ? 2 : std::max<uint8_t>(current, 1);  // 2 = allow, 1 = disallow
+}
+
+} // namespace
+
+RobotsMatcher::RobotsMatcher()
+    : trie_(1),
+      pattern_count_(0),
+      crawl_delay_seconds_(-1.0) {
+}
+
+void RobotsMatcher::add_pattern(const std::string& pattern, bool allow) {
+    if (pattern.empty()) {
+        return;
+    }
+    ++pattern_count_;
+
+    bool anchored = pattern.back() == '$';
+    size_t length = anchored ? pattern.size() - 1 : pattern.size();
+
+    if (pattern.find('*') != std::string::npos) {
+        GlobPattern glob = compile_glob(pattern.substr(0, length), anchored);
+        glob.allow = allow;
+        auto it = std::upper_bound(globs_.begin(), globs_.end(), glob.length,
+                                   [](size_t len, const GlobPattern& other) {
+                                       return len > other.length;
+                                   });
+        globs_.insert(it, std::move(glob));
+        return;
+    }
+
+    uint32_t node = 0;
+    for (size_t i = 0; i < length; ++i) {
+        char c = pattern[i];
+        uint32_t next = 0;
+        for (const auto& child : trie_[node].children) {
+            if (child.first == c) {
+                next = child.second;
+                break;
+            }
+        }
+        if (next == 0) {
+            next = static_cast<uint32_t>(trie_.size());
+            trie_[node].children.emplace_back(c, next);
+            trie_.emplace_back();
+        }
+        node = next;
+    }
+
+    if (anchored) {
+        trie_[node].exact_verdict = merge_verdict(trie_[node].exact_verdict, allow);
+    } else {
+        trie_[node].prefix_verdict = merge_verdict(trie_[node].prefix_verdict, allow);
+    }
+}
+
+bool RobotsMatcher::is_allowed(const std::string& path) const {
+    if (pattern_count_ == 0) {
+        return true;
+    }
+
+    // Literal patterns: the deepest trie match is the longest one
+    size_t best_length = 0;
+    uint8_t best = kNone;
+    uint32_t node = 0;
+    size_t depth = 0;
+    while (true) {
+        const TrieNode& current = trie_[node];
+        if (current.prefix_verdict != kNone) {
+            best_length = depth;
+            best = current.prefix_verdict;
+        }
+        if (depth == path.size()) {
+            if (current.exact_verdict != kNone) {
+                best = std::max(best_length == depth ? best : kNone, current.exact_verdict);
+                best_length = depth;
+            }
+            break;
+        }
+        uint32_t next = 0;
+        for (const auto& child : current.children) {
+            if (child.first == path[depth]) {
+                next = child.second;
+                break;
+            }
+        }
+        if (next == 0) {
+            break;
+        }
+        node = next;
+        ++depth;
+    }
+
+    // Wildcard patterns, longest first
+    for (const auto& glob : globs_) {
+        if (best != kNone && (glob.length < best_length ||
+                              (glob.length == best_length && best == kAllow))) {
+            break;
+        }
+        if (match_glob(glob, path)) {
+            if (best != kNone && glob.length == best_length) {
+                best = merge_verdict(best, glob.allow);
+            } else {
+                best = glob.allow ? kAllow : kDisallow;
+                best_length = glob.length;
+            }
+        }
+    }
+
+    return best != kDisallow;
+}
+
+void RobotsMatcher::set_crawl_delay(double seconds) {
+    crawl_delay_seconds_ = seconds;
+}
+
+double RobotsMatcher::crawl_delay() const {
+    return crawl_delay_seconds_;
+}
+
+size_t RobotsMatcher::pattern_count() const {
+    return pattern_count_;
+}
+
+bool RobotsMatcher::match_pattern(const std::string& pattern, const std::string& path) {
+    if (pattern.empty()) {
+        return path.empty();
+    }
+    bool anchored = pattern.back() == '$';
+    return match_glob(compile_glob(pattern.substr(0, anchored ? pattern.size() - 1 : pattern.size()), anchored),
+                      path);
+}
+
+RobotsMatcher::GlobPattern RobotsMatcher::compile_glob(const std::string& pattern, bool anchored) {
+    GlobPattern glob;
+    glob.anchored = anchored;
+    glob.length = pattern.size();
+    size_t start = 0;
+    while (true) {
+        size_t star = pattern.find('*', start);
+        glob.segments.push_back(pattern.substr(start, star == std::string::npos ? std::string::npos : star - start));
+        if (star == std::string::npos) {
+            break;
+        }
+        start = star + 1;
+    }
+    return glob;
+}
+
+bool RobotsMatcher::match_glob(const GlobPattern& glob, const std::string& path) {
+    const auto& segments = glob.segments;
+
+    // The first segment is anchored at the start of the path
+    const std::string& first = segments.front();
+    if (path.compare(0, first.size(), first) != 0) {
+        return false;
+    }
+    if (segments.size() == 1) {
+        return !glob.anchored || path.size() == first.size();
+    }
+
+    // Middle segments: leftmost occurrence is always the best choice, since
+    // '*' can absorb whatever lies between segments
+    size_t pos = first.size();
+    for (size_t i = 1; i + 1 < segments.size(); ++i) {
+        size_t found = path.find(segments[i], pos);
+        if (found == std::string::npos) {
+            return false;
+        }
+        pos = found + segments[i].size();
+    }
+
+    const std::string& last = segments.back();
+    if (glob.anchored) {
+        return path.size() >= pos + last.size() &&
+               path.compare(path.size() - last.size(), last.size(), last) == 0;
+    }
+    return path.find(last, pos) != std::string::npos;
+}
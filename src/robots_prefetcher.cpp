@@ -0,0 +1,93 @@
+#include "robots_prefetcher.h"
+#include "logger.h"
+
+RobotsPrefetcher::RobotsPrefetcher()
+    : running_(false) {
+}
+
+RobotsPrefetcher::~RobotsPrefetcher() {
+    stop();
+}
+
+void RobotsPrefetcher::start(size_t workers, Loader loader, ReadyCallback on_ready) {
+    stop();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    loader_ = std::move(loader);
+    on_ready_ = std::move(on_ready);
+    running_ = true;
+    size_t count = workers > 0 ? workers : 1;
+    for (size_t i = 0; i < count; ++i) {
+        workers_.emplace_back(&RobotsPrefetcher::worker_loop, this);
+    }
+}
+
+void RobotsPrefetcher::stop() {
+    std::vector<std::thread> workers;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+        queue_.clear();
+        workers.swap(workers_);
+    }
+    queue_cv_.notify_all();
+    for (auto& worker : workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_.clear();
+}
+
+bool RobotsPrefetcher::schedule(const std::string& host) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_ || !pending_.insert(host).second) {
+            return false;
+        }
+        queue_.push_back(host);
+    }
+    queue_cv_.notify_one();
+    return true;
+}
+
+bool RobotsPrefetcher::is_running() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return running_;
+}
+
+size_t RobotsPrefetcher::pending() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pending_.size();
+}
+
+void RobotsPrefetcher::worker_loop() {
+    while (true) {
+        std::string host;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            queue_cv_.wait(lock, [this] { return !running_ || !queue_.empty(); });
+            if (!running_) {
+                return;
+            }
+            host = std::move(queue_.front());
+            queue_.pop_front();
+        }
+
+        try {
+            loader_(host);
+        } catch (const std::exception& e) {
+            Logger::instance().error("RobotsPrefetcher: Failed to load robots.txt for " + host + ": " + e.what());
+        }
+
+        // Forget the host before reporting it, so a URL arriving after the
+        // report can schedule it again instead of waiting on a finished load
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            pending_.erase(host);
+        }
+        on_ready_(host);
+    }
+}
@@ -2,6 +2,8 @@
 #include "logger.h"
 #include <rocksdb/db.h>
 #include <rocksdb/options.h>
+#include <rocksdb/write_batch.h>
+#include <cstdlib>
 #include <sstream>
 #include <iomanip>
 #include <memory>
@@ -73,7 +75,7 @@ bool RocksDBManager::enqueue_url(const std::string& url, int priority) {
     return true;
 }
 
-std::string RocksDBManager::dequeue_url() {
+std::string RocksDBManager::dequeue_url(int* priority) {
     if (!db_) return "";
 
     std::unique_ptr<rocksdb::Iterator> it(db_->NewIterator(rocksdb::ReadOptions()));
@@ -99,6 +101,10 @@ std::string RocksDBManager::dequeue_url() {
             db_->Put(rocksdb::WriteOptions(), "pqueue:size", std::to_string(size - 1));
         }
 
+        if (priority) {
+            // pqueue:item:PPPP:IIIIIIIIIIII
+            *priority = std::atoi(key.c_str() + prefix.size());
+        }
         return value;
     }
 
@@ -130,6 +136,80 @@ int RocksDBManager::get_queue_size() {
     return count;
 }
 
+bool RocksDBManager::defer_url(const std::string& host, const std::string& url, int priority) {
+    if (!db_) return false;
+
+    std::string tail_str;
+    int tail = 0;
+    std::string tail_key = make_deferred_tail_key(host);
+    if (db_->Get(rocksdb::ReadOptions(), tail_key, &tail_str).ok()) {
+        tail = std::stoi(tail_str);
+    }
+
+    rocksdb::WriteBatch batch;
+    batch.Put(make_deferred_key(host, tail), std::to_string(priority) + " " + url);
+    batch.Put(tail_key, std::to_string(tail + 1));
+    rocksdb::Status status = db_->Write(rocksdb::WriteOptions(), &batch);
+    if (!status.ok()) {
+        Logger::instance().error("RocksDB: Failed to defer URL: " + status.ToString());
+        return false;
+    }
+    return true;
+}
+
+size_t RocksDBManager::release_deferred_urls(const std::string& host) {
+    if (!db_) return 0;
+
+    // Collect first: enqueueing writes while the iterator is open
+    std::vector<std::pair<std::string, std::string>> items;
+    const std::string prefix = "dqueue:item:" + host + "|";
+    std::unique_ptr<rocksdb::Iterator> it(db_->NewIterator(rocksdb::ReadOptions()));
+    for (it->Seek(prefix); it->Valid(); it->Next()) {
+        std::string key = it->key().ToString();
+        if (key.compare(0, prefix.size(), prefix) != 0) {
+            break;
+        }
+        items.emplace_back(std::move(key), it->value().ToString());
+    }
+    it.reset();
+
+    size_t released = 0;
+    for (const auto& [key, value] : items) {
+        // "<priority> <url>"
+        size_t space = value.find(' ');
+        if (space != std::string::npos &&
+            !enqueue_url(value.substr(space + 1), std::atoi(value.c_str()))) {
+            break;  // Keep the rest deferred rather than lose them
+        }
+        db_->Delete(rocksdb::WriteOptions(), key);
+        ++released;
+    }
+    if (released == items.size()) {
+        db_->Delete(rocksdb::WriteOptions(), make_deferred_tail_key(host));
+    }
+    return released;
+}
+
+std::vector<std::string> RocksDBManager::get_deferred_hosts() {
+    std::vector<std::string> hosts;
+    if (!db_) return hosts;
+
+    const std::string prefix = "dqueue:item:";
+    std::unique_ptr<rocksdb::Iterator> it(db_->NewIterator(rocksdb::ReadOptions()));
+    it->Seek(prefix);
+    while (it->Valid()) {
+        std::string key = it->key().ToString();
+        size_t bar = key.rfind('|');
+        if (key.compare(0, prefix.size(), prefix) != 0 || bar == std::string::npos || bar < prefix.size()) {
+            break;
+        }
+        hosts.push_back(key.substr(prefix.size(), bar - prefix.size()));
+        // '}' sorts right after '|': skip the rest of this host's URLs
+        it->Seek(key.substr(0, bar) + "}");
+    }
+    return hosts;
+}
+
 bool RocksDBManager::mark_visited(const std::string& url) {
     if (!db_) return false;
     
@@ -147,6 +227,62 @@ bool RocksDBManager::is_visited(const std::string& url) {
     return status.ok();
 }
 
+bool RocksDBManager::unmark_visited(const std::string& url) {
+    if (!db_) return false;
+    
+    rocksdb::Status status = db_->Delete(rocksdb::WriteOptions(), make_visited_key(url));
+    return status.ok();
+}
+
+bool RocksDBManager::store_fetch_history(const std::string& url, const std::string& data,
+                                         int64_t next_due, int64_t previous_due) {
+    if (!db_) return false;
+    
+    rocksdb::WriteBatch batch;
+    batch.Put(make_history_key(url), data);
+    if (previous_due > 0 && previous_due != next_due) {
+        batch.Delete(make_recrawl_key(previous_due, url));
+    }
+    if (next_due > 0) {
+        batch.Put(make_recrawl_key(next_due, url), "");
+    }
+    rocksdb::Status status = db_->Write(rocksdb::WriteOptions(), &batch);
+    if (!status.ok()) {
+        Logger::instance().error("RocksDB: Failed to store fetch history: " + status.ToString());
+        return false;
+    }
+    return true;
+}
+
+std::string RocksDBManager::get_fetch_history(const std::string& url) {
+    if (!db_) return "";
+    
+    std::string value;
+    rocksdb::Status status = db_->Get(rocksdb::ReadOptions(), make_history_key(url), &value);
+    return status.ok() ? value : "";
+}
+
+std::vector<std::string> RocksDBManager::get_due_recrawls(int64_t now, size_t limit) {
+    std::vector<std::string> urls;
+    if (!db_) return urls;
+    
+    // Keys sort by due time, so the scan stops at the first entry in the future
+    const std::string prefix = "recrawl:";
+    const std::string end = make_recrawl_key(now + 1, "");
+    std::unique_ptr<rocksdb::Iterator> it(db_->NewIterator(rocksdb::ReadOptions()));
+    for (it->Seek(prefix); it->Valid() && urls.size() < limit; it->Next()) {
+        std::string key = it->key().ToString();
+        if (key.compare(0, prefix.size(), prefix) != 0 || key >= end) {
+            break;
+        }
+        size_t separator = key.find(':', prefix.size());
+        if (separator != std::string::npos) {
+            urls.push_back(key.substr(separator + 1));
+        }
+    }
+    return urls;
+}
+
 std::vector<std::string> RocksDBManager::get_all_visited() {
     std::vector<std::string> visited;
     if (!db_) return visited;
@@ -198,6 +334,139 @@ bool RocksDBManager::has_cached_html(const std::string& url) {
     return status.ok();
 }
 
+bool RocksDBManager::store_validators(const std::string& url, std::string_view html,
+                                      const std::string& title, const std::string& text,
+                                      const std::string& etag, const std::string& last_modified) {
+    if (!db_) return false;
+    
+    rocksdb::WriteBatch batch;
+    batch.Put(make_cache_key(url), rocksdb::Slice(html.data(), html.size()));
+    // "<title length>\n<title><text>": titles may hold newlines of their own
+    batch.Put(make_extract_key(url), std::to_string(title.size()) + "\n" + title + text);
+    batch.Put(make_validators_key(url), etag + "\n" + last_modified);
+    rocksdb::Status status = db_->Write(rocksdb::WriteOptions(), &batch);
+    if (!status.ok()) {
+        Logger::instance().error("RocksDB: Failed to store validators: " + status.ToString());
+        return false;
+    }
+    return true;
+}
+
+bool RocksDBManager::get_validators(const std::string& url, std::string& etag, std::string& last_modified) {
+    if (!db_) return false;
+    
+    std::string value;
+    rocksdb::Status status = db_->Get(rocksdb::ReadOptions(), 
+                                       make_validators_key(url), &value);
+    if (!status.ok()) {
+        return false;
+    }
+    size_t newline = value.find('\n');
+    if (newline == std::string::npos) {
+        return false;
+    }
+    etag = value.substr(0, newline);
+    last_modified = value.substr(newline + 1);
+    return !etag.empty() || !last_modified.empty();
+}
+
+bool RocksDBManager::get_cached_extract(const std::string& url, std::string& title, std::string& text) {
+    if (!db_) return false;
+    
+    std::string value;
+    rocksdb::Status status = db_->Get(rocksdb::ReadOptions(), 
+                                       make_extract_key(url), &value);
+    if (!status.ok()) {
+        return false;
+    }
+    size_t newline = value.find('\n');
+    if (newline == std::string::npos) {
+        return false;
+    }
+    size_t title_size = 0;
+    try {
+        title_size = static_cast<size_t>(std::stoul(value.substr(0, newline)));
+    } catch (const std::exception&) {
+        return false;
+    }
+    if (title_size > value.size() - newline - 1) {
+        return false;
+    }
+    title = value.substr(newline + 1, title_size);
+    text = value.substr(newline + 1 + title_size);
+    return true;
+}
+
+bool RocksDBManager::store_robots_txt(const std::string& host, const std::string& data) {
+    if (!db_) return false;
+    
+    rocksdb::Status status = db_->Put(rocksdb::WriteOptions(),
+                                      make_robots_key(host), data);
+    return status.ok();
+}
+
+std::string RocksDBManager::get_robots_txt(const std::string& host) {
+    if (!db_) return "";
+    
+    std::string value;
+    rocksdb::Status status = db_->Get(rocksdb::ReadOptions(),
+                                      make_robots_key(host), &value);
+    return status.ok() ? value : "";
+}
+
+bool RocksDBManager::store_dust_rules(const std::string& host, const std::string& data) {
+    if (!db_) return false;
+    
+    rocksdb::Status status = db_->Put(rocksdb::WriteOptions(),
+                                      make_dust_key(host), data);
+    return status.ok();
+}
+
+std::string RocksDBManager::get_dust_rules(const std::string& host) {
+    if (!db_) return "";
+    
+    std::string value;
+    rocksdb::Status status = db_->Get(rocksdb::ReadOptions(),
+                                      make_dust_key(host), &value);
+    return status.ok() ? value : "";
+}
+
+std::vector<std::string> RocksDBManager::get_dust_hosts() {
+    std::vector<std::string> hosts;
+    if (!db_) return hosts;
+    
+    rocksdb::Iterator* it = db_->NewIterator(rocksdb::ReadOptions());
+    std::string prefix = make_dust_key("");
+    
+    for (it->Seek(prefix); it->Valid(); it->Next()) {
+        std::string key = it->key().ToString();
+        if (key.substr(0, prefix.length()) != prefix) {
+            break;
+        }
+        hosts.push_back(key.substr(prefix.length()));
+    }
+    
+    delete it;
+    return hosts;
+}
+
+bool RocksDBManager::store_host_template(const std::string& host, const std::string& data) {
+    if (!db_) return false;
+    
+    rocksdb::Status status = db_->Put(rocksdb::WriteOptions(),
+                                      make_template_key(host), data);
+    return status.ok();
+}
+
+std::string RocksDBManager::get_host_template(const std::string& host) {
+    if (!db_) return "";
+    
+    std::string value;
+    rocksdb::Status status = db_->Get(rocksdb::ReadOptions(),
+                                      make_template_key(host), &value);
+    return status.ok() ? value : "";
+}
+
 bool RocksDBManager::add_link_edge(const std::string& from_url, const std::string& to_url) {
     if (!db_) return false;
 
@@ -223,6 +492,72 @@ std::vector<std::string> RocksDBManager::get_outgoing_links(const std::string& f
     return links;
 }
 
+size_t RocksDBManager::for_each_link_edge(
+    const std::function<void(std::string_view from_url, std::string_view to_url)>& visit) {
+    if (!db_) return 0;
+
+    // Pin a snapshot so edges added by a running crawl do not skew the scan
+    const rocksdb::Snapshot* snapshot = db_->GetSnapshot();
+    rocksdb::ReadOptions options;
+    options.snapshot = snapshot;
+    options.fill_cache = false;
+
+    size_t count = 0;
+    const std::string prefix = "graph:";
+    std::unique_ptr<rocksdb::Iterator> it(db_->NewIterator(options));
+    for (it->Seek(prefix); it->Valid(); it->Next()) {
+        rocksdb::Slice key = it->key();
+        std::string_view edge(key.data(), key.size());
+        if (edge.compare(0, prefix.size(), prefix) != 0) {
+            break;
+        }
+        edge.remove_prefix(prefix.size());
+        size_t arrow = edge.find("->");
+        if (arrow == std::string_view::npos) {
+            continue;
+        }
+        visit(edge.substr(0, arrow), edge.substr(arrow + 2));
+        ++count;
+    }
+
+    it.reset();
+    db_->ReleaseSnapshot(snapshot);
+    return count;
+}
+
+bool RocksDBManager::store_page_scores(const std::vector<std::pair<std::string, std::string>>& scores) {
+    return write_scores(scores, false);
+}
+
+bool RocksDBManager::store_host_scores(const std::vector<std::pair<std::string, std::string>>& scores) {
+    return write_scores(scores, true);
+}
+
+bool RocksDBManager::write_scores(const std::vector<std::pair<std::string, std::string>>& scores, bool hosts) {
+    if (!db_) return false;
+
+    rocksdb::WriteBatch batch;
+    for (const auto& [name, value] : scores) {
+        batch.Put(hosts ? make_host_rank_key(name) : make_page_rank_key(name), value);
+    }
+    rocksdb::Status status = db_->Write(rocksdb::WriteOptions(), &batch);
+    if (!status.ok()) {
+        Logger::instance().error("RocksDB: Failed to store scores: " + status.ToString());
+        return false;
+    }
+    return true;
+}
+
+double RocksDBManager::get_page_rank(const std::string& url) {
+    if (!db_) return 0.0;
+
+    std::string value;
+    if (!db_->Get(rocksdb::ReadOptions(), make_page_rank_key(url), &value).ok()) {
+        return 0.0;
+    }
+    return std::strtod(value.c_str(), nullptr);
+}
+
 std::string RocksDBManager::get_stats() {
     std::ostringstream oss;
     oss << "RocksDB Statistics:\n";
@@ -242,6 +577,16 @@ void RocksDBManager::clear_all() {
     delete it;
 }
 
+std::string RocksDBManager::make_deferred_key(const std::string& host, int index) const {
+    std::ostringstream oss;
+    oss << "dqueue:item:" << host << "|" << std::setfill('0') << std::setw(12) << index;
+    return oss.str();
+}
+
+std::string RocksDBManager::make_deferred_tail_key(const std::string& host) const {
+    return "dqueue:tail:" + host;
+}
+
 std::string RocksDBManager::make_visited_key(const std::string& url) const {
     return "visited:" + url;
 }
@@ -250,6 +595,26 @@ std::string RocksDBManager::make_cache_key(const std::string& url) const {
     return "cache:" + url;
 }
 
+std::string RocksDBManager::make_validators_key(const std::string& url) const {
+    return "validators:" + url;
+}
+
+std::string RocksDBManager::make_extract_key(const std::string& url) const {
+    return "extract:" + url;
+}
+
+std::string RocksDBManager::make_template_key(const std::string& host) const {
+    return "template:" + host;
+}
+
+std::string RocksDBManager::make_robots_key(const std::string& host) const {
+    return "robots:" + host;
+}
+
+std::string RocksDBManager::make_dust_key(const std::string& host) const {
+    return "dust:" + host;
+}
+
 std::string RocksDBManager::make_priority_queue_key(int priority, int index) const {
     std::ostringstream oss;
     oss << "pqueue:item:" << std::setfill('0') << std::setw(4) << priority
@@ -270,3 +635,21 @@ std::string RocksDBManager::make_link_edge_key(const std::string& from_url, cons
 std::string RocksDBManager::make_link_prefix(const std::string& from_url) const {
     return "graph:" + from_url + "->";
 }
+
+std::string RocksDBManager::make_history_key(const std::string& url) const {
+    return "history:" + url;
+}
+
+std::string RocksDBManager::make_recrawl_key(int64_t due, const std::string& url) const {
+    std::ostringstream oss;
+    oss << "recrawl:" << std::setfill('0') << std::setw(12) << due << ":" << url;
+    return oss.str();
+}
+
+std::string RocksDBManager::make_page_rank_key(const std::string& url) const {
+    return "rank:" + url;
+}
+
+std::string RocksDBManager::make_host_rank_key(const std::string& host) const {
+    return "hostrank:" + host;
+}
@@ -0,0 +1,343 @@
+#include "selector_matcher.h"
+#include "logger.h"
+#include <gumbo.h>
+#include <cctype>
+#include <cstring>
+
+namespace {
+
+bool is_ident_char(char c) {
+    unsigned char uc = static_cast<unsigned char>(c);
+    return std::isalnum(uc) || c == '-' || c == '_' || uc >= 0x80;
+}
+
+bool is_selector_space(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f';
+}
+
+char lower(char c) {
+    return static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+}
+
+std::string read_ident(const std::string& text, size_t& pos) {
+    size_t start = pos;
+    while (pos < text.size() && is_ident_char(text[pos])) {
+        ++pos;
+    }
+    return text.substr(start, pos - start);
+}
+
+void skip_spaces(const std::string& text, size_t& pos) {
+    while (pos < text.size() && is_selector_space(text[pos])) {
+        ++pos;
+    }
+}
+
+std::string to_lower_copy(std::string value) {
+    for (char& c : value) {
+        c = lower(c);
+    }
+    return value;
+}
+
+// Compare needle against haystack[pos..]; needle is already lowercased when ignore_case
+bool equals_at(const char* haystack, size_t pos, const std::string& needle, bool ignore_case) {
+    for (size_t i = 0; i < needle.size(); ++i) {
+        char c = haystack[pos + i];
+        if ((ignore_case ? lower(c) : c) != needle[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Split a selector list on commas that are not inside brackets or quotes
+std::vector<std::string> split_selector_list(const std::string& list) {
+    std::vector<std::string> parts;
+    std::string current;
+    char quote = 0;
+    int bracket_depth = 0;
+    for (char c : list) {
+        if (quote) {
+            if (c == quote) {
+                quote = 0;
+            }
+        } else if (c == '"' || c == '\'') {
+            quote = c;
+        } else if (c == '[') {
+            ++bracket_depth;
+        } else if (c == ']' && bracket_depth > 0) {
+            --bracket_depth;
+        } else if (c == ',' && bracket_depth == 0) {
+            parts.push_back(current);
+            current.clear();
+            continue;
+        }
+        current += c;
+    }
+    parts.push_back(current);
+
+    for (auto& part : parts) {
+        size_t start = 0;
+        while (start < part.size() && is_selector_space(part[start])) {
+            ++start;
+        }
+        size_t end = part.size();
+        while (end > start && is_selector_space(part[end - 1])) {
+            --end;
+        }
+        part = part.substr(start, end - start);
+    }
+    return parts;
+}
+
+} // namespace
+
+SelectorMatcher::SelectorMatcher()
+    : tag_always_(GUMBO_TAG_LAST + 1, false),
+      by_tag_(GUMBO_TAG_LAST + 1) {
+}
+
+size_t SelectorMatcher::compile(const std::string& selector_list) {
+    selectors_.clear();
+    tag_always_.assign(GUMBO_TAG_LAST + 1, false);
+    by_tag_.assign(GUMBO_TAG_LAST + 1, {});
+    by_attribute_.clear();
+    universal_.clear();
+
+    for (const auto& text : split_selector_list(selector_list)) {
+        if (text.empty()) {
+            continue;
+        }
+        CompoundSelector selector;
+        if (!parse_compound(text, selector)) {
+            Logger::instance().warn("SelectorMatcher: Unsupported selector skipped: " + text);
+            continue;
+        }
+
+        size_t index = selectors_.size();
+        if (selector.tag >= 0 && selector.tag != GUMBO_TAG_UNKNOWN) {
+            if (selector.conditions.empty()) {
+                tag_always_[selector.tag] = true;
+            } else {
+                by_tag_[selector.tag].push_back(index);
+            }
+        } else if (selector.tag < 0 && !selector.conditions.empty()) {
+            // Every condition needs its attribute present, so the first one is a safe key
+            by_attribute_[selector.conditions.front().name].push_back(index);
+        } else {
+            universal_.push_back(index);
+        }
+        selectors_.push_back(std::move(selector));
+    }
+
+    return selectors_.size();
+}
+
+size_t SelectorMatcher::size() const {
+    return selectors_.size();
+}
+
+bool SelectorMatcher::parse_compound(const std::string& text, CompoundSelector& selector) const {
+    size_t pos = 0;
+    if (text[pos] == '*') {
+        ++pos;
+    } else if (is_ident_char(text[pos])) {
+        std::string name = to_lower_copy(read_ident(text, pos));
+        selector.tag = gumbo_tag_enum(name.c_str());
+        if (selector.tag == GUMBO_TAG_UNKNOWN) {
+            selector.unknown_tag = name;
+        }
+    }
+
+    while (pos < text.size()) {
+        char c = text[pos];
+        if (c == '.' || c == '#') {
+            ++pos;
+            AttrCondition condition;
+            condition.value = read_ident(text, pos);
+            if (condition.value.empty()) {
+                return false;
+            }
+            condition.name = c == '.' ? "class" : "id";
+            condition.op = c == '.' ? AttrOp::Word : AttrOp::Equals;
+            selector.conditions.push_back(std::move(condition));
+            continue;
+        }
+        if (c != '[') {
+            return false;  // Combinators and pseudo-classes are not supported
+        }
+
+        ++pos;
+        skip_spaces(text, pos);
+        AttrCondition condition;
+        condition.name = to_lower_copy(read_ident(text, pos));
+        if (condition.name.empty()) {
+            return false;
+        }
+        skip_spaces(text, pos);
+        if (pos < text.size() && text[pos] != ']') {
+            char op = text[pos];
+            if (op == '=') {
+                condition.op = AttrOp::Equals;
+                ++pos;
+            } else if (pos + 1 < text.size() && text[pos + 1] == '=') {
+                switch (op) {
+                    case '^': condition.op = AttrOp::Prefix; break;
+                    case '$': condition.op = AttrOp::Suffix; break;
+                    case '*': condition.op = AttrOp::Contains; break;
+                    case '~': condition.op = AttrOp::Word; break;
+                    default: return false;
+                }
+                pos += 2;
+            } else {
+                return false;
+            }
+
+            skip_spaces(text, pos);
+            if (pos < text.size() && (text[pos] == '"' || text[pos] == '\'')) {
+                char quote = text[pos++];
+                size_t end = text.find(quote, pos);
+                if (end == std::string::npos) {
+                    return false;
+                }
+                condition.value = text.substr(pos, end - pos);
+                pos = end + 1;
+            } else {
+                condition.value = read_ident(text, pos);
+            }
+
+            skip_spaces(text, pos);
+            if (pos < text.size() && (text[pos] == 'i' || text[pos] == 'I')) {
+                condition.ignore_case = true;
+                condition.value = to_lower_copy(condition.value);
+                ++pos;
+            } else if (pos < text.size() && (text[pos] == 's' || text[pos] == 'S')) {
+                ++pos;
+            }
+            skip_spaces(text, pos);
+        }
+        if (pos >= text.size() || text[pos] != ']') {
+            return false;
+        }
+        ++pos;
+        selector.conditions.push_back(std::move(condition));
+    }
+
+    return selector.tag >= 0 || !selector.conditions.empty() || text == "*";
+}
+
+bool SelectorMatcher::matches(const void* node_ptr) const {
+    if (!node_ptr || selectors_.empty()) return false;
+
+    const GumboNode* node = static_cast<const GumboNode*>(node_ptr);
+    if (node->type != GUMBO_NODE_ELEMENT) return false;
+
+    GumboTag tag = node->v.element.tag;
+    if (tag_always_[tag]) {
+        return true;
+    }
+    for (size_t index : by_tag_[tag]) {
+        if (evaluate(selectors_[index], node)) {
+            return true;
+        }
+    }
+
+    if (!by_attribute_.empty()) {
+        const GumboVector* attributes = &node->v.element.attributes;
+        for (unsigned int i = 0; i < attributes->length; ++i) {
+            const GumboAttribute* attribute = static_cast<const GumboAttribute*>(attributes->data[i]);
+            auto it = by_attribute_.find(attribute->name);
+            if (it == by_attribute_.end()) {
+                continue;
+            }
+            for (size_t index : it->second) {
+                if (evaluate(selectors_[index], node)) {
+                    return true;
+                }
+            }
+        }
+    }
+
+    for (size_t index : universal_) {
+        if (evaluate(selectors_[index], node)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool SelectorMatcher::evaluate(const CompoundSelector& selector, const void* node_ptr) const {
+    const GumboNode* node = static_cast<const GumboNode*>(node_ptr);
+
+    if (!selector.unknown_tag.empty()) {
+        // Custom elements: compare against the tag name as written in the source
+        const GumboStringPiece& original = node->v.element.original_tag;
+        if (node->v.element.tag != GUMBO_TAG_UNKNOWN || !original.data || original.length < 2) {
+            return false;
+        }
+        size_t length = 0;
+        const char* name = original.data + 1;
+        while (length + 1 < original.length && is_ident_char(name[length])) {
+            ++length;
+        }
+        if (length != selector.unknown_tag.size() || !equals_at(name, 0, selector.unknown_tag, true)) {
+            return false;
+        }
+    }
+
+    for (const auto& condition : selector.conditions) {
+        const GumboAttribute* attribute =
+            gumbo_get_attribute(&node->v.element.attributes, condition.name.c_str());
+        if (!attribute || !evaluate_condition(condition, attribute->value)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool SelectorMatcher::evaluate_condition(const AttrCondition& condition, const char* value) {
+    const std::string& needle = condition.value;
+    size_t length = std::strlen(value);
+
+    switch (condition.op) {
+        case AttrOp::Exists:
+            return true;
+        case AttrOp::Equals:
+            return length == needle.size() && equals_at(value, 0, needle, condition.ignore_case);
+        case AttrOp::Prefix:
+            return !needle.empty() && length >= needle.size() &&
+                   equals_at(value, 0, needle, condition.ignore_case);
+        case AttrOp::Suffix:
+            return !needle.empty() && length >= needle.size() &&
+                   equals_at(value, length - needle.size(), needle, condition.ignore_case);
+        case AttrOp::Contains:
+            if (needle.empty() || length < needle.size()) {
+                return false;
+            }
+            for (size_t pos = 0; pos + needle.size() <= length; ++pos) {
+                if (equals_at(value, pos, needle, condition.ignore_case)) {
+                    return true;
+                }
+            }
+            return false;
+        case AttrOp::Word: {
+            size_t pos = 0;
+            while (pos < length) {
+                while (pos < length && is_selector_space(value[pos])) {
+                    ++pos;
+                }
+                size_t start = pos;
+                while (pos < length && !is_selector_space(value[pos])) {
+                    ++pos;
+                }
+                if (pos - start == needle.size() && !needle.empty() &&
+                    equals_at(value, start, needle, condition.ignore_case)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,298 @@
+#include "sharded_dataset_sink.h"
+#include "logger.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <filesystem>
+#include <sstream>
+
+namespace {
+
+constexpr const char* kShardPrefix = "dataset-";
+constexpr const char* kJsonTrailer = "\n]\n";
+constexpr std::streamoff kJsonTrailerSize = 3;
+
+// Index of a dataset-NNNNN.* file name, -1 for anything else
+long shard_index(const std::string& filename) {
+    const std::string prefix = kShardPrefix;
+    if (filename.compare(0, prefix.size(), prefix) != 0) {
+        return -1;
+    }
+    size_t dot = filename.find('.', prefix.size());
+    if (dot == std::string::npos || dot == prefix.size()) {
+        return -1;
+    }
+    std::string digits = filename.substr(prefix.size(), dot - prefix.size());
+    if (!std::all_of(digits.begin(), digits.end(), [](unsigned char c) { return std::isdigit(c); })) {
+        return -1;
+    }
+    return std::stol(digits);
+}
+
+// Formats named in a comma-separated list such as "json,parquet"
+std::vector<std::string> split_formats(const std::string& formats) {
+    std::vector<std::string> names;
+    std::stringstream stream(formats);
+    std::string name;
+    while (std::getline(stream, name, ',')) {
+        name.erase(std::remove_if(name.begin(), name.end(), [](unsigned char c) { return std::isspace(c); }),
+                   name.end());
+        std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return std::tolower(c); });
+        if (!name.empty()) {
+            names.push_back(name);
+        }
+    }
+    return names;
+}
+
+} // namespace
+
+ShardedDatasetSink::ShardedDatasetSink(ShardedDatasetSinkConfig config)
+    : config_(std::move(config)),
+      write_json_(false),
+      write_csv_(false),
+      write_parquet_(false),
+      parquet_(config_.parquet) {
+    for (const auto& name : split_formats(config_.format)) {
+        if (name == "json") {
+            write_json_ = true;
+        } else if (name == "csv") {
+            write_csv_ = true;
+        } else if (name == "parquet") {
+            write_parquet_ = true;
+        } else if (name == "both") {
+            write_json_ = true;
+            write_csv_ = true;
+        } else {
+            log_warn("Unknown output format '" + name + "', ignored");
+        }
+    }
+    if (!write_json_ && !write_csv_ && !write_parquet_) {
+        log_warn("No known output format in '" + config_.format + "', writing JSON");
+        write_json_ = true;
+    }
+    config_.batch_size = std::max<size_t>(config_.batch_size, 1);
+
+    std::error_code ec;
+    std::filesystem::create_directories(config_.output_dir, ec);
+    if (ec) {
+        log_warn("Failed to create output directory " + config_.output_dir + ": " + ec.message());
+    }
+
+    // Continue numbering after the shards of earlier runs instead of overwriting them
+    for (const auto& entry : std::filesystem::directory_iterator(config_.output_dir, ec)) {
+        long index = shard_index(entry.path().filename().string());
+        if (index >= 0) {
+            next_shard_ = std::max(next_shard_, static_cast<size_t>(index) + 1);
+        }
+    }
+
+    writer_ = std::thread(&ShardedDatasetSink::writer_loop, this);
+}
+
+ShardedDatasetSink::~ShardedDatasetSink() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    queue_cv_.notify_all();
+    written_cv_.notify_all();
+    if (writer_.joinable()) {
+        writer_.join();
+    }
+}
+
+void ShardedDatasetSink::push(DataRecord record) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    // Backpressure: the crawl waits for the writer rather than queueing without bound
+    written_cv_.wait(lock, [this] { return stopping_ || queue_.size() < 2 * config_.batch_size; });
+    queue_.push_back(std::move(record));
+    bool batch_ready = queue_.size() >= config_.batch_size;
+    lock.unlock();
+    if (batch_ready) {
+        queue_cv_.notify_one();
+    }
+}
+
+void ShardedDatasetSink::flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    flush_requested_ = true;
+    queue_cv_.notify_one();
+    written_cv_.wait(lock, [this] { return queue_.empty() && in_flight_ == 0; });
+}
+
+size_t ShardedDatasetSink::records_written() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return records_written_;
+}
+
+size_t ShardedDatasetSink::shards_opened() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return shards_opened_;
+}
+
+void ShardedDatasetSink::writer_loop() {
+    while (true) {
+        std::vector<DataRecord> batch;
+        bool stopping = false;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            queue_cv_.wait_for(lock, config_.flush_interval, [this] {
+                return stopping_ || flush_requested_ || queue_.size() >= config_.batch_size;
+            });
+            stopping = stopping_;
+            if (queue_.empty()) {
+                flush_requested_ = false;
+            }
+            size_t count = std::min(queue_.size(), config_.batch_size);
+            batch.reserve(count);
+            for (size_t i = 0; i < count; ++i) {
+                batch.push_back(std::move(queue_.front()));
+                queue_.pop_front();
+            }
+            in_flight_ = count;
+        }
+
+        if (batch.empty()) {
+            if (stopping) {
+                break;
+            }
+            // An idle crawl still rotates on time
+            if (shard_open_ && shard_full()) {
+                close_shard();
+            }
+            continue;
+        }
+
+        written_cv_.notify_all();
+        bool written = write_batch(batch);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            in_flight_ = 0;
+            if (written) {
+                records_written_ += batch.size();
+            }
+        }
+        written_cv_.notify_all();
+    }
+    close_shard();
+}
+
+bool ShardedDatasetSink::write_batch(const std::vector<DataRecord>& batch) {
+    if (shard_open_ && shard_full()) {
+        close_shard();
+    }
+    if (!shard_open_ && !open_shard()) {
+        std::ostringstream error_msg;
+        error_msg << "Dropped " << batch.size() << " records: no dataset shard could be opened";
+        log_error(error_msg.str());
+        return false;
+    }
+
+    if (write_json_) {
+        // Overwrite the previous batch's closing bracket, so the shard is a
+        // complete array again once this batch is written
+        if (shard_records_ > 0) {
+            json_.seekp(-kJsonTrailerSize, std::ios::end);
+        }
+        formatter_.write_json_rows(json_, batch, shard_records_ == 0);
+        json_ << kJsonTrailer;
+        json_.flush();
+    }
+    if (write_csv_) {
+        formatter_.write_csv_rows(csv_, batch);
+        csv_.flush();
+    }
+    bool parquet_ok = !write_parquet_ || parquet_.write(batch);
+    shard_records_ += batch.size();
+
+    if ((write_json_ && !json_) || (write_csv_ && !csv_) || !parquet_ok) {
+        log_error("Failed to write dataset shard " + shard_path(next_shard_ - 1, shard_extension()));
+        close_shard();
+        return false;
+    }
+    return true;
+}
+
+bool ShardedDatasetSink::shard_full() {
+    size_t bytes = 0;
+    if (write_json_) {
+        bytes += static_cast<size_t>(std::max<std::streamoff>(json_.tellp(), 0));
+    }
+    if (write_csv_) {
+        bytes += static_cast<size_t>(std::max<std::streamoff>(csv_.tellp(), 0));
+    }
+    if (write_parquet_) {
+        bytes += parquet_.bytes_written();
+    }
+    return bytes >= config_.max_shard_bytes ||
+           std::chrono::steady_clock::now() - shard_opened_at_ >= config_.max_shard_age;
+}
+
+bool ShardedDatasetSink::open_shard() {
+    size_t index = next_shard_++;
+    if (write_json_) {
+        std::string path = shard_path(index, "json");
+        json_.open(path, std::ios::out | std::ios::trunc);
+        if (!json_.is_open()) {
+            log_error("Failed to open JSON file: " + path);
+            return false;
+        }
+        json_ << "[\n";
+    }
+    if (write_csv_) {
+        std::string path = shard_path(index, "csv");
+        csv_.open(path, std::ios::out | std::ios::trunc);
+        if (!csv_.is_open()) {
+            log_error("Failed to open CSV file: " + path);
+            json_.close();
+            return false;
+        }
+        formatter_.write_csv_header(csv_);
+    }
+    if (write_parquet_ && !parquet_.open(shard_path(index, "parquet"))) {
+        json_.close();
+        csv_.close();
+        return false;
+    }
+
+    shard_open_ = true;
+    shard_records_ = 0;
+    shard_opened_at_ = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(mutex_);
+    shards_opened_++;
+    return true;
+}
+
+void ShardedDatasetSink::close_shard() {
+    if (!shard_open_) {
+        return;
+    }
+    json_.close();
+    json_.clear();
+    csv_.close();
+    csv_.clear();
+    if (write_parquet_ && parquet_.is_open() && !parquet_.close()) {
+        log_error("Failed to finish Parquet shard " + shard_path(next_shard_ - 1, "parquet"));
+    }
+    shard_open_ = false;
+
+    std::ostringstream msg;
+    msg << "Closed dataset shard with " << shard_records_ << " records: "
+        << shard_path(next_shard_ - 1, shard_extension());
+    log_info(msg.str());
+}
+
+std::string ShardedDatasetSink::shard_path(size_t index, const std::string& extension) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%s%05zu.", kShardPrefix, index);
+    return config_.output_dir + "/" + name + extension;
+}
+
+std::string ShardedDatasetSink::shard_extension() const {
+    if (write_json_) {
+        return "json";
+    }
+    return write_csv_ ? "csv" : "parquet";
+}
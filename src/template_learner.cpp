@@ -0,0 +1,333 @@
+#include "template_learner.h"
+#include "logger.h"
+#include <gumbo.h>
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+namespace {
+
+constexpr uint64_t kFnvOffset = 1469598103934665603ULL;
+constexpr uint64_t kFnvPrime = 1099511628211ULL;
+constexpr size_t kMaxOrdinalSignatures = 32;
+
+uint64_t hash_bytes(uint64_t hash, const char* data, size_t length) {
+    for (size_t i = 0; i < length; ++i) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= kFnvPrime;
+    }
+    return hash;
+}
+
+uint64_t hash_value(uint64_t hash, uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        hash ^= (value >> (i * 8)) & 0xff;
+        hash *= kFnvPrime;
+    }
+    return hash;
+}
+
+// Tag, id and class: what a stylesheet would use to address the element
+uint64_t element_signature(const GumboNode* node) {
+    uint64_t hash = hash_value(kFnvOffset, static_cast<uint64_t>(node->v.element.tag));
+    const char* names[] = {"id", "class"};
+    for (const char* name : names) {
+        const GumboAttribute* attr = gumbo_get_attribute(&node->v.element.attributes, name);
+        hash = hash_value(hash, attr ? 1 : 0);
+        if (attr) {
+            hash = hash_bytes(hash, attr->value, std::strlen(attr->value));
+        }
+    }
+    return hash;
+}
+
+// Call fn(child, path) for every child; element paths combine the parent
+// path, the element signature and its ordinal among same-signature siblings.
+// Non-element children get path 0.
+template <typename Fn>
+void for_each_child_path(const GumboNode* node, uint64_t path, Fn&& fn) {
+    std::vector<std::pair<uint64_t, uint32_t>> ordinals;
+    const GumboVector* children = &node->v.element.children;
+    for (unsigned int i = 0; i < children->length; ++i) {
+        const GumboNode* child = static_cast<const GumboNode*>(children->data[i]);
+        if (child->type != GUMBO_NODE_ELEMENT) {
+            fn(child, 0);
+            continue;
+        }
+        uint64_t signature = element_signature(child);
+        uint32_t ordinal = 0;
+        bool found = false;
+        for (auto& seen : ordinals) {
+            if (seen.first == signature) {
+                ordinal = ++seen.second;
+                found = true;
+                break;
+            }
+        }
+        // Very wide sibling lists share ordinal 0 past the first few signatures
+        if (!found && ordinals.size() < kMaxOrdinalSignatures) {
+            ordinals.emplace_back(signature, 0);
+        }
+        fn(child, hash_value(hash_value(path, signature), ordinal));
+    }
+}
+
+// Text under a node outside the `skip` subtrees, counted until it exceeds `limit`
+size_t text_length(const GumboNode* node, const std::unordered_set<const void*>& skip, size_t limit) {
+    if (node->type == GUMBO_NODE_TEXT || node->type == GUMBO_NODE_CDATA) {
+        return std::strlen(node->v.text.text);
+    }
+    if (node->type != GUMBO_NODE_ELEMENT || skip.count(node)) {
+        return 0;
+    }
+    size_t total = 0;
+    const GumboVector* children = &node->v.element.children;
+    for (unsigned int i = 0; i < children->length && total <= limit; ++i) {
+        total += text_length(static_cast<const GumboNode*>(children->data[i]), skip, limit - total);
+    }
+    return total;
+}
+
+int64_t unix_now() {
+    return std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+TemplateLearner::TemplateLearner(size_t max_hosts)
+    : max_hosts_(max_hosts > 0 ? max_hosts : 1),
+      min_share_(0.8),
+      learning_pages_(20),
+      relearn_pages_(5000),
+      relearn_age_(std::chrono::hours(24 * 7)) {
+}
+
+void TemplateLearner::set_min_share(double share) {
+    min_share_ = share;
+}
+
+void TemplateLearner::set_learning_pages(size_t pages) {
+    learning_pages_ = pages;
+}
+
+void TemplateLearner::set_relearn_after(size_t pages, std::chrono::seconds age) {
+    relearn_pages_ = pages;
+    relearn_age_ = age;
+}
+
+void TemplateLearner::set_persistence(Loader loader, Saver saver) {
+    loader_ = std::move(loader);
+    saver_ = std::move(saver);
+}
+
+size_t TemplateLearner::process_page(const std::string& host, const void* body,
+                                     std::unordered_set<const void*>& skipped) {
+    if (host.empty() || !body) return 0;
+
+    const GumboNode* node = static_cast<const GumboNode*>(body);
+    if (node->type != GUMBO_NODE_ELEMENT) return 0;
+
+    HostTemplate& entry = lookup(host);
+    if (entry.frozen && expired(entry)) {
+        relearn(host, entry, "template expired");
+    }
+    if (entry.frozen) {
+        ++entry.pages_applied;
+    } else {
+        bool has_text = false;
+        observe(node, kFnvOffset, 0, entry, has_text);
+        ++entry.pages_seen;
+        rebuild_template(entry);
+
+        if (entry.pages_seen >= learning_pages_) {
+            entry.frozen = true;
+            entry.learned_at = unix_now();
+            std::unordered_map<uint64_t, SubtreeStat>().swap(entry.stats);
+            Logger::instance().info("TemplateLearner: Learned " + std::to_string(entry.template_paths.size()) +
+                                    " template subtrees for " + host);
+            save(host, entry);
+        }
+    }
+
+    if (entry.template_paths.empty()) {
+        return 0;
+    }
+    std::vector<const void*> found;
+    mark(node, kFnvOffset, 0, entry, found);
+
+    // Never let the template take most of the page: extract it in full instead
+    std::unordered_set<const void*> found_set(found.begin(), found.end());
+    size_t template_text = 0;
+    for (const void* root : found) {
+        template_text += text_length(static_cast<const GumboNode*>(root), {}, SIZE_MAX);
+    }
+    if (template_text > 0 && text_length(node, found_set, template_text) <= template_text) {
+        if (entry.frozen && ++entry.refusals >= kMaxRefusals) {
+            relearn(host, entry, "template covered most of the text of recent pages");
+        }
+        return 0;
+    }
+    entry.refusals = 0;
+    skipped.insert(found.begin(), found.end());
+    return found.size();
+}
+
+size_t TemplateLearner::template_size(const std::string& host) const {
+    auto it = hosts_.find(host);
+    return it != hosts_.end() ? it->second.template_paths.size() : 0;
+}
+
+TemplateLearner::HostTemplate& TemplateLearner::lookup(const std::string& host) {
+    auto it = hosts_.find(host);
+    if (it != hosts_.end()) {
+        lru_.splice(lru_.begin(), lru_, it->second.lru_position);
+        return it->second;
+    }
+
+    // Finished templates were saved when frozen; a host still learning
+    // starts over if it comes back
+    if (hosts_.size() >= max_hosts_) {
+        hosts_.erase(lru_.back());
+        lru_.pop_back();
+    }
+
+    lru_.push_front(host);
+    HostTemplate& entry = hosts_[host];
+    entry.lru_position = lru_.begin();
+
+    if (loader_) {
+        std::string data = loader_(host);
+        if (!data.empty() && !deserialize(data, entry)) {
+            Logger::instance().warn("TemplateLearner: Ignoring corrupt template for " + host);
+        }
+    }
+    return entry;
+}
+
+void TemplateLearner::save(const std::string& host, const HostTemplate& entry) {
+    if (saver_) {
+        saver_(host, serialize(entry));
+    }
+}
+
+void TemplateLearner::relearn(const std::string& host, HostTemplate& entry, const char* reason) {
+    Logger::instance().info("TemplateLearner: Relearning the template for " + host + " (" + reason + ")");
+    auto position = entry.lru_position;
+    entry = HostTemplate();
+    entry.lru_position = position;
+    // Drop the stored template too, so a restart does not bring it back
+    if (saver_) {
+        saver_(host, "");
+    }
+}
+
+bool TemplateLearner::expired(const HostTemplate& entry) const {
+    return entry.pages_applied >= relearn_pages_ ||
+           unix_now() - entry.learned_at >= static_cast<int64_t>(relearn_age_.count());
+}
+
+void TemplateLearner::rebuild_template(HostTemplate& entry) {
+    entry.template_paths.clear();
+    if (entry.pages_seen < kMinPages) {
+        return;
+    }
+    double needed = min_share_ * static_cast<double>(entry.pages_seen);
+    for (const auto& [path, stat] : entry.stats) {
+        if (stat.hits >= needed) {
+            entry.template_paths.insert(path);
+        }
+    }
+}
+
+uint64_t TemplateLearner::observe(const void* node_ptr, uint64_t path, int depth,
+                                  HostTemplate& entry, bool& has_text) {
+    const GumboNode* node = static_cast<const GumboNode*>(node_ptr);
+
+    if (node->type == GUMBO_NODE_TEXT || node->type == GUMBO_NODE_CDATA) {
+        const char* text = node->v.text.text;
+        size_t length = std::strlen(text);
+        has_text = has_text || length > 0;
+        return hash_bytes(kFnvOffset, text, length);
+    }
+    if (node->type != GUMBO_NODE_ELEMENT) {
+        return 0;
+    }
+
+    // Content hash: tag plus the content hashes of all children, in order
+    uint64_t hash = hash_value(kFnvOffset, static_cast<uint64_t>(node->v.element.tag));
+    bool subtree_text = false;
+    for_each_child_path(node, path, [&](const GumboNode* child, uint64_t child_path) {
+        hash = hash_value(hash, observe(child, child_path, depth + 1, entry, subtree_text));
+    });
+    has_text = has_text || subtree_text;
+
+    if (depth >= 1 && depth <= kMaxDepth && subtree_text) {
+        auto it = entry.stats.find(path);
+        if (it == entry.stats.end()) {
+            if (entry.stats.size() < kMaxSubtreesPerHost) {
+                entry.stats.emplace(path, SubtreeStat{hash, 1, 0});
+            }
+        } else if (it->second.content_hash == hash) {
+            ++it->second.hits;
+        } else if (++it->second.misses > it->second.hits) {
+            // The content at this position changes more often than not
+            it->second = SubtreeStat{hash, 1, 0};
+        }
+    }
+    return hash;
+}
+
+void TemplateLearner::mark(const void* node_ptr, uint64_t path, int depth, const HostTemplate& entry,
+                           std::vector<const void*>& found) const {
+    for_each_child_path(static_cast<const GumboNode*>(node_ptr), path,
+                        [&](const GumboNode* child, uint64_t child_path) {
+        if (child->type != GUMBO_NODE_ELEMENT) {
+            return;
+        }
+        if (entry.template_paths.count(child_path)) {
+            found.push_back(child);
+        } else if (depth + 1 < kMaxDepth) {
+            mark(child, child_path, depth + 1, entry, found);
+        }
+    });
+}
+
+// "v2 <pages> <learned at> <hex paths...>"; the older "<pages> <hex paths...>"
+// form has no learning time and is relearned on first use
+std::string TemplateLearner::serialize(const HostTemplate& entry) {
+    std::ostringstream oss;
+    oss << "v2 " << entry.pages_seen << ' ' << entry.learned_at << std::hex;
+    for (uint64_t path : entry.template_paths) {
+        oss << ' ' << path;
+    }
+    return oss.str();
+}
+
+bool TemplateLearner::deserialize(const std::string& data, HostTemplate& entry) {
+    std::istringstream iss(data);
+    size_t pages_seen = 0;
+    int64_t learned_at = 0;
+    bool versioned = data.compare(0, 3, "v2 ") == 0;
+    if (versioned) {
+        iss.ignore(3);
+    }
+    if (!(iss >> pages_seen) || (versioned && !(iss >> learned_at))) {
+        return false;
+    }
+    std::unordered_set<uint64_t> paths;
+    uint64_t path = 0;
+    while (iss >> std::hex >> path) {
+        paths.insert(path);
+    }
+    if (!iss.eof()) {
+        return false;
+    }
+    entry.pages_seen = pages_seen;
+    entry.learned_at = learned_at;
+    entry.template_paths = std::move(paths);
+    entry.frozen = true;
+    return true;
+}
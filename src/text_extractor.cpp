@@ -1,12 +1,484 @@
 #include "text_extractor.h"
+#include "code_language_detector.h"
 #include "logger.h"
 #include <gumbo.h>
-#include <regex>
 #include <algorithm>
-#include <sstream>
 #include <cctype>
+#include <cstring>
+#include <utility>
 
-TextExtractor::TextExtractor() {
+namespace {
+
+bool is_html_space(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f';
+}
+
+void trim_in_place(std::string& value) {
+    size_t end = value.size();
+    while (end > 0 && is_html_space(value[end - 1])) {
+        --end;
+    }
+    size_t start = 0;
+    while (start < end && is_html_space(value[start])) {
+        ++start;
+    }
+    value.erase(end);
+    value.erase(0, start);
+}
+
+// Lowercased host[:port] of an absolute URL, "" if there is none
+std::string host_of(const std::string& url) {
+    size_t start = url.find("://");
+    if (start == std::string::npos) {
+        return "";
+    }
+    start += 3;
+    size_t end = url.find_first_of("/?#", start);
+    std::string host = url.substr(start, end == std::string::npos ? std::string::npos : end - start);
+    size_t at = host.rfind('@');
+    if (at != std::string::npos) {
+        host.erase(0, at + 1);
+    }
+    for (char& c : host) {
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    return host;
+}
+
+} // namespace
+
+/**
+ * Append-only output for a single DOM traversal.
+ *
+ * Markdown and plain text are written side by side: markup goes to the
+ * markdown channel only, text goes to both. Whitespace is collapsed as it is
+ * appended, so nothing is ever re-scanned or re-copied.
+ */
+class MarkdownBuilder {
+public:
+    explicit MarkdownBuilder(size_t reserve_hint) {
+        markdown_.out.reserve(reserve_hint);
+        plain_.out.reserve(reserve_hint);
+    }
+
+    // Text node content; runs of whitespace collapse to a single space.
+    void text(const char* data, size_t length) {
+        size_t i = 0;
+        while (i < length) {
+            if (is_html_space(data[i])) {
+                markdown_.pending_space = true;
+                plain_.pending_space = true;
+                ++i;
+                continue;
+            }
+            size_t run_end = i;
+            while (run_end < length && !is_html_space(data[run_end])) {
+                ++run_end;
+            }
+            markdown_.flush_space(quote_depth_);
+            plain_.flush_space(0);
+            markdown_.append(data + i, run_end - i, quote_depth_);
+            plain_.append(data + i, run_end - i, 0);
+            i = run_end;
+        }
+    }
+
+    // Opening markup such as "**" or "[": a pending space goes before it.
+    void open_inline(const char* markup) {
+        markdown_.flush_space(quote_depth_);
+        plain_.flush_space(0);
+        markdown_.append(markup, std::strlen(markup), quote_depth_);
+    }
+
+    // Closing markup such as "**": a pending space stays after it.
+    void close_inline(const char* markup) {
+        close_inline(markup, std::strlen(markup));
+    }
+
+    void close_inline(const char* markup, size_t length) {
+        markdown_.append(markup, length, quote_depth_);
+    }
+
+    // Fenced code block; the body is kept verbatim and left out of plain text.
+    void code_block(const std::string& language, const std::string& code) {
+        ensure_line_start();
+        markdown_.append("```", 3, quote_depth_);
+        markdown_.append(language.data(), language.size(), quote_depth_);
+        markdown_.append("\n", 1, quote_depth_);
+        markdown_.append(code.data(), code.size(), quote_depth_);
+        markdown_.append("\n```\n", 5, quote_depth_);
+        plain_.newline(0);
+    }
+
+    // End of a block element; never more than one blank line in a row.
+    void newline() {
+        markdown_.newline(quote_depth_);
+        plain_.newline(0);
+    }
+
+    void ensure_line_start() {
+        if (!markdown_.at_line_start()) {
+            markdown_.newline(quote_depth_);
+        }
+        if (!plain_.at_line_start()) {
+            plain_.newline(0);
+        }
+    }
+
+    void begin_quote() {
+        ensure_line_start();
+        ++quote_depth_;
+    }
+
+    void end_quote() {
+        if (quote_depth_ > 0) {
+            --quote_depth_;
+        }
+    }
+
+    std::string take_markdown() {
+        trim_in_place(markdown_.out);
+        return std::move(markdown_.out);
+    }
+
+    std::string take_plain() {
+        trim_in_place(plain_.out);
+        return std::move(plain_.out);
+    }
+
+private:
+    struct Channel {
+        std::string out;
+        int trailing_newlines = 0;
+        bool pending_space = false;
+
+        bool at_line_start() const {
+            return out.empty() || out.back() == '\n';
+        }
+
+        void flush_space(int quote_depth) {
+            if (pending_space && !at_line_start() && out.back() != ' ') {
+                append(" ", 1, quote_depth);
+            }
+            pending_space = false;
+        }
+
+        void newline(int quote_depth) {
+            pending_space = false;
+            if (out.empty() || trailing_newlines >= 2) {
+                return;
+            }
+            if (quote_depth > 0 && at_line_start()) {
+                return;  // Empty lines would split the blockquote
+            }
+            out.push_back('\n');
+            ++trailing_newlines;
+        }
+
+        void append(const char* data, size_t length, int quote_depth) {
+            if (length == 0) {
+                return;
+            }
+            if (quote_depth == 0) {
+                out.append(data, length);
+                size_t newlines = 0;
+                while (newlines < length && data[length - 1 - newlines] == '\n') {
+                    ++newlines;
+                }
+                trailing_newlines = newlines == length
+                    ? trailing_newlines + static_cast<int>(newlines)
+                    : static_cast<int>(newlines);
+                return;
+            }
+            // Inside blockquotes every non-empty line gets a "> " prefix per level
+            for (size_t i = 0; i < length; ++i) {
+                char c = data[i];
+                if (at_line_start()) {
+                    if (c == '\n') {
+                        continue;
+                    }
+                    for (int level = 0; level < quote_depth; ++level) {
+                        out.append("> ", 2);
+                    }
+                }
+                out.push_back(c);
+                trailing_newlines = c == '\n' ? trailing_newlines + 1 : 0;
+            }
+        }
+    };
+
+    Channel markdown_;
+    Channel plain_;
+    int quote_depth_ = 0;
+};
+
+namespace {
+
+// Class/id fragments that mark boilerplate or article containers
+const char* const kNegativeHints[] = {
+    "comment", "footer", "footnote", "masthead", "sidebar", "sponsor", "promo",
+    "related", "share", "social", "widget", "advert", "banner", "breadcrumb",
+    "cookie", "popup", "menu", "nav", "pagination", "subscribe", "newsletter",
+    "outbrain", "taboola"
+};
+const char* const kPositiveHints[] = {
+    "article", "content", "entry", "main", "post", "story", "text", "body", "blog"
+};
+
+bool is_block_tag(GumboTag tag) {
+    switch (tag) {
+        case GUMBO_TAG_P: case GUMBO_TAG_DIV: case GUMBO_TAG_SECTION:
+        case GUMBO_TAG_ARTICLE: case GUMBO_TAG_MAIN: case GUMBO_TAG_ASIDE:
+        case GUMBO_TAG_UL: case GUMBO_TAG_OL: case GUMBO_TAG_TABLE:
+        case GUMBO_TAG_PRE: case GUMBO_TAG_BLOCKQUOTE: case GUMBO_TAG_FORM:
+        case GUMBO_TAG_H1: case GUMBO_TAG_H2: case GUMBO_TAG_H3:
+        case GUMBO_TAG_H4: case GUMBO_TAG_H5: case GUMBO_TAG_H6:
+            return true;
+        default:
+            return false;
+    }
+}
+
+int tag_hint(GumboTag tag) {
+    switch (tag) {
+        case GUMBO_TAG_ARTICLE: case GUMBO_TAG_MAIN: return 10;
+        case GUMBO_TAG_DIV: return 5;
+        case GUMBO_TAG_PRE: case GUMBO_TAG_TD: case GUMBO_TAG_BLOCKQUOTE: return 3;
+        case GUMBO_TAG_OL: case GUMBO_TAG_UL: case GUMBO_TAG_DL: case GUMBO_TAG_DD:
+        case GUMBO_TAG_DT: case GUMBO_TAG_LI: case GUMBO_TAG_FORM: return -3;
+        case GUMBO_TAG_H1: case GUMBO_TAG_H2: case GUMBO_TAG_H3: case GUMBO_TAG_H4:
+        case GUMBO_TAG_H5: case GUMBO_TAG_H6: case GUMBO_TAG_TH: return -5;
+        default: return 0;
+    }
+}
+
+/**
+ * Readability-style main-content detection in one post-order pass.
+ *
+ * Every paragraph-like block with enough text adds a score to its parent
+ * and half of it to its grandparent. Candidates start from a tag hint plus
+ * a class/id hint and are finally scaled by (1 - link density). Subtrees
+ * that are boilerplate by their class/id, or mostly links, are pruned so
+ * they neither score nor get emitted.
+ */
+class MainContentScorer {
+public:
+    MainContentScorer(const SelectorMatcher& removed, const std::unordered_set<const void*>& skipped)
+        : removed_(removed), skipped_(skipped), pruned_(nullptr) {
+    }
+
+    /**
+     * @param pruned Receives the subtrees to skip when emitting
+     * @return Elements to emit in document order; empty if nothing scored
+     */
+    std::vector<GumboNode*> select(GumboNode* body, std::unordered_set<const void*>& pruned) {
+        pruned_ = &pruned;
+        visit(body, false);
+
+        GumboNode* best = nullptr;
+        double best_score = 0.0;
+        for (GumboNode* node : order_) {
+            double score = final_score(node);
+            if (score > best_score && !is_pruned(node)) {
+                best = node;
+                best_score = score;
+            }
+        }
+        if (!best) {
+            return {};
+        }
+
+        // Articles split across sibling containers are kept together
+        std::vector<GumboNode*> selected;
+        GumboNode* parent = best->parent;
+        if (!parent || parent->type != GUMBO_NODE_ELEMENT || best == body) {
+            selected.push_back(best);
+            return selected;
+        }
+        double threshold = std::max(10.0, best_score * 0.2);
+        GumboVector* siblings = &parent->v.element.children;
+        for (unsigned int i = 0; i < siblings->length; ++i) {
+            GumboNode* sibling = static_cast<GumboNode*>(siblings->data[i]);
+            if (sibling == best ||
+                (candidates_.count(sibling) && !is_pruned(sibling) &&
+                 final_score(sibling) >= threshold)) {
+                selected.push_back(sibling);
+            }
+        }
+        return selected;
+    }
+
+private:
+    struct Stats {
+        size_t text_chars = 0;
+        size_t link_chars = 0;
+        size_t commas = 0;
+        bool has_block = false;
+    };
+
+    struct Candidate {
+        double score = 0.0;
+        size_t text_chars = 0;
+        size_t link_chars = 0;
+    };
+
+    Stats visit(GumboNode* node, bool in_link) {
+        Stats stats;
+        if (node->type == GUMBO_NODE_TEXT || node->type == GUMBO_NODE_CDATA) {
+            for (const char* p = node->v.text.text; *p; ++p) {
+                if (!is_html_space(*p)) {
+                    ++stats.text_chars;
+                    stats.commas += *p == ',';
+                }
+            }
+            if (in_link) {
+                stats.link_chars = stats.text_chars;
+            }
+            return stats;
+        }
+        if (node->type != GUMBO_NODE_ELEMENT || skipped_.count(node) || removed_.matches(node)) {
+            return stats;
+        }
+
+        GumboTag tag = node->v.element.tag;
+        ancestors_.push_back(node);
+        GumboVector* children = &node->v.element.children;
+        for (unsigned int i = 0; i < children->length; ++i) {
+            GumboNode* child = static_cast<GumboNode*>(children->data[i]);
+            Stats child_stats = visit(child, in_link || tag == GUMBO_TAG_A);
+            stats.text_chars += child_stats.text_chars;
+            stats.link_chars += child_stats.link_chars;
+            stats.commas += child_stats.commas;
+            if (child->type == GUMBO_NODE_ELEMENT && is_block_tag(child->v.element.tag)) {
+                stats.has_block = true;
+            }
+        }
+        ancestors_.pop_back();
+
+        double link_density = stats.text_chars
+            ? static_cast<double>(stats.link_chars) / stats.text_chars : 0.0;
+        bool container = tag == GUMBO_TAG_DIV || tag == GUMBO_TAG_SECTION ||
+                         tag == GUMBO_TAG_ASIDE || tag == GUMBO_TAG_UL ||
+                         tag == GUMBO_TAG_OL || tag == GUMBO_TAG_TABLE;
+        if (tag != GUMBO_TAG_BODY && tag != GUMBO_TAG_HTML &&
+            (class_weight(node) < 0 || (container && link_density > 0.5))) {
+            pruned_->insert(node);
+            return Stats();
+        }
+
+        bool paragraph = tag == GUMBO_TAG_P || tag == GUMBO_TAG_PRE ||
+                         tag == GUMBO_TAG_TD || tag == GUMBO_TAG_BLOCKQUOTE ||
+                         (tag == GUMBO_TAG_DIV && !stats.has_block);
+        if (paragraph && stats.text_chars >= 25 && !ancestors_.empty()) {
+            double score = 1.0 + stats.commas +
+                           std::min(static_cast<double>(stats.text_chars / 100), 3.0);
+            candidate(ancestors_.back()).score += score;
+            if (ancestors_.size() > 1) {
+                candidate(ancestors_[ancestors_.size() - 2]).score += score / 2;
+            }
+        }
+
+        auto it = candidates_.find(node);
+        if (it != candidates_.end()) {
+            it->second.text_chars = stats.text_chars;
+            it->second.link_chars = stats.link_chars;
+        }
+        return stats;
+    }
+
+    Candidate& candidate(GumboNode* node) {
+        auto inserted = candidates_.try_emplace(node);
+        if (inserted.second) {
+            inserted.first->second.score = tag_hint(node->v.element.tag) + class_weight(node);
+            order_.push_back(node);
+        }
+        return inserted.first->second;
+    }
+
+    double final_score(GumboNode* node) const {
+        const Candidate& c = candidates_.at(node);
+        double link_density = c.text_chars
+            ? static_cast<double>(c.link_chars) / c.text_chars : 0.0;
+        return c.score * (1.0 - link_density);
+    }
+
+    // Candidates created inside a subtree that was pruned afterwards
+    bool is_pruned(GumboNode* node) const {
+        for (GumboNode* n = node; n; n = n->parent) {
+            if (pruned_->count(n)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    int class_weight(GumboNode* node) {
+        // Lowercased class and id values, split into words on spaces, '-' and '_'
+        hints_.clear();
+        const char* names[] = {"class", "id"};
+        for (const char* name : names) {
+            GumboAttribute* attr = gumbo_get_attribute(&node->v.element.attributes, name);
+            if (attr) {
+                for (const char* p = attr->value; *p; ++p) {
+                    char c = *p == '-' || *p == '_' || is_html_space(*p)
+                        ? ' ' : static_cast<char>(std::tolower(static_cast<unsigned char>(*p)));
+                    hints_ += c;
+                }
+                hints_ += ' ';
+            }
+        }
+        if (hints_.empty()) {
+            return 0;
+        }
+
+        int weight = 0;
+        for (const char* hint : kNegativeHints) {
+            if (has_hint_word(hint)) {
+                weight -= 25;
+                break;
+            }
+        }
+        for (const char* hint : kPositiveHints) {
+            if (has_hint_word(hint)) {
+                weight += 25;
+                break;
+            }
+        }
+        return weight;
+    }
+
+    // Whole words only, so "nav" does not match "canvas"; a plural ("comments") counts
+    bool has_hint_word(std::string_view hint) const {
+        size_t pos = 0;
+        while (pos < hints_.size()) {
+            size_t end = hints_.find(' ', pos);
+            if (end == std::string::npos) {
+                end = hints_.size();
+            }
+            std::string_view word(hints_.data() + pos, end - pos);
+            if (word == hint || (word.size() == hint.size() + 1 && word.back() == 's' &&
+                                 word.compare(0, hint.size(), hint) == 0)) {
+                return true;
+            }
+            pos = end + 1;
+        }
+        return false;
+    }
+
+    const SelectorMatcher& removed_;
+    const std::unordered_set<const void*>& skipped_;  // Already excluded, e.g. templates
+    std::unordered_set<const void*>* pruned_;
+    std::vector<GumboNode*> ancestors_;
+    std::unordered_map<const GumboNode*, Candidate> candidates_;
+    std::vector<GumboNode*> order_;  // Candidates in creation order, for stable ties
+    std::string hints_;
+};
+
+} // namespace
+
+TextExtractor::TextExtractor()
+    : extraction_mode_(ExtractionMode::FullPage),
+      template_learning_(false) {
     // Default selectors to remove
     set_remove_selectors("nav, footer, script, style, noscript, svg, "
         "img[src^='data:'], "
@@ -14,7 +486,10 @@ TextExtractor::TextExtractor() {
         "[role=\"banner\"], "
         "[role=\"dialog\"], "
         "[role=\"alertdialog\"], "
+        "[role=\"presentation\"], "
+        "[role=\"none\"], "
         "[role=\"region\"][aria-label*=\"skip\" i], "
+        "[aria-label*=\"skip\"], "
         "[aria-modal=\"true\"]");
 }
 
@@ -22,28 +497,31 @@ TextExtractor::~TextExtractor() {
 }
 
 void TextExtractor::set_remove_selectors(const std::string& selectors) {
-    remove_selectors_.clear();
-    
-    // Parse comma-separated selectors
-    std::istringstream iss(selectors);
-    std::string selector;
-    
-    while (std::getline(iss, selector, ',')) {
-        // Trim whitespace
-        selector.erase(0, selector.find_first_not_of(" \t\n\r"));
-        selector.erase(selector.find_last_not_of(" \t\n\r") + 1);
-        
-        if (!selector.empty()) {
-            remove_selectors_.push_back(selector);
-        }
-    }
+    remove_selectors_.compile(selectors);
+}
+
+void TextExtractor::set_extraction_mode(ExtractionMode mode) {
+    extraction_mode_ = mode;
+}
+
+ExtractionMode TextExtractor::get_extraction_mode() const {
+    return extraction_mode_;
+}
+
+void TextExtractor::enable_template_learning(bool enable, double min_share) {
+    template_learning_ = enable;
+    template_learner_.set_min_share(min_share);
+}
+
+void TextExtractor::set_template_persistence(TemplateLearner::Loader loader, TemplateLearner::Saver saver) {
+    template_learner_.set_persistence(std::move(loader), std::move(saver));
 }
 
-TextExtraction TextExtractor::extract_from_html(const std::string& html, const std::string& url) {
+TextExtraction TextExtractor::extract_from_html(std::string_view html, const std::string& url) {
     TextExtraction result;
     
     // Parse HTML with Gumbo
-    GumboOutput* output = gumbo_parse(html.c_str());
+    GumboOutput* output = gumbo_parse_with_options(&kGumboDefaultOptions, html.data(), html.size());
     if (!output) {
         Logger::instance().error("TextExtractor: Failed to parse HTML");
         return result;
@@ -87,21 +565,39 @@ TextExtraction TextExtractor::extract_from_html(const std::string& html, const s
     }
     
     if (body_node) {
-        bool in_code = false;
-        result.text = extract_text_recursive(body_node, in_code);
-        result.plain_text = result.text;
+        // Subtrees repeated across the host's pages are skipped, not traversed
+        if (template_learning_) {
+            template_learner_.process_page(host_of(url), body_node, pruned_nodes_);
+        }
         
-        // Remove markdown formatting from plain text
-        std::regex md_regex(R"(#+\s|```[\s\S]*?```|\*\*|__|\*|_|`|>|-)");
-        result.plain_text = std::regex_replace(result.plain_text, md_regex, "");
+        std::vector<GumboNode*> roots;
+        if (extraction_mode_ == ExtractionMode::MainContent) {
+            std::unordered_set<const void*> boilerplate;
+            roots = MainContentScorer(remove_selectors_, pruned_nodes_).select(body_node, boilerplate);
+            pruned_nodes_.insert(boilerplate.begin(), boilerplate.end());
+        }
+        if (roots.empty()) {
+            roots.push_back(body_node);
+        }
         
-        // Clean up extra whitespace
-        result.plain_text = normalize_text(result.plain_text);
+        // Markdown and plain text are produced by the same traversal
+        MarkdownBuilder builder(html.size() / 2);
+        for (GumboNode* root : roots) {
+            extract_text_recursive(root, builder);
+            builder.newline();
+        }
+        result.text = builder.take_markdown();
+        result.plain_text = builder.take_plain();
         
         // Extract code blocks
-        extract_code_blocks(body_node, result.code_blocks);
+        for (GumboNode* root : roots) {
+            extract_code_blocks(root, result.code_blocks);
+        }
     }
     
+    // Cached entries are keyed by node address and die with the tree
+    language_cache_.clear();
+    pruned_nodes_.clear();
     gumbo_destroy_output(&kGumboDefaultOptions, output);
     
     Logger::instance().info("TextExtractor: Extracted text from HTML: " + 
@@ -110,63 +606,86 @@ TextExtraction TextExtractor::extract_from_html(const std::string& html, const s
     return result;
 }
 
-std::string TextExtractor::extract_text_recursive(void* node_ptr, bool& in_code) {
-    if (!node_ptr) return "";
+void TextExtractor::extract_text_recursive(void* node_ptr, MarkdownBuilder& out) {
+    if (!node_ptr) return;
     
     GumboNode* node = static_cast<GumboNode*>(node_ptr);
-    std::string result;
     
-    if (node->type == GUMBO_NODE_TEXT) {
-        std::string text = node->v.text.text;
-        text = normalize_text(text);
-        return text;
+    if (node->type == GUMBO_NODE_TEXT || node->type == GUMBO_NODE_WHITESPACE ||
+        node->type == GUMBO_NODE_CDATA) {
+        const char* text = node->v.text.text;
+        out.text(text, std::strlen(text));
+        return;
     }
     
     if (node->type != GUMBO_NODE_ELEMENT) {
-        return "";
+        return;
     }
     
     // Check if element should be removed
     if (should_remove_element(node)) {
-        return "";
+        return;
     }
     
-    // Handle specific tags
     GumboTag tag = node->v.element.tag;
     
-    // Heading tags -> markdown
-    if (tag == GUMBO_TAG_H1) {
-        result += "# ";
-    } else if (tag == GUMBO_TAG_H2) {
-        result += "## ";
-    } else if (tag == GUMBO_TAG_H3) {
-        result += "### ";
-    } else if (tag == GUMBO_TAG_H4) {
-        result += "#### ";
-    } else if (tag == GUMBO_TAG_H5) {
-        result += "##### ";
-    } else if (tag == GUMBO_TAG_H6) {
-        result += "###### ";
+    // Code blocks are emitted verbatim; markup inside <pre> is only highlighting
+    if (tag == GUMBO_TAG_PRE) {
+        std::string code;
+        append_element_text(node, code);
+        trim_in_place(code);
+        out.code_block(detect_language_cached(node, code), code);
+        return;
     }
     
-    // Code blocks
-    if (tag == GUMBO_TAG_PRE || tag == GUMBO_TAG_CODE) {
-        in_code = true;
+    // Pre-order: opening markup
+    GumboAttribute* href_attr = nullptr;
+    switch (tag) {
+        case GUMBO_TAG_H1: out.ensure_line_start(); out.open_inline("# "); break;
+        case GUMBO_TAG_H2: out.ensure_line_start(); out.open_inline("## "); break;
+        case GUMBO_TAG_H3: out.ensure_line_start(); out.open_inline("### "); break;
+        case GUMBO_TAG_H4: out.ensure_line_start(); out.open_inline("#### "); break;
+        case GUMBO_TAG_H5: out.ensure_line_start(); out.open_inline("##### "); break;
+        case GUMBO_TAG_H6: out.ensure_line_start(); out.open_inline("###### "); break;
+        case GUMBO_TAG_LI: out.ensure_line_start(); out.open_inline("- "); break;
+        case GUMBO_TAG_BLOCKQUOTE: out.begin_quote(); break;
+        case GUMBO_TAG_STRONG:
+        case GUMBO_TAG_B: out.open_inline("**"); break;
+        case GUMBO_TAG_EM:
+        case GUMBO_TAG_I: out.open_inline("*"); break;
+        case GUMBO_TAG_CODE: out.open_inline("`"); break;
+        case GUMBO_TAG_A:
+            href_attr = gumbo_get_attribute(&node->v.element.attributes, "href");
+            if (href_attr) {
+                out.open_inline("[");
+            }
+            break;
+        default:
+            break;
     }
     
     // Process children
     GumboVector* children = &node->v.element.children;
     for (unsigned int i = 0; i < children->length; i++) {
-        std::string child_text = extract_text_recursive(children->data[i], in_code);
-        result += child_text;
+        extract_text_recursive(children->data[i], out);
     }
     
-    if (tag == GUMBO_TAG_PRE || tag == GUMBO_TAG_CODE) {
-        in_code = false;
-        
-        // Try to detect language
-        std::string language = detect_language(result);
-        result = "```" + language + "\n" + result + "\n```\n";
+    // Post-order: closing markup
+    switch (tag) {
+        case GUMBO_TAG_STRONG:
+        case GUMBO_TAG_B: out.close_inline("**"); break;
+        case GUMBO_TAG_EM:
+        case GUMBO_TAG_I: out.close_inline("*"); break;
+        case GUMBO_TAG_CODE: out.close_inline("`"); break;
+        case GUMBO_TAG_A:
+            if (href_attr) {
+                out.close_inline("](");
+                out.close_inline(href_attr->value);
+                out.close_inline(")");
+            }
+            break;
+        default:
+            break;
     }
     
     // Add line breaks for block elements
@@ -174,148 +693,31 @@ std::string TextExtractor::extract_text_recursive(void* node_ptr, bool& in_code)
         tag == GUMBO_TAG_H1 || tag == GUMBO_TAG_H2 || tag == GUMBO_TAG_H3 ||
         tag == GUMBO_TAG_H4 || tag == GUMBO_TAG_H5 || tag == GUMBO_TAG_H6 ||
         tag == GUMBO_TAG_LI || tag == GUMBO_TAG_BLOCKQUOTE) {
-        result += "\n";
-    }
-    
-    // Lists
-    if (tag == GUMBO_TAG_LI) {
-        result = "- " + result;
-    }
-    
-    // Bold/Strong
-    if (tag == GUMBO_TAG_STRONG || tag == GUMBO_TAG_B) {
-        result = "**" + result + "**";
-    }
-    
-    // Italic/Em
-    if (tag == GUMBO_TAG_EM || tag == GUMBO_TAG_I) {
-        result = "*" + result + "*";
+        out.newline();
     }
     
-    // Inline code
-    if (tag == GUMBO_TAG_CODE && !in_code) {
-        result = "`" + result + "`";
-    }
-    
-    // Links
-    if (tag == GUMBO_TAG_A) {
-        GumboAttribute* href_attr = gumbo_get_attribute(&node->v.element.attributes, "href");
-        if (href_attr) {
-            result = "[" + result + "](" + href_attr->value + ")";
-        }
-    }
-    
-    // Blockquotes
     if (tag == GUMBO_TAG_BLOCKQUOTE) {
-        // Add quote prefix to each line
-        std::istringstream iss(result);
-        std::string line;
-        std::string quoted;
-        while (std::getline(iss, line)) {
-            if (!line.empty()) {
-                quoted += "> " + line + "\n";
-            }
-        }
-        result = quoted;
+        out.end_quote();
     }
-    
-    return result;
 }
 
 std::string TextExtractor::detect_language(const std::string& code_snippet) {
-    std::string trimmed = code_snippet;
-    trimmed.erase(0, trimmed.find_first_not_of(" \t\n\r"));
-    trimmed.erase(trimmed.find_last_not_of(" \t\n\r") + 1);
-    
-    // Check for common language indicators
-    std::vector<std::pair<std::string, std::string>> patterns = {
-        {"function\\s+\\w+\\s*\\(", "js"},
-        {"const\\s+\\w+\\s*=", "js"},
-        {"let\\s+\\w+\\s*=", "js"},
-        {"import\\s+\\{", "js"},
-        {"<?php", "php"},
-        {"class\\s+\\w+\\s*:", "python"},
-        {"def\\s+\\w+\\s*\\(", "python"},
-        {"import\\s+\\w+", "python"},
-        {"#include\\s*<", "cpp"},
-        {"#include\\s+\"", "cpp"},
-        {"pub\\s+fn\\s+", "rust"},
-        {"fn\\s+\\w+\\s*\\(", "rust"},
-        {"func\\s+\\w+\\s*\\(", "go"},
-        {"package\\s+", "go"},
-        {"struct\\s+\\w+\\s*\\{", "go"},
-        {"CREATE\\s+TABLE", "sql"},
-        {"SELECT\\s+\\*?\\s+FROM", "sql"},
-        {"<html>|<!DOCTYPE", "html"},
-        {"\\.css|@media", "css"},
-        {"\\$\\(\\w+\\)|#!/bin/bash", "bash"},
-    };
-    
-    for (const auto& [pattern, lang] : patterns) {
-        std::regex re(pattern, std::regex::icase);
-        if (std::regex_search(trimmed, re)) {
-            return lang;
-        }
-    }
-    
-    return "";  // No language detected
+    return CodeLanguageDetector::default_detector().detect(code_snippet);
 }
 
-std::string TextExtractor::normalize_text(const std::string& text) {
-    std::string result = text;
-    
-    // Replace multiple spaces with single space
-    std::regex space_regex("  +");
-    result = std::regex_replace(result, space_regex, " ");
-    
-    // Replace multiple newlines with double newline
-    std::regex newline_regex("\\n{3,}");
-    result = std::regex_replace(result, newline_regex, "\n\n");
-    
-    // Trim leading/trailing whitespace
-    result.erase(0, result.find_first_not_of(" \t\n\r"));
-    result.erase(result.find_last_not_of(" \t\n\r") + 1);
-    
-    return result;
+const std::string& TextExtractor::detect_language_cached(void* node, const std::string& code_snippet) {
+    auto it = language_cache_.find(node);
+    if (it == language_cache_.end()) {
+        it = language_cache_.emplace(node, detect_language(code_snippet)).first;
+    }
+    return it->second;
 }
 
 bool TextExtractor::should_remove_element(void* node_ptr) {
-    if (!node_ptr) return false;
-    
-    GumboNode* node = static_cast<GumboNode*>(node_ptr);
-    
-    // Always remove script and style tags
-    if (node->v.element.tag == GUMBO_TAG_SCRIPT || 
-        node->v.element.tag == GUMBO_TAG_STYLE ||
-        node->v.element.tag == GUMBO_TAG_NOSCRIPT ||
-        node->v.element.tag == GUMBO_TAG_NAV ||
-        node->v.element.tag == GUMBO_TAG_FOOTER) {
-        return true;
-    }
-    
-    // Check role attribute
-    GumboAttribute* role_attr = gumbo_get_attribute(&node->v.element.attributes, "role");
-    if (role_attr) {
-        std::string role = role_attr->value;
-        if (role == "alert" || role == "banner" || role == "dialog" || 
-            role == "alertdialog" || role == "presentation" || role == "none") {
-            return true;
-        }
-    }
-    
-    // Check aria-modal attribute
-    GumboAttribute* modal_attr = gumbo_get_attribute(&node->v.element.attributes, "aria-modal");
-    if (modal_attr && std::string(modal_attr->value) == "true") {
+    if (!pruned_nodes_.empty() && pruned_nodes_.count(node_ptr)) {
         return true;
     }
-    
-    // Check for skip regions
-    GumboAttribute* aria_label = gumbo_get_attribute(&node->v.element.attributes, "aria-label");
-    if (aria_label && std::string(aria_label->value).find("skip") != std::string::npos) {
-        return true;
-    }
-    
-    return false;
+    return remove_selectors_.matches(node_ptr);
 }
 
 std::string TextExtractor::get_element_tag(void* node_ptr) {
@@ -327,23 +729,23 @@ std::string TextExtractor::get_element_tag(void* node_ptr) {
     return gumbo_normalized_tagname(node->v.element.tag);
 }
 
-std::string TextExtractor::get_element_text(void* node_ptr) {
-    if (!node_ptr) return "";
+void TextExtractor::append_element_text(void* node_ptr, std::string& out) {
+    if (!node_ptr) return;
     
     GumboNode* node = static_cast<GumboNode*>(node_ptr);
     
-    if (node->type == GUMBO_NODE_TEXT) {
-        return node->v.text.text;
+    if (node->type == GUMBO_NODE_TEXT || node->type == GUMBO_NODE_WHITESPACE ||
+        node->type == GUMBO_NODE_CDATA) {
+        out += node->v.text.text;
+        return;
     }
     
-    std::string result;
-    GumboVector* children = &node->v.element.children;
+    if (node->type != GUMBO_NODE_ELEMENT) return;
     
+    GumboVector* children = &node->v.element.children;
     for (unsigned int i = 0; i < children->length; i++) {
-        result += get_element_text(children->data[i]);
+        append_element_text(children->data[i], out);
     }
-    
-    return result;
 }
 
 bool TextExtractor::is_code_element(void* node_ptr) {
@@ -362,18 +764,27 @@ void TextExtractor::extract_code_blocks(void* node_ptr, std::vector<std::string>
     GumboNode* node = static_cast<GumboNode*>(node_ptr);
     
     if (node->type == GUMBO_NODE_ELEMENT) {
+        if (!pruned_nodes_.empty() && pruned_nodes_.count(node)) {
+            return;
+        }
         GumboTag tag = node->v.element.tag;
         
-        // Found code block
+        // Found code block; a <code> inside <pre> is the same block, so the
+        // subtree is not searched again
         if (tag == GUMBO_TAG_PRE || tag == GUMBO_TAG_CODE) {
-            std::string code_text = get_element_text(node);
-            code_text = normalize_text(code_text);
+            std::string code_text;
+            append_element_text(node, code_text);
+            trim_in_place(code_text);
             
             if (!code_text.empty()) {
-                std::string language = detect_language(code_text);
-                std::string code_with_lang = "```" + language + "\n" + code_text + "\n```";
-                code_blocks.push_back(code_with_lang);
+                const std::string& language = detect_language_cached(node, code_text);
+                std::string code_with_lang;
+                code_with_lang.reserve(language.size() + code_text.size() + 8);
+                code_with_lang.append("```").append(language).append("\n")
+                              .append(code_text).append("\n```");
+                code_blocks.push_back(std::move(code_with_lang));
             }
+            return;
         }
         
         // Recursively process children
@@ -0,0 +1,221 @@
+#include "trap_detector.h"
+#include "logger.h"
+#include <algorithm>
+#include <bitset>
+#include <sstream>
+#include <string_view>
+
+namespace {
+
+constexpr uint64_t kFnvOffset = 1469598103934665603ULL;
+constexpr uint64_t kFnvPrime = 1099511628211ULL;
+constexpr size_t kMaxParamsPerPrefix = 64;
+constexpr size_t kMaxFingerprintsPerPrefix = 32;
+constexpr int kSameContentBits = 3;  // SimHash distance for "same page"
+
+uint64_t hash_value(std::string_view data) {
+    uint64_t hash = kFnvOffset;
+    for (char c : data) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= kFnvPrime;
+    }
+    return hash;
+}
+
+std::vector<std::string_view> split(std::string_view text, char separator) {
+    std::vector<std::string_view> pieces;
+    size_t start = 0;
+    while (start <= text.size()) {
+        size_t end = text.find(separator, start);
+        if (end == std::string_view::npos) end = text.size();
+        if (end > start) {
+            pieces.push_back(text.substr(start, end - start));
+        }
+        start = end + 1;
+    }
+    return pieces;
+}
+
+} // namespace
+
+TrapDetector::TrapDetector(const TrapLimits& limits, size_t max_prefixes)
+    : limits_(limits),
+      max_prefixes_(max_prefixes > 0 ? max_prefixes : 1) {
+}
+
+void TrapDetector::set_limits(const TrapLimits& limits) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    limits_ = limits;
+}
+
+TrapVerdict TrapDetector::check(const Url& url) {
+    if (!url.valid()) {
+        return TrapVerdict::Allow;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // Shape of the URL itself: endless nesting and repeating segments
+    std::vector<std::string_view> segments = split(url.path(), '/');
+    std::string shape_reason;
+    if (segments.size() > limits_.max_path_depth) {
+        shape_reason = "path depth " + std::to_string(segments.size());
+    } else {
+        for (size_t i = 0; i < segments.size() && shape_reason.empty(); ++i) {
+            size_t repeats = static_cast<size_t>(std::count(segments.begin() + i, segments.end(), segments[i]));
+            if (repeats > limits_.max_segment_repeats) {
+                shape_reason = "segment '" + std::string(segments[i]) + "' repeated " + std::to_string(repeats) + " times";
+            }
+        }
+    }
+
+    std::string prefix = prefix_of(url);
+    PrefixStats& stats = lookup(prefix);
+
+    if (!shape_reason.empty()) {
+        if (!stats.shape_reported) {
+            stats.shape_reported = true;
+            Logger::instance().warn("TrapDetector: Blocking " + url.str() + " (" + shape_reason + ")");
+        }
+        return TrapVerdict::Block;
+    }
+    if (stats.state == PrefixState::Blocked) {
+        return TrapVerdict::Block;
+    }
+    ++stats.discovered;
+
+    // Parameter cardinality: faceted search and calendars mint new values forever
+    if (stats.state == PrefixState::Normal) {
+        for (std::string_view param : split(url.query(), '&')) {
+            size_t equals = param.find('=');
+            std::string name(param.substr(0, equals));
+            if (equals == std::string_view::npos) continue;
+            auto it = stats.param_values.find(name);
+            if (it == stats.param_values.end()) {
+                if (stats.param_values.size() >= kMaxParamsPerPrefix) continue;
+                it = stats.param_values.emplace(name, std::unordered_set<uint64_t>()).first;
+            }
+            it->second.insert(hash_value(param.substr(equals + 1)));
+            if (it->second.size() > limits_.max_param_values) {
+                flag(prefix, stats, PrefixState::Throttled,
+                     "parameter '" + name + "' has more than " + std::to_string(limits_.max_param_values) + " values");
+                break;
+            }
+        }
+    }
+
+    // Discovery outrunning content: a generator of URLs rather than of pages
+    if (stats.state == PrefixState::Normal && stats.fetched >= limits_.min_fetches_for_ratio &&
+        static_cast<double>(stats.discovered) >
+            limits_.max_discovered_per_unique * static_cast<double>(std::max<size_t>(stats.unique, 1))) {
+        std::ostringstream reason;
+        reason << stats.discovered << " URLs discovered for " << stats.unique << " pages with unique content";
+        flag(prefix, stats, PrefixState::Throttled, reason.str());
+    }
+
+    if (stats.state == PrefixState::Throttled && !take_throttle_slot(stats)) {
+        return TrapVerdict::Throttle;
+    }
+    return TrapVerdict::Allow;
+}
+
+bool TrapDetector::record_fetch(const Url& url, uint64_t fingerprint) {
+    if (!url.valid()) {
+        return true;
+    }
+    std::string prefix = prefix_of(url);
+    uint64_t url_hash = hash_value(url.str());
+    std::lock_guard<std::mutex> lock(mutex_);
+    PrefixStats& stats = lookup(prefix);
+
+    // Compared with other URLs only, so an unchanged page refetched later is still unique
+    bool unique_content = true;
+    auto own = stats.recent.end();
+    for (auto it = stats.recent.begin(); it != stats.recent.end(); ++it) {
+        if (it->first == url_hash) {
+            own = it;
+        } else if (static_cast<int>(std::bitset<64>(it->second ^ fingerprint).count()) <= kSameContentBits) {
+            unique_content = false;
+        }
+    }
+    if (own != stats.recent.end()) {
+        stats.recent.erase(own);
+    } else if (stats.recent.size() >= kMaxFingerprintsPerPrefix) {
+        stats.recent.erase(stats.recent.begin());
+    }
+    stats.recent.emplace_back(url_hash, fingerprint);
+
+    ++stats.fetched;
+    if (unique_content) {
+        ++stats.unique;
+    }
+
+    if (stats.state != PrefixState::Blocked && stats.fetched >= limits_.min_fetches_for_ratio &&
+        static_cast<double>(stats.unique) < limits_.min_unique_ratio * static_cast<double>(stats.fetched)) {
+        std::ostringstream reason;
+        reason << "only " << stats.unique << " of " << stats.fetched << " fetched pages have unique content";
+        flag(prefix, stats, PrefixState::Blocked, reason.str());
+    }
+    return unique_content;
+}
+
+std::vector<std::string> TrapDetector::flagged_prefixes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return flagged_;
+}
+
+TrapDetector::PrefixStats& TrapDetector::lookup(const std::string& prefix) {
+    auto it = prefixes_.find(prefix);
+    if (it != prefixes_.end()) {
+        lru_.splice(lru_.begin(), lru_, it->second.lru_position);
+        return it->second;
+    }
+
+    if (prefixes_.size() >= max_prefixes_) {
+        prefixes_.erase(lru_.back());
+        lru_.pop_back();
+    }
+
+    lru_.push_front(prefix);
+    PrefixStats& stats = prefixes_[prefix];
+    stats.lru_position = lru_.begin();
+    return stats;
+}
+
+void TrapDetector::flag(const std::string& prefix, PrefixStats& stats, PrefixState state, const std::string& reason) {
+    stats.state = state;
+    stats.reason = reason;
+    stats.param_values.clear();  // No longer needed once flagged
+    if (state == PrefixState::Blocked) {
+        stats.recent.clear();
+    }
+    stats.window_start = std::chrono::steady_clock::now();
+    stats.window_count = 0;
+
+    const char* action = state == PrefixState::Blocked ? "blocked" : "throttled";
+    flagged_.push_back(prefix + " (" + action + ": " + reason + ")");
+    Logger::instance().warn("TrapDetector: " + flagged_.back());
+}
+
+bool TrapDetector::take_throttle_slot(PrefixStats& stats) {
+    auto now = std::chrono::steady_clock::now();
+    if (now - stats.window_start >= std::chrono::minutes(1)) {
+        stats.window_start = now;
+        stats.window_count = 0;
+    }
+    if (stats.window_count >= limits_.throttled_urls_per_minute) {
+        return false;
+    }
+    ++stats.window_count;
+    return true;
+}
+
+std::string TrapDetector::prefix_of(const Url& url) {
+    std::string_view path = url.path();
+    size_t start = path.empty() || path[0] != '/' ? 0 : 1;
+    size_t end = path.find('/', start);
+    if (end == std::string_view::npos) end = path.size();
+    std::string prefix(url.host());
+    prefix.push_back('/');
+    prefix.append(path.substr(start, end - start));
+    return prefix;
+}
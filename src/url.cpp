@@ -0,0 +1,339 @@
+#include "url.h"
+#include <cctype>
+
+namespace {
+
+bool is_scheme_char(char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '+' || c == '-' || c == '.';
+}
+
+bool is_unreserved(char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '-' || c == '.' || c == '_' || c == '~';
+}
+
+int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+bool equals_ignore_case(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (std::tolower(static_cast<unsigned char>(a[i])) != std::tolower(static_cast<unsigned char>(b[i]))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+Url::Url()
+    : spec_(),
+      parts_() {
+}
+
+Url Url::parse(std::string spec) {
+    Url url;
+    url.spec_ = std::move(spec);
+    url.parts_ = split(url.spec_);
+    return url;
+}
+
+Url::Parts Url::split(std::string_view spec) {
+    Parts parts;
+    size_t pos = 0;
+
+    // scheme ":"
+    if (!spec.empty() && std::isalpha(static_cast<unsigned char>(spec[0]))) {
+        size_t end = 1;
+        while (end < spec.size() && is_scheme_char(spec[end])) {
+            ++end;
+        }
+        if (end < spec.size() && spec[end] == ':') {
+            parts.has_scheme = true;
+            parts.scheme_end = end;
+            pos = end + 1;
+        }
+    }
+
+    // "//" [userinfo "@"] host [":" port]
+    if (spec.compare(pos, 2, "//") == 0) {
+        parts.has_authority = true;
+        size_t begin = pos + 2;
+        size_t end = spec.find_first_of("/?#", begin);
+        if (end == std::string_view::npos) end = spec.size();
+
+        size_t at = spec.substr(begin, end - begin).rfind('@');
+        parts.authority_begin = at == std::string_view::npos ? begin : begin + at + 1;
+        parts.authority_end = end;
+        parts.port_begin = end;
+
+        size_t host_begin = parts.authority_begin;
+        if (host_begin < end && spec[host_begin] == '[') {
+            size_t close = spec.find(']', host_begin);
+            if (close == std::string_view::npos || close > end) close = end;
+            parts.host_begin = host_begin + 1;
+            parts.host_end = close;
+            if (close + 1 < end && spec[close + 1] == ':') {
+                parts.port_begin = close + 2;
+            }
+        } else {
+            size_t colon = spec.substr(host_begin, end - host_begin).find(':');
+            parts.host_begin = host_begin;
+            parts.host_end = colon == std::string_view::npos ? end : host_begin + colon;
+            if (colon != std::string_view::npos) {
+                parts.port_begin = host_begin + colon + 1;
+            }
+        }
+        pos = end;
+    }
+
+    // path ["?" query] ["#" fragment]
+    parts.path_begin = pos;
+    parts.path_end = spec.find_first_of("?#", pos);
+    if (parts.path_end == std::string_view::npos) parts.path_end = spec.size();
+
+    parts.query_end = parts.path_end;
+    if (parts.path_end < spec.size() && spec[parts.path_end] == '?') {
+        parts.has_query = true;
+        parts.query_end = spec.find('#', parts.path_end + 1);
+        if (parts.query_end == std::string_view::npos) parts.query_end = spec.size();
+    }
+    parts.has_fragment = parts.query_end < spec.size();
+    return parts;
+}
+
+Url Url::resolve(const Url& base, std::string_view reference) {
+    Parts ref = split(reference);
+    std::string_view ref_path = reference.substr(ref.path_begin, ref.path_end - ref.path_begin);
+    std::string_view ref_query = reference.substr(ref.path_end, ref.query_end - ref.path_end);  // With '?'
+    std::string_view base_path = base.path();
+
+    std::string out;
+    out.reserve(base.spec_.size() + reference.size());
+    size_t path_begin = 0;
+
+    if (ref.has_scheme) {
+        out.append(reference.substr(0, ref.path_begin));
+        path_begin = out.size();
+        out.append(ref_path);
+    } else {
+        out.append(base.spec_, 0, base.parts_.has_scheme ? base.parts_.scheme_end + 1 : 0);
+        if (ref.has_authority) {
+            out.append(reference.substr(0, ref.path_begin));
+            path_begin = out.size();
+            out.append(ref_path);
+        } else {
+            size_t authority_start = base.parts_.has_scheme ? base.parts_.scheme_end + 1 : 0;
+            out.append(base.spec_, authority_start, base.parts_.path_begin - authority_start);
+            path_begin = out.size();
+            if (ref_path.empty()) {
+                out.append(base_path);
+                if (!ref.has_query) {
+                    ref_query = std::string_view(base.spec_).substr(
+                        base.parts_.path_end, base.parts_.query_end - base.parts_.path_end);
+                }
+            } else if (ref_path[0] == '/') {
+                out.append(ref_path);
+            } else {
+                // Merge with the directory of the base path
+                size_t last_slash = base_path.rfind('/');
+                if (last_slash == std::string_view::npos) {
+                    if (base.parts_.has_authority) out.push_back('/');
+                } else {
+                    out.append(base_path.substr(0, last_slash + 1));
+                }
+                out.append(ref_path);
+            }
+        }
+    }
+
+    remove_dot_segments(out, path_begin, out.size());
+    out.append(ref_query);
+    return parse(std::move(out));
+}
+
+void Url::remove_dot_segments(std::string& buffer, size_t path_begin, size_t path_end) {
+    if (path_begin >= path_end || buffer[path_begin] != '/') {
+        return;
+    }
+
+    // Output never outgrows input, so segments are copied down in place
+    size_t read = path_begin;
+    size_t write = path_begin;
+    while (read < path_end) {
+        size_t segment_begin = read + 1;
+        size_t segment_end = buffer.find('/', segment_begin);
+        if (segment_end == std::string::npos || segment_end > path_end) segment_end = path_end;
+        size_t length = segment_end - segment_begin;
+        bool dot = length == 1 && buffer[segment_begin] == '.';
+        bool dot_dot = length == 2 && buffer[segment_begin] == '.' && buffer[segment_begin + 1] == '.';
+
+        if (dot || dot_dot) {
+            if (dot_dot) {
+                while (write > path_begin && buffer[--write] != '/') {
+                }
+            }
+            if (segment_end == path_end) {
+                buffer[write++] = '/';
+            }
+        } else {
+            while (read < segment_end) {
+                buffer[write++] = buffer[read++];
+            }
+        }
+        read = segment_end;
+    }
+    buffer.erase(write, path_end - write);
+}
+
+void Url::normalize_percent_encoding(std::string& buffer, size_t begin, size_t end) {
+    size_t write = begin;
+    for (size_t read = begin; read < end; ++read) {
+        if (buffer[read] == '%' && read + 2 < end) {
+            int high = hex_value(buffer[read + 1]);
+            int low = hex_value(buffer[read + 2]);
+            if (high >= 0 && low >= 0) {
+                char decoded = static_cast<char>(high * 16 + low);
+                if (is_unreserved(decoded)) {
+                    buffer[write++] = decoded;
+                } else {
+                    buffer[write++] = '%';
+                    buffer[write++] = static_cast<char>(std::toupper(static_cast<unsigned char>(buffer[read + 1])));
+                    buffer[write++] = static_cast<char>(std::toupper(static_cast<unsigned char>(buffer[read + 2])));
+                }
+                read += 2;
+                continue;
+            }
+        }
+        buffer[write++] = buffer[read];
+    }
+    buffer.erase(write, end - write);
+}
+
+bool Url::valid() const {
+    return parts_.has_scheme && parts_.has_authority && parts_.host_end > parts_.host_begin;
+}
+
+bool Url::is_http() const {
+    std::string_view s = scheme();
+    return equals_ignore_case(s, "http") || equals_ignore_case(s, "https");
+}
+
+std::string_view Url::scheme() const {
+    if (!parts_.has_scheme) return {};
+    return std::string_view(spec_).substr(0, parts_.scheme_end);
+}
+
+std::string_view Url::authority() const {
+    if (!parts_.has_authority) return {};
+    return std::string_view(spec_).substr(parts_.authority_begin, parts_.authority_end - parts_.authority_begin);
+}
+
+std::string_view Url::host() const {
+    if (!parts_.has_authority) return {};
+    return std::string_view(spec_).substr(parts_.host_begin, parts_.host_end - parts_.host_begin);
+}
+
+std::string_view Url::port_text() const {
+    if (!parts_.has_authority) return {};
+    return std::string_view(spec_).substr(parts_.port_begin, parts_.authority_end - parts_.port_begin);
+}
+
+int Url::port() const {
+    std::string_view text = port_text();
+    if (!text.empty() && text.size() <= 5) {
+        int value = 0;
+        bool digits = true;
+        for (char c : text) {
+            if (c < '0' || c > '9') {
+                digits = false;
+                break;
+            }
+            value = value * 10 + (c - '0');
+        }
+        if (digits && value > 0 && value <= 65535) {
+            return value;
+        }
+    }
+    if (equals_ignore_case(scheme(), "https")) return 443;
+    if (equals_ignore_case(scheme(), "http")) return 80;
+    return 0;
+}
+
+std::string_view Url::path() const {
+    return std::string_view(spec_).substr(parts_.path_begin, parts_.path_end - parts_.path_begin);
+}
+
+std::string_view Url::query() const {
+    if (!parts_.has_query) return {};
+    return std::string_view(spec_).substr(parts_.path_end + 1, parts_.query_end - parts_.path_end - 1);
+}
+
+bool Url::has_query() const {
+    return parts_.has_query;
+}
+
+std::string_view Url::fragment() const {
+    if (!parts_.has_fragment) return {};
+    return std::string_view(spec_).substr(parts_.query_end + 1);
+}
+
+std::string Url::request_target() const {
+    std::string target(path());
+    if (target.empty()) {
+        target = "/";
+    }
+    if (parts_.has_query) {
+        target.push_back('?');
+        target.append(query());
+    }
+    return target;
+}
+
+void Url::normalize() {
+    for (size_t i = 0; i < parts_.path_begin; ++i) {
+        spec_[i] = static_cast<char>(std::tolower(static_cast<unsigned char>(spec_[i])));
+    }
+    if (parts_.has_fragment) {
+        spec_.resize(parts_.query_end);
+    }
+
+    // Default or empty port
+    if (parts_.has_authority && parts_.port_begin > parts_.host_end &&
+        spec_[parts_.port_begin - 1] == ':') {
+        std::string_view port = port_text();
+        std::string_view scheme_name = scheme();
+        if (port.empty() || (scheme_name == "http" && port == "80") ||
+            (scheme_name == "https" && port == "443")) {
+            spec_.erase(parts_.port_begin - 1, parts_.authority_end - parts_.port_begin + 1);
+        }
+    }
+    parts_ = split(spec_);
+
+    normalize_percent_encoding(spec_, parts_.path_begin, spec_.size());
+    parts_ = split(spec_);
+    remove_dot_segments(spec_, parts_.path_begin, parts_.path_end);
+    parts_ = split(spec_);
+
+    if (parts_.has_authority && parts_.path_end == parts_.path_begin) {
+        spec_.insert(parts_.path_begin, 1, '/');
+    } else if (!parts_.has_query && parts_.path_end - parts_.path_begin > 1 && spec_.back() == '/') {
+        spec_.pop_back();
+    }
+    parts_ = split(spec_);
+}
+
+const std::string& Url::str() const {
+    return spec_;
+}
+
+std::string Url::release() {
+    std::string spec = std::move(spec_);
+    spec_.clear();
+    parts_ = Parts();
+    return spec;
+}
@@ -0,0 +1,178 @@
+#include "url_canonicalizer.h"
+#include <algorithm>
+#include <cctype>
+
+namespace {
+
+char lower(char c) {
+    return static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+}
+
+// Case-insensitive three-way compare of `name` against a lowercase key
+int compare_lower(std::string_view name, std::string_view key) {
+    size_t length = std::min(name.size(), key.size());
+    for (size_t i = 0; i < length; ++i) {
+        char a = lower(name[i]);
+        if (a != key[i]) {
+            return a < key[i] ? -1 : 1;
+        }
+    }
+    if (name.size() == key.size()) return 0;
+    return name.size() < key.size() ? -1 : 1;
+}
+
+std::string_view param_name(std::string_view param) {
+    return param.substr(0, param.find('='));
+}
+
+} // namespace
+
+UrlCanonicalizer::UrlCanonicalizer()
+    : exact_(),
+      prefixes_(),
+      sort_query_(false) {
+    set_stripped_params(default_stripped_params());
+}
+
+std::vector<std::string> UrlCanonicalizer::default_stripped_params() {
+    return {
+        "utm_*", "gclid", "gclsrc", "dclid", "fbclid", "msclkid", "yclid", "mc_cid", "mc_eid",
+        "_ga", "_gl", "_hsenc", "_hsmi", "igshid", "ref_src",
+        "jsessionid", "phpsessid", "aspsessionid", "sessionid", "sid_token",
+    };
+}
+
+void UrlCanonicalizer::set_stripped_params(const std::vector<std::string>& names) {
+    exact_.clear();
+    prefixes_.clear();
+    for (const auto& name : names) {
+        if (name.empty()) continue;
+        std::string key;
+        key.reserve(name.size());
+        for (char c : name) {
+            key.push_back(lower(c));
+        }
+        if (key.back() == '*') {
+            key.pop_back();
+            prefixes_.push_back(std::move(key));
+        } else {
+            exact_.push_back(std::move(key));
+        }
+    }
+    std::sort(exact_.begin(), exact_.end());
+    exact_.erase(std::unique(exact_.begin(), exact_.end()), exact_.end());
+}
+
+void UrlCanonicalizer::set_sort_query(bool sort) {
+    sort_query_ = sort;
+}
+
+bool UrlCanonicalizer::is_stripped(std::string_view name) const {
+    if (name.empty()) return false;
+    auto it = std::lower_bound(exact_.begin(), exact_.end(), name,
+                               [](const std::string& key, std::string_view value) {
+                                   return compare_lower(value, key) > 0;
+                               });
+    if (it != exact_.end() && compare_lower(name, *it) == 0) {
+        return true;
+    }
+    for (const auto& prefix : prefixes_) {
+        if (name.size() >= prefix.size() && compare_lower(name.substr(0, prefix.size()), prefix) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void UrlCanonicalizer::canonicalize(Url& url) const {
+    bool has_path_params = url.path().find(';') != std::string_view::npos;
+    if (url.has_query() || has_path_params) {
+        const char* base = url.str().data();
+        size_t path_begin = static_cast<size_t>(url.path().data() - base);
+        size_t path_end = path_begin + url.path().size();
+        size_t query_end = url.has_query()
+            ? static_cast<size_t>(url.query().data() - base) + url.query().size()
+            : path_end;
+
+        std::string spec = url.release();
+        // Query first: it lies after the path, so path offsets stay valid
+        if (query_end > path_end) {
+            rewrite_query(spec, path_end, query_end);
+        }
+        if (has_path_params) {
+            strip_path_params(spec, path_begin, path_end);
+        }
+        url = Url::parse(std::move(spec));
+    }
+    url.normalize();
+}
+
+void UrlCanonicalizer::rewrite_query(std::string& spec, size_t question_mark, size_t query_end) const {
+    thread_local std::vector<std::string_view> params;
+    thread_local std::string scratch;
+    params.clear();
+
+    std::string_view query(spec.data() + question_mark + 1, query_end - question_mark - 1);
+    bool dropped = false;
+    size_t start = 0;
+    while (start <= query.size()) {
+        size_t end = query.find('&', start);
+        if (end == std::string_view::npos) end = query.size();
+        std::string_view param = query.substr(start, end - start);
+        if (param.empty() || is_stripped(param_name(param))) {
+            dropped = true;
+        } else {
+            params.push_back(param);
+        }
+        start = end + 1;
+    }
+
+    bool reorder = false;
+    if (sort_query_) {
+        reorder = !std::is_sorted(params.begin(), params.end(),
+                                  [](std::string_view a, std::string_view b) {
+                                      return param_name(a) < param_name(b);
+                                  });
+    }
+    if (!dropped && !reorder) {
+        return;
+    }
+    if (reorder) {
+        std::stable_sort(params.begin(), params.end(), [](std::string_view a, std::string_view b) {
+            return param_name(a) < param_name(b);
+        });
+    }
+
+    scratch.clear();
+    for (std::string_view param : params) {
+        if (!scratch.empty()) scratch.push_back('&');
+        scratch.append(param);
+    }
+    if (scratch.empty()) {
+        spec.erase(question_mark, query_end - question_mark);
+    } else {
+        spec.replace(question_mark + 1, query_end - question_mark - 1, scratch);
+    }
+}
+
+void UrlCanonicalizer::strip_path_params(std::string& spec, size_t path_begin, size_t path_end) const {
+    // Path parameters look like "/page;jsessionid=ABC"; each runs to the next ';' or '/'
+    size_t write = path_begin;
+    size_t read = path_begin;
+    while (read < path_end) {
+        if (spec[read] != ';') {
+            spec[write++] = spec[read++];
+            continue;
+        }
+        size_t end = spec.find_first_of(";/", read + 1);
+        if (end == std::string::npos || end > path_end) end = path_end;
+        std::string_view param(spec.data() + read + 1, end - read - 1);
+        if (!is_stripped(param_name(param))) {
+            while (read < end) {
+                spec[write++] = spec[read++];
+            }
+        }
+        read = end;
+    }
+    spec.erase(write, path_end - write);
+}
@@ -0,0 +1,49 @@
+#include "address_cache.h"
+#include <gtest/gtest.h>
+#include <netinet/in.h>
+
+namespace {
+
+ResolvedAddress address_of(int family, int tag) {
+    ResolvedAddress address;
+    address.family = family;
+    address.protocol = tag;  // Lets the tests follow addresses through reordering
+    return address;
+}
+
+std::vector<int> tags(const std::vector<ResolvedAddress>& addresses) {
+    std::vector<int> result;
+    for (const auto& address : addresses) {
+        result.push_back(address.protocol);
+    }
+    return result;
+}
+
+} // namespace
+
+TEST(AddressCacheTest, InterleavesFamilies) {
+    std::vector<ResolvedAddress> addresses = {
+        address_of(AF_INET6, 1), address_of(AF_INET6, 2), address_of(AF_INET6, 3),
+        address_of(AF_INET, 4), address_of(AF_INET, 5)
+    };
+    EXPECT_EQ(tags(AddressCache::interleave(addresses, AF_INET6)), (std::vector<int>{1, 4, 2, 5, 3}));
+    EXPECT_EQ(tags(AddressCache::interleave(addresses, AF_INET)), (std::vector<int>{4, 1, 5, 2, 3}));
+
+    // A single-family host keeps its resolver order
+    std::vector<ResolvedAddress> v4_only = {address_of(AF_INET, 1), address_of(AF_INET, 2)};
+    EXPECT_EQ(tags(AddressCache::interleave(v4_only, AF_INET6)), (std::vector<int>{1, 2}));
+}
+
+TEST(AddressCacheTest, ResolvesAndRemembersFamily) {
+    AddressCache cache;
+    std::string error;
+    std::vector<ResolvedAddress> addresses = cache.resolve("127.0.0.1", 8080, error);
+    ASSERT_FALSE(addresses.empty()) << error;
+    EXPECT_EQ(addresses.front().family, AF_INET);
+    auto* v4 = reinterpret_cast<const sockaddr_in*>(&addresses.front().address);
+    EXPECT_EQ(ntohs(v4->sin_port), 8080);
+
+    EXPECT_EQ(cache.preferred_family("example.com"), AF_UNSPEC);
+    cache.remember_family("example.com", AF_INET);
+    EXPECT_EQ(cache.preferred_family("example.com"), AF_INET);
+}
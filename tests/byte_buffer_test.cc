@@ -0,0 +1,50 @@
+#include "byte_buffer.h"
+#include <gtest/gtest.h>
+
+TEST(ByteBufferTest, AdoptTakesStorageWithoutCopying) {
+    std::string bytes(4096, 'x');
+    const char* data = bytes.data();
+    ByteBuffer buffer = ByteBuffer::adopt(std::move(bytes));
+    EXPECT_EQ(buffer.data(), data);
+    EXPECT_EQ(buffer.size(), 4096u);
+    EXPECT_EQ(buffer.use_count(), 1);
+
+    ByteBuffer empty = ByteBuffer::adopt(std::string());
+    EXPECT_TRUE(empty.empty());
+    EXPECT_EQ(empty.use_count(), 0);
+    EXPECT_EQ(empty.view(), "");
+}
+
+TEST(ByteBufferTest, CopiesAndSlicesShareStorage) {
+    ByteBuffer buffer = ByteBuffer::adopt("HTTP/1.1 200 OK\r\n\r\n<html></html>");
+    ByteBuffer body = buffer.slice(19);
+    EXPECT_EQ(body.view(), "<html></html>");
+    EXPECT_EQ(body.data(), buffer.data() + 19);
+
+    ByteBuffer copy = body;
+    EXPECT_EQ(copy.data(), body.data());
+    EXPECT_EQ(buffer.use_count(), 3);
+
+    // Out-of-range slices are clamped, and an empty one holds nothing
+    EXPECT_EQ(body.slice(6, 100).view(), "</html>");
+    EXPECT_EQ(body.slice(100).use_count(), 0);
+
+    // The storage outlives the buffer it was adopted by
+    buffer = ByteBuffer();
+    EXPECT_EQ(copy.str(), "<html></html>");
+    EXPECT_EQ(copy.use_count(), 2);
+}
+
+TEST(ByteBufferTest, ReleasedStorageIsReused) {
+    std::string storage = ByteBuffer::acquire(65536);
+    EXPECT_TRUE(storage.empty());
+    EXPECT_GE(storage.capacity(), 65536u);
+    storage.assign(1000, 'a');
+    const char* data = storage.data();
+    ByteBuffer::adopt(std::move(storage));  // Released at once
+
+    std::string reused = ByteBuffer::acquire(1024);
+    EXPECT_TRUE(reused.empty());
+    EXPECT_EQ(reused.data(), data);
+    EXPECT_GE(reused.capacity(), 65536u);
+}
@@ -0,0 +1,74 @@
+#include "circuit_breaker.h"
+#include <gtest/gtest.h>
+
+using std::chrono::seconds;
+
+namespace {
+
+CircuitLimits test_limits() {
+    CircuitLimits limits;
+    limits.window = 10;
+    limits.min_requests = 4;
+    limits.failure_rate = 0.5;
+    limits.open_for = seconds(30);
+    limits.max_open_for = seconds(100);
+    return limits;
+}
+
+} // namespace
+
+TEST(CircuitBreakerTest, StaysClosedForHealthyHosts) {
+    CircuitBreaker breaker(test_limits());
+    auto now = CircuitBreaker::Clock::now();
+    for (int i = 0; i < 20; ++i) {
+        EXPECT_FALSE(breaker.record("a.com", true, now));
+    }
+    // One failure among successes stays under the rate
+    EXPECT_FALSE(breaker.record("a.com", false, now));
+    EXPECT_FALSE(breaker.record("a.com", true, now));
+    EXPECT_FALSE(breaker.record("a.com", true, now));
+    EXPECT_FALSE(breaker.record("a.com", true, now));
+    EXPECT_EQ(breaker.state("a.com"), CircuitState::Closed);
+    EXPECT_TRUE(breaker.allow("a.com", now));
+}
+
+TEST(CircuitBreakerTest, OpensOnFailureRate) {
+    CircuitBreaker breaker(test_limits());
+    auto now = CircuitBreaker::Clock::now();
+    EXPECT_FALSE(breaker.record("a.com", false, now));
+    EXPECT_FALSE(breaker.record("a.com", false, now));
+    EXPECT_FALSE(breaker.record("a.com", true, now));
+    EXPECT_TRUE(breaker.record("a.com", false, now));  // 3 of 4 failed
+
+    EXPECT_EQ(breaker.state("a.com"), CircuitState::Open);
+    EXPECT_TRUE(breaker.is_open("a.com", now + seconds(29)));
+    EXPECT_FALSE(breaker.allow("a.com", now + seconds(29)));
+    EXPECT_TRUE(breaker.allow("b.com", now));
+    EXPECT_EQ(breaker.open_hosts(), 1u);
+}
+
+TEST(CircuitBreakerTest, HalfOpenProbeClosesOrReopens) {
+    CircuitBreaker breaker(test_limits());
+    auto now = CircuitBreaker::Clock::now();
+    for (int i = 0; i < 4; ++i) {
+        breaker.record("a.com", false, now);
+    }
+    ASSERT_EQ(breaker.state("a.com"), CircuitState::Open);
+
+    EXPECT_TRUE(breaker.cooled_down(now + seconds(29)).empty());
+    EXPECT_EQ(breaker.cooled_down(now + seconds(30)), std::vector<std::string>{"a.com"});
+    EXPECT_EQ(breaker.state("a.com"), CircuitState::HalfOpen);
+    EXPECT_EQ(breaker.open_hosts(), 0u);
+
+    // A failed probe doubles the cool-down
+    now += seconds(30);
+    EXPECT_TRUE(breaker.record("a.com", false, now));
+    EXPECT_TRUE(breaker.is_open("a.com", now + seconds(59)));
+    EXPECT_FALSE(breaker.is_open("a.com", now + seconds(60)));
+
+    // The cool-down ends on the next request too; a good probe closes the circuit
+    EXPECT_TRUE(breaker.allow("a.com", now + seconds(60)));
+    EXPECT_EQ(breaker.state("a.com"), CircuitState::HalfOpen);
+    EXPECT_FALSE(breaker.record("a.com", true, now + seconds(60)));
+    EXPECT_EQ(breaker.state("a.com"), CircuitState::Closed);
+}
@@ -0,0 +1,45 @@
+#include "code_language_detector.h"
+#include <gtest/gtest.h>
+
+class CodeLanguageDetectorTest : public ::testing::Test {
+protected:
+    const CodeLanguageDetector& detector = CodeLanguageDetector::default_detector();
+};
+
+TEST_F(CodeLanguageDetectorTest, BuiltInLanguages) {
+    EXPECT_EQ(detector.detect("function hello() {\n  console.log('hi');\n}"), "js");
+    EXPECT_EQ(detector.detect("def main():\n    print(self.value)"), "python");
+    EXPECT_EQ(detector.detect("#include <vector>\nstd::vector<int> v;"), "cpp");
+    EXPECT_EQ(detector.detect("pub fn main() {\n    println!(\"hi\");\n}"), "rust");
+    EXPECT_EQ(detector.detect("package main\n\nfunc main() {\n\tfmt.Println(1)\n}"), "go");
+    EXPECT_EQ(detector.detect("CREATE TABLE users (id INT);"), "sql");
+    EXPECT_EQ(detector.detect("#!/bin/bash\necho $(date)"), "bash");
+    EXPECT_EQ(detector.detect("<?php echo $name; ?>"), "php");
+}
+
+TEST_F(CodeLanguageDetectorTest, CaseInsensitive) {
+    EXPECT_EQ(detector.detect("select * FROM users WHERE id = 1"), "sql");
+}
+
+TEST_F(CodeLanguageDetectorTest, WeakSignalsAreNotEnough) {
+    EXPECT_EQ(detector.detect("just some plain words"), "");
+    EXPECT_EQ(detector.detect("import os"), "");
+}
+
+TEST_F(CodeLanguageDetectorTest, KeywordsRespectWordBoundaries) {
+    // "undef " must not count as the python keyword "def "
+    EXPECT_EQ(detector.detect("#undef FOO\n#undef BAR"), "");
+}
+
+TEST_F(CodeLanguageDetectorTest, CustomLanguages) {
+    CodeLanguageDetector custom;
+    custom.add_keyword("kotlin", "fun ", 2);
+    custom.add_keyword("kotlin", "val ", 1);
+    custom.add_keyword("swift", "func ", 2);
+    custom.add_keyword("swift", "guard let", 3);
+    custom.compile();
+    
+    EXPECT_EQ(custom.detect("fun main() {\n    val x = 1\n}"), "kotlin");
+    EXPECT_EQ(custom.detect("func f() {\n    guard let x = y else { return }\n}"), "swift");
+    EXPECT_EQ(custom.detect("nothing here"), "");
+}
@@ -0,0 +1,125 @@
+#include "connection_race.h"
+#include <gtest/gtest.h>
+
+#include <arpa/inet.h>
+#include <cstring>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+using Clock = EventLoop::Clock;
+
+ResolvedAddress loopback(int port) {
+    ResolvedAddress resolved;
+    resolved.family = AF_INET;
+    struct sockaddr_in address {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(static_cast<uint16_t>(port));
+    std::memcpy(&resolved.address, &address, sizeof(address));
+    resolved.address_length = sizeof(address);
+    return resolved;
+}
+
+// Loopback listener; backlog 0 with one queued client makes later connects hang
+class Listener {
+public:
+    explicit Listener(int backlog) {
+        fd_ = socket(AF_INET, SOCK_STREAM, 0);
+        struct sockaddr_in address {};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        bind(fd_, reinterpret_cast<struct sockaddr*>(&address), sizeof(address));
+        socklen_t length = sizeof(address);
+        getsockname(fd_, reinterpret_cast<struct sockaddr*>(&address), &length);
+        port_ = ntohs(address.sin_port);
+        listen(fd_, backlog);
+    }
+
+    ~Listener() {
+        for (int client : clients_) {
+            close(client);
+        }
+        close(fd_);
+    }
+
+    // Fill the accept queue so the next SYN is dropped
+    void saturate() {
+        int client = socket(AF_INET, SOCK_STREAM, 0);
+        ResolvedAddress address = loopback(port_);
+        connect(client, reinterpret_cast<const struct sockaddr*>(&address.address), address.address_length);
+        clients_.push_back(client);
+    }
+
+    int port() const {
+        return port_;
+    }
+
+private:
+    int fd_ = -1;
+    int port_ = 0;
+    std::vector<int> clients_;
+};
+
+// A port nothing listens on, so connecting to it is refused
+int closed_port() {
+    Listener listener(1);
+    return listener.port();
+}
+
+// Drive a race the way the HTTP client does, until it connects or fails
+Task<int> run_race(EventLoop& loop, ConnectionRace& race, Clock::time_point deadline) {
+    while (true) {
+        int fd = race.step();
+        if (fd >= 0 || race.failed() || Clock::now() >= deadline) {
+            co_return fd;
+        }
+        co_await loop.any_writable(race.pending(), std::min(deadline, race.next_attempt_at()));
+    }
+}
+
+long elapsed_ms(Clock::time_point since) {
+    return static_cast<long>(std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - since).count());
+}
+
+} // namespace
+
+TEST(ConnectionRaceTest, RefusedFirstAddressFallsThroughAtOnce) {
+    Listener server(4);
+    EventLoop loop(IoBackend::Epoll);
+    ConnectionRace race(loop, {loopback(closed_port()), loopback(server.port())});
+
+    auto start = Clock::now();
+    int fd = loop.run(run_race(loop, race, start + std::chrono::seconds(2)));
+    ASSERT_GE(fd, 0);
+    EXPECT_LT(elapsed_ms(start), 150);
+    EXPECT_EQ(race.winner_family(), AF_INET);
+    close(fd);
+}
+
+TEST(ConnectionRaceTest, FailureStartsTheNextCandidateWhileOthersArePending) {
+    Listener stalled(0);
+    stalled.saturate();
+    Listener server(4);
+    EventLoop loop(IoBackend::Epoll);
+    ConnectionRace race(loop, {loopback(stalled.port()), loopback(closed_port()), loopback(server.port())});
+
+    // The refusal at ~250 ms hands over to the server at once, not 250 ms later
+    auto start = Clock::now();
+    int fd = loop.run(run_race(loop, race, start + std::chrono::seconds(2)));
+    ASSERT_GE(fd, 0);
+    EXPECT_LT(elapsed_ms(start), ConnectionRace::kAttemptDelay.count() + 150);
+    close(fd);
+}
+
+TEST(ConnectionRaceTest, EveryCandidateRefusedFails) {
+    EventLoop loop(IoBackend::Epoll);
+    ConnectionRace race(loop, {loopback(closed_port()), loopback(closed_port())});
+
+    int fd = loop.run(run_race(loop, race, Clock::now() + std::chrono::seconds(2)));
+    EXPECT_EQ(fd, -1);
+    EXPECT_TRUE(race.failed());
+    EXPECT_FALSE(race.error().empty());
+}
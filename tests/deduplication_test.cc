@@ -0,0 +1,36 @@
+#include "crawler.h"
+#include <gtest/gtest.h>
+
+class DeduplicationTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        crawler.enable_deduplication(true);
+    }
+
+    WebCrawler crawler{"TestBot/1.0"};
+};
+
+TEST_F(DeduplicationTest, SameContentAtAnotherUrlIsDuplicate) {
+    uint64_t page = crawler.calculate_simhash("An article about crawling the web politely and efficiently.");
+    EXPECT_FALSE(crawler.is_duplicate("https://example.com/article", page));
+    EXPECT_TRUE(crawler.is_duplicate("https://example.com/article?ref=home", page));
+    EXPECT_EQ(crawler.get_duplicates_detected_count(), 1);
+}
+
+TEST_F(DeduplicationTest, RevisitOfUnchangedPageIsNotDuplicate) {
+    uint64_t page = crawler.calculate_simhash("An article about crawling the web politely and efficiently.");
+    EXPECT_FALSE(crawler.is_duplicate("https://example.com/article", page));
+    EXPECT_FALSE(crawler.is_duplicate("https://example.com/article", page));
+    EXPECT_FALSE(crawler.is_duplicate("https://example.com/article", page ^ 0x1));
+    EXPECT_EQ(crawler.get_duplicates_detected_count(), 0);
+
+    // The revisit replaced the stored hash instead of adding a second one
+    EXPECT_TRUE(crawler.is_duplicate("https://example.com/copy", page ^ 0x1));
+}
+
+TEST_F(DeduplicationTest, DisabledNeverReportsDuplicates) {
+    crawler.enable_deduplication(false);
+    uint64_t page = crawler.calculate_simhash("Same text");
+    EXPECT_FALSE(crawler.is_duplicate("https://example.com/a", page));
+    EXPECT_FALSE(crawler.is_duplicate("https://example.com/b", page));
+}
@@ -0,0 +1,139 @@
+#include "dust_learner.h"
+#include <gtest/gtest.h>
+#include <map>
+
+namespace {
+
+// Category pages whose content depends only on "id"
+void observe_sort_variants(DustLearner& learner, int pages) {
+    for (int id = 0; id < pages; ++id) {
+        uint64_t fingerprint = 0x9E3779B97F4A7C15ULL * static_cast<uint64_t>(id + 1);
+        std::string base = "https://shop.com/list?id=" + std::to_string(id);
+        learner.observe(Url::parse(base + "&sort=asc"), fingerprint);
+        learner.observe(Url::parse(base + "&sort=desc"), fingerprint);
+    }
+}
+
+std::string rewritten(DustLearner& learner, const std::string& spec) {
+    Url url = Url::parse(spec);
+    learner.rewrite(url);
+    return url.str();
+}
+
+} // namespace
+
+TEST(DustLearnerTest, LearnsParameterThatDoesNotChangeContent) {
+    DustLearner learner;
+    observe_sort_variants(learner, 4);
+    EXPECT_TRUE(learner.rules("shop.com").empty());
+
+    observe_sort_variants(learner, 5);
+    EXPECT_EQ(learner.rules("shop.com"), std::vector<std::string>{"sort"});
+    EXPECT_TRUE(learner.rules("other.com").empty());
+}
+
+TEST(DustLearnerTest, KeepsParameterThatChangesContent) {
+    DustLearner learner;
+    for (int page = 0; page < 20; ++page) {
+        uint64_t fingerprint = 0xC2B2AE3D27D4EB4FULL * static_cast<uint64_t>(page + 1);
+        learner.observe(Url::parse("https://blog.com/archive?page=" + std::to_string(page)), fingerprint);
+    }
+    EXPECT_TRUE(learner.rules("blog.com").empty());
+    EXPECT_EQ(rewritten(learner, "https://blog.com/archive?page=3"), "https://blog.com/archive?page=3");
+}
+
+TEST(DustLearnerTest, LearnsFromParameterPresence) {
+    DustLearner learner;
+    for (int id = 0; id < 5; ++id) {
+        uint64_t fingerprint = 0x165667B19E3779F9ULL * static_cast<uint64_t>(id + 1);
+        std::string base = "https://news.com/story?id=" + std::to_string(id);
+        learner.observe(Url::parse(base), fingerprint);
+        learner.observe(Url::parse(base + "&print=1"), fingerprint ^ 0x1);  // Near-identical
+    }
+    EXPECT_EQ(learner.rules("news.com"), std::vector<std::string>{"print"});
+}
+
+TEST(DustLearnerTest, RewriteDropsLearnedParameters) {
+    DustLearner learner;
+    observe_sort_variants(learner, 5);
+    Url url = Url::parse("https://shop.com/list?id=42&sort=price");
+    EXPECT_TRUE(learner.rewrite(url));
+    EXPECT_EQ(url.str(), "https://shop.com/list?id=42");
+
+    Url untouched = Url::parse("https://shop.com/list?id=42");
+    EXPECT_FALSE(learner.rewrite(untouched));
+}
+
+TEST(DustLearnerTest, PersistsRules) {
+    std::map<std::string, std::string> store;
+    auto loader = [&store](const std::string& host) {
+        auto it = store.find(host);
+        return it == store.end() ? std::string() : it->second;
+    };
+    auto saver = [&store](const std::string& host, const std::string& data) {
+        store[host] = data;
+    };
+
+    DustLearner learner;
+    learner.set_persistence(loader, saver);
+    observe_sort_variants(learner, 5);
+    ASSERT_EQ(store.count("shop.com"), 1u);
+
+    DustLearner restarted;
+    restarted.set_persistence(loader, saver);
+    EXPECT_EQ(restarted.rules("shop.com"), std::vector<std::string>{"sort"});
+    EXPECT_EQ(rewritten(restarted, "https://shop.com/list?sort=asc&id=1"), "https://shop.com/list?id=1");
+}
+
+TEST(DustLearnerTest, ListingRulesLeavesTheCacheAlone) {
+    std::map<std::string, std::string> store = {{"other.com", "-utm 9 0\nid 0 4\n"}};
+    size_t loads = 0;
+    auto loader = [&store, &loads](const std::string& host) {
+        loads++;
+        auto it = store.find(host);
+        return it == store.end() ? std::string() : it->second;
+    };
+
+    DustLearner learner(1);
+    learner.set_persistence(loader, [&store](const std::string& host, const std::string& data) {
+        store[host] = data;
+    });
+    observe_sort_variants(learner, 5);
+    EXPECT_EQ(learner.rules("other.com"), std::vector<std::string>{"utm"});
+
+    // shop.com is still the cached host: no reload on its next use
+    loads = 0;
+    EXPECT_EQ(rewritten(learner, "https://shop.com/list?id=1&sort=asc"), "https://shop.com/list?id=1");
+    EXPECT_EQ(loads, 0u);
+    EXPECT_EQ(DustLearner::dropped_parameters(store["other.com"]), std::vector<std::string>{"utm"});
+}
+
+TEST(DustLearnerTest, RewritingOtherHostsKeepsPendingEvidence) {
+    std::map<std::string, std::string> store = {{"other.com", "-utm 9 0\n"}};
+    size_t loads = 0;
+    auto loader = [&store, &loads](const std::string& host) {
+        loads++;
+        auto it = store.find(host);
+        return it == store.end() ? std::string() : it->second;
+    };
+
+    DustLearner learner(1);
+    learner.set_persistence(loader, [&store](const std::string& host, const std::string& data) {
+        store[host] = data;
+    });
+    observe_sort_variants(learner, 4);  // One agreeing pair short of a rule
+    EXPECT_TRUE(learner.rules("shop.com").empty());
+
+    // Linked-to hosts are read from the store once and do not evict shop.com
+    loads = 0;
+    EXPECT_EQ(rewritten(learner, "https://other.com/a?utm=x&id=1"), "https://other.com/a?id=1");
+    EXPECT_EQ(rewritten(learner, "https://other.com/b?utm=y"), "https://other.com/b");
+    EXPECT_EQ(rewritten(learner, "https://third.com/c?utm=z"), "https://third.com/c?utm=z");
+    EXPECT_EQ(loads, 2u);
+
+    uint64_t fingerprint = 0x9E3779B97F4A7C15ULL * 5;
+    learner.observe(Url::parse("https://shop.com/list?id=4&sort=asc"), fingerprint);
+    EXPECT_TRUE(learner.observe(Url::parse("https://shop.com/list?id=4&sort=desc"), fingerprint));
+    EXPECT_EQ(loads, 2u);
+    EXPECT_EQ(rewritten(learner, "https://shop.com/list?id=1&sort=asc"), "https://shop.com/list?id=1");
+}
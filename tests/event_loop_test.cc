@@ -0,0 +1,404 @@
+#include "event_loop.h"
+#include "raw_socket_http.h"
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstdlib>
+#include <mutex>
+#include <netinet/in.h>
+#include <openssl/evp.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+
+using Clock = EventLoop::Clock;
+
+Task<int> sleep_then_log(EventLoop& loop, int id, std::chrono::milliseconds delay, std::vector<int>& order) {
+    co_await loop.sleep_until(Clock::now() + delay);
+    order.push_back(id);
+    co_return id;
+}
+
+Task<long> receive_with_deadline(EventLoop& loop, int fd, std::chrono::milliseconds wait) {
+    char buffer[16];
+    co_return co_await loop.receive(fd, buffer, sizeof(buffer), Clock::now() + wait);
+}
+
+Task<int> read_with_deadline(EventLoop& loop, int fd, std::chrono::milliseconds wait) {
+    if (!co_await loop.readable(fd, Clock::now() + wait)) {
+        co_return -1;
+    }
+    char byte = 0;
+    co_return static_cast<int>(read(fd, &byte, 1));
+}
+
+const std::string kHelloResponse =
+    "HTTP/1.1 200 OK\r\nContent-Type: text/html\r\nContent-Length: 5\r\n\r\nhello";
+
+// Listening loopback socket on an ephemeral port
+int listen_loopback(int backlog, int& port) {
+    int listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in address {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(listen_fd, reinterpret_cast<struct sockaddr*>(&address), sizeof(address));
+    socklen_t length = sizeof(address);
+    getsockname(listen_fd, reinterpret_cast<struct sockaddr*>(&address), &length);
+    port = ntohs(address.sin_port);
+    listen(listen_fd, backlog);
+    return listen_fd;
+}
+
+// Minimal HTTP server answering `connections` requests, one per connection;
+// a nonzero `stall` holds each connection open that long after the response
+class TestServer {
+public:
+    explicit TestServer(int connections, std::string response = kHelloResponse,
+                        std::chrono::milliseconds stall = std::chrono::milliseconds(0)) {
+        listen_fd_ = listen_loopback(connections, port_);
+
+        thread_ = std::thread([this, connections, response, stall]() {
+            // Accept everything first, so the clients really are in flight together
+            std::vector<int> clients;
+            for (int i = 0; i < connections; ++i) {
+                clients.push_back(accept(listen_fd_, nullptr, nullptr));
+            }
+            for (int client : clients) {
+                char buffer[4096];
+                long received = recv(client, buffer, sizeof(buffer), 0);
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    last_request_.assign(buffer, static_cast<size_t>(std::max(0L, received)));
+                }
+                (void)send(client, response.data(), response.size(), MSG_NOSIGNAL);
+                std::this_thread::sleep_for(stall);
+                close(client);
+            }
+        });
+    }
+
+    ~TestServer() {
+        thread_.join();
+        close(listen_fd_);
+    }
+
+    int port() const {
+        return port_;
+    }
+
+    std::string last_request() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return last_request_;
+    }
+
+private:
+    int listen_fd_ = -1;
+    int port_ = 0;
+    mutable std::mutex mutex_;
+    std::string last_request_;
+    std::thread thread_;
+};
+
+// TLS server answering one request with a self-signed certificate, then
+// holding the connection open for `stall` without a close_notify
+class TlsTestServer {
+public:
+    TlsTestServer(std::string response, std::chrono::milliseconds stall) {
+        context_ = SSL_CTX_new(TLS_server_method());
+        EVP_PKEY* key = EVP_EC_gen("P-256");
+        X509* certificate = X509_new();
+        ASN1_INTEGER_set(X509_get_serialNumber(certificate), 1);
+        X509_gmtime_adj(X509_getm_notBefore(certificate), 0);
+        X509_gmtime_adj(X509_getm_notAfter(certificate), 3600);
+        X509_set_pubkey(certificate, key);
+        X509_NAME* name = X509_get_subject_name(certificate);
+        X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC,
+                                   reinterpret_cast<const unsigned char*>("127.0.0.1"), -1, -1, 0);
+        X509_set_issuer_name(certificate, name);
+        X509_sign(certificate, key, EVP_sha256());
+        SSL_CTX_use_certificate(context_, certificate);
+        SSL_CTX_use_PrivateKey(context_, key);
+        X509_free(certificate);
+        EVP_PKEY_free(key);
+
+        listen_fd_ = listen_loopback(1, port_);
+        thread_ = std::thread([this, response, stall]() {
+            int client = accept(listen_fd_, nullptr, nullptr);
+            SSL* ssl = SSL_new(context_);
+            SSL_set_fd(ssl, client);
+            if (SSL_accept(ssl) == 1) {
+                char buffer[4096];
+                (void)SSL_read(ssl, buffer, sizeof(buffer));
+                (void)SSL_write(ssl, response.data(), static_cast<int>(response.size()));
+                std::this_thread::sleep_for(stall);
+            }
+            SSL_free(ssl);
+            close(client);
+        });
+    }
+
+    ~TlsTestServer() {
+        thread_.join();
+        close(listen_fd_);
+        SSL_CTX_free(context_);
+    }
+
+    int port() const {
+        return port_;
+    }
+
+private:
+    SSL_CTX* context_ = nullptr;
+    int listen_fd_ = -1;
+    int port_ = 0;
+    std::thread thread_;
+};
+
+// Every test runs on both backends; io_uring ones are skipped where the kernel lacks it
+class EventLoopTest : public ::testing::TestWithParam<IoBackend> {
+protected:
+    void SetUp() override {
+        if (GetParam() == IoBackend::IoUring && EventLoop(IoBackend::IoUring).backend() != IoBackend::IoUring) {
+            GTEST_SKIP() << "io_uring not available";
+        }
+    }
+};
+
+} // namespace
+
+TEST_P(EventLoopTest, SleepersWakeInDeadlineOrder) {
+    EventLoop loop(GetParam());
+    EXPECT_EQ(loop.backend(), GetParam());
+    std::vector<int> order;
+    std::vector<Task<int>> tasks;
+    tasks.push_back(sleep_then_log(loop, 1, std::chrono::milliseconds(30), order));
+    tasks.push_back(sleep_then_log(loop, 2, std::chrono::milliseconds(10), order));
+    tasks.push_back(sleep_then_log(loop, 3, std::chrono::milliseconds(20), order));
+    for (auto& task : tasks) {
+        task.start();
+    }
+    EXPECT_EQ(loop.parked(), 3u);
+    loop.run([&]() { return order.size() == 3; });
+    EXPECT_EQ(order, (std::vector<int>{2, 3, 1}));
+    EXPECT_EQ(loop.parked(), 0u);
+}
+
+TEST_P(EventLoopTest, ReadableHonorsDeadline) {
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    EventLoop loop(GetParam());
+
+    EXPECT_EQ(loop.run(read_with_deadline(loop, fds[0], std::chrono::milliseconds(10))), -1);
+
+    ASSERT_EQ(write(fds[1], "x", 1), 1);
+    EXPECT_EQ(loop.run(read_with_deadline(loop, fds[0], std::chrono::milliseconds(1000))), 1);
+
+    loop.forget(fds[0]);
+    close(fds[0]);
+    close(fds[1]);
+}
+
+TEST_P(EventLoopTest, ReceiveHonorsDeadline) {
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds), 0);
+    EventLoop loop(GetParam());
+
+    EXPECT_EQ(loop.run(receive_with_deadline(loop, fds[0], std::chrono::milliseconds(10))), -ETIME);
+
+    ASSERT_EQ(write(fds[1], "abc", 3), 3);
+    EXPECT_EQ(loop.run(receive_with_deadline(loop, fds[0], std::chrono::milliseconds(1000))), 3);
+
+    close(fds[1]);
+    EXPECT_EQ(loop.run(receive_with_deadline(loop, fds[0], std::chrono::milliseconds(1000))), 0);
+
+    loop.forget(fds[0]);
+    close(fds[0]);
+}
+
+TEST_P(EventLoopTest, ConcurrentFetchesShareOneLoop) {
+    constexpr int kFetches = 16;
+    TestServer server(kFetches);
+    RawSocketHttpConfig config;
+    config.timeout = std::chrono::seconds(5);
+    config.retry.max_retries = 0;
+    RawSocketHttpClient client(config);
+
+    EventLoop loop(GetParam());
+    std::vector<Task<RawHttpResponse>> fetches;
+    const std::string url = "http://127.0.0.1:" + std::to_string(server.port()) + "/page";
+    for (int i = 0; i < kFetches; ++i) {
+        fetches.push_back(client.fetch_async(loop, url, {}));
+        fetches.back().start();
+    }
+    loop.run([&]() {
+        for (const auto& fetch : fetches) {
+            if (!fetch.done()) {
+                return false;
+            }
+        }
+        return true;
+    });
+
+    for (auto& fetch : fetches) {
+        ASSERT_TRUE(fetch.done());
+        RawHttpResponse response = fetch.result();
+        EXPECT_TRUE(response.success) << response.error_message;
+        EXPECT_EQ(response.status_code, 200);
+        EXPECT_EQ(response.body.view(), "hello");
+        EXPECT_GE(response.connect_ms, 0);
+    }
+}
+
+TEST_P(EventLoopTest, ChunkedBodyIsDecoded) {
+    TestServer server(1, "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n"
+                         "5;ext=1\r\nhello\r\n7\r\n, world\r\n0\r\n\r\n");
+    RawSocketHttpConfig config;
+    config.timeout = std::chrono::seconds(5);
+    config.retry.max_retries = 0;
+    RawSocketHttpClient client(config);
+
+    EventLoop loop(GetParam());
+    RawHttpResponse response = loop.run(
+        client.fetch_async(loop, "http://127.0.0.1:" + std::to_string(server.port()) + "/", {}));
+    EXPECT_TRUE(response.success) << response.error_message;
+    EXPECT_EQ(response.body.view(), "hello, world");
+}
+
+TEST_P(EventLoopTest, BlockingFetchesReuseTheThreadLoop) {
+    RawSocketHttpConfig config;
+    config.timeout = std::chrono::seconds(5);
+    config.retry.max_retries = 0;
+    config.io_backend = GetParam();
+    RawSocketHttpClient client(config);
+
+    // The second fetch runs on the loop the first one left behind
+    for (int i = 0; i < 2; ++i) {
+        TestServer server(1);
+        RawHttpResponse response = client.fetch("http://127.0.0.1:" + std::to_string(server.port()) + "/", {});
+        EXPECT_TRUE(response.success) << response.error_message;
+        EXPECT_EQ(response.body.view(), "hello");
+    }
+}
+
+TEST_P(EventLoopTest, StalledBodyIsAnIdleTimeout) {
+    TestServer server(1, "HTTP/1.1 200 OK\r\nContent-Length: 1000\r\n\r\n" + std::string(100, 'x'),
+                      std::chrono::milliseconds(600));
+    RawSocketHttpConfig config;
+    config.timeout = std::chrono::seconds(5);
+    config.idle_timeout = std::chrono::milliseconds(200);
+    config.retry.max_retries = 0;
+    RawSocketHttpClient client(config);
+
+    EventLoop loop(GetParam());
+    RawHttpResponse response = loop.run(
+        client.fetch_async(loop, "http://127.0.0.1:" + std::to_string(server.port()) + "/", {}));
+    EXPECT_FALSE(response.success);
+    EXPECT_EQ(response.error_message, "read idle timeout");
+    EXPECT_GE(response.first_byte_ms, 0);
+    EXPECT_FALSE(response.timed_out);
+}
+
+TEST_P(EventLoopTest, TotalDeadlineReportsACensoredTime) {
+    TestServer server(1, "HTTP/1.1 200 OK\r\nContent-Length: 1000\r\n\r\n" + std::string(100, 'x'),
+                      std::chrono::milliseconds(600));
+    RawSocketHttpConfig config;
+    config.timeout = std::chrono::milliseconds(200);
+    config.retry.max_retries = 0;
+    RawSocketHttpClient client(config);
+
+    EventLoop loop(GetParam());
+    RawHttpResponse response = loop.run(
+        client.fetch_async(loop, "http://127.0.0.1:" + std::to_string(server.port()) + "/", {}));
+    EXPECT_FALSE(response.success);
+    EXPECT_TRUE(response.timed_out);
+    EXPECT_EQ(response.error_message, "raw socket fetch timeout");
+    EXPECT_GE(response.total_ms, 200);
+    EXPECT_GE(response.connect_ms, 0);
+}
+
+TEST_P(EventLoopTest, BodyShorterThanContentLengthFails) {
+    TestServer server(1, "HTTP/1.1 200 OK\r\nContent-Length: 1000\r\n\r\n" + std::string(100, 'x'));
+    RawSocketHttpConfig config;
+    config.timeout = std::chrono::seconds(5);
+    config.retry.max_retries = 0;
+    RawSocketHttpClient client(config);
+
+    EventLoop loop(GetParam());
+    RawHttpResponse response = loop.run(
+        client.fetch_async(loop, "http://127.0.0.1:" + std::to_string(server.port()) + "/", {}));
+    EXPECT_FALSE(response.success);
+    EXPECT_EQ(response.status_code, 200);
+    EXPECT_EQ(response.error_message, "incomplete response body");
+}
+
+TEST_P(EventLoopTest, ConditionalRequestSendsAndCapturesValidators) {
+    TestServer server(1, "HTTP/1.1 200 OK\r\nETag: \"v2\"\r\n"
+                         "Last-Modified: Thu, 22 Oct 2015 07:28:00 GMT\r\nContent-Length: 5\r\n\r\nhello");
+    RawSocketHttpConfig config;
+    config.timeout = std::chrono::seconds(5);
+    config.retry.max_retries = 0;
+    RawSocketHttpClient client(config);
+
+    EventLoop loop(GetParam());
+    RawHttpResponse response = loop.run(client.fetch_async(
+        loop, "http://127.0.0.1:" + std::to_string(server.port()) + "/",
+        {{"If-None-Match", "\"v1\""}, {"If-Modified-Since", "Wed, 21 Oct 2015 07:28:00 GMT"}}));
+    EXPECT_TRUE(response.success) << response.error_message;
+    EXPECT_EQ(response.validators.etag, "\"v2\"");
+    EXPECT_EQ(response.validators.last_modified, "Thu, 22 Oct 2015 07:28:00 GMT");
+
+    std::string request = server.last_request();
+    EXPECT_NE(request.find("\r\nIf-None-Match: \"v1\"\r\n"), std::string::npos) << request;
+    EXPECT_NE(request.find("\r\nIf-Modified-Since: Wed, 21 Oct 2015 07:28:00 GMT\r\n"), std::string::npos)
+        << request;
+}
+
+TEST_P(EventLoopTest, BodylessResponsesFinishWithTheHeaders) {
+    // Neither waits for the 1000 bytes announced, nor for the server to close
+    for (const char* status : {"304 Not Modified", "204 No Content"}) {
+        TestServer server(1, std::string("HTTP/1.1 ") + status + "\r\nETag: \"v1\"\r\n"
+                             "Content-Length: 1000\r\n\r\n",
+                          std::chrono::milliseconds(600));
+        RawSocketHttpConfig config;
+        config.timeout = std::chrono::seconds(5);
+        config.retry.max_retries = 0;
+        RawSocketHttpClient client(config);
+
+        EventLoop loop(GetParam());
+        RawHttpResponse response = loop.run(
+            client.fetch_async(loop, "http://127.0.0.1:" + std::to_string(server.port()) + "/", {}));
+        EXPECT_TRUE(response.success) << status << ": " << response.error_message;
+        EXPECT_EQ(response.status_code, std::atoi(status));
+        EXPECT_TRUE(response.body.empty());
+        EXPECT_EQ(response.validators.etag, "\"v1\"");
+        EXPECT_LT(response.total_ms, 500) << status;
+    }
+}
+
+TEST_P(EventLoopTest, TlsReadStopsOnceTheResponseIsComplete) {
+    TlsTestServer server(kHelloResponse, std::chrono::milliseconds(600));
+    RawSocketHttpConfig config;
+    config.timeout = std::chrono::seconds(5);
+    config.retry.max_retries = 0;
+    RawSocketHttpClient client(config);
+
+    EventLoop loop(GetParam());
+    RawHttpResponse response = loop.run(
+        client.fetch_async(loop, "https://127.0.0.1:" + std::to_string(server.port()) + "/", {}));
+    EXPECT_TRUE(response.success) << response.error_message;
+    EXPECT_EQ(response.status_code, 200);
+    EXPECT_EQ(response.body.view(), "hello");
+    EXPECT_LT(response.total_ms, 500);
+}
+
+INSTANTIATE_TEST_SUITE_P(Backends, EventLoopTest,
+                         ::testing::Values(IoBackend::Epoll, IoBackend::IoUring),
+                         [](const ::testing::TestParamInfo<IoBackend>& info) {
+                             return info.param == IoBackend::Epoll ? std::string("Epoll") : std::string("IoUring");
+                         });
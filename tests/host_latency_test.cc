@@ -0,0 +1,92 @@
+#include "host_latency.h"
+#include <gtest/gtest.h>
+
+namespace {
+
+HostTimeouts defaults() {
+    HostTimeouts timeouts;
+    timeouts.connect = std::chrono::milliseconds(10000);
+    timeouts.idle = std::chrono::milliseconds(30000);
+    timeouts.total = std::chrono::milliseconds(30000);
+    return timeouts;
+}
+
+} // namespace
+
+TEST(HostLatencyTest, UnknownHostsGetDefaults) {
+    HostLatencyTracker tracker;
+    HostTimeouts timeouts = tracker.timeouts("example.com", defaults());
+    EXPECT_EQ(timeouts.connect.count(), 10000);
+    EXPECT_EQ(timeouts.idle.count(), 30000);
+    EXPECT_EQ(timeouts.total.count(), 30000);
+    EXPECT_EQ(tracker.percentile("example.com", LatencyMetric::Total, 0.5), -1);
+
+    // Too few samples to trust
+    tracker.record("example.com", 50, 100, 200);
+    EXPECT_EQ(tracker.timeouts("example.com", defaults()).total.count(), 30000);
+}
+
+TEST(HostLatencyTest, TimeoutsFollowPercentiles) {
+    HostLatencyTracker tracker;
+    for (int i = 0; i < 20; ++i) {
+        tracker.record("slow.example", 1000, 2000, 4000);
+    }
+
+    long connect_p99 = tracker.percentile("slow.example", LatencyMetric::Connect, 0.99);
+    long total_p99 = tracker.percentile("slow.example", LatencyMetric::Total, 0.99);
+    EXPECT_GE(connect_p99, 1000);
+    EXPECT_LT(connect_p99, 1200);  // Within one bucket of the samples
+    EXPECT_GE(total_p99, 4000);
+
+    HostTimeouts timeouts = tracker.timeouts("slow.example", defaults());
+    EXPECT_EQ(timeouts.connect.count(), connect_p99 * 3);
+    EXPECT_EQ(timeouts.idle.count(), tracker.percentile("slow.example", LatencyMetric::FirstByte, 0.99) * 3);
+    EXPECT_EQ(timeouts.total.count(), std::min<long>(30000, total_p99 * 3));
+}
+
+TEST(HostLatencyTest, TimeoutsAreClamped) {
+    HostLatencyTracker tracker;
+    for (int i = 0; i < 20; ++i) {
+        tracker.record("fast.example", 5, 10, 20);
+        tracker.record("hung.example", 9000, 60000, 120000);
+    }
+
+    HostTimeouts fast = tracker.timeouts("fast.example", defaults());
+    EXPECT_EQ(fast.connect.count(), 1000);
+    EXPECT_EQ(fast.idle.count(), 2000);
+    EXPECT_EQ(fast.total.count(), 5000);
+
+    HostTimeouts hung = tracker.timeouts("hung.example", defaults());
+    EXPECT_EQ(hung.connect.count(), 10000);
+    EXPECT_EQ(hung.idle.count(), 30000);
+    EXPECT_EQ(hung.total.count(), 30000);
+}
+
+TEST(HostLatencyTest, FailedRequestsOnlyCountMeasuredPhases) {
+    HostLatencyTracker tracker;
+    for (int i = 0; i < 10; ++i) {
+        tracker.record("example.com", 100, -1, -1);
+    }
+    EXPECT_GE(tracker.percentile("example.com", LatencyMetric::Connect, 0.5), 100);
+    EXPECT_EQ(tracker.percentile("example.com", LatencyMetric::Total, 0.5), -1);
+    EXPECT_EQ(tracker.timeouts("example.com", defaults()).total.count(), 30000);
+}
+
+TEST(HostLatencyTest, TimedOutRequestsGrowTheDeadline) {
+    HostLatencyTracker tracker;
+    for (int i = 0; i < 50; ++i) {
+        tracker.record("small-pages.example", 5, 10, 20);
+    }
+    HostTimeouts before = tracker.timeouts("small-pages.example", defaults());
+    EXPECT_EQ(before.total.count(), 5000);
+
+    // A large page runs into the total deadline: its censored time is recorded
+    tracker.record("small-pages.example", 5, 10, before.total.count());
+    HostTimeouts after = tracker.timeouts("small-pages.example", defaults());
+    EXPECT_GT(after.total.count(), before.total.count());
+    EXPECT_GE(after.total.count(), 3 * before.total.count());
+
+    // Likewise for a connect deadline
+    tracker.record("small-pages.example", before.connect.count(), -1, -1);
+    EXPECT_GT(tracker.timeouts("small-pages.example", defaults()).connect.count(), before.connect.count());
+}
@@ -0,0 +1,50 @@
+#include "host_throttle.h"
+#include "http_config.h"
+#include <gtest/gtest.h>
+
+using std::chrono::seconds;
+
+TEST(HostThrottleTest, ParsesRetryAfter) {
+    std::time_t now = 1445412480;  // Wed, 21 Oct 2015 07:28:00 GMT
+    EXPECT_EQ(parse_retry_after("120", now), 120);
+    EXPECT_EQ(parse_retry_after(" 0 ", now), 0);
+    EXPECT_EQ(parse_retry_after("Wed, 21 Oct 2015 07:29:30 GMT", now), 90);
+    EXPECT_EQ(parse_retry_after("Wednesday, 21-Oct-15 07:28:10 GMT", now), 10);
+    EXPECT_EQ(parse_retry_after("Wed Oct 21 07:28:05 2015", now), 5);
+    EXPECT_EQ(parse_retry_after("Tue, 20 Oct 2015 07:28:00 GMT", now), 0);  // Already past
+    EXPECT_EQ(parse_retry_after("soon", now), -1);
+    EXPECT_EQ(parse_retry_after("", now), -1);
+}
+
+TEST(HostThrottleTest, PausesOnlyTheRateLimitedHost) {
+    HostThrottle throttle(seconds(10), seconds(3600));
+    auto now = HostThrottle::Clock::now();
+
+    EXPECT_EQ(throttle.rate_limited("a.com", 30, now), seconds(30));
+    EXPECT_TRUE(throttle.is_paused("a.com", now + seconds(29)));
+    EXPECT_FALSE(throttle.is_paused("b.com", now));
+    EXPECT_EQ(throttle.paused_hosts(), 1u);
+
+    EXPECT_TRUE(throttle.expire(now + seconds(29)).empty());
+    EXPECT_EQ(throttle.expire(now + seconds(30)), std::vector<std::string>{"a.com"});
+    EXPECT_FALSE(throttle.is_paused("a.com", now + seconds(30)));
+    EXPECT_EQ(throttle.paused_hosts(), 0u);
+}
+
+TEST(HostThrottleTest, BacksOffWithoutRetryAfter) {
+    HostThrottle throttle(seconds(10), seconds(60));
+    auto now = HostThrottle::Clock::now();
+
+    EXPECT_EQ(throttle.rate_limited("a.com", -1, now), seconds(10));
+    EXPECT_EQ(throttle.rate_limited("a.com", -1, now), seconds(20));
+    EXPECT_EQ(throttle.rate_limited("a.com", -1, now), seconds(40));
+    EXPECT_EQ(throttle.rate_limited("a.com", -1, now), seconds(60));  // Capped
+    EXPECT_EQ(throttle.rate_limited("a.com", 86400, now), seconds(60));
+    EXPECT_EQ(throttle.strikes("a.com"), 5);
+
+    // A success after the window starts the streak over
+    throttle.expire(now + seconds(60));
+    throttle.succeeded("a.com");
+    EXPECT_EQ(throttle.strikes("a.com"), 0);
+    EXPECT_EQ(throttle.rate_limited("a.com", -1, now), seconds(10));
+}
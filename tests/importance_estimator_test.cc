@@ -0,0 +1,86 @@
+#include "importance_estimator.h"
+#include <gtest/gtest.h>
+
+TEST(ImportanceEstimatorTest, SplitsCashAmongOutlinks) {
+    ImportanceEstimator estimator;
+    ImportanceEstimator::Credit seed = estimator.take("https://a.com/");
+    EXPECT_DOUBLE_EQ(seed.cash, 1.0);
+    EXPECT_EQ(seed.depth, 0);
+
+    estimator.distribute(seed, {"https://a.com/x", "https://a.com/y"});
+    EXPECT_DOUBLE_EQ(estimator.cash("https://a.com/x"), 0.5);
+
+    ImportanceEstimator::Credit x = estimator.take("https://a.com/x");
+    EXPECT_DOUBLE_EQ(x.cash, 0.5);
+    EXPECT_EQ(x.depth, 1);
+    EXPECT_DOUBLE_EQ(estimator.cash("https://a.com/x"), 0.0);
+}
+
+TEST(ImportanceEstimatorTest, WellLinkedPagesGetBetterPriority) {
+    ImportanceEstimator estimator;
+    estimator.set_weights(0.5, 0.0);
+    for (int i = 0; i < 4; ++i) {
+        estimator.distribute(ImportanceEstimator::Credit(), {"https://a.com/popular", "https://a.com/p" + std::to_string(i)});
+    }
+    int popular = estimator.claim_priority("https://a.com/popular");
+    int rare = estimator.claim_priority("https://a.com/p0");
+    EXPECT_GE(popular, ImportanceEstimator::kFirstPriority);
+    EXPECT_LT(popular, rare);
+    EXPECT_LT(rare, ImportanceEstimator::kFirstPriority + ImportanceEstimator::kLevels);
+}
+
+TEST(ImportanceEstimatorTest, SpreadsAcrossHosts) {
+    ImportanceEstimator estimator;
+    std::vector<std::string> links;
+    for (int i = 0; i < 8; ++i) {
+        links.push_back("https://big.com/page" + std::to_string(i));
+    }
+    links.push_back("https://small.com/page");
+    estimator.distribute(ImportanceEstimator::Credit(), links);
+
+    int first = estimator.claim_priority(links[0]);
+    int last = first;
+    for (int i = 1; i < 8; ++i) {
+        last = estimator.claim_priority(links[i]);
+    }
+    EXPECT_GT(last, first);
+    EXPECT_EQ(estimator.claim_priority("https://small.com/page"), first);
+}
+
+TEST(ImportanceEstimatorTest, ReclaimsOnlyWhenPriorityImproves) {
+    ImportanceEstimator estimator;
+    estimator.distribute(ImportanceEstimator::Credit{0.01, 2}, {"https://a.com/late"});
+    int queued = estimator.claim_priority("https://a.com/late");
+    EXPECT_GT(queued, 0);
+    EXPECT_EQ(estimator.claim_priority("https://a.com/late"), -1);
+
+    estimator.distribute(ImportanceEstimator::Credit{4.0, 0}, {"https://a.com/late"});
+    int promoted = estimator.claim_priority("https://a.com/late");
+    EXPECT_GT(promoted, 0);
+    EXPECT_LT(promoted, queued);
+}
+
+TEST(ImportanceEstimatorTest, UsesStoredRank) {
+    ImportanceEstimator estimator;
+    estimator.set_rank_lookup([](const std::string& url) {
+        return url == "https://a.com/hub" ? 64.0 : 0.0;
+    });
+    estimator.distribute(ImportanceEstimator::Credit(), {"https://a.com/hub", "https://b.com/leaf"});
+    EXPECT_LT(estimator.claim_priority("https://a.com/hub"), estimator.claim_priority("https://b.com/leaf"));
+}
+
+TEST(ImportanceEstimatorTest, RestoredCreditSurvivesARetry) {
+    ImportanceEstimator estimator;
+    estimator.distribute(ImportanceEstimator::Credit(), {"https://a.com/x", "https://a.com/y"});
+    int priority = estimator.claim_priority("https://a.com/x");
+    ImportanceEstimator::Credit taken = estimator.take("https://a.com/x");
+
+    // Not fetched after all: the cash goes back and the URL counts as queued
+    estimator.restore("https://a.com/x", taken, priority);
+    EXPECT_DOUBLE_EQ(estimator.cash("https://a.com/x"), 0.5);
+    EXPECT_EQ(estimator.claim_priority("https://a.com/x"), -1);
+
+    ImportanceEstimator::Credit again = estimator.take("https://a.com/x");
+    EXPECT_DOUBLE_EQ(again.cash, 0.5);
+    EXPECT_EQ(again.depth, 1);
+}
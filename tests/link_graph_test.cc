@@ -0,0 +1,93 @@
+#include "link_graph.h"
+#include <gtest/gtest.h>
+#include <numeric>
+
+namespace {
+
+LinkGraph star_graph(size_t threads) {
+    // Every leaf links to the hub, the hub links back to the first leaf
+    LinkGraph graph;
+    uint32_t hub = graph.add_node("https://hub.com/");
+    for (int i = 0; i < 10; ++i) {
+        uint32_t leaf = graph.add_node("https://leaf" + std::to_string(i) + ".com/page");
+        graph.add_edge(leaf, hub);
+    }
+    graph.add_edge(hub, graph.add_node("https://leaf0.com/page"));
+    graph.finalize(threads);
+    return graph;
+}
+
+} // namespace
+
+TEST(LinkGraphTest, InternsUrlsAndBuildsDegrees) {
+    LinkGraph graph;
+    uint32_t a = graph.add_node("https://a.com/");
+    uint32_t b = graph.add_node("https://b.com/");
+    EXPECT_EQ(graph.add_node("https://a.com/"), a);
+    graph.add_edge(a, b);
+    graph.add_edge(a, a);  // Self-link ignored
+    graph.finalize(2);
+
+    EXPECT_EQ(graph.node_count(), 2u);
+    EXPECT_EQ(graph.edge_count(), 1u);
+    EXPECT_EQ(graph.url(b), "https://b.com/");
+    EXPECT_EQ(graph.out_degree(a), 1u);
+    EXPECT_EQ(graph.in_degree(b), 1u);
+    EXPECT_EQ(graph.in_degree(a), 0u);
+}
+
+TEST(LinkGraphTest, InternsAnEmptyUrlFirst) {
+    LinkGraph graph;
+    uint32_t empty = graph.add_node("");
+    uint32_t a = graph.add_node("https://a.com/");
+    EXPECT_EQ(graph.add_node(""), empty);
+    graph.add_edge(empty, a);
+    graph.finalize(1);
+
+    EXPECT_EQ(graph.node_count(), 2u);
+    EXPECT_EQ(graph.url(empty), "");
+    EXPECT_EQ(graph.url(a), "https://a.com/");
+    EXPECT_EQ(graph.in_degree(a), 1u);
+}
+
+TEST(LinkGraphTest, PageRankFavorsLinkedPages) {
+    LinkGraph graph = star_graph(1);
+    int iterations = 0;
+    std::vector<double> ranks = graph.pagerank(0.85, 100, 1e-10, 1, &iterations);
+
+    EXPECT_GT(iterations, 1);
+    EXPECT_NEAR(std::accumulate(ranks.begin(), ranks.end(), 0.0), 1.0, 1e-9);
+    EXPECT_GT(ranks[0], ranks[2] * 5);
+    EXPECT_GT(ranks[1], ranks[2]);  // leaf0 is linked from the hub
+}
+
+TEST(LinkGraphTest, ThreadCountDoesNotChangeRanks) {
+    std::vector<double> single = star_graph(1).pagerank(0.85, 100, 1e-12, 1);
+    std::vector<double> multi = star_graph(4).pagerank(0.85, 100, 1e-12, 4);
+    ASSERT_EQ(single.size(), multi.size());
+    for (size_t i = 0; i < single.size(); ++i) {
+        EXPECT_NEAR(single[i], multi[i], 1e-12);
+    }
+}
+
+TEST(LinkGraphTest, AggregatesHosts) {
+    LinkGraph graph;
+    uint32_t a1 = graph.add_node("https://a.com/1");
+    uint32_t a2 = graph.add_node("https://a.com/2");
+    uint32_t b = graph.add_node("https://b.com/");
+    uint32_t c = graph.add_node("https://c.com/");
+    graph.add_edge(a1, a2);
+    graph.add_edge(b, a1);
+    graph.add_edge(b, a2);
+    graph.add_edge(c, a1);
+    graph.finalize(1);
+
+    std::vector<double> ranks = graph.pagerank(0.85, 50, 1e-9, 1);
+    std::vector<LinkGraph::HostStats> hosts = graph.aggregate_hosts(ranks);
+    ASSERT_EQ(hosts.size(), 3u);
+    EXPECT_EQ(hosts[0].host, "a.com");
+    EXPECT_EQ(hosts[0].pages, 2u);
+    EXPECT_EQ(hosts[0].linking_hosts, 2u);
+    EXPECT_NEAR(hosts[0].rank, ranks[a1] + ranks[a2], 1e-12);
+    EXPECT_EQ(hosts[1].linking_hosts, 0u);
+}
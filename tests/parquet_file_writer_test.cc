@@ -0,0 +1,469 @@
+#include "parquet_file_writer.h"
+#include "url.h"
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <unistd.h>
+
+namespace {
+
+class ParquetFileWriterTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        path_ = "/tmp/test_parquet_" + std::to_string(getpid()) + "_" +
+                ::testing::UnitTest::GetInstance()->current_test_info()->name() + ".parquet";
+    }
+
+    void TearDown() override {
+        std::remove(path_.c_str());
+    }
+
+    std::string read() const {
+        std::ifstream file(path_, std::ios::binary);
+        std::stringstream content;
+        content << file.rdbuf();
+        return content.str();
+    }
+
+    std::string path_;
+};
+
+std::vector<DataRecord> records(int count) {
+    std::vector<DataRecord> result;
+    for (int i = 0; i < count; ++i) {
+        DataRecord record;
+        record.url = "https://example" + std::to_string(i % 3) + ".com/page/" + std::to_string(i);
+        record.title = "Page " + std::to_string(i);
+        record.text = "Repeated body text for page. " + std::string(200, 'a' + i % 5);
+        record.timestamp = "2026-01-01 00:00:00";
+        record.status_code = 200;
+        record.was_allowed = true;
+        record.content_length = 1000 + i;
+        record.was_skipped = false;
+        result.push_back(record);
+    }
+    return result;
+}
+
+// Length of the footer, as stored before the trailing magic
+uint32_t footer_length(const std::string& file) {
+    uint32_t length = 0;
+    for (int i = 0; i < 4; ++i) {
+        length |= static_cast<uint32_t>(static_cast<unsigned char>(file[file.size() - 8 + i])) << (8 * i);
+    }
+    return length;
+}
+
+uint32_t read_u32(const std::string& data, size_t pos) {
+    uint32_t value = 0;
+    for (int i = 0; i < 4; ++i) {
+        value |= static_cast<uint32_t>(static_cast<unsigned char>(data[pos + i])) << (8 * i);
+    }
+    return value;
+}
+
+// Thrift compact protocol value; structs keep their fields by id
+struct ThriftValue {
+    int64_t number = 0;
+    std::string binary;
+    std::vector<ThriftValue> list;
+    std::map<int16_t, ThriftValue> fields;
+
+    const ThriftValue& operator[](int16_t id) const {
+        static const ThriftValue missing;
+        auto it = fields.find(id);
+        return it == fields.end() ? missing : it->second;
+    }
+
+    bool has(int16_t id) const {
+        return fields.count(id) > 0;
+    }
+};
+
+// Reads the compact protocol independently of the writer's ThriftWriter
+class ThriftReader {
+public:
+    ThriftReader(const std::string& data, size_t pos) : data_(data), pos_(pos) {}
+
+    ThriftValue read_struct() {
+        ThriftValue value;
+        int16_t last_id = 0;
+        while (true) {
+            uint8_t header = byte();
+            if (header == 0) {
+                return value;
+            }
+            int type = header & 0x0f;
+            int delta = header >> 4;
+            int16_t id = delta != 0 ? static_cast<int16_t>(last_id + delta) : static_cast<int16_t>(zigzag());
+            last_id = id;
+            value.fields[id] = read_value(type);
+        }
+    }
+
+    size_t position() const {
+        return pos_;
+    }
+
+private:
+    const std::string& data_;
+    size_t pos_;
+
+    uint8_t byte() {
+        if (pos_ >= data_.size()) {
+            throw std::runtime_error("thrift: read past end");
+        }
+        return static_cast<uint8_t>(data_[pos_++]);
+    }
+
+    uint64_t varint() {
+        uint64_t value = 0;
+        for (int shift = 0;; shift += 7) {
+            uint8_t b = byte();
+            value |= static_cast<uint64_t>(b & 0x7f) << shift;
+            if ((b & 0x80) == 0) {
+                return value;
+            }
+        }
+    }
+
+    int64_t zigzag() {
+        uint64_t raw = varint();
+        return static_cast<int64_t>(raw >> 1) ^ -static_cast<int64_t>(raw & 1);
+    }
+
+    ThriftValue read_value(int type) {
+        ThriftValue value;
+        switch (type) {
+            case 1:  // Boolean true, false
+            case 2:
+                value.number = type == 1;
+                break;
+            case 3:
+                value.number = static_cast<int8_t>(byte());
+                break;
+            case 4:
+            case 5:
+            case 6:
+                value.number = zigzag();
+                break;
+            case 8: {
+                size_t size = varint();
+                value.binary = data_.substr(pos_, size);
+                pos_ += size;
+                break;
+            }
+            case 9: {
+                uint8_t header = byte();
+                size_t size = header >> 4;
+                if (size == 15) {
+                    size = varint();
+                }
+                for (size_t i = 0; i < size; ++i) {
+                    value.list.push_back(read_value(header & 0x0f));
+                }
+                break;
+            }
+            case 12:
+                return read_struct();
+            default:
+                throw std::runtime_error("thrift: unexpected type " + std::to_string(type));
+        }
+        return value;
+    }
+};
+
+// Snappy raw format
+std::string snappy_decompress(const std::string& input) {
+    size_t pos = 0;
+    uint64_t length = 0;
+    for (int shift = 0;; shift += 7) {
+        uint8_t b = static_cast<uint8_t>(input.at(pos++));
+        length |= static_cast<uint64_t>(b & 0x7f) << shift;
+        if ((b & 0x80) == 0) {
+            break;
+        }
+    }
+    std::string out;
+    while (pos < input.size()) {
+        uint8_t tag = static_cast<uint8_t>(input[pos++]);
+        size_t size = 0;
+        size_t offset = 0;
+        auto little_endian = [&](int bytes) {
+            size_t value = 0;
+            for (int i = 0; i < bytes; ++i) {
+                value |= static_cast<size_t>(static_cast<uint8_t>(input.at(pos++))) << (8 * i);
+            }
+            return value;
+        };
+        switch (tag & 3) {
+            case 0:
+                size = (tag >> 2) + 1;
+                if ((tag >> 2) >= 60) {
+                    size = little_endian((tag >> 2) - 59) + 1;
+                }
+                out.append(input, pos, size);
+                pos += size;
+                continue;
+            case 1:
+                size = ((tag >> 2) & 7) + 4;
+                offset = (static_cast<size_t>(tag >> 5) << 8) | little_endian(1);
+                break;
+            case 2:
+                size = (tag >> 2) + 1;
+                offset = little_endian(2);
+                break;
+            default:
+                size = (tag >> 2) + 1;
+                offset = little_endian(4);
+                break;
+        }
+        if (offset == 0 || offset > out.size()) {
+            throw std::runtime_error("snappy: bad copy offset");
+        }
+        for (size_t i = 0; i < size; ++i) {
+            out.push_back(out[out.size() - offset]);  // Copies may overlap their own output
+        }
+    }
+    if (out.size() != length) {
+        throw std::runtime_error("snappy: length mismatch");
+    }
+    return out;
+}
+
+// RLE/bit-packing hybrid, as prefixed with its bit width in dictionary data pages
+std::vector<uint32_t> decode_hybrid(const std::string& data, size_t count) {
+    size_t pos = 0;
+    int bit_width = static_cast<uint8_t>(data.at(pos++));
+    std::vector<uint32_t> values;
+    while (values.size() < count) {
+        uint64_t header = 0;
+        for (int shift = 0;; shift += 7) {
+            uint8_t b = static_cast<uint8_t>(data.at(pos++));
+            header |= static_cast<uint64_t>(b & 0x7f) << shift;
+            if ((b & 0x80) == 0) {
+                break;
+            }
+        }
+        if (header & 1) {
+            size_t packed = (header >> 1) * 8;
+            uint64_t bits = 0;
+            int available = 0;
+            for (size_t i = 0; i < packed; ++i) {
+                while (available < bit_width) {
+                    bits |= static_cast<uint64_t>(static_cast<uint8_t>(data.at(pos++))) << available;
+                    available += 8;
+                }
+                if (values.size() < count) {
+                    values.push_back(static_cast<uint32_t>(bits & ((1u << bit_width) - 1)));
+                }
+                bits >>= bit_width;
+                available -= bit_width;
+            }
+        } else {
+            uint32_t value = 0;
+            for (int i = 0; i < (bit_width + 7) / 8; ++i) {
+                value |= static_cast<uint32_t>(static_cast<uint8_t>(data.at(pos++))) << (8 * i);
+            }
+            values.insert(values.end(), header >> 1, value);
+        }
+    }
+    values.resize(count);
+    return values;
+}
+
+std::vector<std::string> decode_plain(const std::string& data, size_t count) {
+    std::vector<std::string> values;
+    size_t pos = 0;
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t size = read_u32(data, pos);
+        values.push_back(data.substr(pos + 4, size));
+        pos += 4 + size;
+    }
+    EXPECT_EQ(pos, data.size());
+    return values;
+}
+
+struct Page {
+    ThriftValue header;
+    std::string body;  // Decompressed
+};
+
+Page read_page(const std::string& file, int64_t offset) {
+    ThriftReader reader(file, static_cast<size_t>(offset));
+    Page page;
+    page.header = reader.read_struct();
+    std::string compressed = file.substr(reader.position(), static_cast<size_t>(page.header[3].number));
+    page.body = snappy_decompress(compressed);
+    EXPECT_EQ(page.body.size(), static_cast<size_t>(page.header[2].number));
+    return page;
+}
+
+// Values of one Snappy-compressed BYTE_ARRAY column chunk, through its dictionary if it has one
+std::vector<std::string> decode_byte_array_chunk(const std::string& file, const ThriftValue& meta) {
+    size_t rows = static_cast<size_t>(meta[5].number);
+    Page data = read_page(file, meta[9].number);
+    EXPECT_EQ(data.header[1].number, 0);  // DATA_PAGE
+    EXPECT_EQ(data.header[5][1].number, static_cast<int64_t>(rows));
+    if (!meta.has(11)) {
+        EXPECT_EQ(data.header[5][2].number, 0);  // PLAIN
+        return decode_plain(data.body, rows);
+    }
+
+    Page dictionary = read_page(file, meta[11].number);
+    EXPECT_EQ(dictionary.header[1].number, 2);  // DICTIONARY_PAGE
+    std::vector<std::string> entries =
+        decode_plain(dictionary.body, static_cast<size_t>(dictionary.header[7][1].number));
+    EXPECT_EQ(data.header[5][2].number, 8);  // RLE_DICTIONARY
+    std::vector<std::string> values;
+    for (uint32_t id : decode_hybrid(data.body, rows)) {
+        EXPECT_LT(id, entries.size());
+        values.push_back(id < entries.size() ? entries[id] : "");
+    }
+    return values;
+}
+
+} // namespace
+
+TEST_F(ParquetFileWriterTest, FileIsFramedByMagicAndFooter) {
+    ParquetFileWriter writer;
+    ASSERT_TRUE(writer.open(path_));
+    ASSERT_TRUE(writer.write(records(10)));
+    ASSERT_TRUE(writer.close());
+    EXPECT_FALSE(writer.is_open());
+
+    std::string file = read();
+    ASSERT_GT(file.size(), 12u);
+    EXPECT_EQ(file.substr(0, 4), "PAR1");
+    EXPECT_EQ(file.substr(file.size() - 4), "PAR1");
+    EXPECT_EQ(writer.bytes_written(), file.size());
+
+    uint32_t length = footer_length(file);
+    ASSERT_LT(length, file.size() - 12);
+    std::string footer = file.substr(file.size() - 8 - length, length);
+    for (const char* column : {"url", "host", "title", "text", "content_length", "status_code", "timestamp"}) {
+        EXPECT_NE(footer.find(column), std::string::npos) << column;
+    }
+    EXPECT_NE(footer.find("DatasetCrawler"), std::string::npos);
+}
+
+TEST_F(ParquetFileWriterTest, RowsAreSplitIntoRowGroups) {
+    ParquetWriterOptions options;
+    options.row_group_rows = 4;
+    ParquetFileWriter writer(options);
+    ASSERT_TRUE(writer.open(path_));
+    ASSERT_TRUE(writer.write(records(6)));
+    EXPECT_EQ(writer.row_groups(), 1u);  // The last two rows wait for more
+    ASSERT_TRUE(writer.write(records(4)));
+    ASSERT_TRUE(writer.close());
+
+    EXPECT_EQ(writer.row_groups(), 3u);
+    EXPECT_EQ(writer.rows_written(), 10u);
+}
+
+TEST_F(ParquetFileWriterTest, FooterAndPagesDecode) {
+    // Long same-host runs give the host indices RLE runs as well as bit-packed ones
+    std::vector<DataRecord> rows = records(30);
+    for (int i = 5; i < 22; ++i) {
+        rows[i].url = "https://runs.example.org/item/" + std::to_string(i);
+    }
+    ParquetWriterOptions options;
+    options.row_group_rows = 25;
+    options.compression = ParquetCompression::Snappy;
+    ParquetFileWriter writer(options);
+    ASSERT_TRUE(writer.open(path_));
+    ASSERT_TRUE(writer.write(rows));
+    ASSERT_TRUE(writer.close());
+
+    std::string file = read();
+    uint32_t length = footer_length(file);
+    ASSERT_LT(length, file.size() - 12);
+    ThriftValue metadata = ThriftReader(file, file.size() - 8 - length).read_struct();
+    EXPECT_EQ(metadata[3].number, 30);  // num_rows
+    EXPECT_EQ(metadata[2].list.size(), 8u);  // Root plus seven columns
+    EXPECT_EQ(metadata[2].list[2][4].binary, "host");
+
+    const auto& groups = metadata[4].list;
+    ASSERT_EQ(groups.size(), 2u);
+    size_t row = 0;
+    int64_t expected_offset = 4;  // Right after the leading magic
+    for (const auto& group : groups) {
+        size_t group_rows = static_cast<size_t>(group[3].number);
+        EXPECT_EQ(group[5].number, expected_offset);  // file_offset
+        const auto& columns = group[1].list;
+        ASSERT_EQ(columns.size(), 7u);
+        EXPECT_EQ(columns[0][2].number, expected_offset);  // Chunk starts with the url column
+
+        const ThriftValue& url = columns[0][3];
+        const ThriftValue& host = columns[1][3];
+        const ThriftValue& text = columns[3][3];
+        EXPECT_EQ(url[4].number, 1);  // SNAPPY
+        EXPECT_EQ(host[3].list[0].binary, "host");
+        ASSERT_TRUE(host.has(11));
+        EXPECT_LT(host[11].number, host[9].number);  // Dictionary page first
+
+        std::vector<std::string> urls = decode_byte_array_chunk(file, url);
+        std::vector<std::string> hosts = decode_byte_array_chunk(file, host);
+        std::vector<std::string> texts = decode_byte_array_chunk(file, text);
+        ASSERT_EQ(urls.size(), group_rows);
+        ASSERT_EQ(hosts.size(), group_rows);
+        ASSERT_EQ(texts.size(), group_rows);
+        for (size_t i = 0; i < group_rows; ++i, ++row) {
+            EXPECT_EQ(urls[i], rows[row].url);
+            EXPECT_EQ(hosts[i], std::string(Url::parse(rows[row].url).host())) << row;
+            EXPECT_EQ(texts[i], rows[row].text);
+        }
+
+        int64_t group_end = expected_offset;
+        for (const auto& column : columns) {
+            group_end += column[3][7].number;  // total_compressed_size
+        }
+        expected_offset = group_end;
+    }
+    EXPECT_EQ(row, 30u);
+    EXPECT_EQ(static_cast<uint64_t>(expected_offset), file.size() - 8 - length);  // Footer follows the data
+}
+
+TEST_F(ParquetFileWriterTest, EveryCodecWritesACompleteFile) {
+    size_t uncompressed = 0;
+    for (auto codec : {ParquetCompression::None, ParquetCompression::Snappy, ParquetCompression::Gzip,
+                       ParquetCompression::Zstd}) {
+        ParquetWriterOptions options;
+        options.compression = codec;
+        ParquetFileWriter writer(options);
+        ASSERT_TRUE(writer.open(path_));
+        ASSERT_TRUE(writer.write(records(50)));
+        ASSERT_TRUE(writer.close());
+
+        std::string file = read();
+        EXPECT_EQ(file.substr(file.size() - 4), "PAR1");
+        if (codec == ParquetCompression::None) {
+            uncompressed = file.size();
+        } else {
+            EXPECT_LT(file.size(), uncompressed);
+        }
+    }
+}
+
+TEST_F(ParquetFileWriterTest, EmptyFileIsStillValid) {
+    ParquetFileWriter writer;
+    ASSERT_TRUE(writer.open(path_));
+    ASSERT_TRUE(writer.close());
+
+    std::string file = read();
+    EXPECT_EQ(file.substr(0, 4), "PAR1");
+    EXPECT_EQ(file.substr(file.size() - 4), "PAR1");
+    EXPECT_EQ(writer.row_groups(), 0u);
+}
+
+TEST(ParquetCompressionTest, ParsesCodecNames) {
+    EXPECT_EQ(ParquetFileWriter::parse_compression("none"), ParquetCompression::None);
+    EXPECT_EQ(ParquetFileWriter::parse_compression("Snappy"), ParquetCompression::Snappy);
+    EXPECT_EQ(ParquetFileWriter::parse_compression("gzip"), ParquetCompression::Gzip);
+    EXPECT_EQ(ParquetFileWriter::parse_compression("zstd"), ParquetCompression::Zstd);
+    EXPECT_EQ(ParquetFileWriter::parse_compression("lz4"), ParquetCompression::Snappy);
+}
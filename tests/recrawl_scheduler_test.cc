@@ -0,0 +1,76 @@
+#include "recrawl_scheduler.h"
+#include <gtest/gtest.h>
+
+namespace {
+
+constexpr int64_t kHour = 3600;
+constexpr int64_t kDay = 86400;
+
+// Fetch a page every `interval` seconds; it changes on every `change_every`-th visit
+FetchHistory simulate(const RecrawlScheduler& scheduler, int visits, int64_t interval, int change_every) {
+    FetchHistory history;
+    uint64_t fingerprint = 0x0123456789ABCDEFULL;
+    for (int i = 0; i < visits; ++i) {
+        if (change_every > 0 && i > 0 && i % change_every == 0) {
+            fingerprint = ~fingerprint;
+        }
+        scheduler.record_fetch(history, fingerprint, 1700000000 + i * interval);
+    }
+    return history;
+}
+
+} // namespace
+
+TEST(RecrawlSchedulerTest, FirstFetchUsesInitialInterval) {
+    RecrawlScheduler scheduler(kHour, 30 * kDay);
+    FetchHistory history;
+    EXPECT_FALSE(scheduler.record_fetch(history, 42, 1000));
+    EXPECT_EQ(history.fetches, 1u);
+    EXPECT_EQ(history.next_due, 1000 + kDay);
+}
+
+TEST(RecrawlSchedulerTest, DetectsChangesBySimHashDistance) {
+    RecrawlScheduler scheduler;
+    FetchHistory history;
+    scheduler.record_fetch(history, 0xF0F0, 1000);
+    EXPECT_FALSE(scheduler.record_fetch(history, 0xF0F1, 2000));  // 1 bit: same page
+    EXPECT_TRUE(scheduler.record_fetch(history, 0x0F0F, 3000));
+    EXPECT_EQ(history.changes, 1u);
+    EXPECT_EQ(history.fetches, 3u);
+}
+
+TEST(RecrawlSchedulerTest, FrequentlyChangingPagesComeBackSooner) {
+    RecrawlScheduler scheduler(kHour, 30 * kDay);
+    FetchHistory always = simulate(scheduler, 6, kDay, 1);
+    FetchHistory sometimes = simulate(scheduler, 6, kDay, 3);
+    FetchHistory never = simulate(scheduler, 6, kDay, 0);
+
+    EXPECT_GT(RecrawlScheduler::change_rate(always), RecrawlScheduler::change_rate(sometimes));
+    EXPECT_EQ(RecrawlScheduler::change_rate(never), 0.0);
+
+    int64_t always_interval = scheduler.revisit_interval(always);
+    int64_t sometimes_interval = scheduler.revisit_interval(sometimes);
+    EXPECT_LT(always_interval, kDay);
+    EXPECT_LT(always_interval, sometimes_interval);
+    EXPECT_EQ(scheduler.revisit_interval(never), 2 * kDay);
+}
+
+TEST(RecrawlSchedulerTest, ClampsIntervals) {
+    RecrawlScheduler scheduler(2 * kHour, 3 * kDay);
+    EXPECT_EQ(scheduler.revisit_interval(simulate(scheduler, 10, 60, 1)), 2 * kHour);
+    EXPECT_EQ(scheduler.revisit_interval(simulate(scheduler, 10, 10 * kDay, 0)), 3 * kDay);
+}
+
+TEST(RecrawlSchedulerTest, SerializesHistory) {
+    RecrawlScheduler scheduler;
+    FetchHistory history = simulate(scheduler, 4, kDay, 2);
+    FetchHistory restored;
+    ASSERT_TRUE(RecrawlScheduler::deserialize(RecrawlScheduler::serialize(history), restored));
+    EXPECT_EQ(restored.first_fetch, history.first_fetch);
+    EXPECT_EQ(restored.last_fetch, history.last_fetch);
+    EXPECT_EQ(restored.fetches, history.fetches);
+    EXPECT_EQ(restored.changes, history.changes);
+    EXPECT_EQ(restored.fingerprint, history.fingerprint);
+    EXPECT_EQ(restored.next_due, history.next_due);
+    EXPECT_FALSE(RecrawlScheduler::deserialize("", restored));
+}
@@ -0,0 +1,32 @@
+#include "retry_budget.h"
+#include <gtest/gtest.h>
+
+TEST(RetryBudgetTest, StartsWithReserve) {
+    RetryBudget budget(0.1, 3.0);
+    EXPECT_TRUE(budget.try_spend());
+    EXPECT_TRUE(budget.try_spend());
+    EXPECT_TRUE(budget.try_spend());
+    EXPECT_FALSE(budget.try_spend());
+}
+
+TEST(RetryBudgetTest, RetriesStayWithinRatioOfRequests) {
+    RetryBudget budget(0.1, 2.0);
+    while (budget.try_spend()) {
+    }
+
+    int retries = 0;
+    for (int i = 0; i < 1000; ++i) {
+        budget.on_request();
+        if (budget.try_spend()) {
+            retries++;
+        }
+    }
+    EXPECT_GE(retries, 99);
+    EXPECT_LE(retries, 100);
+
+    // Idle requests refill the balance only up to the reserve
+    for (int i = 0; i < 1000; ++i) {
+        budget.on_request();
+    }
+    EXPECT_DOUBLE_EQ(budget.balance(), 2.0);
+}
@@ -0,0 +1,101 @@
+#include "robots_cache.h"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+std::shared_ptr<const RobotsEntry> make_entry(const std::string& disallow,
+                                              std::chrono::system_clock::time_point fetched_at =
+                                                  std::chrono::system_clock::now()) {
+    auto entry = std::make_shared<RobotsEntry>();
+    entry->matcher.add_pattern(disallow, false);
+    entry->fetched_at = fetched_at;
+    return entry;
+}
+
+} // namespace
+
+TEST(RobotsCacheTest, CachedEntryIsReused) {
+    RobotsCache cache;
+    int loads = 0;
+    auto loader = [&loads](const std::string&) {
+        ++loads;
+        return make_entry("/private");
+    };
+
+    auto first = cache.get("example.com", loader);
+    auto second = cache.get("example.com", loader);
+    ASSERT_TRUE(first);
+    EXPECT_EQ(first, second);
+    EXPECT_EQ(loads, 1);
+    EXPECT_FALSE(first->matcher.is_allowed("/private/page"));
+}
+
+TEST(RobotsCacheTest, LeastRecentlyUsedHostIsEvicted) {
+    RobotsCache cache(2, 3600);
+    auto loader = [](const std::string&) { return make_entry("/x"); };
+
+    cache.get("a.com", loader);
+    cache.get("b.com", loader);
+    cache.get("a.com", loader);  // a.com becomes most recent
+    cache.get("c.com", loader);
+
+    EXPECT_EQ(cache.size(), 2u);
+    EXPECT_TRUE(cache.find("a.com"));
+    EXPECT_FALSE(cache.find("b.com"));
+    EXPECT_TRUE(cache.find("c.com"));
+}
+
+TEST(RobotsCacheTest, ExpiredEntryIsReloaded) {
+    RobotsCache cache(10, 60);
+    int loads = 0;
+    auto stale_loader = [&loads](const std::string&) {
+        ++loads;
+        return make_entry("/x", std::chrono::system_clock::now() - std::chrono::seconds(120));
+    };
+
+    cache.get("example.com", stale_loader);
+    EXPECT_FALSE(cache.find("example.com"));
+    cache.get("example.com", stale_loader);
+    EXPECT_EQ(loads, 2);
+}
+
+TEST(RobotsCacheTest, ConcurrentRequestsShareOneLoad) {
+    RobotsCache cache;
+    std::atomic<int> loads{0};
+    auto loader = [&loads](const std::string&) {
+        ++loads;
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        return make_entry("/private");
+    };
+
+    std::vector<std::thread> threads;
+    std::atomic<int> allowed{0};
+    for (int i = 0; i < 8; ++i) {
+        threads.emplace_back([&] {
+            auto entry = cache.get("example.com", loader);
+            if (entry && entry->matcher.is_allowed("/public")) {
+                ++allowed;
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(loads.load(), 1);
+    EXPECT_EQ(allowed.load(), 8);
+}
+
+TEST(RobotsCacheTest, FailedLoadIsNotCached) {
+    RobotsCache cache;
+    auto failing = [](const std::string&) -> std::shared_ptr<const RobotsEntry> {
+        throw std::runtime_error("connection reset");
+    };
+
+    EXPECT_FALSE(cache.get("example.com", failing));
+    EXPECT_EQ(cache.size(), 0u);
+    EXPECT_TRUE(cache.get("example.com", [](const std::string&) { return make_entry("/x"); }));
+}
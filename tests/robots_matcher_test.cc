@@ -0,0 +1,65 @@
+#include "robots_matcher.h"
+#include <gtest/gtest.h>
+
+class RobotsMatcherTest : public ::testing::Test {
+protected:
+    RobotsMatcher matcher;
+};
+
+TEST_F(RobotsMatcherTest, EmptyMatcherAllowsEverything) {
+    EXPECT_TRUE(matcher.is_allowed("/anything"));
+    EXPECT_EQ(matcher.pattern_count(), 0u);
+}
+
+TEST_F(RobotsMatcherTest, LiteralPrefixes) {
+    matcher.add_pattern("/fish", false);
+
+    EXPECT_FALSE(matcher.is_allowed("/fish"));
+    EXPECT_FALSE(matcher.is_allowed("/fishheads/yummy.html"));
+    EXPECT_FALSE(matcher.is_allowed("/fish.php?id=anything"));
+    EXPECT_TRUE(matcher.is_allowed("/Fish.asp"));
+    EXPECT_TRUE(matcher.is_allowed("/catfish"));
+}
+
+TEST_F(RobotsMatcherTest, EndAnchoredLiteral) {
+    matcher.add_pattern("/", true);
+    matcher.add_pattern("/$", false);
+
+    EXPECT_TRUE(matcher.is_allowed("/page"));
+    // Allow wins when both patterns have the same length
+    EXPECT_TRUE(matcher.is_allowed("/"));
+}
+
+TEST_F(RobotsMatcherTest, WildcardsArePrefixMatches) {
+    matcher.add_pattern("/*.php", false);
+
+    EXPECT_FALSE(matcher.is_allowed("/index.php"));
+    EXPECT_FALSE(matcher.is_allowed("/folder/filename.php?parameters"));
+    EXPECT_FALSE(matcher.is_allowed("/filename.php/"));
+    EXPECT_TRUE(matcher.is_allowed("/windows.PHP"));
+}
+
+TEST_F(RobotsMatcherTest, WildcardWithEndAnchor) {
+    matcher.add_pattern("/*.php$", false);
+
+    EXPECT_FALSE(matcher.is_allowed("/filename.php"));
+    EXPECT_TRUE(matcher.is_allowed("/filename.php?parameters"));
+    EXPECT_TRUE(matcher.is_allowed("/filename.php5"));
+}
+
+TEST_F(RobotsMatcherTest, LongestMatchAcrossLiteralsAndWildcards) {
+    matcher.add_pattern("/", false);
+    matcher.add_pattern("/page", true);
+    matcher.add_pattern("/*.htm", false);
+
+    EXPECT_TRUE(matcher.is_allowed("/page"));
+    EXPECT_FALSE(matcher.is_allowed("/page.htm"));
+    EXPECT_FALSE(matcher.is_allowed("/other"));
+}
+
+TEST_F(RobotsMatcherTest, MatchPattern) {
+    EXPECT_TRUE(RobotsMatcher::match_pattern("/fish*.php", "/fish123.php"));
+    EXPECT_TRUE(RobotsMatcher::match_pattern("/*a*b*c", "/xxaxxbxxcxx"));
+    EXPECT_FALSE(RobotsMatcher::match_pattern("/*a*b*c$", "/xxaxxbxxcxx"));
+    EXPECT_FALSE(RobotsMatcher::match_pattern("/fish*.php", "/catfish.php"));
+}
@@ -0,0 +1,81 @@
+#include "robots_prefetcher.h"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+
+class RobotsPrefetcherTest : public ::testing::Test {
+protected:
+    // Block until `count` hosts were reported ready (or a timeout elapses)
+    bool wait_ready(size_t count) {
+        std::unique_lock<std::mutex> lock(mutex);
+        return ready_cv.wait_for(lock, std::chrono::seconds(5), [&] { return ready.size() >= count; });
+    }
+
+    void on_ready(const std::string& host) {
+        std::lock_guard<std::mutex> lock(mutex);
+        ready.insert(host);
+        ready_cv.notify_all();
+    }
+
+    RobotsPrefetcher prefetcher;
+    std::set<std::string> ready;
+    std::mutex mutex;
+    std::condition_variable ready_cv;
+};
+
+TEST_F(RobotsPrefetcherTest, LoadsEachScheduledHost) {
+    std::atomic<int> loads{0};
+    prefetcher.start(2,
+                     [&loads](const std::string&) { ++loads; },
+                     [this](const std::string& host) { on_ready(host); });
+
+    EXPECT_TRUE(prefetcher.schedule("a.com"));
+    EXPECT_TRUE(prefetcher.schedule("b.com"));
+    ASSERT_TRUE(wait_ready(2));
+
+    EXPECT_EQ(loads.load(), 2);
+    EXPECT_EQ(ready.count("a.com"), 1u);
+    EXPECT_EQ(ready.count("b.com"), 1u);
+}
+
+TEST_F(RobotsPrefetcherTest, PendingHostIsQueuedOnce) {
+    std::mutex gate;
+    gate.lock();
+    std::atomic<int> loads{0};
+    prefetcher.start(1,
+                     [&](const std::string&) {
+                         std::lock_guard<std::mutex> wait(gate);
+                         ++loads;
+                     },
+                     [this](const std::string& host) { on_ready(host); });
+
+    EXPECT_TRUE(prefetcher.schedule("a.com"));
+    EXPECT_FALSE(prefetcher.schedule("a.com"));
+    EXPECT_EQ(prefetcher.pending(), 1u);
+
+    gate.unlock();
+    ASSERT_TRUE(wait_ready(1));
+    EXPECT_EQ(loads.load(), 1);
+}
+
+TEST_F(RobotsPrefetcherTest, FailedLoadStillReportsReady) {
+    prefetcher.start(1,
+                     [](const std::string&) { throw std::runtime_error("timeout"); },
+                     [this](const std::string& host) { on_ready(host); });
+
+    prefetcher.schedule("a.com");
+    EXPECT_TRUE(wait_ready(1));
+}
+
+TEST_F(RobotsPrefetcherTest, NothingIsScheduledWhenStopped) {
+    EXPECT_FALSE(prefetcher.schedule("a.com"));
+
+    prefetcher.start(1, [](const std::string&) {}, [](const std::string&) {});
+    prefetcher.stop();
+    EXPECT_FALSE(prefetcher.is_running());
+    EXPECT_FALSE(prefetcher.schedule("a.com"));
+}
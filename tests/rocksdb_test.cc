@@ -1,5 +1,6 @@
 #include "rocksdb_manager.h"
 #include <gtest/gtest.h>
+#include <algorithm>
 #include <filesystem>
 #include <random>
 #include <chrono>
@@ -40,6 +41,17 @@ TEST_F(RocksDBManagerTest, EnqueueAndDequeue) {
     EXPECT_EQ(db->dequeue_url(), "https://another.com");
 }
 
+TEST_F(RocksDBManagerTest, DequeueReportsPriority) {
+    ASSERT_TRUE(db->enqueue_url("https://late.com", 42));
+    ASSERT_TRUE(db->enqueue_url("https://seed.com", 0));
+    
+    int priority = -1;
+    EXPECT_EQ(db->dequeue_url(&priority), "https://seed.com");
+    EXPECT_EQ(priority, 0);
+    EXPECT_EQ(db->dequeue_url(&priority), "https://late.com");
+    EXPECT_EQ(priority, 42);
+}
+
 TEST_F(RocksDBManagerTest, QueueSize) {
     ASSERT_TRUE(db->enqueue_url("https://example.com"));
     ASSERT_TRUE(db->enqueue_url("https://test.com"));
@@ -55,6 +67,35 @@ TEST_F(RocksDBManagerTest, QueueSize) {
     EXPECT_FALSE(db->has_queued_urls());
 }
 
+TEST_F(RocksDBManagerTest, DeferredUrlsWaitPerHost) {
+    ASSERT_TRUE(db->defer_url("a.com", "https://a.com/1", 5));
+    ASSERT_TRUE(db->defer_url("a.com", "https://a.com/2", 0));
+    ASSERT_TRUE(db->defer_url("a.com.evil", "https://a.com.evil/", 0));
+    ASSERT_TRUE(db->defer_url("b.org", "https://b.org/", 0));
+    
+    // Deferred URLs are not in the queue
+    EXPECT_FALSE(db->has_queued_urls());
+    std::vector<std::string> hosts = db->get_deferred_hosts();
+    std::sort(hosts.begin(), hosts.end());
+    EXPECT_EQ(hosts, (std::vector<std::string>{"a.com", "a.com.evil", "b.org"}));
+    
+    EXPECT_EQ(db->release_deferred_urls("a.com"), 2u);
+    EXPECT_EQ(db->get_queue_size(), 2);
+    int priority = -1;
+    EXPECT_EQ(db->dequeue_url(&priority), "https://a.com/2");
+    EXPECT_EQ(priority, 0);
+    EXPECT_EQ(db->dequeue_url(&priority), "https://a.com/1");
+    EXPECT_EQ(priority, 5);
+    
+    EXPECT_EQ(db->release_deferred_urls("a.com"), 0u);
+    EXPECT_EQ(db->get_deferred_hosts(), (std::vector<std::string>{"a.com.evil", "b.org"}));
+    
+    // A host deferred again after its release keeps the new URLs only
+    ASSERT_TRUE(db->defer_url("a.com", "https://a.com/3", 0));
+    EXPECT_EQ(db->release_deferred_urls("a.com"), 1u);
+    EXPECT_EQ(db->dequeue_url(), "https://a.com/3");
+}
+
 TEST_F(RocksDBManagerTest, VisitedTracking) {
     ASSERT_TRUE(db->mark_visited("https://example.com"));
     ASSERT_TRUE(db->mark_visited("https://visited.com"));
@@ -104,3 +145,64 @@ TEST_F(RocksDBManagerTest, Statistics) {
     EXPECT_TRUE(stats.find("Queued URLs") != std::string::npos);
     EXPECT_TRUE(stats.find("Visited URLs") != std::string::npos);
 }
+
+TEST_F(RocksDBManagerTest, LinkGraphScanAndScores) {
+    ASSERT_TRUE(db->add_link_edge("https://a.com/", "https://b.com/"));
+    ASSERT_TRUE(db->add_link_edge("https://a.com/", "https://c.com/"));
+    ASSERT_TRUE(db->add_link_edge("https://b.com/", "https://a.com/"));
+
+    std::vector<std::pair<std::string, std::string>> edges;
+    size_t count = db->for_each_link_edge([&edges](std::string_view from, std::string_view to) {
+        edges.emplace_back(std::string(from), std::string(to));
+    });
+    EXPECT_EQ(count, 3u);
+    ASSERT_EQ(edges.size(), 3u);
+    EXPECT_EQ(edges[0], std::make_pair(std::string("https://a.com/"), std::string("https://b.com/")));
+    EXPECT_EQ(edges[2], std::make_pair(std::string("https://b.com/"), std::string("https://a.com/")));
+
+    EXPECT_DOUBLE_EQ(db->get_page_rank("https://a.com/"), 0.0);
+    ASSERT_TRUE(db->store_page_scores({{"https://a.com/", "2.5 1"}, {"https://b.com/", "0.25 1"}}));
+    EXPECT_DOUBLE_EQ(db->get_page_rank("https://a.com/"), 2.5);
+    EXPECT_DOUBLE_EQ(db->get_page_rank("https://b.com/"), 0.25);
+}
+
+TEST_F(RocksDBManagerTest, RecrawlIndex) {
+    ASSERT_TRUE(db->store_fetch_history("https://a.com/", "a", 2000, 0));
+    ASSERT_TRUE(db->store_fetch_history("https://b.com/", "b", 1000, 0));
+    ASSERT_TRUE(db->store_fetch_history("https://c.com/", "c", 5000, 0));
+    EXPECT_EQ(db->get_fetch_history("https://a.com/"), "a");
+
+    EXPECT_EQ(db->get_due_recrawls(999, 10), std::vector<std::string>{});
+    EXPECT_EQ(db->get_due_recrawls(2000, 10), (std::vector<std::string>{"https://b.com/", "https://a.com/"}));
+    EXPECT_EQ(db->get_due_recrawls(9999, 1), std::vector<std::string>{"https://b.com/"});
+
+    // Rescheduling moves the index entry
+    ASSERT_TRUE(db->store_fetch_history("https://b.com/", "b2", 8000, 1000));
+    EXPECT_EQ(db->get_due_recrawls(5000, 10), (std::vector<std::string>{"https://a.com/", "https://c.com/"}));
+
+    ASSERT_TRUE(db->mark_visited("https://a.com/"));
+    ASSERT_TRUE(db->unmark_visited("https://a.com/"));
+    EXPECT_FALSE(db->is_visited("https://a.com/"));
+}
+
+TEST_F(RocksDBManagerTest, ConditionalGetValidators) {
+    std::string etag, last_modified;
+    EXPECT_FALSE(db->get_validators("https://a.com/", etag, last_modified));
+
+    std::string title, text;
+    EXPECT_FALSE(db->get_cached_extract("https://a.com/", title, text));
+
+    ASSERT_TRUE(db->store_validators("https://a.com/", "<html>a</html>", "Two\nlines", "Body\ntext",
+                                     "\"v1\"", "Wed, 21 Oct 2015 07:28:00 GMT"));
+    ASSERT_TRUE(db->get_validators("https://a.com/", etag, last_modified));
+    EXPECT_EQ(etag, "\"v1\"");
+    EXPECT_EQ(last_modified, "Wed, 21 Oct 2015 07:28:00 GMT");
+    EXPECT_EQ(db->get_cached_html("https://a.com/"), "<html>a</html>");
+    ASSERT_TRUE(db->get_cached_extract("https://a.com/", title, text));
+    EXPECT_EQ(title, "Two\nlines");
+    EXPECT_EQ(text, "Body\ntext");
+
+    // A page that stops sending validators is no longer revalidated
+    ASSERT_TRUE(db->store_validators("https://a.com/", "<html>b</html>", "", "", "", ""));
+    EXPECT_FALSE(db->get_validators("https://a.com/", etag, last_modified));
+}
@@ -0,0 +1,88 @@
+#include "selector_matcher.h"
+#include <gtest/gtest.h>
+#include <gumbo.h>
+
+class SelectorMatcherTest : public ::testing::Test {
+protected:
+    void TearDown() override {
+        if (output_) {
+            gumbo_destroy_output(&kGumboDefaultOptions, output_);
+        }
+    }
+
+    // Parse a fragment and return the first element with the given tag
+    const GumboNode* parse_first(const std::string& html, GumboTag tag) {
+        output_ = gumbo_parse(html.c_str());
+        return find(output_->root, tag);
+    }
+
+    SelectorMatcher matcher;
+
+private:
+    static const GumboNode* find(const GumboNode* node, GumboTag tag) {
+        if (node->type != GUMBO_NODE_ELEMENT) return nullptr;
+        if (node->v.element.tag == tag) return node;
+        const GumboVector* children = &node->v.element.children;
+        for (unsigned int i = 0; i < children->length; ++i) {
+            const GumboNode* found = find(static_cast<const GumboNode*>(children->data[i]), tag);
+            if (found) return found;
+        }
+        return nullptr;
+    }
+
+    GumboOutput* output_ = nullptr;
+};
+
+TEST_F(SelectorMatcherTest, TagAndAttributeSelectors) {
+    EXPECT_EQ(matcher.compile("nav, img[src^='data:'], [aria-modal=\"true\"]"), 3u);
+
+    EXPECT_TRUE(matcher.matches(parse_first("<nav>menu</nav>", GUMBO_TAG_NAV)));
+}
+
+TEST_F(SelectorMatcherTest, AttributePrefixOnTag) {
+    matcher.compile("img[src^='data:']");
+
+    EXPECT_TRUE(matcher.matches(parse_first("<img src=\"data:image/png;base64,AAAA\">", GUMBO_TAG_IMG)));
+}
+
+TEST_F(SelectorMatcherTest, AttributePrefixRejectsOtherValues) {
+    matcher.compile("img[src^='data:']");
+
+    EXPECT_FALSE(matcher.matches(parse_first("<img src=\"/logo.png\">", GUMBO_TAG_IMG)));
+}
+
+TEST_F(SelectorMatcherTest, ClassAndIdSelectors) {
+    matcher.compile(".sidebar, #comments");
+
+    EXPECT_TRUE(matcher.matches(parse_first("<div class=\"col sidebar wide\">x</div>", GUMBO_TAG_DIV)));
+}
+
+TEST_F(SelectorMatcherTest, ClassMatchesWholeWordsOnly) {
+    matcher.compile(".sidebar");
+
+    EXPECT_FALSE(matcher.matches(parse_first("<div class=\"sidebar-toggle\">x</div>", GUMBO_TAG_DIV)));
+}
+
+TEST_F(SelectorMatcherTest, CaseInsensitiveFlag) {
+    matcher.compile("[aria-label*=\"skip\" i]");
+
+    EXPECT_TRUE(matcher.matches(parse_first("<section aria-label=\"Skip Links\">x</section>", GUMBO_TAG_SECTION)));
+}
+
+TEST_F(SelectorMatcherTest, CaseSensitiveByDefault) {
+    matcher.compile("[aria-label*=\"skip\"]");
+
+    EXPECT_FALSE(matcher.matches(parse_first("<section aria-label=\"Skip Links\">x</section>", GUMBO_TAG_SECTION)));
+}
+
+TEST_F(SelectorMatcherTest, AllConditionsMustMatch) {
+    matcher.compile("[role=\"region\"][data-ad]");
+
+    EXPECT_FALSE(matcher.matches(parse_first("<div role=\"region\">x</div>", GUMBO_TAG_DIV)));
+}
+
+TEST_F(SelectorMatcherTest, UnsupportedSelectorsAreSkipped) {
+    EXPECT_EQ(matcher.compile("div p, a:hover, aside, ul > li"), 1u);
+
+    EXPECT_FALSE(matcher.matches(parse_first("<div><p>x</p></div>", GUMBO_TAG_P)));
+}
@@ -0,0 +1,159 @@
+#include "sharded_dataset_sink.h"
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+
+namespace {
+
+class ShardedDatasetSinkTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        dir_ = "/tmp/test_dataset_sink_" + std::to_string(getpid()) + "_" +
+               ::testing::UnitTest::GetInstance()->current_test_info()->name();
+        std::filesystem::remove_all(dir_);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(dir_);
+    }
+
+    ShardedDatasetSinkConfig config(const std::string& format) const {
+        ShardedDatasetSinkConfig config;
+        config.output_dir = dir_;
+        config.format = format;
+        config.batch_size = 4;
+        return config;
+    }
+
+    std::string read(const std::string& name) const {
+        std::ifstream file(dir_ + "/" + name);
+        std::stringstream content;
+        content << file.rdbuf();
+        return content.str();
+    }
+
+    std::string dir_;
+};
+
+DataRecord record(int i) {
+    DataRecord record;
+    record.url = "https://example.com/" + std::to_string(i);
+    record.title = "Page " + std::to_string(i);
+    record.content = ByteBuffer::adopt(std::string(100, 'x'));
+    record.timestamp = "2026-01-01 00:00:00";
+    record.status_code = 200;
+    record.was_allowed = true;
+    record.content_length = 100;
+    record.was_skipped = false;
+    return record;
+}
+
+size_t count(const std::string& text, const std::string& needle) {
+    size_t found = 0;
+    for (size_t pos = text.find(needle); pos != std::string::npos; pos = text.find(needle, pos + 1)) {
+        found++;
+    }
+    return found;
+}
+
+} // namespace
+
+TEST_F(ShardedDatasetSinkTest, ShardIsCompleteAfterEveryFlush) {
+    ShardedDatasetSink sink(config("json"));
+    for (int i = 0; i < 6; ++i) {
+        sink.push(record(i));
+    }
+    sink.flush();
+    EXPECT_EQ(sink.records_written(), 6u);
+
+    std::string shard = read("dataset-00000.json");
+    EXPECT_EQ(shard.substr(0, 2), "[\n");
+    EXPECT_EQ(shard.substr(shard.size() - 3), "\n]\n");
+    EXPECT_EQ(count(shard, "\"url\""), 6u);
+
+    sink.push(record(6));
+    sink.flush();
+    shard = read("dataset-00000.json");
+    EXPECT_EQ(shard.substr(shard.size() - 3), "\n]\n");
+    EXPECT_EQ(count(shard, "\"url\""), 7u);
+    EXPECT_EQ(count(shard, "},\n"), 6u);
+    EXPECT_EQ(count(shard, "]"), 1u);
+}
+
+TEST_F(ShardedDatasetSinkTest, RotatesBySize) {
+    ShardedDatasetSinkConfig settings = config("both");
+    settings.max_shard_bytes = 1;  // Every batch fills a shard
+    {
+        ShardedDatasetSink sink(settings);
+        for (int i = 0; i < 10; ++i) {
+            sink.push(record(i));
+        }
+        sink.flush();
+        EXPECT_EQ(sink.records_written(), 10u);
+        EXPECT_EQ(sink.shards_opened(), 3u);
+    }
+
+    size_t rows = 0;
+    for (const char* name : {"dataset-00000", "dataset-00001", "dataset-00002"}) {
+        std::string csv = read(std::string(name) + ".csv");
+        EXPECT_EQ(csv.find("url,title,content_length,timestamp,status_code\n"), 0u);
+        rows += count(csv, "\n") - 1;
+        EXPECT_EQ(read(std::string(name) + ".json").substr(0, 2), "[\n");
+    }
+    EXPECT_EQ(rows, 10u);
+
+    // A later run continues the numbering
+    ShardedDatasetSink sink(settings);
+    sink.push(record(10));
+    sink.flush();
+    EXPECT_EQ(count(read("dataset-00003.json"), "\"url\""), 1u);
+}
+
+TEST_F(ShardedDatasetSinkTest, RotatesByAgeAndWritesPartialBatches) {
+    ShardedDatasetSinkConfig settings = config("csv");
+    settings.max_shard_age = std::chrono::seconds(0);
+    settings.flush_interval = std::chrono::milliseconds(10);
+    ShardedDatasetSink sink(settings);
+
+    sink.push(record(0));
+    // Less than a batch: written once the flush interval passes, no flush() needed
+    for (int i = 0; i < 200 && sink.records_written() < 1; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    EXPECT_EQ(sink.records_written(), 1u);
+
+    sink.push(record(1));
+    sink.flush();
+    EXPECT_EQ(sink.shards_opened(), 2u);
+    EXPECT_NE(read("dataset-00001.csv").find("https://example.com/1"), std::string::npos);
+}
+
+TEST_F(ShardedDatasetSinkTest, PushBlocksInsteadOfQueueingWithoutBound) {
+    ShardedDatasetSink sink(config("json"));
+    for (int i = 0; i < 1000; ++i) {
+        sink.push(record(i));
+    }
+    sink.flush();
+    EXPECT_EQ(sink.records_written(), 1000u);
+    EXPECT_EQ(count(read("dataset-00000.json"), "\"url\""), 1000u);
+}
+
+TEST_F(ShardedDatasetSinkTest, ParquetShardIsFinishedOnClose) {
+    {
+        ShardedDatasetSink sink(config("json, parquet"));
+        for (int i = 0; i < 6; ++i) {
+            sink.push(record(i));
+        }
+        sink.flush();
+        EXPECT_EQ(sink.records_written(), 6u);
+    }
+
+    std::string parquet = read("dataset-00000.parquet");
+    ASSERT_GT(parquet.size(), 8u);
+    EXPECT_EQ(parquet.substr(0, 4), "PAR1");
+    EXPECT_EQ(parquet.substr(parquet.size() - 4), "PAR1");
+    EXPECT_EQ(count(read("dataset-00000.json"), "\"url\""), 6u);
+}
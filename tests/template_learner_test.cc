@@ -0,0 +1,179 @@
+#include "template_learner.h"
+#include <gtest/gtest.h>
+#include <gumbo.h>
+#include <map>
+
+class TemplateLearnerTest : public ::testing::Test {
+protected:
+    // Parse a page and feed its <body> to the learner; the article is padded
+    // to outweigh the header and footer, as on a real page
+    size_t feed(const std::string& host, const std::string& article, bool pad = true) {
+        std::string html = "<html><body>"
+            "<div id=\"header\"><a href=\"/\">Site name</a> <a href=\"/about\">About</a></div>"
+            "<div class=\"content\"><p>" + article + (pad ? kArticleBody : "") + "</p></div>"
+            "<div class=\"footer\">Copyright Example Inc.</div>"
+            "</body></html>";
+        GumboOutput* output = gumbo_parse(html.c_str());
+        std::unordered_set<const void*> skipped;
+        size_t count = learner.process_page(host, body_of(output), skipped);
+        last_skipped_text.clear();
+        for (const void* node : skipped) {
+            append_text(static_cast<const GumboNode*>(node), last_skipped_text);
+        }
+        gumbo_destroy_output(&kGumboDefaultOptions, output);
+        return count;
+    }
+
+    static constexpr const char* kArticleBody =
+        ". The rest of the article text goes on for a while after its title.";
+
+    TemplateLearner learner;
+    std::string last_skipped_text;
+
+    static const GumboNode* body_of(GumboOutput* output) {
+        const GumboVector* children = &output->root->v.element.children;
+        for (unsigned int i = 0; i < children->length; ++i) {
+            const GumboNode* node = static_cast<const GumboNode*>(children->data[i]);
+            if (node->type == GUMBO_NODE_ELEMENT && node->v.element.tag == GUMBO_TAG_BODY) {
+                return node;
+            }
+        }
+        return nullptr;
+    }
+
+private:
+    static void append_text(const GumboNode* node, std::string& out) {
+        if (node->type == GUMBO_NODE_TEXT) {
+            out += node->v.text.text;
+            return;
+        }
+        if (node->type != GUMBO_NODE_ELEMENT) return;
+        const GumboVector* children = &node->v.element.children;
+        for (unsigned int i = 0; i < children->length; ++i) {
+            append_text(static_cast<const GumboNode*>(children->data[i]), out);
+        }
+    }
+};
+
+TEST_F(TemplateLearnerTest, RepeatedSubtreesBecomeTemplate) {
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_EQ(feed("example.com", "Article number " + std::to_string(i)), 0u);
+    }
+    EXPECT_EQ(feed("example.com", "Article number 4"), 2u);
+
+    EXPECT_TRUE(last_skipped_text.find("Site name") != std::string::npos);
+    EXPECT_TRUE(last_skipped_text.find("Copyright") != std::string::npos);
+    EXPECT_EQ(last_skipped_text.find("Article"), std::string::npos);
+}
+
+TEST_F(TemplateLearnerTest, HostsLearnIndependently) {
+    for (int i = 0; i < 5; ++i) {
+        feed("example.com", "Article number " + std::to_string(i));
+    }
+    EXPECT_GT(learner.template_size("example.com"), 0u);
+
+    EXPECT_EQ(feed("other.org", "Some page"), 0u);
+}
+
+TEST_F(TemplateLearnerTest, FrozenTemplateIsPersisted) {
+    std::map<std::string, std::string> store;
+    learner.set_learning_pages(5);
+    learner.set_persistence(
+        [&store](const std::string& host) { return store[host]; },
+        [&store](const std::string& host, const std::string& data) { store[host] = data; });
+    for (int i = 0; i < 5; ++i) {
+        feed("example.com", "Article number " + std::to_string(i));
+    }
+    ASSERT_FALSE(store["example.com"].empty());
+
+    TemplateLearner restarted;
+    restarted.set_persistence(
+        [&store](const std::string& host) { return store[host]; },
+        [&store](const std::string& host, const std::string& data) { store[host] = data; });
+    std::string html = "<html><body>"
+        "<div id=\"header\"><a href=\"/\">Site name</a> <a href=\"/about\">About</a></div>"
+        "<div class=\"content\"><p>Fresh article, long enough to outweigh the site chrome</p></div>"
+        "<div class=\"footer\">Copyright Example Inc.</div>"
+        "</body></html>";
+    GumboOutput* output = gumbo_parse(html.c_str());
+    std::unordered_set<const void*> skipped;
+
+    EXPECT_EQ(restarted.process_page("example.com", body_of(output), skipped), 2u);
+    gumbo_destroy_output(&kGumboDefaultOptions, output);
+}
+
+TEST_F(TemplateLearnerTest, RefusesTemplateHoldingMostOfThePage) {
+    std::map<std::string, std::string> store;
+    learner.set_learning_pages(5);
+    learner.set_persistence(
+        [&store](const std::string& host) { return store[host]; },
+        [&store](const std::string& host, const std::string& data) { store[host] = data; });
+    // Every sampled page was the same, e.g. a consent wall: the article is learned too
+    for (int i = 0; i < 4; ++i) {
+        feed("example.com", "Please accept cookies");
+    }
+    EXPECT_EQ(feed("example.com", "Please accept cookies"), 0u);
+    EXPECT_GT(learner.template_size("example.com"), 0u);
+    ASSERT_FALSE(store["example.com"].empty());
+
+    // A short page the template would mostly empty is extracted in full
+    EXPECT_EQ(feed("example.com", "Short note", false), 0u);
+    EXPECT_TRUE(last_skipped_text.empty());
+
+    // Refused on kMaxRefusals pages in a row: the template is learned again
+    for (int i = 0; i < 2; ++i) {
+        feed("example.com", "Please accept cookies");
+    }
+    EXPECT_GT(learner.template_size("example.com"), 0u);
+    feed("example.com", "Please accept cookies");
+    EXPECT_EQ(learner.template_size("example.com"), 0u);
+    EXPECT_TRUE(store["example.com"].empty());
+}
+
+TEST_F(TemplateLearnerTest, TemplateIsRelearnedAfterManyPages) {
+    learner.set_learning_pages(5);
+    learner.set_relearn_after(3, std::chrono::hours(1));
+    for (int i = 0; i < 5; ++i) {
+        feed("example.com", "Article number " + std::to_string(i));
+    }
+    for (int i = 5; i < 8; ++i) {
+        EXPECT_EQ(feed("example.com", "Article number " + std::to_string(i)), 2u);
+    }
+
+    EXPECT_EQ(feed("example.com", "Article number 8"), 0u);
+    EXPECT_EQ(learner.template_size("example.com"), 0u);
+}
+
+TEST_F(TemplateLearnerTest, TemplateWithoutLearnedTimeIsRelearned) {
+    std::map<std::string, std::string> store;
+    learner.set_learning_pages(5);
+    learner.set_persistence(
+        [&store](const std::string& host) { return store[host]; },
+        [&store](const std::string& host, const std::string& data) { store[host] = data; });
+    for (int i = 0; i < 5; ++i) {
+        feed("example.com", "Article number " + std::to_string(i));
+    }
+    std::string stored = store["example.com"];
+    ASSERT_EQ(stored.compare(0, 3, "v2 "), 0);
+
+    // Drop the version and learned-at fields, as written by older builds
+    size_t pages_end = stored.find(' ', 3);
+    size_t learned_end = stored.find(' ', pages_end + 1);
+    store["example.com"] = stored.substr(3, pages_end - 3) + stored.substr(learned_end);
+
+    TemplateLearner restarted;
+    restarted.set_persistence(
+        [&store](const std::string& host) { return store[host]; },
+        [&store](const std::string& host, const std::string& data) { store[host] = data; });
+    std::string html = "<html><body>"
+        "<div id=\"header\"><a href=\"/\">Site name</a> <a href=\"/about\">About</a></div>"
+        "<div class=\"content\"><p>Fresh article, long enough to outweigh the site chrome</p></div>"
+        "<div class=\"footer\">Copyright Example Inc.</div>"
+        "</body></html>";
+    GumboOutput* output = gumbo_parse(html.c_str());
+    std::unordered_set<const void*> skipped;
+
+    EXPECT_EQ(restarted.process_page("example.com", body_of(output), skipped), 0u);
+    EXPECT_TRUE(store["example.com"].empty());
+    gumbo_destroy_output(&kGumboDefaultOptions, output);
+}
@@ -115,3 +115,192 @@ function test() {
     EXPECT_TRUE(result.code_blocks[0].find("```js") != std::string::npos ||
                 result.code_blocks[0].find("```") != std::string::npos);
 }
+
+TEST_F(TextExtractorTest, InlineWhitespaceCollapsed) {
+    std::string html = R"(
+        <html>
+            <body>
+                <p>This   is <strong>bold</strong>
+                   and <em>italic</em>  text.</p>
+            </body>
+        </html>
+    )";
+    
+    TextExtraction result = extractor.extract_from_html(html, "http://test.com");
+    
+    EXPECT_EQ(result.text, "This is **bold** and *italic* text.");
+    EXPECT_EQ(result.plain_text, "This is bold and italic text.");
+}
+
+TEST_F(TextExtractorTest, ListsAndBlockquotes) {
+    std::string html = R"(
+        <html>
+            <body>
+                <ul><li>first</li><li>second</li></ul>
+                <blockquote><p>quoted line</p><p>another</p></blockquote>
+            </body>
+        </html>
+    )";
+    
+    TextExtraction result = extractor.extract_from_html(html, "http://test.com");
+    
+    EXPECT_TRUE(result.text.find("- first\n- second\n") != std::string::npos);
+    EXPECT_TRUE(result.text.find("> quoted line\n> another") != std::string::npos);
+}
+
+TEST_F(TextExtractorTest, DeeplyNestedDocument) {
+    const int depth = 2000;
+    std::string html = "<html><body>";
+    for (int i = 0; i < depth; ++i) {
+        html += "<span><b>x</b>";
+    }
+    for (int i = 0; i < depth; ++i) {
+        html += "</span>";
+    }
+    html += "</body></html>";
+    
+    TextExtraction result = extractor.extract_from_html(html, "http://test.com");
+    
+    EXPECT_EQ(result.plain_text.size(), static_cast<size_t>(depth));
+    EXPECT_EQ(result.text.size(), static_cast<size_t>(depth) * 5);
+}
+
+TEST_F(TextExtractorTest, NestedCodeIsOneBlock) {
+    std::string html = R"(
+        <html>
+            <body>
+                <pre><code>def main():
+    return self.value</code></pre>
+            </body>
+        </html>
+    )";
+    
+    TextExtraction result = extractor.extract_from_html(html, "http://test.com");
+    
+    ASSERT_EQ(result.code_blocks.size(), 1u);
+    EXPECT_EQ(result.code_blocks[0].rfind("```python\n", 0), 0u);
+    EXPECT_TRUE(result.text.find("```python\ndef main():\n    return self.value\n```") != std::string::npos);
+}
+
+TEST_F(TextExtractorTest, CustomRemoveSelectors) {
+    std::string html = R"(
+        <html>
+            <body>
+                <div class="sidebar">Related posts</div>
+                <div data-ad="top">Buy now</div>
+                <p>Article body</p>
+            </body>
+        </html>
+    )";
+    
+    extractor.set_remove_selectors(".sidebar, [data-ad]");
+    TextExtraction result = extractor.extract_from_html(html, "http://test.com");
+    
+    EXPECT_EQ(result.text.find("Related"), std::string::npos);
+    EXPECT_EQ(result.text.find("Buy now"), std::string::npos);
+    EXPECT_TRUE(result.text.find("Article body") != std::string::npos);
+}
+
+TEST_F(TextExtractorTest, MainContentDropsBoilerplate) {
+    std::string html = R"(
+        <html>
+            <body>
+                <div class="header-links"><a href="/a">Home</a> <a href="/b">About</a> <a href="/c">Contact</a></div>
+                <div class="layout">
+                    <div class="sidebar"><p>Popular posts you might enjoy reading today.</p></div>
+                    <article>
+                        <p>The first paragraph of the article explains the topic, with enough detail to matter.</p>
+                        <p>The second paragraph continues the story, adding context, numbers, and a quote.</p>
+                        <div class="comments"><p>Great article, thanks for sharing this with everyone!</p></div>
+                    </article>
+                </div>
+                <ul><li><a href="/x">Related link one</a></li><li><a href="/y">Related link two</a></li></ul>
+            </body>
+        </html>
+    )";
+    
+    extractor.set_extraction_mode(ExtractionMode::MainContent);
+    TextExtraction result = extractor.extract_from_html(html, "http://test.com");
+    
+    EXPECT_TRUE(result.text.find("first paragraph") != std::string::npos);
+    EXPECT_TRUE(result.text.find("second paragraph") != std::string::npos);
+    EXPECT_EQ(result.text.find("Popular posts"), std::string::npos);
+    EXPECT_EQ(result.text.find("Great article"), std::string::npos);
+    EXPECT_EQ(result.text.find("Related link"), std::string::npos);
+    EXPECT_EQ(result.text.find("Home"), std::string::npos);
+}
+
+TEST_F(TextExtractorTest, MainContentFallsBackToFullPage) {
+    std::string html = R"(
+        <html>
+            <body>
+                <p>Short note.</p>
+            </body>
+        </html>
+    )";
+    
+    extractor.set_extraction_mode(ExtractionMode::MainContent);
+    TextExtraction result = extractor.extract_from_html(html, "http://test.com");
+    
+    EXPECT_EQ(result.text, "Short note.");
+}
+
+TEST_F(TextExtractorTest, MainContentHintsMatchWholeWords) {
+    // "shareholders" is not "share": the report inside it must not be pruned
+    std::string html = R"(
+        <html>
+            <body>
+                <div class="shareholders-letter">
+                    <p>The first paragraph of the article explains the topic, with enough detail to matter.</p>
+                    <p>The second paragraph continues the story, adding context, numbers, and a quote.</p>
+                </div>
+                <div class="main-nav"><p>Navigation entries that belong to the site chrome.</p></div>
+            </body>
+        </html>
+    )";
+    
+    extractor.set_extraction_mode(ExtractionMode::MainContent);
+    TextExtraction result = extractor.extract_from_html(html, "http://test.com");
+    
+    EXPECT_TRUE(result.text.find("first paragraph") != std::string::npos);
+    EXPECT_TRUE(result.text.find("second paragraph") != std::string::npos);
+    EXPECT_EQ(result.text.find("Navigation entries"), std::string::npos);
+}
+
+TEST_F(TextExtractorTest, MainContentHintsIgnoreEmbeddedWords) {
+    // "domains" is not "main": the list of domains gets no content boost
+    std::string html = R"(
+        <html>
+            <body>
+                <div class="layout">
+                    <div id="parked-domains"><p>Register one of these parked domain names today.</p></div>
+                    <div>
+                        <p>The first paragraph of the article explains the topic, with enough detail to matter.</p>
+                        <p>The second paragraph continues the story, adding context, numbers, and a quote.</p>
+                    </div>
+                </div>
+            </body>
+        </html>
+    )";
+    
+    extractor.set_extraction_mode(ExtractionMode::MainContent);
+    TextExtraction result = extractor.extract_from_html(html, "http://test.com");
+    
+    EXPECT_TRUE(result.text.find("first paragraph") != std::string::npos);
+    EXPECT_EQ(result.text.find("parked domain"), std::string::npos);
+}
+
+TEST_F(TextExtractorTest, LearnedTemplatesAreSkipped) {
+    extractor.enable_template_learning(true);
+    TextExtraction result;
+    for (int i = 0; i < 6; ++i) {
+        std::string html = "<html><body>"
+            "<div class=\"masthead\">Example Site Header</div>"
+            "<p>Article text number " + std::to_string(i) + "</p>"
+            "</body></html>";
+        result = extractor.extract_from_html(html, "https://Example.com/page" + std::to_string(i));
+    }
+    
+    EXPECT_EQ(result.text.find("Example Site Header"), std::string::npos);
+    EXPECT_TRUE(result.text.find("Article text number 5") != std::string::npos);
+}
@@ -0,0 +1,102 @@
+#include "trap_detector.h"
+#include <gtest/gtest.h>
+
+namespace {
+
+TrapVerdict check(TrapDetector& detector, const std::string& spec) {
+    return detector.check(Url::parse(spec));
+}
+
+} // namespace
+
+TEST(TrapDetectorTest, AllowsOrdinaryUrls) {
+    TrapDetector detector;
+    EXPECT_EQ(check(detector, "https://example.com/"), TrapVerdict::Allow);
+    EXPECT_EQ(check(detector, "https://example.com/blog/2024/05/post?page=2"), TrapVerdict::Allow);
+    EXPECT_TRUE(detector.flagged_prefixes().empty());
+}
+
+TEST(TrapDetectorTest, BlocksDeepAndRepeatingPaths) {
+    TrapLimits limits;
+    limits.max_path_depth = 6;
+    TrapDetector detector(limits);
+    EXPECT_EQ(check(detector, "https://example.com/a/b/c/d/e/f"), TrapVerdict::Allow);
+    EXPECT_EQ(check(detector, "https://example.com/a/b/c/d/e/f/g"), TrapVerdict::Block);
+    EXPECT_EQ(check(detector, "https://example.com/x/y/x/y/x/y"), TrapVerdict::Allow);
+    EXPECT_EQ(check(detector, "https://example.com/x/x/x/x"), TrapVerdict::Block);
+}
+
+TEST(TrapDetectorTest, ThrottlesExplodingParameter) {
+    TrapLimits limits;
+    limits.max_param_values = 20;
+    limits.throttled_urls_per_minute = 3;
+    TrapDetector detector(limits);
+
+    for (int day = 0; day < 20; ++day) {
+        EXPECT_EQ(check(detector, "https://example.com/calendar?date=" + std::to_string(day)), TrapVerdict::Allow);
+    }
+    int allowed = 0;
+    for (int day = 20; day < 30; ++day) {
+        if (check(detector, "https://example.com/calendar?date=" + std::to_string(day)) == TrapVerdict::Allow) {
+            ++allowed;
+        }
+    }
+    EXPECT_EQ(allowed, 3);
+    ASSERT_EQ(detector.flagged_prefixes().size(), 1u);
+    EXPECT_EQ(detector.flagged_prefixes()[0].rfind("example.com/calendar (throttled", 0), 0u);
+
+    // Other sections of the host are unaffected
+    EXPECT_EQ(check(detector, "https://example.com/news?id=1"), TrapVerdict::Allow);
+}
+
+TEST(TrapDetectorTest, ThrottlesPrefixDiscoveringFarMoreThanItYields) {
+    TrapLimits limits;
+    limits.min_fetches_for_ratio = 10;
+    limits.max_discovered_per_unique = 5.0;
+    limits.throttled_urls_per_minute = 0;
+    TrapDetector detector(limits);
+
+    for (int i = 0; i < 10; ++i) {
+        uint64_t fingerprint = 0x9E3779B97F4A7C15ULL * static_cast<uint64_t>(i + 1);
+        EXPECT_TRUE(detector.record_fetch(Url::parse("https://example.com/tags/" + std::to_string(i)), fingerprint));
+    }
+    // Ten unique pages earn fifty discoveries
+    for (int i = 0; i < 50; ++i) {
+        EXPECT_EQ(check(detector, "https://example.com/tags/a" + std::to_string(i)), TrapVerdict::Allow);
+    }
+    EXPECT_EQ(check(detector, "https://example.com/tags/b"), TrapVerdict::Throttle);
+    ASSERT_EQ(detector.flagged_prefixes().size(), 1u);
+    EXPECT_EQ(detector.flagged_prefixes()[0].rfind("example.com/tags (throttled: 51 URLs discovered", 0), 0u);
+    EXPECT_EQ(check(detector, "https://example.com/about"), TrapVerdict::Allow);
+}
+
+TEST(TrapDetectorTest, BlocksPrefixWithMostlyDuplicateContent) {
+    TrapLimits limits;
+    limits.min_fetches_for_ratio = 10;
+    TrapDetector detector(limits);
+
+    EXPECT_TRUE(detector.record_fetch(Url::parse("https://example.com/search?q=0"), 0xF0F0));
+    for (int i = 1; i < 10; ++i) {
+        // Near-identical result pages
+        EXPECT_FALSE(detector.record_fetch(Url::parse("https://example.com/search?q=" + std::to_string(i)),
+                                           0xF0F0 ^ (1ULL << i)));
+    }
+    EXPECT_EQ(check(detector, "https://example.com/search?q=new"), TrapVerdict::Block);
+    EXPECT_EQ(check(detector, "https://example.com/about"), TrapVerdict::Allow);
+}
+
+TEST(TrapDetectorTest, RefetchedPageIsNotItsOwnDuplicate) {
+    TrapLimits limits;
+    limits.min_fetches_for_ratio = 10;
+    TrapDetector detector(limits);
+
+    for (int round = 0; round < 10; ++round) {
+        for (int i = 0; i < 3; ++i) {
+            uint64_t fingerprint = 0x9E3779B97F4A7C15ULL * static_cast<uint64_t>(i + 1);
+            EXPECT_TRUE(detector.record_fetch(Url::parse("https://example.com/docs/" + std::to_string(i)),
+                                              fingerprint));
+        }
+    }
+    EXPECT_EQ(check(detector, "https://example.com/docs/new"), TrapVerdict::Allow);
+    EXPECT_TRUE(detector.flagged_prefixes().empty());
+}
@@ -0,0 +1,60 @@
+#include "url_canonicalizer.h"
+#include <gtest/gtest.h>
+
+namespace {
+
+std::string canonical(const UrlCanonicalizer& canonicalizer, const std::string& spec) {
+    Url url = Url::parse(spec);
+    canonicalizer.canonicalize(url);
+    return url.str();
+}
+
+} // namespace
+
+TEST(UrlCanonicalizerTest, StripsTrackingParameters) {
+    UrlCanonicalizer canonicalizer;
+    EXPECT_EQ(canonical(canonicalizer, "https://example.com/post?id=7&utm_source=x&UTM_Medium=y&fbclid=abc"),
+              "https://example.com/post?id=7");
+    EXPECT_EQ(canonical(canonicalizer, "https://example.com/post/?utm_campaign=spring"),
+              "https://example.com/post");
+    EXPECT_EQ(canonical(canonicalizer, "https://example.com/post?&&id=7&"),
+              "https://example.com/post?id=7");
+}
+
+TEST(UrlCanonicalizerTest, StripsSessionPathParameters) {
+    UrlCanonicalizer canonicalizer;
+    EXPECT_EQ(canonical(canonicalizer, "https://example.com/shop;jsessionid=A1B2/item;color=red?x=1"),
+              "https://example.com/shop/item;color=red?x=1");
+}
+
+TEST(UrlCanonicalizerTest, SortsQueryWhenEnabled) {
+    UrlCanonicalizer canonicalizer;
+    EXPECT_EQ(canonical(canonicalizer, "https://example.com/?b=2&a=1"), "https://example.com/?b=2&a=1");
+
+    canonicalizer.set_sort_query(true);
+    EXPECT_EQ(canonical(canonicalizer, "https://example.com/?b=2&a=1&b=1"), "https://example.com/?a=1&b=2&b=1");
+}
+
+TEST(UrlCanonicalizerTest, CustomStrippedParameters) {
+    UrlCanonicalizer canonicalizer;
+    canonicalizer.set_stripped_params({"ref", "track_*"});
+
+    EXPECT_TRUE(canonicalizer.is_stripped("REF"));
+    EXPECT_TRUE(canonicalizer.is_stripped("track_id"));
+    EXPECT_FALSE(canonicalizer.is_stripped("utm_source"));
+    EXPECT_EQ(canonical(canonicalizer, "https://Example.com:443/a?ref=home&track_x=1&utm_source=y#top"),
+              "https://example.com/a?utm_source=y");
+}
+
+TEST(UrlCanonicalizerTest, VariantsCollapseToOneUrl) {
+    UrlCanonicalizer canonicalizer;
+    canonicalizer.set_sort_query(true);
+    const char* variants[] = {
+        "https://example.com/docs/../article?id=5&lang=en",
+        "HTTPS://EXAMPLE.COM:443/article?lang=en&id=5&utm_source=feed",
+        "https://example.com/./article?lang=en&gclid=XYZ&id=5#comments",
+    };
+    for (const char* variant : variants) {
+        EXPECT_EQ(canonical(canonicalizer, variant), "https://example.com/article?id=5&lang=en");
+    }
+}
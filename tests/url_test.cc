@@ -0,0 +1,77 @@
+#include "url.h"
+#include <gtest/gtest.h>
+
+TEST(UrlTest, ParsesComponents) {
+    Url url = Url::parse("https://user@Example.com:8443/a/b?x=1&y=2#top");
+    ASSERT_TRUE(url.valid());
+    EXPECT_TRUE(url.is_http());
+    EXPECT_EQ(url.scheme(), "https");
+    EXPECT_EQ(url.authority(), "Example.com:8443");
+    EXPECT_EQ(url.host(), "Example.com");
+    EXPECT_EQ(url.port(), 8443);
+    EXPECT_EQ(url.path(), "/a/b");
+    EXPECT_EQ(url.query(), "x=1&y=2");
+    EXPECT_EQ(url.fragment(), "top");
+    EXPECT_EQ(url.request_target(), "/a/b?x=1&y=2");
+}
+
+TEST(UrlTest, DefaultsAndEdgeCases) {
+    Url bare = Url::parse("http://example.com");
+    EXPECT_EQ(bare.port(), 80);
+    EXPECT_EQ(bare.path(), "");
+    EXPECT_EQ(bare.request_target(), "/");
+
+    Url ipv6 = Url::parse("https://[::1]:8080/");
+    EXPECT_EQ(ipv6.host(), "::1");
+    EXPECT_EQ(ipv6.authority(), "[::1]:8080");
+    EXPECT_EQ(ipv6.port(), 8080);
+
+    EXPECT_FALSE(Url::parse("/relative/path").valid());
+    EXPECT_FALSE(Url::parse("mailto:someone@example.com").is_http());
+    EXPECT_EQ(Url::parse("https://example.com:bad/").port(), 443);
+}
+
+TEST(UrlTest, ResolvesReferences) {
+    Url base = Url::parse("https://example.com/docs/guide/intro.html?page=1");
+
+    EXPECT_EQ(Url::resolve(base, "setup.html").str(), "https://example.com/docs/guide/setup.html");
+    EXPECT_EQ(Url::resolve(base, "../api/").str(), "https://example.com/docs/api/");
+    EXPECT_EQ(Url::resolve(base, "/root/./x/../y").str(), "https://example.com/root/y");
+    EXPECT_EQ(Url::resolve(base, "//cdn.example.com/lib.js").str(), "https://cdn.example.com/lib.js");
+    EXPECT_EQ(Url::resolve(base, "?page=2").str(), "https://example.com/docs/guide/intro.html?page=2");
+    EXPECT_EQ(Url::resolve(base, "#section").str(), "https://example.com/docs/guide/intro.html?page=1");
+    EXPECT_EQ(Url::resolve(base, "http://other.org/a/../b").str(), "http://other.org/b");
+    EXPECT_EQ(Url::resolve(base, "../../../../x").str(), "https://example.com/x");
+
+    Url root = Url::parse("https://example.com");
+    EXPECT_EQ(Url::resolve(root, "page").str(), "https://example.com/page");
+}
+
+TEST(UrlTest, NormalizesInPlace) {
+    Url url = Url::parse("HTTPS://Example.COM/Path/To/#frag");
+    url.normalize();
+    EXPECT_EQ(url.str(), "https://example.com/Path/To");
+    EXPECT_EQ(url.host(), "example.com");
+
+    Url root = Url::parse("https://example.com/");
+    root.normalize();
+    EXPECT_EQ(root.str(), "https://example.com/");
+
+    Url query = Url::parse("https://example.com/dir/?next=/");
+    query.normalize();
+    EXPECT_EQ(query.str(), "https://example.com/dir/?next=/");
+}
+
+TEST(UrlTest, NormalizesRfc3986Equivalents) {
+    Url url = Url::parse("HTTP://Example.com:80/a/./b/../c/%7euser/%2fx%3a?q=%7e");
+    url.normalize();
+    EXPECT_EQ(url.str(), "http://example.com/a/c/~user/%2Fx%3A?q=~");
+
+    Url https = Url::parse("https://example.com:443");
+    https.normalize();
+    EXPECT_EQ(https.str(), "https://example.com/");
+
+    Url other_port = Url::parse("https://example.com:8443/x");
+    other_port.normalize();
+    EXPECT_EQ(other_port.str(), "https://example.com:8443/x");
+}
@@ -0,0 +1,197 @@
+#include "link_graph.h"
+#include "logger.h"
+#include "rocksdb_manager.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct Options {
+    std::string db_path = "rocksdb_queue";
+    double damping = 0.85;
+    int max_iterations = 50;
+    double tolerance = 1e-6;
+    size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    size_t top = 20;
+    bool write_back = true;
+    std::string output_path;  // Optional TSV: url, rank, in_degree, out_degree
+};
+
+constexpr size_t kWriteBatch = 100000;
+
+void print_usage() {
+    std::cout << "Usage: link_graph_rank [--db PATH] [--damping 0.85] [--iterations 50]\n"
+              << "                       [--tolerance 1e-6] [--threads N] [--top 20]\n"
+              << "                       [--output scores.tsv] [--no-write]\n"
+              << "Computes PageRank, in-degree and host-graph scores from the crawler's\n"
+              << "RocksDB link graph and stores them for use as crawl priorities.\n"
+              << "Run it while the crawler is stopped: RocksDB allows one writer process.\n";
+}
+
+bool parse_options(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--db" && has_value) {
+            options.db_path = argv[++i];
+        } else if (arg == "--damping" && has_value) {
+            options.damping = std::stod(argv[++i]);
+        } else if (arg == "--iterations" && has_value) {
+            options.max_iterations = std::stoi(argv[++i]);
+        } else if (arg == "--tolerance" && has_value) {
+            options.tolerance = std::stod(argv[++i]);
+        } else if (arg == "--threads" && has_value) {
+            options.threads = static_cast<size_t>(std::max(1, std::stoi(argv[++i])));
+        } else if (arg == "--top" && has_value) {
+            options.top = static_cast<size_t>(std::max(0, std::stoi(argv[++i])));
+        } else if (arg == "--output" && has_value) {
+            options.output_path = argv[++i];
+        } else if (arg == "--no-write") {
+            options.write_back = false;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+long elapsed_ms(std::chrono::steady_clock::time_point since) {
+    return static_cast<long>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - since).count());
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Logger::instance().set_level(LogLevel::INFO);
+    Logger::instance().set_color_output(true);
+
+    Options options;
+    try {
+        if (!parse_options(argc, argv, options)) {
+            print_usage();
+            return 1;
+        }
+    } catch (const std::exception&) {
+        print_usage();
+        return 1;
+    }
+
+    RocksDBManager db(options.db_path);
+    if (!db.init()) {
+        return 1;
+    }
+
+    // Load: graph keys are sorted by source URL, so each source is interned once
+    auto started = std::chrono::steady_clock::now();
+    LinkGraph graph;
+    std::string last_from;
+    uint32_t from_id = 0;
+    size_t scanned = db.for_each_link_edge([&](std::string_view from_url, std::string_view to_url) {
+        if (last_from.empty() || from_url != last_from) {
+            last_from.assign(from_url.data(), from_url.size());
+            from_id = graph.add_node(from_url);
+        }
+        graph.add_edge(from_id, graph.add_node(to_url));
+    });
+    graph.finalize(options.threads);
+
+    std::ostringstream load_msg;
+    load_msg << "Loaded link graph: " << graph.node_count() << " URLs, " << graph.edge_count()
+             << " edges (" << scanned << " scanned) in " << elapsed_ms(started) << " ms";
+    Logger::instance().info(load_msg.str());
+    if (graph.node_count() == 0) {
+        Logger::instance().warn("Link graph is empty; nothing to rank");
+        return 0;
+    }
+
+    started = std::chrono::steady_clock::now();
+    int iterations = 0;
+    std::vector<double> ranks = graph.pagerank(options.damping, options.max_iterations,
+                                               options.tolerance, options.threads, &iterations);
+    std::ostringstream rank_msg;
+    rank_msg << "PageRank: " << iterations << " iterations on " << options.threads
+             << " threads in " << elapsed_ms(started) << " ms";
+    Logger::instance().info(rank_msg.str());
+
+    std::vector<LinkGraph::HostStats> hosts = graph.aggregate_hosts(ranks);
+
+    // Scores are stored scaled so the average page has rank 1
+    double scale = static_cast<double>(graph.node_count());
+
+    std::vector<uint32_t> order(graph.node_count());
+    std::iota(order.begin(), order.end(), 0u);
+    size_t top_pages = std::min(options.top, order.size());
+    std::partial_sort(order.begin(), order.begin() + top_pages, order.end(),
+                      [&ranks](uint32_t a, uint32_t b) { return ranks[a] > ranks[b]; });
+    for (size_t i = 0; i < top_pages; ++i) {
+        std::ostringstream line;
+        line << "  #" << (i + 1) << " " << graph.url(order[i]) << " rank " << ranks[order[i]] * scale
+             << ", in-degree " << graph.in_degree(order[i]);
+        Logger::instance().info(line.str());
+    }
+
+    std::sort(hosts.begin(), hosts.end(),
+              [](const LinkGraph::HostStats& a, const LinkGraph::HostStats& b) { return a.rank > b.rank; });
+    for (size_t i = 0; i < std::min(options.top, hosts.size()); ++i) {
+        std::ostringstream line;
+        line << "  host #" << (i + 1) << " " << hosts[i].host << " rank " << hosts[i].rank * scale
+             << ", pages " << hosts[i].pages << ", linking hosts " << hosts[i].linking_hosts;
+        Logger::instance().info(line.str());
+    }
+
+    if (!options.output_path.empty()) {
+        std::ofstream out(options.output_path);
+        if (!out) {
+            Logger::instance().error("Cannot write " + options.output_path);
+            return 1;
+        }
+        out << "url\trank\tin_degree\tout_degree\n";
+        for (uint32_t id = 0; id < graph.node_count(); ++id) {
+            out << graph.url(id) << "\t" << ranks[id] * scale << "\t"
+                << graph.in_degree(id) << "\t" << graph.out_degree(id) << "\n";
+        }
+        Logger::instance().info("Scores written to " + options.output_path);
+    }
+
+    if (options.write_back) {
+        started = std::chrono::steady_clock::now();
+        std::vector<std::pair<std::string, std::string>> batch;
+        batch.reserve(kWriteBatch);
+        bool ok = true;
+        for (uint32_t id = 0; id < graph.node_count() && ok; ++id) {
+            std::ostringstream value;
+            value << ranks[id] * scale << " " << graph.in_degree(id);
+            batch.emplace_back(std::string(graph.url(id)), value.str());
+            if (batch.size() == kWriteBatch) {
+                ok = db.store_page_scores(batch);
+                batch.clear();
+            }
+        }
+        if (ok && !batch.empty()) {
+            ok = db.store_page_scores(batch);
+        }
+        batch.clear();
+        for (const auto& host : hosts) {
+            std::ostringstream value;
+            value << host.rank * scale << " " << host.pages << " " << host.linking_hosts;
+            batch.emplace_back(host.host, value.str());
+        }
+        ok = ok && db.store_host_scores(batch);
+        if (!ok) {
+            return 1;
+        }
+        std::ostringstream write_msg;
+        write_msg << "Stored scores for " << graph.node_count() << " URLs and " << hosts.size()
+                  << " hosts in " << elapsed_ms(started) << " ms";
+        Logger::instance().info(write_msg.str());
+    }
+    return 0;
+}